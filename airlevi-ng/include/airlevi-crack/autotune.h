@@ -0,0 +1,38 @@
+#ifndef AIRLEVI_AUTOTUNE_H
+#define AIRLEVI_AUTOTUNE_H
+
+#include <string>
+#include <chrono>
+
+namespace airlevi {
+
+struct CrackTuning {
+    int threads;
+    int batch_size;   // candidates a worker claims at once
+    int lanes;        // PBKDF2 lanes derived side by side (see PMKBatch)
+    double rate;      // PMKs per second measured during calibration
+};
+
+class Autotuner {
+public:
+    explicit Autotuner(int max_threads = 0);
+
+    // Cached per-host profile; false when missing or written on another machine
+    bool loadProfile(CrackTuning& tuning) const;
+    bool saveProfile(const CrackTuning& tuning) const;
+
+    // Short benchmark over lane widths, worker counts and batch sizes
+    CrackTuning calibrate();
+
+    static std::string profilePath();
+    static std::string hostIdentity();
+
+private:
+    int max_threads_;
+
+    double measure(int threads, int batch_size, int lanes, std::chrono::milliseconds duration);
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_AUTOTUNE_H
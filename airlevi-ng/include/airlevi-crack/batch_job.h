@@ -0,0 +1,60 @@
+#ifndef AIRLEVI_BATCH_JOB_H
+#define AIRLEVI_BATCH_JOB_H
+
+#include "common/types.h"
+#include "crack_target.h"
+#include "dictionary_attack.h"
+#include <functional>
+#include <map>
+#include <set>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Cracks many captures and 22000 hash files in one job. Targets are grouped
+// by ESSID (the PBKDF2 salt) so every candidate PMK is derived once per ESSID
+// and checked against every target in the group.
+class BatchJob {
+public:
+    // Called to apply tuning, dedup and similar options to each pass
+    using PassSetup = std::function<bool(DictionaryAttack& attack)>;
+
+    BatchJob(const Config& config, int num_threads);
+
+    // A capture, a 22000 file, a directory of those, or a manifest listing paths
+    bool addPath(const std::string& path);
+
+    // Passes run in order; later passes only see ESSIDs with targets left
+    void addWordlistPass(const std::string& wordlist);
+    void addHybridPass(const std::string& wordlist, const std::string& mask, bool prefix);
+
+    bool run(const PassSetup& setup);
+    void printReport(std::ostream& out) const;
+
+    size_t getTargetCount() const { return targets_.size(); }
+    size_t getCrackedCount() const;
+
+private:
+    struct Pass {
+        std::string wordlist;
+        std::string mask;     // empty for a plain wordlist pass
+        bool prefix;
+    };
+
+    Config config_;
+    int num_threads_;
+    std::vector<std::unique_ptr<CrackTarget>> targets_;
+    std::vector<Pass> passes_;
+    std::set<std::string> loaded_files_;   // canonical paths, so overlapping inputs load once
+
+    bool addFile(const std::string& path);
+    bool addManifest(const std::string& path);
+    std::map<std::string, std::vector<CrackTarget*>> groupByESSID() const;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_BATCH_JOB_H
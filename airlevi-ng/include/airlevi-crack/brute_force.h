@@ -2,8 +2,11 @@
 #define AIRLEVI_BRUTE_FORCE_H
 
 #include "common/types.h"
+#include "common/numa_topology.h"
 #include "wpa_crack.h"
+#include "markov_model.h"
 #include <thread>
+#include <chrono>
 #include <atomic>
 #include <mutex>
 #include <string>
@@ -17,11 +20,15 @@ public:
 
     bool crack(std::string& found_password);
     
-    void setCharset(const std::string& charset) { charset_ = charset; }
+    void setCharset(const std::string& charset) { charset_ = charset; markov_.reset(); }
     void setLengthRange(int min_len, int max_len) { 
         min_length_ = min_len; 
         max_length_ = max_len; 
     }
+    // Reorder the charset per position from a trained model; call after setCharset
+    bool loadMarkovModel(const std::string& training_file);
+    void setBatchSize(int batch_size) { batch_size_ = batch_size > 0 ? batch_size : 1; }
+    void setLanes(int lanes) { lanes_ = lanes; }
     
     void stop() { running_ = false; }
     bool isRunning() const { return running_; }
@@ -35,22 +42,37 @@ private:
     std::string charset_;
     int min_length_;
     int max_length_;
+    int batch_size_;
+    int lanes_;
     
     std::atomic<bool> running_;
     std::atomic<bool> found_;
     std::atomic<uint64_t> attempts_;
-    std::atomic<uint64_t> current_index_;
+    uint64_t total_combinations_;
     std::string result_password_;
+    std::chrono::steady_clock::time_point start_time_;
     
+    // Each NUMA node generates from its own slice of the keyspace; the
+    // cursor sits on its own cache line so nodes never share it
+    struct alignas(64) KeyspaceSlice {
+        size_t node_index;
+        std::atomic<uint64_t> next;
+        uint64_t end;
+    };
+    
+    NumaTopology topology_;
+    std::vector<std::unique_ptr<KeyspaceSlice>> slices_;
     std::vector<std::thread> worker_threads_;
     std::mutex result_mutex_;
     
     std::unique_ptr<WPACrack> wpa_cracker_;
+    std::unique_ptr<MarkovModel> markov_;
     
-    void workerThread();
+    void workerThread(size_t slice_index);
+    bool claimRange(size_t slice_index, uint64_t& first, uint64_t& last);
     std::string generatePassword(uint64_t index, int length);
+    bool indexToPassword(uint64_t index, std::string& password);
     uint64_t calculateTotalCombinations();
-    bool testPasswordWorker(const std::string& password);
 };
 
 } // namespace airlevi
@@ -0,0 +1,41 @@
+#ifndef AIRLEVI_CANDIDATE_FILTER_H
+#define AIRLEVI_CANDIDATE_FILTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace airlevi {
+
+// Blocked Bloom filter used to drop repeated candidates before they reach
+// PBKDF2. Each candidate touches a single 64-byte block, so a lookup costs
+// one cache miss. Inserts are lock-free and safe from several readers.
+// A false positive drops a candidate that was never tested, at the
+// configured rate.
+class CandidateFilter {
+public:
+    CandidateFilter(uint64_t expected_items, double false_positive_rate, size_t max_bytes);
+
+    // Returns true if the candidate was not seen before
+    bool insert(const std::string& candidate);
+
+    size_t getMemoryUsage() const { return num_blocks_ * sizeof(Block); }
+    int getHashCount() const { return hash_count_; }
+    uint64_t getDuplicates() const { return duplicates_; }
+
+private:
+    struct alignas(64) Block {
+        std::atomic<uint64_t> words[8];
+    };
+
+    std::unique_ptr<Block[]> blocks_;
+    uint64_t num_blocks_;
+    int hash_count_;
+    std::atomic<uint64_t> duplicates_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CANDIDATE_FILTER_H
@@ -0,0 +1,47 @@
+#ifndef AIRLEVI_CRACK_TARGET_H
+#define AIRLEVI_CRACK_TARGET_H
+
+#include "common/types.h"
+#include "handshake_verifier.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// One crackable target, either a 4-way handshake or a PMKID, together with
+// where it came from and its result
+struct CrackTarget {
+    std::string source;
+    std::string essid;
+    MacAddress ap_mac;
+    MacAddress client_mac;
+    std::unique_ptr<HandshakeVerifier> handshake;
+    std::unique_ptr<PMKIDVerifier> pmkid;
+
+    std::atomic<bool> cracked{false};
+    std::string password;   // valid once cracked
+
+    bool testPMK(const uint8_t* pmk) const {
+        return handshake ? handshake->testPMK(pmk) : pmkid->testPMK(pmk);
+    }
+
+    std::string describe() const;
+};
+
+class TargetLoader {
+public:
+    // Every paired handshake and PMKID of a capture file (pcap/pcapng)
+    static bool loadCapture(const Config& config, const std::string& path,
+                            std::vector<std::unique_ptr<CrackTarget>>& targets);
+
+    // hashcat 22000 lines: WPA*01*PMKID*AP*STA*ESSID*** and
+    // WPA*02*MIC*AP*STA*ESSID*ANONCE*EAPOL*MESSAGEPAIR
+    static bool loadHashFile(const std::string& path, std::vector<std::unique_ptr<CrackTarget>>& targets);
+    static std::unique_ptr<CrackTarget> parseHashLine(const std::string& line);
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CRACK_TARGET_H
@@ -2,10 +2,19 @@
 #define AIRLEVI_DICTIONARY_ATTACK_H
 
 #include "common/types.h"
+#include "common/numa_topology.h"
 #include "wpa_crack.h"
+#include "candidate_filter.h"
+#include "pmk_batch.h"
+#include "mask.h"
+#include "crack_target.h"
+#include "pmk_cache.h"
+#include "common/pmkid_index.h"
 #include <thread>
+#include <chrono>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <queue>
 
 namespace airlevi {
@@ -17,25 +26,77 @@ public:
 
     bool crack(std::string& found_password);
     
-    void stop() { running_ = false; }
+    void stop();
     bool isRunning() const { return running_; }
     
+    // Tuning (see Autotuner)
+    void setBatchSize(int batch_size) { batch_size_ = batch_size > 0 ? batch_size : 1; }
+    void setLanes(int lanes) { lanes_ = lanes; }
+    
+    // Drop repeated candidates before hashing (see CandidateFilter)
+    void setDeduplication(double false_positive_rate, size_t max_memory) {
+        dedup_fp_rate_ = false_positive_rate;
+        dedup_max_memory_ = max_memory;
+    }
+    
+    // Hybrid attack: append (or prepend) every mask combination to each word
+    bool setHybridMask(const std::string& mask, bool prefix);
+    
+    // Reuse and record PMKs across runs; the cache must outlive the attack
+    void setPMKCache(PMKCache* cache) { pmk_cache_ = cache; }
+    
+    // Batch mode: crack every target sharing one ESSID instead of the
+    // capture in config; each PMK is checked against all of them
+    void setTargetGroup(const std::string& essid, const std::vector<CrackTarget*>& targets);
+    
     // Statistics
     uint64_t getAttempts() const { return attempts_; }
+    uint64_t getDuplicates() const { return filter_ ? filter_->getDuplicates() : 0; }
     double getRate() const; // passwords per second
 
 private:
     Config config_;
     int num_threads_;
+    int batch_size_;
+    int lanes_;
+    double dedup_fp_rate_;      // 0 = deduplication disabled
+    size_t dedup_max_memory_;
+    std::unique_ptr<Mask> hybrid_mask_;
+    bool hybrid_prefix_;
+    PMKCache* pmk_cache_;
+    std::string group_essid_;
+    std::vector<CrackTarget*> group_targets_;
+    std::vector<CrackTarget*> group_handshakes_;
+    PMKIDIndex group_pmkids_;                              // PMKID targets, matched per PMK in one pass
+    std::vector<std::vector<CrackTarget*>> group_pmkid_targets_;  // index id -> targets
+    size_t group_remaining_;
     std::atomic<bool> running_;
     std::atomic<bool> found_;
     std::atomic<uint64_t> attempts_;
     std::string result_password_;
+    std::chrono::steady_clock::time_point start_time_;
+    uint64_t wordlist_size_;
+    
+    // One buffer per NUMA node, fed by a reader pinned to that node
+    struct CandidateBuffer {
+        size_t node_index;
+        int workers;
+        uint64_t begin;   // byte range of the wordlist this node reads
+        uint64_t end;
+        std::queue<std::string> queue;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool loading_done;
+        uint64_t loaded;
+        std::atomic<uint64_t> position;   // wordlist bytes consumed so far
+    };
     
     // Threading
+    NumaTopology topology_;
+    std::vector<std::unique_ptr<CandidateBuffer>> buffers_;
+    std::unique_ptr<CandidateFilter> filter_;
+    std::vector<std::thread> reader_threads_;
     std::vector<std::thread> worker_threads_;
-    std::queue<std::string> password_queue_;
-    std::mutex queue_mutex_;
     std::mutex result_mutex_;
     
     // WPA cracker instance
@@ -43,13 +104,18 @@ private:
     HandshakePacket target_handshake_;
     
     // Worker functions
-    void workerThread();
-    void loadPasswords();
-    bool testPasswordWorker(const std::string& password);
+    void workerThread(CandidateBuffer* buffer);
+    void readerThread(CandidateBuffer* buffer);
+    bool testBatch(const PMKBatch& pmk_batch, const std::vector<std::string>& batch, uint8_t (*pmks)[32]);
+    bool testGroupBatch(const PMKBatch& pmk_batch, const std::vector<std::string>& batch, uint8_t (*pmks)[32]);
+    void derivePMKs(const PMKBatch& pmk_batch, const std::string& essid,
+                    const std::vector<std::string>& batch, uint8_t (*pmks)[32]);
+    bool claimTarget(CrackTarget* target, const std::string& password);
+    void reportProgress(size_t tested);
     
     // Queue management
-    void addPasswordToQueue(const std::string& password);
-    bool getPasswordFromQueue(std::string& password);
+    void addPasswordToQueue(CandidateBuffer* buffer, std::string& password);
+    bool getPasswordBatch(CandidateBuffer* buffer, std::vector<std::string>& batch);
 };
 
 } // namespace airlevi
@@ -0,0 +1,92 @@
+#ifndef AIRLEVI_HANDSHAKE_VERIFIER_H
+#define AIRLEVI_HANDSHAKE_VERIFIER_H
+
+#include "common/types.h"
+#include "common/crypto_utils.h"
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Everything about a handshake that does not depend on the candidate
+// passphrase, prepared once when the target is loaded
+struct HandshakeTarget {
+    std::string essid;
+    MacAddress ap_mac;
+    MacAddress client_mac;
+    KeyDescriptorVersion key_version;
+    std::vector<uint8_t> kck_input;    // PRF/KDF input producing the first PTK block
+    std::vector<uint8_t> eapol_frame;  // EAPOL-Key frame with the MIC field zeroed
+    uint8_t mic[EAPOL_MIC_LENGTH];
+};
+
+// One kernel per key descriptor version. Each derives only the KCK (the
+// first 128 bits of the PTK) and computes the EAPOL-Key MIC with it.
+template <KeyDescriptorVersion V>
+struct MICKernel;
+
+template <>
+struct MICKernel<KeyDescriptorVersion::HMAC_MD5_RC4> {
+    static void deriveKCK(const uint8_t* pmk, const HandshakeTarget& target, uint8_t* kck);
+    static void computeMIC(const uint8_t* kck, const HandshakeTarget& target, uint8_t* mic);
+};
+
+template <>
+struct MICKernel<KeyDescriptorVersion::HMAC_SHA1_AES> {
+    static void deriveKCK(const uint8_t* pmk, const HandshakeTarget& target, uint8_t* kck);
+    static void computeMIC(const uint8_t* kck, const HandshakeTarget& target, uint8_t* mic);
+};
+
+template <>
+struct MICKernel<KeyDescriptorVersion::AES_128_CMAC> {
+    static void deriveKCK(const uint8_t* pmk, const HandshakeTarget& target, uint8_t* kck);
+    static void computeMIC(const uint8_t* kck, const HandshakeTarget& target, uint8_t* mic);
+};
+
+class HandshakeVerifier {
+public:
+    explicit HandshakeVerifier(const HandshakePacket& handshake);
+
+    bool isSupported() const { return verify_ != nullptr; }
+    KeyDescriptorVersion getKeyVersion() const { return target_.key_version; }
+    const std::string& getESSID() const { return target_.essid; }
+    const HandshakeTarget& getTarget() const { return target_; }
+
+    // Full check: PBKDF2 PMK derivation followed by the MIC kernel
+    bool testPassword(const std::string& password) const;
+    // MIC kernel only, for callers that already hold the 32-byte PMK
+    bool testPMK(const uint8_t* pmk) const { return verify_(pmk, target_); }
+
+    static std::string describe(KeyDescriptorVersion version);
+
+private:
+    using VerifyFn = bool (*)(const uint8_t* pmk, const HandshakeTarget& target);
+
+    HandshakeTarget target_;
+    VerifyFn verify_;
+
+    template <KeyDescriptorVersion V>
+    static bool verify(const uint8_t* pmk, const HandshakeTarget& target);
+};
+
+// PMKID = HMAC-SHA1-128(PMK, "PMK Name" || AA || SPA), from the RSN IE of
+// EAPOL message 1 or a 22000 hash line
+class PMKIDVerifier {
+public:
+    PMKIDVerifier(const std::string& essid, const MacAddress& ap_mac,
+                  const MacAddress& client_mac, const uint8_t* pmkid);
+
+    const std::string& getESSID() const { return essid_; }
+    const uint8_t* getPMKID() const { return pmkid_; }
+
+    bool testPMK(const uint8_t* pmk) const;
+
+private:
+    std::string essid_;
+    uint8_t message_[20];   // "PMK Name" || AA || SPA
+    uint8_t pmkid_[16];
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_HANDSHAKE_VERIFIER_H
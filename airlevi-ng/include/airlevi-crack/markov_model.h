@@ -0,0 +1,47 @@
+#ifndef AIRLEVI_MARKOV_MODEL_H
+#define AIRLEVI_MARKOV_MODEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Per-position, previous-character (first-order Markov) frequency model
+// over a brute-force charset. For every position and predecessor the
+// charset is reordered most-likely first, so rank r maps to one character
+// and the keyspace stays the same size and index-addressable.
+class MarkovModel {
+public:
+    static constexpr int MAX_POSITIONS = 64;
+
+    explicit MarkovModel(const std::string& charset);
+
+    // Count character transitions in a wordlist or cracked-password list
+    bool train(const std::string& training_file);
+
+    // Character of the given rank at a position; prev is the charset index
+    // of the previous character, or -1 at the start of the password
+    char at(int position, int prev, int rank) const {
+        return order_[slot(position, prev) + rank];
+    }
+
+    int indexOf(char c) const { return index_[static_cast<uint8_t>(c)]; }
+
+    uint64_t getSamples() const { return samples_; }
+
+private:
+    std::string charset_;
+    int index_[256];
+    std::vector<char> order_;   // [position][prev + 1][rank]
+    uint64_t samples_;
+
+    size_t slot(int position, int prev) const {
+        if (position >= MAX_POSITIONS) position = MAX_POSITIONS - 1;
+        return (static_cast<size_t>(position) * (charset_.size() + 1) + (prev + 1)) * charset_.size();
+    }
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_MARKOV_MODEL_H
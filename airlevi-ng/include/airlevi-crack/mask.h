@@ -0,0 +1,34 @@
+#ifndef AIRLEVI_MASK_H
+#define AIRLEVI_MASK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Compiled candidate mask, e.g. "?d?d?s" or "19?d?d".
+//   ?l a-z   ?u A-Z   ?d 0-9   ?s symbols   ?a all of them
+//   ?h 0-9a-f   ?H 0-9A-F   ?? a literal '?'   anything else is literal
+class Mask {
+public:
+    bool compile(const std::string& mask);
+
+    size_t length() const { return positions_.size(); }
+    uint64_t size() const { return size_; }
+
+    // Write the first combination into out[offset, offset + length())
+    void first(std::string& out, size_t offset, std::vector<uint32_t>& digits) const;
+
+    // Advance to the next combination in place, last position fastest.
+    // Returns false after the final combination.
+    bool next(std::string& out, size_t offset, std::vector<uint32_t>& digits) const;
+
+private:
+    std::vector<std::string> positions_;
+    uint64_t size_ = 0;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_MASK_H
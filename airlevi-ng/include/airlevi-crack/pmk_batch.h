@@ -0,0 +1,39 @@
+#ifndef AIRLEVI_PMK_BATCH_H
+#define AIRLEVI_PMK_BATCH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Derives WPA PMKs (PBKDF2-HMAC-SHA1, 4096 iterations, 256-bit output) for
+// many candidates sharing one ESSID salt. Candidates are processed in groups
+// of `lanes`, with the SHA-1 state of each lane laid out side by side so the
+// compiler can vectorize the 4096-iteration loop across lanes.
+class PMKBatch {
+public:
+    static constexpr int MAX_LANES = 16;
+
+    explicit PMKBatch(int lanes = 8);
+
+    int getLanes() const { return lanes_; }
+
+    // Passwords are expected to be valid WPA passphrases (8-63 characters)
+    void derive(const std::string* passwords, size_t count,
+                const std::string& essid, uint8_t (*pmks)[32]) const;
+
+    static std::vector<int> supportedLanes() { return {1, 4, 8, 16}; }
+
+private:
+    using DeriveFn = void (*)(const std::string* passwords, size_t count,
+                              const std::string& essid, uint8_t (*pmks)[32]);
+
+    int lanes_;
+    DeriveFn derive_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_PMK_BATCH_H
@@ -0,0 +1,71 @@
+#ifndef AIRLEVI_PMK_CACHE_H
+#define AIRLEVI_PMK_CACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sqlite3.h>
+
+namespace airlevi {
+
+// On-disk (ESSID, passphrase) -> PMK cache that fills itself while cracking.
+// Lookups run on the workers; inserts and LRU bookkeeping are handed to a
+// writer thread so hashing never waits on the disk. Once the cache holds
+// more than max_entries, the least recently used entries are evicted.
+class PMKCache {
+public:
+    PMKCache();
+    ~PMKCache();
+
+    bool open(const std::string& path, uint64_t max_entries);
+    void close();
+    bool isOpen() const { return read_db_ != nullptr; }
+
+    // Fills pmks[i] and sets hit[i] for every cached candidate; returns the hit count
+    size_t lookup(const std::string& essid, const std::vector<std::string>& passwords,
+                  uint8_t (*pmks)[32], std::vector<bool>& hit);
+
+    // Queue freshly derived PMKs for the writer
+    void store(const std::string& essid, const std::string* passwords,
+               const uint8_t (*pmks)[32], size_t count);
+
+    uint64_t getHits() const { return hits_; }
+    uint64_t getMisses() const { return misses_; }
+
+private:
+    struct PendingEntry {
+        std::string essid;
+        std::string password;
+        uint8_t pmk[32];
+        bool touch_only;   // cache hit: only refresh its LRU position
+    };
+
+    sqlite3* read_db_;
+    sqlite3* write_db_;
+    sqlite3_stmt* select_stmt_;
+    std::mutex read_mutex_;
+
+    uint64_t max_entries_;
+    uint64_t entry_count_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+
+    std::deque<PendingEntry> pending_;
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    bool stopping_;
+    std::thread writer_;
+
+    void writerThread();
+    void writeBatch(std::vector<PendingEntry>& batch);
+    void evict();
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_PMK_CACHE_H
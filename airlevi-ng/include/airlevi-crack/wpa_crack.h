@@ -3,11 +3,21 @@
 
 #include "common/types.h"
 #include "common/crypto_utils.h"
+#include "handshake_verifier.h"
 #include <vector>
 #include <string>
+#include <memory>
 
 namespace airlevi {
 
+// PMKID KDE of an EAPOL message 1
+struct PMKIDPacket {
+    MacAddress ap_mac;
+    MacAddress client_mac;
+    std::string essid;
+    std::vector<uint8_t> pmkid;
+};
+
 class WPACrack {
 public:
     explicit WPACrack(const Config& config);
@@ -15,6 +25,15 @@ public:
 
     bool crack(std::string& found_password);
     
+    // Load the capture and select the MIC verifier for the best handshake
+    bool prepareTarget();
+    const HandshakeVerifier* getVerifier() const { return verifier_.get(); }
+    std::unique_ptr<HandshakeVerifier> releaseVerifier() { return std::move(verifier_); }
+    
+    // Every crackable target of the capture rather than the best one: a
+    // paired handshake per AP and station and each PMKID with a known ESSID
+    bool loadTargets(std::vector<HandshakePacket>& handshakes, std::vector<PMKIDPacket>& pmkids);
+    
     // Attack methods
     bool handshakeAttack(std::string& found_password);
     bool pmkidAttack(std::string& found_password);
@@ -26,7 +45,9 @@ public:
 private:
     Config config_;
     std::vector<HandshakePacket> handshakes_;
-    std::vector<std::vector<uint8_t>> pmkids_;
+    std::vector<PMKIDPacket> pmkids_;
+    std::unique_ptr<HandshakeVerifier> verifier_;
+    bool target_loaded_;
     
     // Load data from capture file
     bool loadCaptureFile();
@@ -35,9 +56,10 @@ private:
     
     // Password testing
     bool testPassword(const std::string& password, const HandshakePacket& handshake);
-    bool testPasswordPMKID(const std::string& password, const std::vector<uint8_t>& pmkid);
+    bool testPasswordPMKID(const std::string& password, const PMKIDPacket& pmkid);
     
-    // Handshake processing
+    // Handshake processing: one M2 per AP and station, with the ANonce of its exchange
+    std::vector<HandshakePacket> pairHandshakes();
     HandshakePacket findBestHandshake();
     bool verifyHandshakeIntegrity(const HandshakePacket& handshake);
 };
@@ -3,11 +3,16 @@
 
 #include "common/types.h"
 #include "common/packet_parser.h"
+#include "common/frame_dispatcher.h"
+#include "common/beacon_cache.h"
+#include "common/ring_capture.h"
+#include "common/capture_replay.h"
+#include "common/pcap_writer.h"
 #include <pcap.h>
 #include <thread>
 #include <atomic>
 #include <mutex>
-#include <fstream>
+#include <unordered_map>
 
 namespace airlevi {
 
@@ -16,45 +21,94 @@ public:
     explicit PacketCapture(const Config& config);
     ~PacketCapture();
 
+    // Capture through an AF_PACKET ring instead of libpcap; before start()
+    void setCaptureRing(const RingOptions& options) { ring_options_ = options; }
+    // Play a capture file through the same pipeline instead; before start()
+    void setReplay(const ReplayOptions& options) { replay_options_ = options; }
+    // Queueing, rotation and O_DIRECT of the -w output; before start()
+    void setWriterOptions(const PcapWriterOptions& options) { writer_options_ = options; }
+
     bool start();
     void stop();
     bool isRunning() const { return running_; }
+    // The replayed file has been processed to its end
+    bool isReplayFinished() const { return replay_.isFinished(); }
+    double getReplaySeconds() const { return replay_.getElapsedSeconds(); }
 
     // Packet handlers
     void onPacketReceived(const uint8_t* packet, int length);
-    void onBeaconFrame(const WifiNetwork& network);
+    void onBeaconFrame(const BeaconView& beacon, const RadiotapInfo& radiotap);
     void onDataFrame(const MacAddress& src, const MacAddress& dst);
-    void onHandshakePacket(const HandshakePacket& handshake);
-    void onSAEHandshakePacket(const SAEHandshakePacket& sae_packet);
+    void onHandshakePacket(const EapolKeyView& handshake);
+    void onSAECommit(const SaeCommitView& commit);
+    void onSAEConfirm(const SaeConfirmView& confirm);
 
     // Statistics
     uint64_t getTotalPackets() const { return total_packets_; }
     uint64_t getHandshakeCount() const { return handshake_count_; }
+    
+    // Kernel and interface counters of the capture source
+    CaptureCounters getCaptureCounters();
+    // Filled ring blocks waiting per worker; empty on the libpcap path
+    std::vector<size_t> getRingBacklog() const;
+    // Frame timestamp to the end of its processing: sampled for all frames,
+    // every EAPOL and SAE frame for handshakes
+    const LatencyHistogram& getFrameLatency() const { return frame_latency_; }
+    const LatencyHistogram& getHandshakeLatency() const { return handshake_latency_; }
+    // Records handed to the writer, and those dropped because it fell behind
+    uint64_t getRecordsQueued() const { return writer_.getQueued(); }
+    uint64_t getRecordsDropped() const { return writer_.getDropped(); }
+    int getOutputFileCount() const { return writer_.getFileCount(); }
 
 private:
     Config config_;
     pcap_t* pcap_handle_;
+    int link_type_;
     std::thread capture_thread_;
     std::atomic<bool> running_;
     PacketParser parser_;
+    FrameDispatcher dispatcher_;
+    BeaconCache beacon_cache_;
+    std::mutex beacon_mutex_;
+    // BSSIDs whose named beacon is indexed, with the output file it went to
+    std::unordered_map<uint64_t, int> indexed_bss_;
+    
+    // Ring backend: one parser per worker for its radiotap layout cache
+    RingOptions ring_options_;
+    RingCapture ring_;
+    std::vector<PacketParser> ring_parsers_;
+    
+    ReplayOptions replay_options_;
+    CaptureReplay replay_;
     
     // Statistics
     std::atomic<uint64_t> total_packets_;
     std::atomic<uint64_t> handshake_count_;
+    LatencyHistogram frame_latency_;
+    LatencyHistogram handshake_latency_;
     
-    // Output file
-    std::ofstream output_file_;
-    std::mutex file_mutex_;
+    // Output file, written from its own thread
+    PcapWriterOptions writer_options_;
+    PcapWriter writer_;
     
     // Packet capture loop
     void captureLoop();
     
+    bool startRing();
+    bool startReplay();
+    
     // Packet processing
     void processPacket(const struct pcap_pkthdr* header, const uint8_t* packet);
+    void processBatch(int worker, const std::vector<RingPacket>& batch);
+    void replayBatch(const std::vector<RingPacket>& batch);
+    // interface_id picks the parser's radiotap cache slot
+    bool processFrame(const struct pcap_pkthdr* header, const uint8_t* packet, uint32_t interface_id,
+                      PacketParser& parser, IndexedFrameKind& index_kind);
+    IndexedFrameKind indexKind(FrameClass frame_class, const uint8_t* frame, int length, PacketParser& parser);
+    void registerFrameHandlers();
     
     // File operations
     bool openOutputFile();
-    void writePacketToFile(const struct pcap_pkthdr* header, const uint8_t* packet);
     
     // Filter functions
     bool shouldCapturePacket(const uint8_t* packet, int length);
@@ -1,7 +1,10 @@
 #ifndef HANDSHAKE_CAPTURE_H
 #define HANDSHAKE_CAPTURE_H
 
-#include "common/mac_address.h"
+#include "common/types.h"
+#include "common/packet_parser.h"
+#include "common/frame_dispatcher.h"
+#include "common/pcap_writer.h"
 #include <string>
 #include <vector>
 #include <thread>
@@ -11,6 +14,8 @@
 #include <chrono>
 #include <map>
 
+namespace airlevi {
+
 // Structure pour représenter un point d'accès (AP)
 struct AccessPoint {
     MacAddress bssid;
@@ -89,7 +94,10 @@ private:
     std::string interface;
     std::string output_file;
     pcap_t* pcap_handle = nullptr;
-    pcap_dumper_t* pcap_dumper = nullptr;
+    PcapWriter pcap_writer;
+    int link_type = DLT_IEEE802_11_RADIO;
+    PacketParser parser;
+    FrameDispatcher dispatcher;
 
     std::atomic<bool> running;
     std::thread capture_thread;
@@ -119,4 +127,6 @@ private:
     std::chrono::steady_clock::time_point start_time;
 };
 
+} // namespace airlevi
+
 #endif // HANDSHAKE_CAPTURE_H
@@ -0,0 +1,98 @@
+#ifndef AIRLEVI_CAPTURE_MERGE_H
+#define AIRLEVI_CAPTURE_MERGE_H
+
+#include "common/capture_reader.h"
+#include "common/frame_dispatcher.h"
+#include "common/packet_parser.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace airlevi {
+
+struct MergeOptions {
+    CaptureFormat format = CaptureFormat::PCAPNG;
+    uint64_t dedup_window_us = 0;   // drop frames another input saw this close in time; 0 keeps all
+};
+
+struct MergeStats {
+    uint64_t captures = 0;
+    uint64_t frames_in = 0;
+    uint64_t frames_out = 0;
+    uint64_t duplicates = 0;
+    uint64_t out_of_order = 0;      // frames older than one already written: an input was not in time order
+};
+
+// Merges captures of the same air, e.g. one per radio, into one file in
+// timestamp order. Inputs stay mapped and are read frame by frame through
+// a heap of their next frames, so memory does not grow with their size.
+// With a dedup window, a frame whose 802.11 bytes another input already
+// gave within the window is the same transmission heard twice and is
+// dropped; the FCS is left out, so radios that strip it still match.
+class CaptureMerge {
+public:
+    explicit CaptureMerge(const MergeOptions& options);
+    ~CaptureMerge();
+
+    bool addCapture(const std::string& path);
+
+    // pcapng gives every input and link type its own interface and ends
+    // with the key-material index; pcap needs a single link type
+    bool write(const std::string& path);
+
+    const MergeStats& getStats() const { return stats_; }
+
+private:
+    CaptureMerge(const CaptureMerge&) = delete;
+    CaptureMerge& operator=(const CaptureMerge&) = delete;
+
+    struct Input {
+        std::unique_ptr<CaptureReader> reader;
+        std::string path;
+        std::vector<uint32_t> link_types;             // in order of appearance
+        std::map<uint32_t, uint32_t> interface_ids;   // link type -> output interface
+    };
+
+    // Next frame of an input; the heap pops the earliest, the lowest input
+    // first on equal timestamps
+    struct Head {
+        CaptureFrame frame;
+        size_t input;
+
+        bool operator>(const Head& other) const {
+            return frame.timestamp_ns != other.frame.timestamp_ns ? frame.timestamp_ns > other.frame.timestamp_ns
+                                                                   : input > other.input;
+        }
+    };
+
+    struct Seen {
+        uint64_t timestamp_ns;
+        uint64_t hash;
+        size_t input;
+    };
+
+    bool duplicate(const CaptureFrame& frame, size_t input);
+    IndexedFrameKind indexKind(const CaptureFrame& frame);
+
+    MergeOptions options_;
+    MergeStats stats_;
+    std::vector<Input> inputs_;
+
+    // Frames written within the dedup window, oldest first
+    std::deque<Seen> recent_;
+    std::unordered_multimap<uint64_t, const Seen*> recent_by_hash_;
+
+    std::unordered_set<uint64_t> indexed_bss_;   // BSSIDs whose beacon is in the index
+    FrameDispatcher dispatcher_;
+    PacketParser parser_;
+    std::vector<uint8_t> unpadded_;   // last frame whose data pad was removed
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CAPTURE_MERGE_H
@@ -3,6 +3,12 @@
 
 #include "common/types.h"
 #include "common/logger.h"
+#include "common/packet_parser.h"
+#include "common/frame_dispatcher.h"
+#include "common/beacon_cache.h"
+#include "common/ring_capture.h"
+#include "common/capture_replay.h"
+#include "common/capture_stats.h"
 #include <pcap.h>
 #include <string>
 #include <vector>
@@ -69,6 +75,9 @@ struct HandshakeInfo {
     std::vector<uint8_t> anonce;
     std::vector<uint8_t> snonce;
     std::vector<uint8_t> mic;
+    uint8_t anonce_message;            // 1 or 3: the message the ANonce came from
+    uint64_t anonce_replay_counter;
+    uint64_t replay_counter;           // of the M2 the SNonce and MIC came from
 };
 
 class AdvancedMonitor {
@@ -77,8 +86,16 @@ public:
     ~AdvancedMonitor();
 
     bool initialize(const std::string& interface);
+    
+    // Capture through an AF_PACKET ring instead of libpcap; before initialize()
+    void setCaptureRing(const RingOptions& options) { ring_options_ = options; }
+    // Analyze a capture file instead of the interface; before initialize()
+    void setReplay(const ReplayOptions& options) { replay_options_ = options; }
     bool startMonitoring();
     void stopMonitoring();
+    // The replayed file has been analyzed to its end
+    bool isReplayFinished() const { return replay_.isFinished(); }
+    double getReplaySeconds() const { return replay_.getElapsedSeconds(); }
     
     // Channel management
     void setChannelHopping(bool enabled, int dwell_time_ms = 250);
@@ -127,34 +144,43 @@ public:
     
     MonitorStats getStats() const { return stats_; }
     void resetStats();
+    
+    // Kernel counters of the pcap handle or ring, and the ring's queue depth
+    CaptureCounters getCaptureCounters();
+    std::vector<size_t> getRingBacklog() const;
+    
+    // Kernel timestamp to end of analysis; one frame in LATENCY_SAMPLE_EVERY
+    // is sampled, handshake frames always
+    const LatencyHistogram& getFrameLatency() const { return frame_latency_; }
+    const LatencyHistogram& getHandshakeLatency() const { return handshake_latency_; }
 
 private:
     void monitoringThread();
     void channelHoppingThread();
     void cleanupThread();
-    void packetHandler(const struct pcap_pkthdr* header, const u_char* packet);
-    
-    // Packet analysis
-    void analyzeBeacon(const u_char* packet, int length);
-    void analyzeProbeRequest(const u_char* packet, int length);
-    void analyzeProbeResponse(const u_char* packet, int length);
-    void analyzeAuthFrame(const u_char* packet, int length);
-    void analyzeAssocFrame(const u_char* packet, int length);
-    void analyzeDataFrame(const u_char* packet, int length);
-    void analyzeDeauthFrame(const u_char* packet, int length);
-    void analyzeEAPOLFrame(const u_char* packet, int length);
+    void packetHandler(const struct pcap_pkthdr* header, const u_char* packet, uint32_t interface_id,
+                       PacketParser& parser);
+    void ringHandler(int worker, const std::vector<RingPacket>& batch);
+    void replayHandler(const std::vector<RingPacket>& batch);
+    
+    // Packet analysis, one handler per frame class
+    void registerFrameHandlers();
+    void analyzeBeacon(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeProbeRequest(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeProbeResponse(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeAuthFrame(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeAssocFrame(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeDataFrame(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeDeauthFrame(const u_char* packet, int length, const RadiotapInfo& radiotap);
+    void analyzeEAPOLFrame(const u_char* packet, int length, const RadiotapInfo& radiotap);
     
     // Information extraction
     std::string extractSSID(const u_char* packet, int length);
     std::string extractEncryption(const u_char* packet, int length);
     uint8_t extractChannel(const u_char* packet, int length);
-    int extractSignalStrength(const u_char* packet);
     std::string getVendorFromMAC(const MacAddress& mac);
-    
-    // Handshake detection
-    void detectHandshake(const u_char* packet, int length);
-    bool isEAPOLKey(const u_char* packet, int length);
-    uint8_t getEAPOLKeyType(const u_char* packet, int length);
+    void updateAccessPoint(const WifiNetwork& network, const RadiotapInfo& radiotap, bool from_beacon);
+    ClientInfo& touchClient(const MacAddress& mac, const RadiotapInfo& radiotap);
     
     // Display helpers
     void clearScreen();
@@ -165,7 +191,19 @@ private:
     std::string formatDuration(const std::chrono::steady_clock::time_point& start);
     
     pcap_t* pcap_handle_;
+    int link_type_;
     std::string interface_;
+    PacketParser parser_;
+    FrameDispatcher dispatcher_;
+    BeaconCache beacon_cache_;
+    
+    // Ring backend: one parser per worker for its radiotap layout cache
+    RingOptions ring_options_;
+    RingCapture ring_;
+    std::vector<PacketParser> ring_parsers_;
+    
+    ReplayOptions replay_options_;
+    CaptureReplay replay_;
     
     // Threading
     std::atomic<bool> running_;
@@ -193,6 +231,8 @@ private:
     
     // Statistics
     MonitorStats stats_;
+    LatencyHistogram frame_latency_;
+    LatencyHistogram handshake_latency_;
     
     // OUI database for vendor lookup
     std::unordered_map<std::string, std::string> oui_database_;
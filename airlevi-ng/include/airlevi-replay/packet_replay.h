@@ -3,6 +3,7 @@
 
 #include "common/types.h"
 #include "common/logger.h"
+#include "common/capture_reader.h"
 #include <pcap.h>
 #include <string>
 #include <vector>
@@ -54,16 +55,17 @@ public:
     
 private:
     void replayThread();
+    bool replayFrame(const CaptureFrame& frame);
     bool injectPacket(const u_char* packet, int length);
     void modifyPacket(u_char* packet, int length);
     void updateStats();
     
-    pcap_t* pcap_handle_;
     pcap_t* inject_handle_;
     std::string interface_;
     std::string capture_file_;
     
-    std::vector<std::pair<std::vector<u_char>, int>> packets_;
+    CaptureReader capture_;
+    std::vector<CaptureFrame> packets_;
     
     ReplayMode mode_;
     int packet_delay_;
@@ -0,0 +1,118 @@
+#ifndef AIRLEVI_CAPTURE_STRIP_H
+#define AIRLEVI_CAPTURE_STRIP_H
+
+#include "common/capture_reader.h"
+#include "common/frame_dispatcher.h"
+#include "common/packet_parser.h"
+#include "common/types.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace airlevi {
+
+struct StripOptions {
+    bool keep_wep = false;     // one data frame per WEP IV and BSS
+    std::string bssid;         // only this BSS, "aa:bb:cc:dd:ee:ff"
+    int threads = 0;           // scan workers per capture; 0 for one per core
+    uint64_t range_bytes = SCAN_MIN_RANGE_BYTES;   // smallest byte range given to a worker
+};
+
+struct StripStats {
+    uint64_t captures = 0;
+    uint64_t bytes_in = 0;
+    uint64_t candidates = 0;   // frames the scan picked out
+    uint64_t beacons = 0;
+    uint64_t eapol = 0;        // kept: messages of a usable pair
+    uint64_t pmkids = 0;
+    uint64_t wep = 0;
+    uint64_t handshakes = 0;   // message pairs
+    uint64_t unnamed = 0;      // pairs and PMKIDs whose BSS never gave its ESSID: no 22000 line
+};
+
+// Reduces captures to the frames a crack needs: the beacon or probe
+// response naming each BSS, EAPOL messages that pair into a crackable
+// handshake, M1s carrying a PMKID and, optionally, one WEP frame per IV.
+// Captures stay mapped until the strip is written, so only frame references
+// are held; each is scanned in parallel, or read through its sidecar index.
+class CaptureStrip {
+public:
+    explicit CaptureStrip(const StripOptions& options);
+    ~CaptureStrip();
+
+    bool addCapture(const std::string& path);
+
+    // Minimal pcapng: one interface per input capture and link type, frames
+    // in timestamp order and the key-material index
+    bool writePcapng(const std::string& path);
+    // hashcat 22000 lines; WEP frames have no place there
+    bool writeHashes(const std::string& path);
+
+    const StripStats& getStats() const { return stats_; }
+
+private:
+    CaptureStrip(const CaptureStrip&) = delete;
+    CaptureStrip& operator=(const CaptureStrip&) = delete;
+
+    struct Frame {
+        CaptureFrame frame;
+        size_t capture;              // index into captures_
+    };
+
+    struct KeyMessage {
+        Frame source;
+        int message_number;
+        uint64_t replay_counter;
+    };
+
+    // A crackable pair: the M2 carrying the MIC and the M1 or M3 carrying the ANonce
+    struct Handshake {
+        MacAddress ap_mac;
+        const KeyMessage* eapol;
+        const KeyMessage* anonce;
+        uint8_t message_pair;        // hashcat MESSAGEPAIR
+    };
+
+    struct Pmkid {
+        Frame source;
+        MacAddress ap_mac;
+        MacAddress client_mac;
+        std::vector<uint8_t> pmkid;
+    };
+
+    void selectFrame(const Frame& frame);
+    void pairHandshakes();
+    // Frames to write, in timestamp order
+    std::vector<std::pair<const Frame*, IndexedFrameKind>> selection();
+    bool wanted(const MacAddress& bssid) const;
+
+    StripOptions options_;
+    bool filtered_;
+    MacAddress target_;
+    StripStats stats_;
+
+    std::vector<std::unique_ptr<CaptureReader>> captures_;
+    std::vector<std::string> paths_;
+
+    std::map<MacAddress, Frame> beacons_;                  // first naming each BSS
+    std::map<MacAddress, std::string> essids_;
+    std::map<std::pair<MacAddress, MacAddress>, std::vector<KeyMessage>> messages_;   // by AP, station
+    std::vector<Pmkid> pmkids_;
+    std::map<MacAddress, std::set<uint32_t>> wep_ivs_;
+    std::vector<Frame> wep_frames_;
+
+    std::vector<Handshake> handshakes_;
+    bool paired_;
+
+    FrameDispatcher dispatcher_;
+    PacketParser parser_;
+    std::vector<uint8_t> unpadded_;   // last frame whose data pad was removed
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CAPTURE_STRIP_H
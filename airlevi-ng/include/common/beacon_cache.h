@@ -0,0 +1,72 @@
+#ifndef AIRLEVI_BEACON_CACHE_H
+#define AIRLEVI_BEACON_CACHE_H
+
+#include "types.h"
+#include "frame_views.h"
+#include <cstdint>
+#include <unordered_map>
+
+namespace airlevi {
+
+// Last decoded beacon of every BSS. An AP repeats the same elements about
+// ten times a second, only its timestamp and TIM changing, so beacons are
+// keyed by a hash of their stable bytes and the elements are decoded again
+// only when that hash changes. Not thread-safe: one cache per capture thread.
+// Past max_entries BSSes, e.g. under a beacon flood, the quarter heard from
+// least recently is dropped.
+class BeaconCache {
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 4096;
+
+    explicit BeaconCache(size_t max_entries = DEFAULT_MAX_ENTRIES)
+        : max_entries_(max_entries > 0 ? max_entries : 1), hits_(0), misses_(0), evictions_(0) {}
+
+    // Network for the beacon's BSS. On a hit only last_seen, signal_strength
+    // and packets_captured move; changed is set when the elements were
+    // decoded, for a new BSS or one whose beacon changed.
+    const WifiNetwork& update(const BeaconView& beacon, const RadiotapInfo& radiotap, bool& changed);
+
+    // Capabilities, beacon interval and every element except the TIM and
+    // BSS Load, which change from one beacon to the next
+    static uint64_t stableHash(const BeaconView& beacon);
+
+    size_t size() const { return entries_.size(); }
+    uint64_t getHits() const { return hits_; }
+    uint64_t getMisses() const { return misses_; }
+    uint64_t getEvictions() const { return evictions_; }
+    void clear() { entries_.clear(); }
+
+private:
+    // Where the volatile elements sat: gap[i] bytes of stable elements,
+    // then element id[i], in order of appearance
+    struct Layout {
+        uint8_t count;
+        uint8_t id[2];
+        uint16_t gap[2];
+    };
+
+    struct Entry {
+        uint64_t hash;
+        Layout layout;
+        WifiNetwork network;
+    };
+
+    // Full walk, recording the layout
+    static uint64_t stableHash(const BeaconView& beacon, Layout& layout);
+    // Same hash without a walk; false when the layout no longer fits
+    static bool stableHash(const BeaconView& beacon, const Layout& layout, uint64_t& hash);
+
+    // Drops the entries with the oldest last_seen, so a full cache costs
+    // one pass per quarter of its size rather than one per new BSS
+    void evictOldest();
+
+    std::unordered_map<uint64_t, Entry> entries_;   // BSSID packed in 48 bits
+    size_t max_entries_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t evictions_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_BEACON_CACHE_H
@@ -0,0 +1,157 @@
+#ifndef AIRLEVI_CAPTURE_READER_H
+#define AIRLEVI_CAPTURE_READER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Link types we decode (LINKTYPE_* values)
+constexpr uint32_t LINKTYPE_IEEE802_11 = 105;
+constexpr uint32_t LINKTYPE_IEEE802_11_RADIOTAP = 127;
+
+// scanParallel() gives no worker a byte range smaller than this by default
+constexpr uint64_t SCAN_MIN_RANGE_BYTES = 16ULL << 20;
+
+// pcapng files written by airlevi end with a custom block (no-copy, since
+// it holds file offsets) listing where the key material is. The enterprise
+// number is IANA's documentation one; the magic tells the block apart.
+constexpr uint32_t PCAPNG_INDEX_PEN = 32473;
+constexpr uint32_t PCAPNG_INDEX_MAGIC = 0x58494c41;   // "ALIX"
+constexpr uint32_t PCAPNG_INDEX_VERSION = 1;
+
+enum class IndexedFrameKind : uint8_t {
+    NONE = 0,
+    EAPOL = 1,     // EAPOL-Key of a 4-way handshake
+    PMKID = 2,     // message 1 carrying a PMKID
+    BEACON = 3     // first beacon naming each BSS
+};
+
+struct IndexedFrame {
+    uint64_t offset;         // of the Enhanced Packet Block
+    IndexedFrameKind kind;
+};
+
+// One captured frame. data points into the reader's mapping and stays valid
+// until the reader is closed.
+struct CaptureFrame {
+    uint64_t timestamp_ns;   // since the epoch
+    uint32_t link_type;
+    const uint8_t* data;
+    uint32_t caplen;
+    uint32_t len;            // original length on the wire
+    uint64_t offset;         // file offset of the record
+    uint32_t interface_id;   // pcapng interface within its section, 0 for pcap
+};
+
+enum class CaptureFormat {
+    PCAP,
+    PCAPNG
+};
+
+// Memory-mapped reader for pcap (either byte order, micro- or nanosecond)
+// and pcapng (any number of sections and interfaces)
+class CaptureReader {
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return map_ != nullptr; }
+
+    CaptureFormat getFormat() const { return format_; }
+    uint64_t getSize() const { return size_; }
+
+    // Link type of the first interface
+    uint32_t getLinkType() const { return link_type_; }
+
+    // Next frame in file order; false at the end or on a truncated record
+    bool next(CaptureFrame& frame);
+    void rewind();
+
+    // The trailing index block of a pcapng file written by airlevi; false
+    // when there is none, e.g. because the capture was cut short
+    bool readFrameIndex(std::vector<IndexedFrame>& frames) const;
+
+    // The frame whose record starts at offset, as listed by the pcapng or a
+    // sidecar index
+    bool frameAt(uint64_t offset, CaptureFrame& frame) const;
+
+    // Frames for which keep() returns true, merged in timestamp order (file
+    // order for equal timestamps). Files of at least two min_range_bytes are
+    // split into byte ranges that up to `threads` workers scan concurrently,
+    // so keep() must be thread-safe. The sequential position is left untouched.
+    std::vector<CaptureFrame> scanParallel(int threads, const std::function<bool(const CaptureFrame&)>& keep,
+                                           uint64_t min_range_bytes = SCAN_MIN_RANGE_BYTES) const;
+
+    // 802.11 header and length of a frame, past any radiotap header and
+    // without a trailing FCS. A radiotap data pad is removed into scratch,
+    // which data then points into: frames held at once need one each.
+    static bool ieee80211Frame(const CaptureFrame& frame, const uint8_t*& data, uint32_t& length,
+                               std::vector<uint8_t>& scratch);
+
+private:
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    struct Interface {
+        uint32_t link_type;
+        bool binary_resolution;   // if_tsresol: 2^-exponent instead of 10^-exponent
+        uint8_t exponent;
+
+        bool operator==(const Interface& other) const {
+            return link_type == other.link_type && binary_resolution == other.binary_resolution &&
+                   exponent == other.exponent;
+        }
+    };
+
+    // Everything needed to decode from a record boundary onwards; the
+    // sequential reader and every parallel worker each own one
+    struct Cursor {
+        uint64_t pos;
+        bool swapped;
+        std::vector<Interface> interfaces;   // pcapng, current section
+
+        bool operator==(const Cursor& other) const {
+            return pos == other.pos && swapped == other.swapped && interfaces == other.interfaces;
+        }
+    };
+
+    // Frames from records starting before limit
+    bool nextFrame(Cursor& cursor, uint64_t limit, CaptureFrame& frame) const;
+    bool nextPcap(Cursor& cursor, uint64_t limit, CaptureFrame& frame) const;
+    bool nextPcapng(Cursor& cursor, uint64_t limit, CaptureFrame& frame) const;
+    bool readSectionHeader(Cursor& cursor) const;
+    bool readInterface(Cursor& cursor, const uint8_t* body, uint32_t body_length) const;
+    uint64_t toNanoseconds(const Interface& iface, uint64_t units) const;
+
+    // First offset in [from, end) where a chain of plausible records starts
+    bool resync(Cursor& cursor, uint64_t from, uint64_t end) const;
+    bool plausiblePcapChain(uint64_t pos, bool swapped) const;
+    bool plausiblePcapngChain(uint64_t pos, bool swapped) const;
+    void scanRange(Cursor& cursor, uint64_t end, const std::function<bool(const CaptureFrame&)>& keep,
+                   std::vector<CaptureFrame>& frames) const;
+
+    std::string path_;
+    int fd_;
+    const uint8_t* map_;
+    uint64_t size_;
+    uint64_t first_record_;
+
+    CaptureFormat format_;
+    bool nanosecond_;              // pcap only
+    uint32_t snaplen_;             // pcap only
+    uint32_t first_second_;        // pcap only, timestamp of the first record
+    uint32_t link_type_;           // pcap header, or first pcapng interface
+
+    Cursor cursor_;                // sequential position
+    Cursor start_;                 // state at the first record
+    Cursor head_;                  // pcapng: first section's interfaces, at its first packet
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CAPTURE_READER_H
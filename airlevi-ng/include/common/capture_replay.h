@@ -0,0 +1,82 @@
+#ifndef AIRLEVI_CAPTURE_REPLAY_H
+#define AIRLEVI_CAPTURE_REPLAY_H
+
+#include "capture_reader.h"
+#include "capture_stats.h"
+#include "ring_capture.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace airlevi {
+
+struct ReplayOptions {
+    std::string path;                // capture to play instead of a live interface; empty for none
+    double speed = 0;                // 0 as fast as frames are taken, 1 at recorded timing, 2 twice as fast...
+    size_t batch_frames = 256;       // at most this many frames per handler call
+};
+
+// Plays a capture file into the batch handler of a live source, so offline
+// analysis goes through the same pipeline as a capture. Frames come in file
+// order from one thread, as worker 0, with their recorded timestamps:
+// either as fast as the handler takes them or paced by the gaps between
+// those timestamps, scaled by the speed. A pipeline decodes one link type,
+// so frames of other pcapng interfaces are skipped.
+class CaptureReplay {
+public:
+    using BatchHandler = RingCapture::BatchHandler;
+
+    CaptureReplay();
+    ~CaptureReplay();
+
+    bool open(const ReplayOptions& options);
+    void close();
+    bool isOpen() const { return reader_.isOpen(); }
+
+    // DLT_* of the capture's first interface
+    int getLinkType() const { return static_cast<int>(reader_.getLinkType()); }
+
+    bool start(BatchHandler handler);
+    void stop();
+
+    // Every frame has been handed over
+    bool isFinished() const { return finished_; }
+
+    // Frames handed over count as received; any thread
+    CaptureCounters getCounters() const;
+    uint64_t getSkipped() const { return skipped_; }
+    // From start() to the last frame, or until now while playing
+    double getElapsedSeconds() const;
+
+private:
+    CaptureReplay(const CaptureReplay&) = delete;
+    CaptureReplay& operator=(const CaptureReplay&) = delete;
+
+    void replayLoop(BatchHandler handler);
+    // Sleeps until due; false once stop() was called
+    bool waitUntil(std::chrono::steady_clock::time_point due);
+
+    ReplayOptions options_;
+    CaptureReader reader_;
+
+    std::thread thread_;
+    std::mutex stop_mutex_;
+    std::condition_variable stop_wake_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> playing_;
+    std::atomic<bool> finished_;
+
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint64_t> skipped_;
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<int64_t> elapsed_ns_;    // set when finished
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CAPTURE_REPLAY_H
@@ -0,0 +1,75 @@
+#ifndef AIRLEVI_CAPTURE_STATS_H
+#define AIRLEVI_CAPTURE_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+
+namespace airlevi {
+
+// Counters of a capture source, cumulative since it was opened
+struct CaptureCounters {
+    uint64_t received = 0;            // reached the capture socket
+    uint64_t dropped = 0;             // no room left in the socket buffer or ring
+    uint64_t interface_dropped = 0;   // dropped by the driver before the socket
+};
+
+// Log-linear latency histogram in the manner of HdrHistogram: exact below
+// 64 ns, then 32 linear sub-buckets per power of two (about 3% error) up to
+// the full 64-bit range. Recording is lock-free and may come from any
+// thread; readers see a slightly moving snapshot.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+    void reset();
+
+    uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the percentile (0-100), in ns
+    uint64_t getPercentile(double percentile) const;
+
+    // "p50 1.2ms p99 8.4ms p99.9 31ms max 40ms", or "-" before any sample
+    std::string summary() const;
+    static std::string formatNanoseconds(uint64_t nanoseconds);
+
+private:
+    static const int SUB_BUCKET_BITS = 6;
+    static const size_t LINEAR = size_t(1) << SUB_BUCKET_BITS;
+    static const size_t HALF = LINEAR / 2;
+    static const size_t BUCKETS = LINEAR + (64 - SUB_BUCKET_BITS) * HALF;
+
+    static size_t indexFor(uint64_t value);
+    static uint64_t highestValueAt(size_t index);
+
+    std::atomic<uint64_t> counts_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> max_;
+};
+
+// Frames are stamped with wall-clock time by the kernel or libpcap
+uint64_t nanosecondsSince(const struct timeval& timestamp);
+
+// True for one call in LATENCY_SAMPLE_EVERY on the calling thread, so the
+// per-frame cost of measuring latency is one increment
+const uint32_t LATENCY_SAMPLE_EVERY = 64;
+bool latencySampleDue();
+
+// rx_dropped of a network interface, from sysfs; 0 when unavailable
+uint64_t readInterfaceDrops(const std::string& interface);
+
+class ProgressEvent;
+
+// Fields of the capture tools' "stats" progress event: kernel counters,
+// ring backlog and latency percentiles in nanoseconds
+void addCaptureFields(ProgressEvent& event, const CaptureCounters& counters, const std::vector<size_t>& backlog,
+                      const LatencyHistogram& frame_latency, const LatencyHistogram& handshake_latency);
+
+} // namespace airlevi
+
+#endif // AIRLEVI_CAPTURE_STATS_H
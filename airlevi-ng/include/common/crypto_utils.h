@@ -8,6 +8,10 @@
 
 namespace airlevi {
 
+// MIC field position inside an EAPOL-Key frame (from the EAPOL header)
+constexpr size_t EAPOL_MIC_OFFSET = 81;
+constexpr size_t EAPOL_MIC_LENGTH = 16;
+
 class CryptoUtils {
 public:
     CryptoUtils();
@@ -26,11 +30,26 @@ public:
                                            const MacAddress& client_mac,
                                            const std::vector<uint8_t>& anonce,
                                            const std::vector<uint8_t>& snonce);
+    // KDF-SHA256 PTK used by key descriptor version 3 (802.11w / SHA256 AKMs)
+    static std::vector<uint8_t> generatePTKSha256(const std::vector<uint8_t>& pmk,
+                                                 const MacAddress& ap_mac,
+                                                 const MacAddress& client_mac,
+                                                 const std::vector<uint8_t>& anonce,
+                                                 const std::vector<uint8_t>& snonce);
+    static std::vector<uint8_t> buildPTKData(const MacAddress& ap_mac,
+                                            const MacAddress& client_mac,
+                                            const std::vector<uint8_t>& anonce,
+                                            const std::vector<uint8_t>& snonce);
     
     // MIC verification
     static bool verifyMIC(const HandshakePacket& handshake, const std::vector<uint8_t>& ptk);
     static std::vector<uint8_t> calculateMIC(const std::vector<uint8_t>& kck, 
-                                            const std::vector<uint8_t>& eapol_data);
+                                            const std::vector<uint8_t>& eapol_data,
+                                            KeyDescriptorVersion version = KeyDescriptorVersion::HMAC_MD5_RC4);
+    static std::vector<uint8_t> aesCmac(const std::vector<uint8_t>& key,
+                                       const std::vector<uint8_t>& data);
+    // AES-128-CMAC into a 16-byte mac, through a context kept per thread
+    static bool aesCmac(const uint8_t* key, const uint8_t* data, size_t length, uint8_t* mac);
 
     // Hash functions
     static std::vector<uint8_t> md5Hash(const std::vector<uint8_t>& data);
@@ -53,6 +72,12 @@ private:
                                    const std::vector<uint8_t>& data,
                                    size_t output_length);
     
+    // IEEE 802.11 KDF (HMAC-SHA256 in counter mode)
+    static std::vector<uint8_t> kdfSha256(const std::vector<uint8_t>& key,
+                                         const std::string& label,
+                                         const std::vector<uint8_t>& data,
+                                         size_t output_length);
+    
     // HMAC-SHA1
     static std::vector<uint8_t> hmacSha1(const std::vector<uint8_t>& key, 
                                         const std::vector<uint8_t>& data);
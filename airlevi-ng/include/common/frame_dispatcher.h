@@ -0,0 +1,57 @@
+#ifndef AIRLEVI_FRAME_DISPATCHER_H
+#define AIRLEVI_FRAME_DISPATCHER_H
+
+#include "types.h"
+#include <cstdint>
+#include <functional>
+
+namespace airlevi {
+
+// What a frame is, decided once from its frame control field. Data frames
+// carrying EAPOL and authentication frames using SAE get their own class.
+enum class FrameClass : uint8_t {
+    OTHER,
+    ASSOC_REQUEST,
+    ASSOC_RESPONSE,
+    REASSOC_REQUEST,
+    REASSOC_RESPONSE,
+    PROBE_REQUEST,
+    PROBE_RESPONSE,
+    BEACON,
+    DISASSOCIATION,
+    AUTHENTICATION,
+    SAE,
+    DEAUTHENTICATION,
+    ACTION,
+    CONTROL,
+    DATA,
+    NULL_DATA,
+    EAPOL,
+    COUNT
+};
+
+// Frame-control-indexed dispatch shared by the capture tools: each frame is
+// classified once and handed to the single handler registered for its class
+class FrameDispatcher {
+public:
+    using Handler = std::function<void(const uint8_t* frame, int length, const RadiotapInfo& radiotap)>;
+
+    FrameDispatcher();
+
+    void on(FrameClass frame_class, Handler handler);
+
+    FrameClass classify(const uint8_t* frame, int length) const;
+
+    // Classify and run the matching handler, if any
+    FrameClass dispatch(const uint8_t* frame, int length, const RadiotapInfo& radiotap) const;
+
+private:
+    // Indexed by the first frame control byte without its version bits:
+    // subtype << 2 | type
+    FrameClass table_[64];
+    Handler handlers_[static_cast<size_t>(FrameClass::COUNT)];
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_FRAME_DISPATCHER_H
@@ -0,0 +1,143 @@
+#ifndef AIRLEVI_FRAME_INDEX_H
+#define AIRLEVI_FRAME_INDEX_H
+
+#include "capture_reader.h"
+#include "frame_dispatcher.h"
+#include "packet_parser.h"
+#include "types.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace airlevi {
+
+// Sidecar index kept next to a capture ("capture.cap.alxi"): a header, one
+// fixed-size entry per frame in file order, then posting lists of the frames
+// the offline tools look for. Written in host byte order; a foreign one
+// fails the magic check and the index is simply not used.
+constexpr uint32_t SIDECAR_INDEX_MAGIC = 0x49584c41;   // "ALXI"
+constexpr uint32_t SIDECAR_INDEX_VERSION = 1;
+
+enum class FramePosting : uint8_t {
+    EAPOL,         // EAPOL-Key of a 4-way handshake
+    PMKID,         // message 1 carrying a PMKID, also listed under EAPOL
+    BEACON,        // beacon or probe response naming a BSS for the first time
+    WEP_DATA,      // WEP-encrypted data, for the statistical attacks
+    COUNT
+};
+
+struct FrameIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capture_size;       // of the capture the index was built from
+    uint64_t frame_count;
+    uint64_t posting_counts[static_cast<size_t>(FramePosting::COUNT)];
+    uint64_t reserved;
+};
+
+struct FrameIndexEntry {
+    uint64_t offset;             // of the record in the capture
+    uint64_t timestamp_ns;
+    uint32_t bssid_hash;         // 0 when the frame names no BSS
+    uint32_t station_hash;       // 0 when it names no unicast station
+    uint16_t frame_control;      // type and subtype, flags
+    uint8_t postings;            // bit (1 << FramePosting) per list holding the frame
+    uint8_t reserved;
+    uint32_t caplen;
+};
+
+static_assert(sizeof(FrameIndexHeader) == 64, "sidecar header layout");
+static_assert(sizeof(FrameIndexEntry) == 32, "sidecar entry layout");
+
+// Builds a sidecar from frames fed in file order. Entries stream to a
+// temporary file; only the posting lists stay in memory, so captures of any
+// size can be indexed. The sidecar appears under its name once complete.
+// Not thread-safe.
+class FrameIndexBuilder {
+public:
+    FrameIndexBuilder();
+    ~FrameIndexBuilder();
+
+    bool open(const std::string& capture_path);
+    void add(const CaptureFrame& frame);
+    // Once the capture itself is complete, since the sidecar records its length
+    bool close();
+    // Drops what was built so far
+    void discard();
+    bool isOpen() const { return file_ != nullptr; }
+
+    uint64_t getFrameCount() const { return frame_count_; }
+    uint64_t getPostingCount(FramePosting list) const { return postings_[static_cast<size_t>(list)].size(); }
+
+private:
+    FrameIndexBuilder(const FrameIndexBuilder&) = delete;
+    FrameIndexBuilder& operator=(const FrameIndexBuilder&) = delete;
+
+    uint8_t classify(const uint8_t* frame, int length);
+
+    FILE* file_;
+    std::string path_;
+    std::string temp_path_;
+    uint64_t frame_count_;
+    std::vector<uint64_t> postings_[static_cast<size_t>(FramePosting::COUNT)];
+
+    // SSID hash each BSS was last named with, so repeated beacons are not listed
+    std::unordered_map<uint64_t, uint64_t> named_bss_;
+    FrameDispatcher dispatcher_;
+    PacketParser parser_;
+    std::vector<uint8_t> unpadded_;   // last frame whose data pad was removed
+};
+
+// Memory-mapped sidecar of a capture
+class FrameIndex {
+public:
+    FrameIndex();
+    ~FrameIndex();
+
+    // False when the capture has no sidecar, or one that was built for a
+    // different capture or an earlier length of this one
+    bool open(const std::string& capture_path, const CaptureReader& reader);
+    void close();
+    bool isOpen() const { return map_ != nullptr; }
+
+    uint64_t size() const { return header_ ? header_->frame_count : 0; }
+    const FrameIndexEntry& entry(uint64_t number) const { return entries_[number]; }
+
+    // Entry numbers in one posting list, in file order
+    const uint64_t* posting(FramePosting list, uint64_t& count) const;
+
+    // Capture offsets of the frames on the lists in mask (bits of
+    // 1 << FramePosting) whose BSSID hashes like bssid, or of all of them
+    // when bssid is null. A hash can collide: callers still check the frame.
+    std::vector<uint64_t> find(uint8_t mask, const MacAddress* bssid = nullptr) const;
+
+    static std::string sidecarPath(const std::string& capture_path);
+    // FNV-1a of the six bytes, never 0
+    static uint32_t hashAddress(const uint8_t* address);
+
+private:
+    FrameIndex(const FrameIndex&) = delete;
+    FrameIndex& operator=(const FrameIndex&) = delete;
+
+    const uint8_t* map_;
+    uint64_t size_;
+    const FrameIndexHeader* header_;
+    const FrameIndexEntry* entries_;
+    const uint64_t* postings_[static_cast<size_t>(FramePosting::COUNT)];
+};
+
+inline uint8_t postingMask(FramePosting list) {
+    return static_cast<uint8_t>(1u << static_cast<unsigned>(list));
+}
+
+// Frames on the lists in mask, in file order, through the sidecar of an open
+// capture; only those of bssid ("aa:bb:cc:dd:ee:ff") when it is not empty.
+// False when there is no usable sidecar and the capture has to be scanned.
+bool loadIndexedFrames(const std::string& capture_path, const CaptureReader& reader, uint8_t mask,
+                       const std::string& bssid, std::vector<CaptureFrame>& frames);
+
+} // namespace airlevi
+
+#endif // AIRLEVI_FRAME_INDEX_H
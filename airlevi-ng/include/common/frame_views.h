@@ -0,0 +1,85 @@
+#ifndef AIRLEVI_FRAME_VIEWS_H
+#define AIRLEVI_FRAME_VIEWS_H
+
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+// Views point into the buffer a frame was parsed from and stay valid only
+// as long as it does. Every range has been bounds-checked by the parser;
+// materialize() copies out what a consumer wants to keep.
+
+struct ByteView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    bool empty() const { return size == 0; }
+    std::vector<uint8_t> toVector() const { return std::vector<uint8_t>(data, data + size); }
+    std::string toString() const { return std::string(reinterpret_cast<const char*>(data), size); }
+};
+
+// EAPOL-Key frame of the 4-way handshake
+struct EapolKeyView {
+    MacAddress ap_mac;
+    MacAddress client_mac;
+    int message_number;        // 1-4, 0 if the key info matches none
+    KeyDescriptorVersion key_version;
+    uint16_t key_info;
+    uint64_t replay_counter;
+    ByteView eapol;            // EAPOL header and body, as covered by the MIC
+    ByteView nonce;            // ANonce on M1/M3, SNonce on M2/M4
+    ByteView mic;              // empty unless the MIC flag is set
+    ByteView key_data;
+
+    void materialize(HandshakePacket& handshake) const;
+
+    // PMKID KDE (00-0F-AC type 4) in the plaintext key data of message 1
+    bool findPMKID(ByteView& pmkid) const;
+};
+
+// Beacon or probe response
+struct BeaconView {
+    MacAddress bssid;
+    uint16_t beacon_interval;
+    uint16_t capabilities;
+    bool has_ssid;             // SSID element present
+    ByteView ssid;             // empty when hidden
+    ByteView ies;              // all information elements
+
+    // Fills the ESSID, channel and encryption from the elements
+    void materialize(WifiNetwork& network) const;
+};
+
+// SAE authentication, transaction sequence 1
+struct SaeCommitView {
+    MacAddress ap_mac;
+    MacAddress client_mac;
+    uint16_t status;
+    uint16_t group;
+    ByteView token;            // anti-clogging token, when one precedes the scalar
+    ByteView scalar;           // empty for groups we do not know the sizes of
+    ByteView element;
+    ByteView body;             // everything after the group
+
+    void materialize(SAEHandshakePacket& sae_packet) const;
+};
+
+// SAE authentication, transaction sequence 2
+struct SaeConfirmView {
+    MacAddress ap_mac;
+    MacAddress client_mac;
+    uint16_t status;
+    uint16_t send_confirm;
+    ByteView confirm;
+    ByteView body;             // send-confirm and confirm
+
+    void materialize(SAEHandshakePacket& sae_packet) const;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_FRAME_VIEWS_H
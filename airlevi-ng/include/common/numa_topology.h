@@ -0,0 +1,39 @@
+#ifndef AIRLEVI_NUMA_TOPOLOGY_H
+#define AIRLEVI_NUMA_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+namespace airlevi {
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// NUMA layout read from sysfs. Machines without /sys/devices/system/node
+// report a single node holding every CPU.
+class NumaTopology {
+public:
+    NumaTopology();
+
+    const std::vector<NumaNode>& getNodes() const { return nodes_; }
+    size_t getNodeCount() const { return nodes_.size(); }
+    bool isMultiNode() const { return nodes_.size() > 1; }
+
+    // Split a worker count across nodes in proportion to their CPU count
+    std::vector<int> distributeThreads(int num_threads) const;
+
+    // Restrict the calling thread to the CPUs of one node. Memory the thread
+    // touches first is then allocated on that node by the kernel.
+    bool bindCurrentThread(size_t node_index) const;
+
+    static std::vector<int> parseCpuList(const std::string& list);
+
+private:
+    std::vector<NumaNode> nodes_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_NUMA_TOPOLOGY_H
@@ -2,6 +2,7 @@
 #define AIRLEVI_PACKET_PARSER_H
 
 #include "types.h"
+#include "frame_views.h"
 #include <pcap.h>
 
 namespace airlevi {
@@ -18,11 +19,39 @@ public:
     bool parseDeauthFrame(const uint8_t* packet, int length, MacAddress& src, MacAddress& dst);
     bool parseSAEFrame(const uint8_t* packet, int length, SAEHandshakePacket& sae_packet);
     
+    // Same frames as views into the packet buffer: bounds-checked, no copies
+    bool parseBeaconFrame(const uint8_t* packet, int length, BeaconView& beacon);
+    bool parseEAPOLFrame(const uint8_t* packet, int length, EapolKeyView& eapol);
+    bool parseSAEFrame(const uint8_t* packet, int length, SaeCommitView& commit);
+    bool parseSAEFrame(const uint8_t* packet, int length, SaeConfirmView& confirm);
+
+    // Radiotap header in front of a monitor-mode frame. The field layout of
+    // the last header seen is cached per slot (one per capture interface),
+    // so frames repeating its present bitmaps skip the walk. Slots past
+    // MAX_RADIOTAP_SLOTS share the last one.
+    bool parseRadiotap(const uint8_t* packet, int length, RadiotapInfo& info, size_t slot = 0);
+    static bool decodeRadiotap(const uint8_t* packet, int length, RadiotapInfo& info);
+
+    // 802.11 frame behind a DLT_IEEE802_11 or DLT_IEEE802_11_RADIOTAP header,
+    // without any trailing FCS. info, when given, receives the radiotap fields;
+    // slot is the capture interface, as for parseRadiotap(). When radiotap
+    // flags a data pad, frame points to a copy without it, valid until the
+    // next call.
+    bool ieee80211Frame(const uint8_t* packet, int length, int link_type,
+                        const uint8_t*& frame, int& frame_length, RadiotapInfo* info = nullptr, size_t slot = 0);
+    // Drops the pad radiotap's data-pad flag puts between the MAC header and
+    // the body: frame then points into unpadded, which holds the copy
+    static void removeDataPad(const uint8_t*& frame, int& frame_length, std::vector<uint8_t>& unpadded);
+    static int frequencyToChannel(int frequency);
+    
     // Extract information elements from beacon frames
     std::string extractSSID(const uint8_t* ie_data, int ie_length);
     int extractChannel(const uint8_t* ie_data, int ie_length);
     EncryptionType extractEncryption(const uint8_t* ie_data, int ie_length);
     
+    // DS channel and encryption from a single walk over the elements
+    void extractBeaconElements(const uint8_t* ie_data, int ie_length, int& channel, EncryptionType& encryption);
+    
     // Utility functions
     bool isBeaconFrame(const uint8_t* packet);
     bool isDataFrame(const uint8_t* packet);
@@ -30,12 +59,47 @@ public:
     bool isDeauthFrame(const uint8_t* packet);
     bool isSAEFrame(const uint8_t* packet);
     
+    // MAC header length, including addr4, QoS control and HT control when present
+    static int ieee80211HeaderLength(const uint8_t* packet);
+
+    // Protected data frame carrying a WEP IV and key ID: TKIP and CCMP set
+    // the Extended IV bit of the key ID octet, WEP leaves it clear
+    static bool isWEPDataFrame(const uint8_t* packet, int length);
+    
     // Frame validation
     bool validateFrameChecksum(const uint8_t* packet, int length);
     bool isFromDS(const uint8_t* packet);
     bool isToDS(const uint8_t* packet);
 
 private:
+    static constexpr size_t MAX_RADIOTAP_KEY = 2 + 4 * 8;   // it_len and up to 8 present words
+    static constexpr size_t MAX_RADIOTAP_SLOTS = 64;
+
+    // Offsets of the radiotap fields we read, 0 when absent: fields start
+    // past the 8-byte fixed header
+    struct RadiotapLayout {
+        uint8_t key[MAX_RADIOTAP_KEY];
+        uint8_t key_length;            // 0: nothing cached
+        uint16_t header_length;
+        uint16_t flags;
+        uint16_t rate;
+        uint16_t channel;
+        uint16_t xchannel;
+        uint16_t signal;
+    };
+
+    static bool parseSAEHeader(const uint8_t* packet, int length, uint16_t sequence,
+                               MacAddress& ap_mac, MacAddress& client_mac, uint16_t& status,
+                               const uint8_t*& body, int& body_length);
+    static bool saeGroupSizes(uint16_t group, size_t& scalar_length, size_t& element_length);
+    static bool elementsSpanExactly(const uint8_t* data, size_t length);
+
+    static bool walkRadiotap(const uint8_t* packet, int length, RadiotapLayout& layout, bool& cacheable);
+    static void readRadiotap(const uint8_t* packet, const RadiotapLayout& layout, RadiotapInfo& info);
+
+    std::vector<RadiotapLayout> radiotap_cache_;
+    std::vector<uint8_t> unpadded_;   // last frame whose data pad was removed
+
     // Helper functions for parsing information elements
     const uint8_t* findInformationElement(const uint8_t* ie_data, int ie_length, uint8_t element_id);
     bool parseRSNInformation(const uint8_t* rsn_data, int rsn_length, EncryptionType& encryption);
@@ -0,0 +1,159 @@
+#ifndef AIRLEVI_PCAP_WRITER_H
+#define AIRLEVI_PCAP_WRITER_H
+
+#include "capture_reader.h"
+#include "frame_index.h"
+#include <pcap.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+
+namespace airlevi {
+
+// One capture source; pcapng gives each an Interface Description Block
+struct CaptureInterface {
+    std::string name;                // if_name
+    std::string description;         // if_description, e.g. the channel setting
+    int link_type = DLT_IEEE802_11_RADIO;
+    uint32_t snaplen = 65535;
+};
+
+struct PcapWriterOptions {
+    CaptureFormat format = CaptureFormat::PCAP;
+    std::string application;         // pcapng section: shb_userappl
+    std::string comment;             // pcapng section: session details
+    size_t queue_mb = 32;            // ring between the capture threads and the writer
+    size_t batch_kb = 1024;          // the writer is woken once this much is queued...
+    int flush_interval_ms = 500;     // ...and writes whatever is queued at least this often
+    uint64_t rotate_size_mb = 0;     // start a new file past this size; 0 never
+    int rotate_seconds = 0;          // start a new file after this long; 0 never
+    bool direct_io = false;          // O_DIRECT, bypassing the page cache
+    bool sidecar_index = false;      // index every file into "<file>.alxi" as it is written
+    bool wait_when_full = false;     // offline writers: write() waits for room instead of dropping
+};
+
+// pcap/pcapng writer that keeps the disk off the capture threads. write()
+// copies the record, already in file format, into a lock-free ring shared
+// by all producers and never blocks: when the ring is full the record is
+// dropped and counted. Records are published in the order their space was
+// reserved, so the committed part of the ring is the file's byte stream and
+// a writer thread hands it to the kernel in a few large writev() calls.
+// Tools that write from a file rather than the air can have write() wait
+// for the disk instead.
+// Classic pcap has room for one link type only, so it takes the first
+// interface's; pcapng files also end with an index of the key material.
+class PcapWriter {
+public:
+    PcapWriter();
+    ~PcapWriter();
+
+    bool open(const std::string& path, const std::vector<CaptureInterface>& interfaces,
+              const PcapWriterOptions& options = PcapWriterOptions());
+    bool open(const std::string& path, int link_type, const PcapWriterOptions& options = PcapWriterOptions());
+    // Writes out everything queued, then closes the file
+    void close();
+    bool isOpen() const { return open_; }
+
+    // Any thread; false when the record was dropped. The kind lists the
+    // frame in the pcapng index.
+    bool write(const struct pcap_pkthdr* header, const uint8_t* data, uint32_t interface_id = 0,
+               IndexedFrameKind kind = IndexedFrameKind::NONE);
+
+    // Whether write() does anything with its kind argument
+    bool isIndexing() const { return open_ && options_.format == CaptureFormat::PCAPNG; }
+
+    // Has the writer write out everything queued so far; does not wait
+    void flush();
+
+    uint64_t getQueued() const { return queued_; }
+    uint64_t getDropped() const { return dropped_; }
+    int getFileCount() const { return file_count_; }
+
+    // "capture.cap" -> "capture-00002.cap"
+    static std::string rotatedPath(const std::string& path, int index);
+
+private:
+    PcapWriter(const PcapWriter&) = delete;
+    PcapWriter& operator=(const PcapWriter&) = delete;
+
+    struct RecordHeader {
+        uint32_t ts_sec;
+        uint32_t ts_usec;
+        uint32_t caplen;
+        uint32_t len;
+    };
+
+    void writerLoop();
+    void drain();
+    bool openFile();
+    void closeFile();
+    bool rotationDue() const;
+    uint64_t recordLength(uint64_t position) const;
+    uint64_t cutForRotation(uint64_t begin, uint64_t end) const;
+    std::vector<uint8_t> fileHeader() const;
+    void collectIndex(uint64_t begin, uint64_t end, uint64_t file_offset);
+    bool writeIndex();
+    void indexRecords(uint64_t begin, uint64_t end, uint64_t file_offset);
+
+    void copyIn(uint64_t position, const void* data, size_t length);
+    void copyOut(uint64_t position, void* data, size_t length) const;
+    bool writeOut(struct iovec* iov, int count);
+    bool writeStaging(bool pad);
+
+    std::string path_;
+    std::vector<CaptureInterface> interfaces_;
+    PcapWriterOptions options_;
+    std::atomic<bool> open_;
+
+    // Positions only grow; a byte lives at ring_[position & mask_]
+    std::vector<uint8_t> ring_;
+    uint64_t mask_;
+    size_t batch_bytes_;
+    std::atomic<uint64_t> reserve_;   // next byte a producer may claim
+    std::atomic<uint64_t> commit_;    // everything below is complete
+    std::atomic<uint64_t> tail_;      // everything below has been written out
+
+    std::atomic<uint64_t> queued_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<int> file_count_;
+
+    std::thread thread_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> flush_requested_;
+
+    // Ring positions of indexed records, added before they are committed
+    std::mutex index_mutex_;
+    std::vector<std::pair<uint64_t, IndexedFrameKind>> pending_index_;
+
+    // Current file; writer thread only once open() returns
+    std::string file_path_;
+    int fd_;
+    bool direct_;
+    bool failed_;
+    uint64_t file_bytes_;
+    uint64_t header_bytes_;
+    std::chrono::steady_clock::time_point file_opened_;
+    std::vector<IndexedFrame> file_index_;
+    FrameIndexBuilder sidecar_;
+    std::vector<uint8_t> record_copy_;   // a record wrapping around the ring, for sidecar_
+
+    // O_DIRECT wants aligned buffers, lengths and offsets: bytes gather in
+    // an aligned buffer that starts at file offset direct_offset_
+    uint8_t* staging_;
+    size_t staging_size_;
+    size_t staging_used_;
+    uint64_t direct_offset_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_PCAP_WRITER_H
@@ -0,0 +1,46 @@
+#ifndef AIRLEVI_PMKID_INDEX_H
+#define AIRLEVI_PMKID_INDEX_H
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace airlevi {
+
+// PMKIDs bucketed by ESSID, so a derived PMK is checked against every
+// PMKID sharing its salt in one pass. The HMAC key schedule is computed once
+// per PMK, and the per-PMKID "PMK Name" || AA || SPA messages are pre-padded
+// and laid out LANES wide for the multi-lane SHA-1 kernel.
+class PMKIDIndex {
+public:
+    static constexpr int LANES = 8;
+
+    PMKIDIndex() : count_(0) {}
+
+    // Returns the entry id; an identical (ESSID, AP, STA, PMKID) returns the existing one
+    size_t add(const std::string& essid, const MacAddress& ap_mac,
+               const MacAddress& client_mac, const uint8_t* pmkid);
+
+    size_t size() const { return count_; }
+    std::vector<std::string> getESSIDs() const;
+
+    // Append the ids of every PMKID of this ESSID that the PMK produces
+    void match(const std::string& essid, const uint8_t* pmk, std::vector<size_t>& matches) const;
+
+private:
+    struct Bucket {
+        std::unordered_map<std::string, size_t> lookup;   // AP || STA || PMKID -> id
+        std::vector<size_t> ids;
+        std::vector<uint32_t> blocks;     // [group][16][LANES] padded message blocks
+        std::vector<uint32_t> expected;   // [group][4][LANES] PMKID words
+    };
+
+    std::unordered_map<std::string, Bucket> buckets_;
+    size_t count_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_PMKID_INDEX_H
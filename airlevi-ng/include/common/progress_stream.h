@@ -0,0 +1,90 @@
+#ifndef AIRLEVI_PROGRESS_STREAM_H
+#define AIRLEVI_PROGRESS_STREAM_H
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+
+namespace airlevi {
+
+// One NDJSON line: {"event":TYPE,"tool":...,"ts":...,<fields>}
+class ProgressEvent {
+public:
+    explicit ProgressEvent(const std::string& type);
+
+    ProgressEvent& add(const std::string& key, const std::string& value);
+    ProgressEvent& add(const std::string& key, const char* value) { return add(key, std::string(value)); }
+    ProgressEvent& add(const std::string& key, double value);
+    ProgressEvent& add(const std::string& key, bool value) { return raw(key, value ? "true" : "false"); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, ProgressEvent&>::type
+    add(const std::string& key, T value) { return raw(key, std::to_string(value)); }
+
+    const std::string& getType() const { return type_; }
+    const std::string& getFields() const { return fields_; }
+
+    static std::string escape(const std::string& value);
+
+private:
+    std::string type_;
+    std::string fields_;
+
+    ProgressEvent& raw(const std::string& key, const std::string& json);
+};
+
+// Opt-in machine-readable stream for job schedulers. Events are queued and
+// written by a background thread, so emitting never waits on the consumer.
+class ProgressStream {
+public:
+    static ProgressStream& getInstance();
+
+    // "fd:N" writes to an inherited descriptor, anything else is a file path
+    bool open(const std::string& target, const std::string& tool);
+    void close();
+    bool isEnabled() const { return enabled_; }
+
+    void setInterval(std::chrono::milliseconds interval) { interval_ns_ = interval.count() * 1000000LL; }
+
+    // True at most once per interval; workers call it before building a progress event
+    bool progressDue();
+
+    // Periodic events are dropped when the consumer falls behind, others are always kept
+    void emit(const ProgressEvent& event, bool droppable = false);
+
+    uint64_t getDropped() const { return dropped_; }
+
+private:
+    ProgressStream();
+    ~ProgressStream();
+    ProgressStream(const ProgressStream&) = delete;
+    ProgressStream& operator=(const ProgressStream&) = delete;
+
+    void writerThread();
+    void writeAll(const std::string& data);
+
+    static const size_t MAX_QUEUED = 256;
+
+    std::atomic<bool> enabled_;
+    std::atomic<long long> interval_ns_;
+    std::atomic<long long> next_due_ns_;
+    std::atomic<uint64_t> dropped_;
+    std::string tool_;
+    int fd_;
+    bool owns_fd_;
+
+    std::deque<std::string> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+    std::thread writer_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_PROGRESS_STREAM_H
@@ -0,0 +1,104 @@
+#ifndef AIRLEVI_RING_CAPTURE_H
+#define AIRLEVI_RING_CAPTURE_H
+
+#include "capture_stats.h"
+#include <pcap.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace airlevi {
+
+// How the kernel spreads frames over the workers' sockets
+enum class FanoutMode {
+    STATION_PAIR,   // both directions between two stations on one worker
+    HASH,           // kernel flow hash: only useful for Ethernet-framed links
+    LOAD_BALANCE    // round robin
+};
+
+struct RingOptions {
+    bool enabled = false;
+    size_t ring_size_mb = 64;        // per worker
+    size_t block_size_kb = 1024;
+    int block_timeout_ms = 64;       // a partly filled block is handed over after this long
+    int workers = 1;
+    FanoutMode fanout = FanoutMode::STATION_PAIR;
+};
+
+struct RingPacket {
+    struct pcap_pkthdr header;
+    const uint8_t* data;            // valid until the batch handler returns
+    uint32_t interface_id;          // 0 live; a replay gives the pcapng interface
+};
+
+// AF_PACKET TPACKET_V3 capture: each worker owns a socket with its own
+// mmap'd block ring and is handed every block the kernel retires as one
+// batch. With several workers the sockets join a PACKET_FANOUT group.
+// Frames come as received, so monitor interfaces must already be in
+// monitor mode (airlevi-mon).
+class RingCapture {
+public:
+    // Runs on the worker's own thread
+    using BatchHandler = std::function<void(int worker, const std::vector<RingPacket>& batch)>;
+
+    RingCapture();
+    ~RingCapture();
+
+    bool open(const std::string& interface, const RingOptions& options);
+    void close();
+    bool isOpen() const { return !workers_.empty(); }
+
+    // DLT_* of the interface's ARPHRD type
+    int getLinkType() const { return link_type_; }
+    int getWorkerCount() const { return static_cast<int>(workers_.size()); }
+
+    bool start(BatchHandler handler);
+    void stop();
+
+    // Kernel counters of all workers' sockets since open(); any thread
+    CaptureCounters getCounters();
+
+    // Blocks per worker that the kernel has filled and the worker has not
+    // yet handed back: the ring's queue depth
+    std::vector<size_t> getBacklog() const;
+
+    // "pair", "hash" or "lb"
+    static bool parseFanoutMode(const std::string& name, FanoutMode& mode);
+
+private:
+    RingCapture(const RingCapture&) = delete;
+    RingCapture& operator=(const RingCapture&) = delete;
+
+    struct Worker {
+        int fd = -1;
+        uint8_t* ring = nullptr;
+        size_t block_count = 0;
+        std::thread thread;
+    };
+
+    bool openSocket(Worker& worker, int ifindex, const RingOptions& options);
+    bool joinFanout(Worker& worker, const RingOptions& options);
+    void workerLoop(int index);
+
+    std::string interface_;
+    int link_type_;
+    size_t block_size_;
+    uint16_t fanout_group_;
+    std::vector<Worker> workers_;
+    BatchHandler handler_;
+    std::atomic<bool> running_;
+
+    // PACKET_STATISTICS resets on every read, so reads are accumulated here
+    std::mutex counters_mutex_;
+    CaptureCounters counters_;
+    uint64_t interface_drops_at_open_;
+};
+
+} // namespace airlevi
+
+#endif // AIRLEVI_RING_CAPTURE_H
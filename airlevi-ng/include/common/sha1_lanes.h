@@ -0,0 +1,78 @@
+#ifndef AIRLEVI_SHA1_LANES_H
+#define AIRLEVI_SHA1_LANES_H
+
+#include <cstdint>
+
+namespace airlevi {
+
+// SHA-1 compression over L independent messages at once. State and message
+// words are stored [word][lane] so every inner loop runs across lanes and
+// the compiler can turn it into SIMD.
+
+const uint32_t kSha1Init[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+inline uint32_t rol32(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+inline uint32_t loadBE32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+inline void storeBE32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+template <int L>
+inline void sha1Rounds(int first, int last, uint32_t k, int kind, const uint32_t w[80][L],
+                       uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d, uint32_t* e) {
+    for (int t = first; t < last; ++t) {
+        for (int l = 0; l < L; ++l) {
+            uint32_t f;
+            if (kind == 0) {
+                f = d[l] ^ (b[l] & (c[l] ^ d[l]));
+            } else if (kind == 2) {
+                f = (b[l] & c[l]) | (d[l] & (b[l] | c[l]));
+            } else {
+                f = b[l] ^ c[l] ^ d[l];
+            }
+            uint32_t tmp = rol32(a[l], 5) + f + e[l] + k + w[t][l];
+            e[l] = d[l];
+            d[l] = c[l];
+            c[l] = rol32(b[l], 30);
+            b[l] = a[l];
+            a[l] = tmp;
+        }
+    }
+}
+
+template <int L>
+inline void sha1Compress(uint32_t state[5][L], const uint32_t block[16][L]) {
+    uint32_t w[80][L];
+    uint32_t a[L], b[L], c[L], d[L], e[L];
+
+    for (int t = 0; t < 16; ++t)
+        for (int l = 0; l < L; ++l) w[t][l] = block[t][l];
+    for (int t = 16; t < 80; ++t)
+        for (int l = 0; l < L; ++l)
+            w[t][l] = rol32(w[t - 3][l] ^ w[t - 8][l] ^ w[t - 14][l] ^ w[t - 16][l], 1);
+
+    for (int l = 0; l < L; ++l) {
+        a[l] = state[0][l]; b[l] = state[1][l]; c[l] = state[2][l];
+        d[l] = state[3][l]; e[l] = state[4][l];
+    }
+
+    sha1Rounds<L>(0, 20, 0x5A827999, 0, w, a, b, c, d, e);
+    sha1Rounds<L>(20, 40, 0x6ED9EBA1, 1, w, a, b, c, d, e);
+    sha1Rounds<L>(40, 60, 0x8F1BBCDC, 2, w, a, b, c, d, e);
+    sha1Rounds<L>(60, 80, 0xCA62C1D6, 3, w, a, b, c, d, e);
+
+    for (int l = 0; l < L; ++l) {
+        state[0][l] += a[l]; state[1][l] += b[l]; state[2][l] += c[l];
+        state[3][l] += d[l]; state[4][l] += e[l];
+    }
+}
+
+} // namespace airlevi
+
+#endif // AIRLEVI_SHA1_LANES_H
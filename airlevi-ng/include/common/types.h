@@ -61,6 +61,29 @@ struct BeaconFrame {
     // Variable length information elements follow
 } __attribute__((packed));
 
+// Per-frame metadata from a radiotap header; fields the header does not
+// carry are left zero
+struct RadiotapInfo {
+    uint16_t header_length;    // offset of the 802.11 frame
+    uint8_t flags;             // IEEE80211_RADIOTAP_FLAGS
+    bool has_signal;
+    int8_t signal_dbm;         // antenna signal
+    uint16_t frequency;        // MHz
+    uint16_t channel_flags;
+    uint32_t rate_kbps;        // legacy rate, 0 for HT/VHT/HE frames
+    bool has_fcs;              // frame ends in a 4-byte FCS
+    bool bad_fcs;
+    bool data_pad;             // padding between the 802.11 header and payload
+};
+
+// EAPOL-Key descriptor version (Key Information bits 0-2), selects the
+// KDF and MIC algorithm used to protect the 4-way handshake
+enum class KeyDescriptorVersion : uint8_t {
+    HMAC_MD5_RC4 = 1,   // WPA/TKIP: PRF-SHA1 PTK, HMAC-MD5 MIC
+    HMAC_SHA1_AES = 2,  // WPA2/CCMP: PRF-SHA1 PTK, HMAC-SHA1-128 MIC
+    AES_128_CMAC = 3    // 802.11w/SHA256 AKMs: KDF-SHA256 PTK, AES-128-CMAC MIC
+};
+
 struct HandshakePacket {
     MacAddress ap_mac;
     MacAddress client_mac;
@@ -70,6 +93,8 @@ struct HandshakePacket {
     std::vector<uint8_t> eapol_data;
     std::string essid;
     int message_number; // 1-4 for 4-way handshake
+    KeyDescriptorVersion key_version;
+    uint64_t replay_counter; // M2 answers the M1 of its counter, M3 carries it plus one
 };
 
 struct SAEHandshakePacket {
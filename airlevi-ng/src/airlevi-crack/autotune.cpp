@@ -0,0 +1,212 @@
+#include "airlevi-crack/autotune.h"
+#include "airlevi-crack/pmk_batch.h"
+#include "common/logger.h"
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace airlevi {
+
+Autotuner::Autotuner(int max_threads)
+    : max_threads_(max_threads > 0 ? max_threads : std::thread::hardware_concurrency()) {
+    if (max_threads_ <= 0) max_threads_ = 1;
+}
+
+std::string Autotuner::profilePath() {
+    const char* dir = std::getenv("AIRLEVI_PROFILE_DIR");
+    std::string base;
+    if (dir && *dir) {
+        base = dir;
+    } else {
+        const char* home = std::getenv("HOME");
+        base = std::string(home ? home : ".") + "/.airlevi-ng";
+    }
+
+    char hostname[256] = {0};
+    gethostname(hostname, sizeof(hostname) - 1);
+    return base + "/crack-" + hostname + ".profile";
+}
+
+std::string Autotuner::hostIdentity() {
+    // Hostname alone is not enough when home directories are shared between machines
+    std::string model = "unknown";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t pos = line.find(':');
+            if (pos != std::string::npos) model = line.substr(pos + 2);
+            break;
+        }
+    }
+
+    char hostname[256] = {0};
+    gethostname(hostname, sizeof(hostname) - 1);
+    return std::string(hostname) + "/" + model + "/" + std::to_string(std::thread::hardware_concurrency());
+}
+
+bool Autotuner::loadProfile(CrackTuning& tuning) const {
+    std::ifstream file(profilePath());
+    if (!file.is_open()) {
+        return false;
+    }
+
+    CrackTuning loaded = {0, 0, 0, 0.0};
+    bool host_matches = false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t pos = line.find('=');
+        if (pos == std::string::npos) continue;
+
+        std::string key = line.substr(0, pos);
+        std::string value = line.substr(pos + 1);
+
+        try {
+            if (key == "host") {
+                host_matches = (value == hostIdentity());
+            } else if (key == "threads") {
+                loaded.threads = std::stoi(value);
+            } else if (key == "batch_size") {
+                loaded.batch_size = std::stoi(value);
+            } else if (key == "lanes") {
+                loaded.lanes = std::stoi(value);
+            } else if (key == "rate") {
+                loaded.rate = std::stod(value);
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    if (!host_matches || loaded.threads <= 0 || loaded.batch_size <= 0 || loaded.lanes <= 0) {
+        return false;
+    }
+
+    tuning = loaded;
+    return true;
+}
+
+bool Autotuner::saveProfile(const CrackTuning& tuning) const {
+    std::string path = profilePath();
+    std::string dir = path.substr(0, path.find_last_of('/'));
+    mkdir(dir.c_str(), 0700);
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        Logger::getInstance().warning("Cannot write tuning profile: " + path);
+        return false;
+    }
+
+    file << "# AirLevi-NG crack tuning profile\n";
+    file << "host=" << hostIdentity() << "\n";
+    file << "threads=" << tuning.threads << "\n";
+    file << "batch_size=" << tuning.batch_size << "\n";
+    file << "lanes=" << tuning.lanes << "\n";
+    file << "rate=" << tuning.rate << "\n";
+
+    return true;
+}
+
+CrackTuning Autotuner::calibrate() {
+    Logger::getInstance().info("Calibrating crack engine (" + std::to_string(max_threads_) + " threads max)...");
+
+    const auto slice = std::chrono::milliseconds(400);
+    CrackTuning best = {1, 32, 1, 0.0};
+
+    // Lane width is a per-core property, measure it on a single worker
+    for (int lanes : PMKBatch::supportedLanes()) {
+        double rate = measure(1, lanes * 2, lanes, slice);
+        Logger::getInstance().debug("lanes=" + std::to_string(lanes) + ": " + std::to_string(static_cast<int>(rate)) + " PMK/s");
+        if (rate > best.rate) {
+            best.lanes = lanes;
+            best.rate = rate;
+        }
+    }
+
+    // Worker count: SMT siblings do not always pay for themselves
+    std::vector<int> thread_counts = {max_threads_};
+    if (max_threads_ >= 4) thread_counts.push_back(max_threads_ / 2);
+
+    best.rate = 0.0;
+    for (int threads : thread_counts) {
+        double rate = measure(threads, best.lanes * 2, best.lanes, slice);
+        Logger::getInstance().debug("threads=" + std::to_string(threads) + ": " + std::to_string(static_cast<int>(rate)) + " PMK/s");
+        if (rate > best.rate) {
+            best.threads = threads;
+            best.rate = rate;
+        }
+    }
+
+    // Batch size trades claim overhead against tail imbalance
+    best.rate = 0.0;
+    for (int multiplier : {1, 4, 16}) {
+        int batch_size = best.lanes * multiplier;
+        double rate = measure(best.threads, batch_size, best.lanes, slice);
+        Logger::getInstance().debug("batch=" + std::to_string(batch_size) + ": " + std::to_string(static_cast<int>(rate)) + " PMK/s");
+        if (rate > best.rate) {
+            best.batch_size = batch_size;
+            best.rate = rate;
+        }
+    }
+
+    Logger::getInstance().info("Calibration: " + std::to_string(best.threads) + " threads, batch " +
+                             std::to_string(best.batch_size) + ", " + std::to_string(best.lanes) + " lanes (" +
+                             std::to_string(static_cast<int>(best.rate)) + " PMK/s)");
+    return best;
+}
+
+double Autotuner::measure(int threads, int batch_size, int lanes, std::chrono::milliseconds duration) {
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> derived(0);
+    std::mutex claim_mutex;
+    uint64_t claimed = 0;
+
+    auto worker = [&]() {
+        PMKBatch batch(lanes);
+        std::vector<std::string> passwords(batch_size);
+        std::unique_ptr<uint8_t[][32]> pmks(new uint8_t[batch_size][32]);
+
+        while (running) {
+            // Claim through a lock like the real candidate queues do
+            uint64_t base;
+            {
+                std::lock_guard<std::mutex> lock(claim_mutex);
+                base = claimed;
+                claimed += batch_size;
+            }
+            for (int i = 0; i < batch_size; ++i) {
+                passwords[i] = "calibrate" + std::to_string(base + i);
+            }
+
+            batch.derive(passwords.data(), passwords.size(), "airlevi-autotune", pmks.get());
+            derived += batch_size;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    std::this_thread::sleep_for(duration);
+    running = false;
+
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return elapsed > 0 ? derived / elapsed : 0.0;
+}
+
+} // namespace airlevi
@@ -0,0 +1,214 @@
+#include "airlevi-crack/batch_job.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace airlevi {
+
+namespace {
+
+bool hasExtension(const std::string& path, const std::string& ext) {
+    return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool isHashFile(const std::string& path) {
+    return hasExtension(path, ".22000") || hasExtension(path, ".hc22000");
+}
+
+bool isCaptureFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    uint32_t magic = 0;
+    if (!file.read(reinterpret_cast<char*>(&magic), sizeof(magic))) {
+        return false;
+    }
+    // pcap (us/ns, either byte order) and pcapng section header
+    return magic == 0xa1b2c3d4 || magic == 0xd4c3b2a1 || magic == 0xa1b23c4d ||
+           magic == 0x4d3cb2a1 || magic == 0x0a0d0d0a;
+}
+
+} // namespace
+
+BatchJob::BatchJob(const Config& config, int num_threads)
+    : config_(config), num_threads_(num_threads) {}
+
+bool BatchJob::addPath(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        Logger::getInstance().error("Batch input not found: " + path);
+        return false;
+    }
+
+    if (!S_ISDIR(st.st_mode)) {
+        return addFile(path);
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        Logger::getInstance().error("Cannot open directory: " + path);
+        return false;
+    }
+
+    std::vector<std::string> entries;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if (hasExtension(name, ".cap") || hasExtension(name, ".pcap") ||
+            hasExtension(name, ".pcapng") || isHashFile(name)) {
+            entries.push_back(path + "/" + name);
+        }
+    }
+    closedir(dir);
+
+    // Deterministic order so reports line up between runs
+    std::sort(entries.begin(), entries.end());
+
+    bool any = false;
+    for (const auto& file : entries) {
+        any |= addFile(file);
+    }
+    return any;
+}
+
+bool BatchJob::addFile(const std::string& path) {
+    char resolved[PATH_MAX];
+    std::string canonical = realpath(path.c_str(), resolved) ? resolved : path;
+    if (!loaded_files_.insert(canonical).second) {
+        return true;
+    }
+
+    if (isHashFile(path)) {
+        return TargetLoader::loadHashFile(path, targets_);
+    }
+    if (isCaptureFile(path)) {
+        if (!TargetLoader::loadCapture(config_, path, targets_)) {
+            Logger::getInstance().warning("No crackable handshake or PMKID in " + path);
+            return false;
+        }
+        return true;
+    }
+    return addManifest(path);
+}
+
+bool BatchJob::addManifest(const std::string& path) {
+    std::ifstream manifest(path);
+    if (!manifest.is_open()) {
+        Logger::getInstance().error("Cannot open manifest: " + path);
+        return false;
+    }
+
+    // Relative entries are resolved against the manifest's directory
+    std::string base;
+    size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos) {
+        base = path.substr(0, slash + 1);
+    }
+
+    bool any = false;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r\n"));
+        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+        if (line.empty() || line[0] == '#') continue;
+
+        any |= addPath(line[0] == '/' ? line : base + line);
+    }
+    return any;
+}
+
+void BatchJob::addWordlistPass(const std::string& wordlist) {
+    passes_.push_back({wordlist, "", false});
+}
+
+void BatchJob::addHybridPass(const std::string& wordlist, const std::string& mask, bool prefix) {
+    passes_.push_back({wordlist, mask, prefix});
+}
+
+std::map<std::string, std::vector<CrackTarget*>> BatchJob::groupByESSID() const {
+    std::map<std::string, std::vector<CrackTarget*>> groups;
+    for (const auto& target : targets_) {
+        if (!target->cracked) {
+            groups[target->essid].push_back(target.get());
+        }
+    }
+    return groups;
+}
+
+size_t BatchJob::getCrackedCount() const {
+    return std::count_if(targets_.begin(), targets_.end(),
+                         [](const std::unique_ptr<CrackTarget>& t) { return t->cracked.load(); });
+}
+
+bool BatchJob::run(const PassSetup& setup) {
+    if (targets_.empty()) {
+        Logger::getInstance().error("Batch job has no crackable targets");
+        return false;
+    }
+
+    Logger::getInstance().info("Batch job: " + std::to_string(targets_.size()) + " targets across " +
+                             std::to_string(groupByESSID().size()) + " ESSIDs");
+
+    for (size_t p = 0; p < passes_.size(); ++p) {
+        const Pass& pass = passes_[p];
+
+        // Largest groups first: each derived PMK then settles the most targets
+        auto groups = groupByESSID();
+        std::vector<std::pair<std::string, std::vector<CrackTarget*>>> order(groups.begin(), groups.end());
+        std::stable_sort(order.begin(), order.end(),
+                         [](const std::pair<std::string, std::vector<CrackTarget*>>& a,
+                            const std::pair<std::string, std::vector<CrackTarget*>>& b) {
+                             return a.second.size() > b.second.size();
+                         });
+
+        Logger::getInstance().info("Pass " + std::to_string(p + 1) + "/" + std::to_string(passes_.size()) + ": " +
+                                 pass.wordlist + (pass.mask.empty() ? "" : " + mask " + pass.mask) +
+                                 " over " + std::to_string(order.size()) + " ESSIDs");
+
+        for (const auto& group : order) {
+            Config pass_config = config_;
+            pass_config.wordlist_file = pass.wordlist;
+
+            DictionaryAttack attack(pass_config, num_threads_);
+            if (!setup(attack)) {
+                return false;
+            }
+            if (!pass.mask.empty() && !attack.setHybridMask(pass.mask, pass.prefix)) {
+                return false;
+            }
+
+            Logger::getInstance().info("ESSID '" + group.first + "': " + std::to_string(group.second.size()) +
+                                     " targets");
+            attack.setTargetGroup(group.first, group.second);
+
+            std::string unused;
+            attack.crack(unused);
+        }
+
+        if (getCrackedCount() == targets_.size()) {
+            break;
+        }
+    }
+
+    return getCrackedCount() > 0;
+}
+
+void BatchJob::printReport(std::ostream& out) const {
+    out << "\nBatch results (" << getCrackedCount() << "/" << targets_.size() << " cracked)\n";
+    out << std::left << std::setw(20) << "BSSID" << std::setw(20) << "STATION"
+        << std::setw(28) << "TYPE" << std::setw(24) << "ESSID" << "RESULT / SOURCE\n";
+
+    for (const auto& target : targets_) {
+        out << std::left << std::setw(20) << target->ap_mac.toString()
+            << std::setw(20) << target->client_mac.toString()
+            << std::setw(28) << target->describe()
+            << std::setw(24) << target->essid
+            << (target->cracked ? "[+] " + target->password : "[-] not found")
+            << "  " << target->source << "\n";
+    }
+}
+
+} // namespace airlevi
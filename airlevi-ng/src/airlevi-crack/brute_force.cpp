@@ -1,15 +1,19 @@
 #include "airlevi-crack/brute_force.h"
+#include "airlevi-crack/pmk_batch.h"
 #include "common/logger.h"
+#include "common/progress_stream.h"
 #include <chrono>
 #include <cmath>
+#include <algorithm>
+#include <memory>
 
 namespace airlevi {
 
 BruteForce::BruteForce(const Config& config, int num_threads)
     : config_(config), num_threads_(num_threads > 0 ? num_threads : std::thread::hardware_concurrency()),
       charset_("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"),
-      min_length_(8), max_length_(12), running_(false), found_(false), 
-      attempts_(0), current_index_(0) {
+      min_length_(8), max_length_(12), batch_size_(64), lanes_(PMKBatch::MAX_LANES),
+      running_(false), found_(false), attempts_(0), total_combinations_(0) {
     
     wpa_cracker_ = std::make_unique<WPACrack>(config);
 }
@@ -18,25 +22,65 @@ BruteForce::~BruteForce() {
     stop();
 }
 
+bool BruteForce::loadMarkovModel(const std::string& training_file) {
+    auto model = std::make_unique<MarkovModel>(charset_);
+    if (!model->train(training_file)) {
+        return false;
+    }
+    
+    markov_ = std::move(model);
+    return true;
+}
+
 bool BruteForce::crack(std::string& found_password) {
     Logger::getInstance().info("Starting brute force attack with " + std::to_string(num_threads_) + " threads");
     Logger::getInstance().info("Charset: " + charset_);
     Logger::getInstance().info("Length range: " + std::to_string(min_length_) + "-" + std::to_string(max_length_));
+    if (markov_) {
+        Logger::getInstance().info("Candidate order: Markov (" + std::to_string(markov_->getSamples()) + " samples)");
+    }
+    
+    // Load the handshake and select its MIC verifier
+    if (!wpa_cracker_->prepareTarget()) {
+        return false;
+    }
     
-    uint64_t total_combinations = calculateTotalCombinations();
-    Logger::getInstance().info("Total combinations to test: " + std::to_string(total_combinations));
+    total_combinations_ = calculateTotalCombinations();
+    Logger::getInstance().info("Total combinations to test: " + std::to_string(total_combinations_));
     
     running_ = true;
     found_ = false;
     attempts_ = 0;
-    current_index_ = 0;
     
     auto start_time = std::chrono::steady_clock::now();
+    start_time_ = start_time;
+    
+    // Slice the keyspace per NUMA node in proportion to its worker count
+    std::vector<int> node_threads = topology_.distributeThreads(num_threads_);
+    slices_.clear();
+    uint64_t offset = 0;
+    for (size_t node = 0; node < node_threads.size(); ++node) {
+        if (node_threads[node] == 0) continue;
+        
+        auto slice = std::make_unique<KeyspaceSlice>();
+        slice->node_index = node;
+        slice->next = offset;
+        offset += static_cast<uint64_t>(static_cast<long double>(total_combinations_) * node_threads[node] / num_threads_);
+        slice->end = offset;
+        slices_.push_back(std::move(slice));
+    }
+    slices_.back()->end = total_combinations_;
+    
+    if (topology_.isMultiNode()) {
+        Logger::getInstance().info("Spreading workers over " + std::to_string(slices_.size()) + " NUMA nodes");
+    }
     
     // Start worker threads
     worker_threads_.reserve(num_threads_);
-    for (int i = 0; i < num_threads_; ++i) {
-        worker_threads_.emplace_back(&BruteForce::workerThread, this);
+    for (size_t i = 0; i < slices_.size(); ++i) {
+        for (int t = 0; t < node_threads[slices_[i]->node_index]; ++t) {
+            worker_threads_.emplace_back(&BruteForce::workerThread, this, i);
+        }
     }
     
     // Wait for completion
@@ -45,6 +89,7 @@ bool BruteForce::crack(std::string& found_password) {
             thread.join();
         }
     }
+    worker_threads_.clear();
     
     auto end_time = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time);
@@ -62,9 +107,8 @@ bool BruteForce::crack(std::string& found_password) {
 }
 
 double BruteForce::getRate() const {
-    static auto start_time = std::chrono::steady_clock::now();
     auto now = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - start_time);
+    auto duration = std::chrono::duration<double>(now - start_time_);
     
     if (duration.count() > 0) {
         return static_cast<double>(attempts_) / duration.count();
@@ -73,55 +117,143 @@ double BruteForce::getRate() const {
     return 0.0;
 }
 
-void BruteForce::workerThread() {
+void BruteForce::workerThread(size_t slice_index) {
+    if (topology_.isMultiNode()) {
+        topology_.bindCurrentThread(slices_[slice_index]->node_index);
+    }
+    
+    // The verifier is immutable once the target is loaded, so workers share it
+    const HandshakeVerifier* verifier = wpa_cracker_->getVerifier();
+    const std::string& essid = verifier->getESSID();
+    
+    PMKBatch pmk_batch(lanes_);
+    std::vector<std::string> batch;
+    batch.reserve(batch_size_);
+    std::unique_ptr<uint8_t[][32]> pmks(new uint8_t[batch_size_][32]);
+    
     while (running_ && !found_) {
-        // Get next password to test
-        uint64_t index = current_index_++;
+        // Claim a contiguous block of the keyspace
+        uint64_t first, last;
+        if (!claimRange(slice_index, first, last)) {
+            break;
+        }
         
-        // Try all lengths
-        for (int length = min_length_; length <= max_length_ && running_ && !found_; ++length) {
-            uint64_t combinations_for_length = static_cast<uint64_t>(std::pow(charset_.size(), length));
-            
-            if (index >= combinations_for_length) {
-                index -= combinations_for_length;
-                continue;
+        batch.clear();
+        std::string password;
+        for (uint64_t index = first; index < last; ++index) {
+            if (indexToPassword(index, password)) {
+                batch.push_back(password);
             }
-            
-            std::string password = generatePassword(index, length);
-            
-            if (testPasswordWorker(password)) {
+        }
+        if (batch.empty()) {
+            continue;
+        }
+        
+        pmk_batch.derive(batch.data(), batch.size(), essid, pmks.get());
+        
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (verifier->testPMK(pmks[i])) {
                 std::lock_guard<std::mutex> lock(result_mutex_);
                 if (!found_) {
                     found_ = true;
-                    result_password_ = password;
-                    Logger::getInstance().info("Password found by brute force: " + password);
+                    result_password_ = batch[i];
+                    Logger::getInstance().info("Password found by brute force: " + batch[i]);
+                    ProgressStream::getInstance().emit(ProgressEvent("found")
+                        .add("source", config_.output_file)
+                        .add("essid", essid)
+                        .add("password", batch[i]));
                 }
                 return;
             }
-            
-            attempts_++;
-            
-            if (attempts_ % 10000 == 0) {
-                Logger::getInstance().info("Tested " + std::to_string(attempts_) + 
-                                         " passwords (" + std::to_string(static_cast<int>(getRate())) + " p/s)");
-            }
-            
-            break; // Found the right length for this index
+        }
+        
+        uint64_t before = attempts_.fetch_add(batch.size());
+        uint64_t after = before + batch.size();
+        
+        if (before / 10000 != after / 10000) {
+            Logger::getInstance().info("Tested " + std::to_string(after) + 
+                                     " passwords (" + std::to_string(static_cast<int>(getRate())) + " p/s)");
+        }
+        
+        if (ProgressStream::getInstance().progressDue()) {
+            double rate = getRate();
+            uint64_t left = total_combinations_ > after ? total_combinations_ - after : 0;
+            ProgressStream::getInstance().emit(ProgressEvent("progress")
+                .add("attack", markov_ ? "markov" : "brute-force")
+                .add("tested", after)
+                .add("rate", rate)
+                .add("position", after)
+                .add("keyspace", total_combinations_)
+                .add("progress", total_combinations_ > 0 ? static_cast<double>(after) / total_combinations_ : 1.0)
+                .add("eta", rate > 0.0 ? left / rate : NAN)
+                .add("targets_remaining", 1), true);
+        }
+    }
+}
+
+bool BruteForce::claimRange(size_t slice_index, uint64_t& first, uint64_t& last) {
+    // Own node first; once it is drained, help the others finish theirs
+    for (size_t i = 0; i < slices_.size(); ++i) {
+        KeyspaceSlice& slice = *slices_[(slice_index + i) % slices_.size()];
+        if (slice.next.load(std::memory_order_relaxed) >= slice.end) {
+            continue;
+        }
+        
+        first = slice.next.fetch_add(batch_size_);
+        if (first < slice.end) {
+            last = std::min<uint64_t>(first + batch_size_, slice.end);
+            return true;
         }
     }
+    
+    return false;
+}
+
+bool BruteForce::indexToPassword(uint64_t index, std::string& password) {
+    // Global index runs through every length in turn, shortest first
+    for (int length = min_length_; length <= max_length_; ++length) {
+        uint64_t combinations_for_length = static_cast<uint64_t>(std::pow(charset_.size(), length));
+        
+        if (index >= combinations_for_length) {
+            index -= combinations_for_length;
+            continue;
+        }
+        
+        // Lengths outside the WPA passphrase range can never match
+        if (length < 8 || length > 63) {
+            return false;
+        }
+        
+        password = generatePassword(index, length);
+        return true;
+    }
+    
+    return false;
 }
 
 std::string BruteForce::generatePassword(uint64_t index, int length) {
-    std::string password;
-    password.reserve(length);
+    std::string password(length, '\0');
     
     uint64_t charset_size = charset_.size();
     
-    for (int i = 0; i < length; ++i) {
-        password += charset_[index % charset_size];
+    // Last position varies fastest, so the leading characters stay on their
+    // most likely values for the longest
+    int ranks[MarkovModel::MAX_POSITIONS];
+    for (int i = length - 1; i >= 0; --i) {
+        ranks[i] = static_cast<int>(index % charset_size);
         index /= charset_size;
     }
     
+    int prev = -1;
+    for (int i = 0; i < length; ++i) {
+        if (markov_) {
+            password[i] = markov_->at(i, prev, ranks[i]);
+            prev = markov_->indexOf(password[i]);
+        } else {
+            password[i] = charset_[ranks[i]];
+        }
+    }
+    
     return password;
 }
 
@@ -136,15 +268,4 @@ uint64_t BruteForce::calculateTotalCombinations() {
     return total;
 }
 
-bool BruteForce::testPasswordWorker(const std::string& password) {
-    // Create a local WPA cracker instance for this thread
-    WPACrack local_cracker(config_);
-    
-    // Test the password
-    std::string temp_result;
-    
-    // Placeholder - actual implementation would test against handshake
-    return false;
-}
-
 } // namespace airlevi
@@ -0,0 +1,76 @@
+#include "airlevi-crack/candidate_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace airlevi {
+
+namespace {
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+} // namespace
+
+CandidateFilter::CandidateFilter(uint64_t expected_items, double false_positive_rate, size_t max_bytes)
+    : num_blocks_(1), hash_count_(1), duplicates_(0) {
+    false_positive_rate = std::min(std::max(false_positive_rate, 1e-9), 0.5);
+    expected_items = std::max<uint64_t>(expected_items, 1);
+
+    // Standard Bloom sizing; blocking costs a little accuracy, so round up
+    double bits = -static_cast<double>(expected_items) * std::log(false_positive_rate) / (std::log(2.0) * std::log(2.0));
+    uint64_t wanted = static_cast<uint64_t>(std::ceil(bits * 1.1 / 512.0));
+    uint64_t budget = std::max<uint64_t>(max_bytes / sizeof(Block), 1);
+    num_blocks_ = std::max<uint64_t>(std::min(wanted, budget), 1);
+
+    // Optimal k for the bits we actually got
+    double bits_per_item = static_cast<double>(num_blocks_) * 512.0 / expected_items;
+    hash_count_ = std::min(std::max(static_cast<int>(std::lround(bits_per_item * std::log(2.0))), 1), 16);
+
+    blocks_.reset(new Block[num_blocks_]());
+}
+
+bool CandidateFilter::insert(const std::string& candidate) {
+    uint64_t hash = mix64(std::hash<std::string>()(candidate));
+    Block& block = blocks_[static_cast<uint64_t>((static_cast<unsigned __int128>(hash) * num_blocks_) >> 64)];
+
+    // Double hashing within the block: bit_i = h1 + i * h2 (mod 512)
+    uint64_t h2 = mix64(hash ^ 0x9e3779b97f4a7c15ULL);
+    uint32_t h1 = static_cast<uint32_t>(h2);
+    uint32_t step = static_cast<uint32_t>(h2 >> 32) | 1;
+
+    uint64_t masks[8] = {0};
+    for (int i = 0; i < hash_count_; ++i) {
+        uint32_t bit = (h1 + i * step) & 511;
+        masks[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    bool seen = true;
+    for (int w = 0; w < 8; ++w) {
+        if (!masks[w]) continue;
+        if ((block.words[w].load(std::memory_order_relaxed) & masks[w]) != masks[w]) {
+            seen = false;
+            break;
+        }
+    }
+
+    if (seen) {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    for (int w = 0; w < 8; ++w) {
+        if (masks[w]) {
+            block.words[w].fetch_or(masks[w], std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+} // namespace airlevi
@@ -0,0 +1,172 @@
+#include "airlevi-crack/crack_target.h"
+#include "airlevi-crack/wpa_crack.h"
+#include "common/logger.h"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+namespace airlevi {
+
+namespace {
+
+bool parseHex(const std::string& hex, std::vector<uint8_t>& out) {
+    if (hex.size() % 2 != 0) return false;
+    for (char c : hex) {
+        if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+    }
+    out = CryptoUtils::hexToBytes(hex);
+    return true;
+}
+
+bool parseMac(const std::string& hex, MacAddress& mac) {
+    std::vector<uint8_t> bytes;
+    if (hex.size() != 12 || !parseHex(hex, bytes)) return false;
+    mac = MacAddress(bytes.data());
+    return true;
+}
+
+} // namespace
+
+std::string CrackTarget::describe() const {
+    if (handshake) {
+        return HandshakeVerifier::describe(handshake->getKeyVersion());
+    }
+    return "PMKID";
+}
+
+bool TargetLoader::loadCapture(const Config& config, const std::string& path,
+                               std::vector<std::unique_ptr<CrackTarget>>& targets) {
+    Config capture_config = config;
+    capture_config.output_file = path; // input capture, as in single-file mode
+
+    WPACrack loader(capture_config);
+    std::vector<HandshakePacket> handshakes;
+    std::vector<PMKIDPacket> pmkids;
+    if (!loader.loadTargets(handshakes, pmkids)) {
+        return false;
+    }
+
+    size_t loaded = 0;
+    for (const HandshakePacket& handshake : handshakes) {
+        auto target = std::make_unique<CrackTarget>();
+        target->handshake = std::make_unique<HandshakeVerifier>(handshake);
+        if (!target->handshake->isSupported()) {
+            Logger::getInstance().warning(path + ": unsupported key descriptor version " +
+                                          HandshakeVerifier::describe(handshake.key_version) + " for " +
+                                          handshake.client_mac.toString());
+            continue;
+        }
+        target->source = path;
+        target->essid = handshake.essid;
+        target->ap_mac = handshake.ap_mac;
+        target->client_mac = handshake.client_mac;
+        targets.push_back(std::move(target));
+        loaded++;
+    }
+
+    for (const PMKIDPacket& pmkid : pmkids) {
+        auto target = std::make_unique<CrackTarget>();
+        target->source = path;
+        target->essid = pmkid.essid;
+        target->ap_mac = pmkid.ap_mac;
+        target->client_mac = pmkid.client_mac;
+        target->pmkid = std::make_unique<PMKIDVerifier>(pmkid.essid, pmkid.ap_mac, pmkid.client_mac,
+                                                        pmkid.pmkid.data());
+        targets.push_back(std::move(target));
+        loaded++;
+    }
+
+    return loaded > 0;
+}
+
+bool TargetLoader::loadHashFile(const std::string& path, std::vector<std::unique_ptr<CrackTarget>>& targets) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        Logger::getInstance().error("Cannot open hash file: " + path);
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    size_t loaded = 0;
+
+    while (std::getline(file, line)) {
+        line_number++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        auto target = parseHashLine(line);
+        if (!target) {
+            Logger::getInstance().warning(path + ":" + std::to_string(line_number) + ": invalid 22000 line");
+            continue;
+        }
+
+        target->source = path + ":" + std::to_string(line_number);
+        targets.push_back(std::move(target));
+        loaded++;
+    }
+
+    return loaded > 0;
+}
+
+std::unique_ptr<CrackTarget> TargetLoader::parseHashLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, '*')) {
+        fields.push_back(field);
+    }
+
+    if (fields.size() < 6 || fields[0] != "WPA") {
+        return nullptr;
+    }
+
+    auto target = std::make_unique<CrackTarget>();
+    std::vector<uint8_t> essid;
+    std::vector<uint8_t> key;
+
+    if (!parseMac(fields[3], target->ap_mac) || !parseMac(fields[4], target->client_mac) ||
+        !parseHex(fields[5], essid) || essid.empty() || essid.size() > 32 ||
+        !parseHex(fields[2], key) || key.size() != 16) {
+        return nullptr;
+    }
+    target->essid.assign(essid.begin(), essid.end());
+
+    if (fields[1] == "01") {
+        target->pmkid = std::make_unique<PMKIDVerifier>(target->essid, target->ap_mac,
+                                                        target->client_mac, key.data());
+        return target;
+    }
+
+    if (fields[1] != "02" || fields.size() < 8) {
+        return nullptr;
+    }
+
+    // The message pair field only steers nonce-error correction, which is not applied here
+    HandshakePacket handshake;
+    handshake.essid = target->essid;
+    handshake.ap_mac = target->ap_mac;
+    handshake.client_mac = target->client_mac;
+    handshake.mic = key;
+    handshake.message_number = 2;
+
+    if (!parseHex(fields[6], handshake.anonce) || handshake.anonce.size() != 32 ||
+        !parseHex(fields[7], handshake.eapol_data) ||
+        handshake.eapol_data.size() < EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH) {
+        return nullptr;
+    }
+
+    // Key Information (big-endian) at offset 5, SNonce at offset 17
+    uint16_t key_info = (handshake.eapol_data[5] << 8) | handshake.eapol_data[6];
+    handshake.key_version = static_cast<KeyDescriptorVersion>(key_info & 0x07);
+    handshake.snonce.assign(handshake.eapol_data.begin() + 17, handshake.eapol_data.begin() + 49);
+
+    target->handshake = std::make_unique<HandshakeVerifier>(handshake);
+    if (!target->handshake->isSupported()) {
+        return nullptr;
+    }
+
+    return target;
+}
+
+} // namespace airlevi
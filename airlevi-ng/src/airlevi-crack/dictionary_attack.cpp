@@ -1,14 +1,20 @@
 #include "airlevi-crack/dictionary_attack.h"
+#include "common/progress_stream.h"
 #include "common/logger.h"
 #include <fstream>
+#include <memory>
 #include <chrono>
 #include <algorithm>
+#include <cstring>
+#include <cmath>
 
 namespace airlevi {
 
 DictionaryAttack::DictionaryAttack(const Config& config, int num_threads)
     : config_(config), num_threads_(num_threads > 0 ? num_threads : std::thread::hardware_concurrency()),
-      running_(false), found_(false), attempts_(0) {
+      batch_size_(64), lanes_(PMKBatch::MAX_LANES), dedup_fp_rate_(0.0),
+      dedup_max_memory_(0), hybrid_prefix_(false), pmk_cache_(nullptr), group_remaining_(0), running_(false), found_(false), attempts_(0),
+      wordlist_size_(0) {
     
     wpa_cracker_ = std::make_unique<WPACrack>(config);
 }
@@ -17,14 +23,87 @@ DictionaryAttack::~DictionaryAttack() {
     stop();
 }
 
+void DictionaryAttack::stop() {
+    running_ = false;
+    for (auto& buffer : buffers_) {
+        // Take the lock so a thread between its predicate check and wait() cannot miss this
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->cv.notify_all();
+    }
+}
+
+bool DictionaryAttack::setHybridMask(const std::string& mask, bool prefix) {
+    auto compiled = std::make_unique<Mask>();
+    if (!compiled->compile(mask)) {
+        return false;
+    }
+    
+    hybrid_mask_ = std::move(compiled);
+    hybrid_prefix_ = prefix;
+    return true;
+}
+
+void DictionaryAttack::setTargetGroup(const std::string& essid, const std::vector<CrackTarget*>& targets) {
+    group_essid_ = essid;
+    group_targets_ = targets;
+    group_remaining_ = 0;
+    group_handshakes_.clear();
+    group_pmkids_ = PMKIDIndex();
+    group_pmkid_targets_.clear();
+    
+    for (CrackTarget* target : targets) {
+        if (target->cracked) continue;
+        group_remaining_++;
+        
+        if (target->handshake) {
+            group_handshakes_.push_back(target);
+            continue;
+        }
+        
+        // Identical PMKIDs from several captures share one index entry
+        size_t id = group_pmkids_.add(essid, target->ap_mac, target->client_mac, target->pmkid->getPMKID());
+        if (id == group_pmkid_targets_.size()) {
+            group_pmkid_targets_.emplace_back();
+        }
+        group_pmkid_targets_[id].push_back(target);
+    }
+}
+
 bool DictionaryAttack::crack(std::string& found_password) {
     Logger::getInstance().info("Starting multi-threaded dictionary attack with " + 
                              std::to_string(num_threads_) + " threads");
     
-    // Load and prepare handshake
-    std::string temp;
-    if (!wpa_cracker_->crack(temp)) {
-        // This call is just to load the handshake data
+    if (config_.wordlist_file.empty()) {
+        Logger::getInstance().error("No wordlist file specified");
+        return false;
+    }
+    
+    std::ifstream wordlist(config_.wordlist_file, std::ios::binary | std::ios::ate);
+    if (!wordlist.is_open()) {
+        Logger::getInstance().error("Cannot open wordlist file: " + config_.wordlist_file);
+        return false;
+    }
+    uint64_t wordlist_size = static_cast<uint64_t>(wordlist.tellg());
+    wordlist.close();
+    wordlist_size_ = wordlist_size;
+    
+    // Load the handshake and select its MIC verifier
+    if (group_targets_.empty() && !wpa_cracker_->prepareTarget()) {
+        return false;
+    }
+    
+    // Assume short lines (~9 bytes) so the filter is not undersized
+    filter_.reset();
+    if (dedup_fp_rate_ > 0.0) {
+        filter_ = std::make_unique<CandidateFilter>(wordlist_size / 9 + 1, dedup_fp_rate_, dedup_max_memory_);
+        Logger::getInstance().info("Candidate deduplication enabled (" +
+                                 std::to_string(filter_->getMemoryUsage() / 1024) + " KB, " +
+                                 std::to_string(filter_->getHashCount()) + " hashes)");
+    }
+    
+    if (hybrid_mask_) {
+        Logger::getInstance().info("Each word expanded to " + std::to_string(hybrid_mask_->size()) +
+                                 " candidates (" + (hybrid_prefix_ ? "mask+word" : "word+mask") + ")");
     }
     
     running_ = true;
@@ -32,15 +111,41 @@ bool DictionaryAttack::crack(std::string& found_password) {
     attempts_ = 0;
     
     auto start_time = std::chrono::steady_clock::now();
+    start_time_ = start_time;
     
-    // Start worker threads
-    worker_threads_.reserve(num_threads_);
-    for (int i = 0; i < num_threads_; ++i) {
-        worker_threads_.emplace_back(&DictionaryAttack::workerThread, this);
+    // Give every NUMA node that runs workers its own slice of the wordlist
+    std::vector<int> node_threads = topology_.distributeThreads(num_threads_);
+    buffers_.clear();
+    for (size_t node = 0; node < node_threads.size(); ++node) {
+        if (node_threads[node] == 0) continue;
+        
+        auto buffer = std::make_unique<CandidateBuffer>();
+        buffer->node_index = node;
+        buffer->workers = node_threads[node];
+        buffer->loading_done = false;
+        buffer->loaded = 0;
+        buffer->position = 0;
+        buffers_.push_back(std::move(buffer));
+    }
+    
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        buffers_[i]->begin = wordlist_size * i / buffers_.size();
+        buffers_[i]->end = wordlist_size * (i + 1) / buffers_.size();
+        buffers_[i]->position = buffers_[i]->begin;
     }
     
-    // Load passwords into queue
-    loadPasswords();
+    if (topology_.isMultiNode()) {
+        Logger::getInstance().info("Spreading workers over " + std::to_string(buffers_.size()) + " NUMA nodes");
+    }
+    
+    // Start worker threads; they block on their node's queue until its reader feeds them
+    worker_threads_.reserve(num_threads_);
+    for (auto& buffer : buffers_) {
+        reader_threads_.emplace_back(&DictionaryAttack::readerThread, this, buffer.get());
+        for (int i = 0; i < buffer->workers; ++i) {
+            worker_threads_.emplace_back(&DictionaryAttack::workerThread, this, buffer.get());
+        }
+    }
     
     // Wait for completion or password found
     for (auto& thread : worker_threads_) {
@@ -49,6 +154,26 @@ bool DictionaryAttack::crack(std::string& found_password) {
         }
     }
     
+    // Readers may be blocked on a full queue once the workers are gone
+    stop();
+    for (auto& thread : reader_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    reader_threads_.clear();
+    worker_threads_.clear();
+    
+    uint64_t loaded = 0;
+    for (const auto& buffer : buffers_) {
+        loaded += buffer->loaded;
+    }
+    Logger::getInstance().info("Loaded " + std::to_string(loaded) + " valid passwords from wordlist");
+    if (filter_) {
+        Logger::getInstance().info("Skipped " + std::to_string(filter_->getDuplicates()) +
+                                 " duplicate candidates (PMK computations saved)");
+    }
+    
     auto end_time = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time);
     
@@ -66,9 +191,8 @@ bool DictionaryAttack::crack(std::string& found_password) {
 
 double DictionaryAttack::getRate() const {
     // Calculate passwords per second
-    static auto start_time = std::chrono::steady_clock::now();
     auto now = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - start_time);
+    auto duration = std::chrono::duration<double>(now - start_time_);
     
     if (duration.count() > 0) {
         return static_cast<double>(attempts_) / duration.count();
@@ -77,48 +201,228 @@ double DictionaryAttack::getRate() const {
     return 0.0;
 }
 
-void DictionaryAttack::workerThread() {
-    std::string password;
+void DictionaryAttack::workerThread(CandidateBuffer* buffer) {
+    if (topology_.isMultiNode()) {
+        topology_.bindCurrentThread(buffer->node_index);
+    }
+    
+    PMKBatch pmk_batch(lanes_);
+    std::vector<std::string> words;
+    std::unique_ptr<uint8_t[][32]> pmks(new uint8_t[batch_size_][32]);
+    
+    if (!hybrid_mask_) {
+        while (running_ && !found_ && getPasswordBatch(buffer, words)) {
+            if (testBatch(pmk_batch, words, pmks.get())) return;
+        }
+        return;
+    }
+    
+    // Hybrid mode: expand each word across the mask in place, only the
+    // words themselves ever pass through the queue
+    std::vector<std::string> batch;
+    std::vector<uint32_t> digits;
+    size_t mask_length = hybrid_mask_->length();
+    
+    while (running_ && !found_ && getPasswordBatch(buffer, words)) {
+        for (const auto& word : words) {
+            std::string candidate = hybrid_prefix_ ? std::string(mask_length, '\0') + word
+                                                   : word + std::string(mask_length, '\0');
+            size_t offset = hybrid_prefix_ ? 0 : word.size();
+            
+            hybrid_mask_->first(candidate, offset, digits);
+            do {
+                batch.push_back(candidate);
+                if (batch.size() == static_cast<size_t>(batch_size_)) {
+                    if (testBatch(pmk_batch, batch, pmks.get()) || !running_) return;
+                    batch.clear();
+                }
+            } while (hybrid_mask_->next(candidate, offset, digits));
+        }
+    }
+    
+    if (!batch.empty() && running_ && !found_) {
+        testBatch(pmk_batch, batch, pmks.get());
+    }
+}
+
+bool DictionaryAttack::testBatch(const PMKBatch& pmk_batch, const std::vector<std::string>& batch,
+                                 uint8_t (*pmks)[32]) {
+    if (!group_targets_.empty()) {
+        return testGroupBatch(pmk_batch, batch, pmks);
+    }
     
-    while (running_ && !found_ && getPasswordFromQueue(password)) {
-        if (testPasswordWorker(password)) {
+    // The verifier is immutable once the target is loaded, so workers share it
+    const HandshakeVerifier* verifier = wpa_cracker_->getVerifier();
+    
+    derivePMKs(pmk_batch, verifier->getESSID(), batch, pmks);
+    
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (verifier->testPMK(pmks[i])) {
             std::lock_guard<std::mutex> lock(result_mutex_);
             if (!found_) {
                 found_ = true;
-                result_password_ = password;
-                Logger::getInstance().info("Password found by worker thread: " + password);
+                result_password_ = batch[i];
+                Logger::getInstance().info("Password found by worker thread: " + batch[i]);
+                ProgressStream::getInstance().emit(ProgressEvent("found")
+                    .add("source", config_.output_file)
+                    .add("essid", verifier->getESSID())
+                    .add("password", batch[i]));
             }
-            break;
+            stop();
+            return true;
+        }
+    }
+    
+    reportProgress(batch.size());
+    return false;
+}
+
+bool DictionaryAttack::testGroupBatch(const PMKBatch& pmk_batch, const std::vector<std::string>& batch,
+                                      uint8_t (*pmks)[32]) {
+    derivePMKs(pmk_batch, group_essid_, batch, pmks);
+    
+    std::vector<size_t> matches;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        for (CrackTarget* target : group_handshakes_) {
+            if (target->cracked || !target->testPMK(pmks[i])) continue;
+            if (claimTarget(target, batch[i])) return true;
         }
         
-        attempts_++;
+        if (group_pmkids_.size() == 0) continue;
         
-        // Progress reporting
-        if (attempts_ % 1000 == 0) {
-            Logger::getInstance().info("Tested " + std::to_string(attempts_) + 
-                                     " passwords (" + std::to_string(static_cast<int>(getRate())) + " p/s)");
+        matches.clear();
+        group_pmkids_.match(group_essid_, pmks[i], matches);
+        for (size_t id : matches) {
+            for (CrackTarget* target : group_pmkid_targets_[id]) {
+                if (!target->cracked && claimTarget(target, batch[i])) return true;
+            }
         }
     }
+    
+    reportProgress(batch.size());
+    return false;
+}
+
+bool DictionaryAttack::claimTarget(CrackTarget* target, const std::string& password) {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    if (target->cracked) return false;
+    
+    target->password = password;
+    target->cracked = true;
+    Logger::getInstance().info("Password found for " + target->source + ": " + password);
+    ProgressStream::getInstance().emit(ProgressEvent("found")
+        .add("source", target->source)
+        .add("type", target->describe())
+        .add("essid", target->essid)
+        .add("bssid", target->ap_mac.toString())
+        .add("station", target->client_mac.toString())
+        .add("password", password)
+        .add("targets_remaining", group_remaining_ - 1));
+    
+    // The run is only over once every target of the ESSID has fallen
+    if (--group_remaining_ == 0) {
+        found_ = true;
+        result_password_ = password;
+        stop();
+        return true;
+    }
+    return false;
 }
 
-void DictionaryAttack::loadPasswords() {
-    if (config_.wordlist_file.empty()) {
-        Logger::getInstance().error("No wordlist file specified");
-        running_ = false;
+void DictionaryAttack::derivePMKs(const PMKBatch& pmk_batch, const std::string& essid,
+                                  const std::vector<std::string>& batch, uint8_t (*pmks)[32]) {
+    if (!pmk_cache_) {
+        pmk_batch.derive(batch.data(), batch.size(), essid, pmks);
         return;
     }
     
-    std::ifstream wordlist(config_.wordlist_file);
-    if (!wordlist.is_open()) {
-        Logger::getInstance().error("Cannot open wordlist file: " + config_.wordlist_file);
-        running_ = false;
+    std::vector<bool> hit;
+    if (pmk_cache_->lookup(essid, batch, pmks, hit) == batch.size()) {
         return;
     }
     
+    // Derive only the misses, packed so the lanes stay full
+    std::vector<std::string> misses;
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!hit[i]) {
+            misses.push_back(batch[i]);
+            positions.push_back(i);
+        }
+    }
+    
+    std::unique_ptr<uint8_t[][32]> derived(new uint8_t[misses.size()][32]);
+    pmk_batch.derive(misses.data(), misses.size(), essid, derived.get());
+    for (size_t j = 0; j < misses.size(); ++j) {
+        memcpy(pmks[positions[j]], derived[j], 32);
+    }
+    
+    pmk_cache_->store(essid, misses.data(), derived.get(), misses.size());
+}
+
+void DictionaryAttack::reportProgress(size_t tested) {
+    uint64_t before = attempts_.fetch_add(tested);
+    uint64_t after = before + tested;
+    
+    // Progress reporting
+    if (before / 1000 != after / 1000) {
+        Logger::getInstance().info("Tested " + std::to_string(after) + 
+                                 " passwords (" + std::to_string(static_cast<int>(getRate())) + " p/s)");
+    }
+    
+    ProgressStream& stream = ProgressStream::getInstance();
+    if (!stream.progressDue()) return;
+    
+    // Keyspace position is the share of the wordlist the readers have consumed
+    uint64_t consumed = 0;
+    for (const auto& buffer : buffers_) {
+        consumed += buffer->position.load(std::memory_order_relaxed) - buffer->begin;
+    }
+    double fraction = wordlist_size_ > 0 ? static_cast<double>(consumed) / wordlist_size_ : 1.0;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+    
+    size_t remaining = 1;
+    if (!group_targets_.empty()) {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        remaining = group_remaining_;
+    }
+    
+    ProgressEvent event("progress");
+    event.add("attack", hybrid_mask_ ? "hybrid" : "dictionary")
+         .add("tested", after)
+         .add("rate", getRate())
+         .add("position", consumed)
+         .add("keyspace", wordlist_size_)
+         .add("progress", fraction)
+         .add("eta", fraction > 0.0 ? elapsed * (1.0 - fraction) / fraction : NAN)
+         .add("targets_remaining", remaining);
+    if (!group_essid_.empty()) {
+        event.add("essid", group_essid_);
+    }
+    stream.emit(event, true);
+}
+
+void DictionaryAttack::readerThread(CandidateBuffer* buffer) {
+    // Strings built here are first touched on this node, so they stay node-local
+    if (topology_.isMultiNode()) {
+        topology_.bindCurrentThread(buffer->node_index);
+    }
+    
+    std::ifstream wordlist(config_.wordlist_file, std::ios::binary);
     std::string password;
-    int loaded = 0;
+    uint64_t pos = buffer->begin;
     
-    while (std::getline(wordlist, password) && running_) {
+    // A line belongs to the slice its first byte falls in
+    if (buffer->begin > 0) {
+        wordlist.seekg(buffer->begin - 1);
+        std::getline(wordlist, password);
+        pos = buffer->begin + password.size();
+    }
+    
+    while (pos < buffer->end && std::getline(wordlist, password) && running_ && !found_) {
+        pos += password.size() + 1;
+        buffer->position.store(std::min(pos, buffer->end), std::memory_order_relaxed);
+        
         // Trim whitespace
         password.erase(0, password.find_first_not_of(" \t\r\n"));
         password.erase(password.find_last_not_of(" \t\r\n") + 1);
@@ -126,48 +430,62 @@ void DictionaryAttack::loadPasswords() {
         // Skip empty lines and comments
         if (password.empty() || password[0] == '#') continue;
         
-        // WPA password length validation
-        if (password.length() >= 8 && password.length() <= 63) {
-            addPasswordToQueue(password);
-            loaded++;
-        }
-        
-        if (loaded % 100000 == 0) {
-            Logger::getInstance().info("Loaded " + std::to_string(loaded) + " passwords");
+        // WPA password length validation, counting what the mask adds
+        size_t length = password.length() + (hybrid_mask_ ? hybrid_mask_->length() : 0);
+        if (length >= 8 && length <= 63) {
+            if (filter_ && !filter_->insert(password)) continue;
+            
+            addPasswordToQueue(buffer, password);
+            buffer->loaded++;
+            
+            if (buffer->loaded % 100000 == 0) {
+                Logger::getInstance().debug("Node " + std::to_string(buffer->node_index) + " loaded " +
+                                          std::to_string(buffer->loaded) + " passwords");
+            }
         }
     }
     
-    Logger::getInstance().info("Loaded " + std::to_string(loaded) + " valid passwords from wordlist");
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->loading_done = true;
+    }
+    buffer->cv.notify_all();
 }
 
-bool DictionaryAttack::testPasswordWorker(const std::string& password) {
-    // Create a local WPA cracker instance for this thread
-    WPACrack local_cracker(config_);
+void DictionaryAttack::addPasswordToQueue(CandidateBuffer* buffer, std::string& password) {
+    std::unique_lock<std::mutex> lock(buffer->mutex);
     
-    // Test the password (this would need access to the handshake)
-    std::string temp_result;
+    // Keep a few batches per worker buffered rather than the whole slice
+    size_t limit = static_cast<size_t>(batch_size_) * buffer->workers * 4;
+    buffer->cv.wait(lock, [&] { return buffer->queue.size() < limit || !running_ || found_; });
     
-    // For now, we'll use a simplified approach
-    // In a real implementation, we'd need to share the handshake data
-    // between threads more efficiently
-    
-    return false; // Placeholder - actual implementation would test against handshake
-}
-
-void DictionaryAttack::addPasswordToQueue(const std::string& password) {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    password_queue_.push(password);
+    buffer->queue.push(std::move(password));
+    if (buffer->queue.size() >= static_cast<size_t>(batch_size_)) {
+        buffer->cv.notify_one();
+    }
 }
 
-bool DictionaryAttack::getPasswordFromQueue(std::string& password) {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
+bool DictionaryAttack::getPasswordBatch(CandidateBuffer* buffer, std::vector<std::string>& batch) {
+    std::unique_lock<std::mutex> lock(buffer->mutex);
     
-    if (password_queue_.empty()) {
+    buffer->cv.wait(lock, [&] {
+        return buffer->queue.size() >= static_cast<size_t>(batch_size_) ||
+               buffer->loading_done || !running_ || found_;
+    });
+    
+    if (buffer->queue.empty() || !running_ || found_) {
         return false;
     }
     
-    password = password_queue_.front();
-    password_queue_.pop();
+    batch.clear();
+    while (!buffer->queue.empty() && batch.size() < static_cast<size_t>(batch_size_)) {
+        batch.push_back(std::move(buffer->queue.front()));
+        buffer->queue.pop();
+    }
+    
+    // Wake the reader if it is waiting for room
+    lock.unlock();
+    buffer->cv.notify_all();
     return true;
 }
 
@@ -0,0 +1,173 @@
+#include "airlevi-crack/handshake_verifier.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <cstring>
+
+namespace airlevi {
+
+namespace {
+
+const char kPairwiseLabel[] = "Pairwise key expansion";
+
+// PRF-SHA1 input for the first 160-bit block: label || 0x00 || data || counter(0)
+std::vector<uint8_t> buildPRFInput(const std::vector<uint8_t>& ptk_data) {
+    std::vector<uint8_t> input(kPairwiseLabel, kPairwiseLabel + sizeof(kPairwiseLabel) - 1);
+    input.push_back(0x00);
+    input.insert(input.end(), ptk_data.begin(), ptk_data.end());
+    input.push_back(0x00);
+    return input;
+}
+
+// KDF-SHA256 input for the first 256-bit block of a 384-bit PTK:
+// counter(1, LE16) || label || data || length(384, LE16)
+std::vector<uint8_t> buildKDFInput(const std::vector<uint8_t>& ptk_data) {
+    std::vector<uint8_t> input = {0x01, 0x00};
+    input.insert(input.end(), kPairwiseLabel, kPairwiseLabel + sizeof(kPairwiseLabel) - 1);
+    input.insert(input.end(), ptk_data.begin(), ptk_data.end());
+    input.push_back(0x80);
+    input.push_back(0x01);
+    return input;
+}
+
+void prfSha1KCK(const uint8_t* pmk, const HandshakeTarget& target, uint8_t* kck) {
+    unsigned char block[SHA_DIGEST_LENGTH];
+    unsigned int block_len;
+    HMAC(EVP_sha1(), pmk, 32, target.kck_input.data(), target.kck_input.size(), block, &block_len);
+    memcpy(kck, block, 16);
+}
+
+} // namespace
+
+void MICKernel<KeyDescriptorVersion::HMAC_MD5_RC4>::deriveKCK(const uint8_t* pmk,
+                                                              const HandshakeTarget& target,
+                                                              uint8_t* kck) {
+    prfSha1KCK(pmk, target, kck);
+}
+
+void MICKernel<KeyDescriptorVersion::HMAC_MD5_RC4>::computeMIC(const uint8_t* kck,
+                                                               const HandshakeTarget& target,
+                                                               uint8_t* mic) {
+    unsigned int mic_len;
+    HMAC(EVP_md5(), kck, 16, target.eapol_frame.data(), target.eapol_frame.size(), mic, &mic_len);
+}
+
+void MICKernel<KeyDescriptorVersion::HMAC_SHA1_AES>::deriveKCK(const uint8_t* pmk,
+                                                               const HandshakeTarget& target,
+                                                               uint8_t* kck) {
+    prfSha1KCK(pmk, target, kck);
+}
+
+void MICKernel<KeyDescriptorVersion::HMAC_SHA1_AES>::computeMIC(const uint8_t* kck,
+                                                                const HandshakeTarget& target,
+                                                                uint8_t* mic) {
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    unsigned int digest_len;
+    HMAC(EVP_sha1(), kck, 16, target.eapol_frame.data(), target.eapol_frame.size(), digest, &digest_len);
+    memcpy(mic, digest, EAPOL_MIC_LENGTH);
+}
+
+void MICKernel<KeyDescriptorVersion::AES_128_CMAC>::deriveKCK(const uint8_t* pmk,
+                                                              const HandshakeTarget& target,
+                                                              uint8_t* kck) {
+    unsigned char block[SHA256_DIGEST_LENGTH];
+    unsigned int block_len;
+    HMAC(EVP_sha256(), pmk, 32, target.kck_input.data(), target.kck_input.size(), block, &block_len);
+    memcpy(kck, block, 16);
+}
+
+void MICKernel<KeyDescriptorVersion::AES_128_CMAC>::computeMIC(const uint8_t* kck,
+                                                               const HandshakeTarget& target,
+                                                               uint8_t* mic) {
+    if (!CryptoUtils::aesCmac(kck, target.eapol_frame.data(), target.eapol_frame.size(), mic)) {
+        memset(mic, 0, EAPOL_MIC_LENGTH);
+    }
+}
+
+template <KeyDescriptorVersion V>
+bool HandshakeVerifier::verify(const uint8_t* pmk, const HandshakeTarget& target) {
+    uint8_t kck[16];
+    uint8_t mic[EVP_MAX_MD_SIZE];
+
+    MICKernel<V>::deriveKCK(pmk, target, kck);
+    MICKernel<V>::computeMIC(kck, target, mic);
+
+    return CRYPTO_memcmp(mic, target.mic, EAPOL_MIC_LENGTH) == 0;
+}
+
+HandshakeVerifier::HandshakeVerifier(const HandshakePacket& handshake) : verify_(nullptr) {
+    target_.essid = handshake.essid;
+    target_.ap_mac = handshake.ap_mac;
+    target_.client_mac = handshake.client_mac;
+    target_.key_version = handshake.key_version;
+
+    if (handshake.mic.size() != EAPOL_MIC_LENGTH ||
+        handshake.eapol_data.size() < EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH) {
+        return;
+    }
+
+    memcpy(target_.mic, handshake.mic.data(), EAPOL_MIC_LENGTH);
+
+    target_.eapol_frame = handshake.eapol_data;
+    std::fill(target_.eapol_frame.begin() + EAPOL_MIC_OFFSET,
+              target_.eapol_frame.begin() + EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH, 0);
+
+    auto ptk_data = CryptoUtils::buildPTKData(handshake.ap_mac, handshake.client_mac,
+                                             handshake.anonce, handshake.snonce);
+
+    // Select the kernel once; the per-candidate path never branches on the version
+    switch (handshake.key_version) {
+        case KeyDescriptorVersion::HMAC_MD5_RC4:
+            target_.kck_input = buildPRFInput(ptk_data);
+            verify_ = &HandshakeVerifier::verify<KeyDescriptorVersion::HMAC_MD5_RC4>;
+            break;
+        case KeyDescriptorVersion::HMAC_SHA1_AES:
+            target_.kck_input = buildPRFInput(ptk_data);
+            verify_ = &HandshakeVerifier::verify<KeyDescriptorVersion::HMAC_SHA1_AES>;
+            break;
+        case KeyDescriptorVersion::AES_128_CMAC:
+            target_.kck_input = buildKDFInput(ptk_data);
+            verify_ = &HandshakeVerifier::verify<KeyDescriptorVersion::AES_128_CMAC>;
+            break;
+    }
+}
+
+bool HandshakeVerifier::testPassword(const std::string& password) const {
+    if (!verify_ || password.length() < 8 || password.length() > 63) {
+        return false;
+    }
+
+    uint8_t pmk[32];
+    PKCS5_PBKDF2_HMAC(password.c_str(), password.length(),
+                      reinterpret_cast<const unsigned char*>(target_.essid.c_str()), target_.essid.length(),
+                      4096, EVP_sha1(), 32, pmk);
+
+    return verify_(pmk, target_);
+}
+
+std::string HandshakeVerifier::describe(KeyDescriptorVersion version) {
+    switch (version) {
+        case KeyDescriptorVersion::HMAC_MD5_RC4:  return "WPA (HMAC-MD5)";
+        case KeyDescriptorVersion::HMAC_SHA1_AES: return "WPA2 (HMAC-SHA1-128)";
+        case KeyDescriptorVersion::AES_128_CMAC:  return "WPA2/802.11w (AES-128-CMAC)";
+    }
+    return "Unknown (" + std::to_string(static_cast<int>(version)) + ")";
+}
+
+PMKIDVerifier::PMKIDVerifier(const std::string& essid, const MacAddress& ap_mac,
+                             const MacAddress& client_mac, const uint8_t* pmkid)
+    : essid_(essid) {
+    memcpy(message_, "PMK Name", 8);
+    memcpy(message_ + 8, ap_mac.bytes, 6);
+    memcpy(message_ + 14, client_mac.bytes, 6);
+    memcpy(pmkid_, pmkid, 16);
+}
+
+bool PMKIDVerifier::testPMK(const uint8_t* pmk) const {
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    unsigned int digest_len;
+    HMAC(EVP_sha1(), pmk, 32, message_, sizeof(message_), digest, &digest_len);
+    return CRYPTO_memcmp(digest, pmkid_, 16) == 0;
+}
+
+} // namespace airlevi
@@ -7,7 +7,11 @@
 #include "airlevi-crack/wpa_crack.h"
 #include "airlevi-crack/dictionary_attack.h"
 #include "airlevi-crack/brute_force.h"
+#include "airlevi-crack/autotune.h"
+#include "airlevi-crack/batch_job.h"
+#include "airlevi-crack/pmk_cache.h"
 #include "common/logger.h"
+#include "common/progress_stream.h"
 #include "common/config.h"
 
 using namespace airlevi;
@@ -35,6 +39,18 @@ void printUsage(const char* program_name) {
     std::cout << "  --min-length NUM         Minimum password length for brute force\n";
     std::cout << "  --max-length NUM         Maximum password length for brute force\n";
     std::cout << "  --charset CHARSET        Character set for brute force\n";
+    std::cout << "  --batch PATH             Batch mode over a capture/22000 file, directory or manifest\n";
+    std::cout << "                           (repeatable, replaces -f; needs -w)\n";
+    std::cout << "  --hybrid-suffix MASK     Wordlist entries followed by MASK (e.g. ?d?d?s)\n";
+    std::cout << "  --hybrid-prefix MASK     MASK followed by wordlist entries\n";
+    std::cout << "  --pmk-cache FILE         Reuse PMKs from, and add new ones to, an on-disk cache\n";
+    std::cout << "  --pmk-cache-size NUM     Maximum cache entries before LRU eviction (default: 10000000)\n";
+    std::cout << "  --markov FILE            Order brute-force candidates by a model trained on FILE\n";
+    std::cout << "  --autotune               Re-run the crack engine calibration and save it\n";
+    std::cout << "  --dedup[=RATE]           Skip repeated wordlist candidates (false-positive rate, default 0.0001)\n";
+    std::cout << "  --dedup-memory MB        Memory cap for the dedup filter (default: 512)\n";
+    std::cout << "  --progress-stream DEST   NDJSON progress and results to a file or fd:N\n";
+    std::cout << "  --progress-interval MS   Minimum time between progress events (default: 1000)\n";
     std::cout << "\nAttack Types:\n";
     std::cout << "  wep                      WEP key recovery\n";
     std::cout << "  wpa                      WPA/WPA2 dictionary attack\n";
@@ -43,6 +59,7 @@ void printUsage(const char* program_name) {
     std::cout << "  " << program_name << " -f capture.cap -t wep\n";
     std::cout << "  " << program_name << " -f capture.cap -t wpa -w wordlist.txt\n";
     std::cout << "  " << program_name << " -f capture.cap -t wpa --brute-force --min-length 8\n";
+    std::cout << "  " << program_name << " -f capture.cap -t wpa -w words.txt --hybrid-suffix ?d?d?s\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -52,7 +69,18 @@ int main(int argc, char* argv[]) {
     int min_length = 8;
     int max_length = 12;
     std::string charset = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-    int num_threads = std::thread::hardware_concurrency();
+    int num_threads = 0; // 0 = take from the tuning profile
+    std::string markov_file;
+    std::string hybrid_mask;
+    std::vector<std::string> batch_paths;
+    std::string pmk_cache_file;
+    uint64_t pmk_cache_size = 10000000;
+    bool hybrid_prefix = false;
+    bool force_autotune = false;
+    double dedup_rate = 0.0;
+    size_t dedup_memory_mb = 512;
+    std::string progress_stream;
+    int progress_interval = 1000;
     
     // Default values
     config.verbose = false;
@@ -70,6 +98,17 @@ int main(int argc, char* argv[]) {
         {"min-length", required_argument, 0, 1001},
         {"max-length", required_argument, 0, 1002},
         {"charset", required_argument, 0, 1003},
+        {"autotune", no_argument, 0, 1004},
+        {"dedup", optional_argument, 0, 1005},
+        {"dedup-memory", required_argument, 0, 1006},
+        {"markov", required_argument, 0, 1007},
+        {"hybrid-suffix", required_argument, 0, 1008},
+        {"hybrid-prefix", required_argument, 0, 1009},
+        {"batch", required_argument, 0, 1010},
+        {"pmk-cache", required_argument, 0, 1011},
+        {"pmk-cache-size", required_argument, 0, 1012},
+        {"progress-stream", required_argument, 0, 1013},
+        {"progress-interval", required_argument, 0, 1014},
         {0, 0, 0, 0}
     };
     
@@ -112,13 +151,49 @@ int main(int argc, char* argv[]) {
             case 1003:
                 charset = optarg;
                 break;
+            case 1004:
+                force_autotune = true;
+                break;
+            case 1005:
+                dedup_rate = optarg ? std::atof(optarg) : 0.0001;
+                break;
+            case 1006:
+                dedup_memory_mb = std::atoi(optarg);
+                break;
+            case 1007:
+                markov_file = optarg;
+                break;
+            case 1008:
+            case 1009:
+                hybrid_mask = optarg;
+                hybrid_prefix = (c == 1009);
+                if (hybrid_mask.empty()) {
+                    std::cerr << "Error: Hybrid mask is empty" << std::endl;
+                    return 1;
+                }
+                break;
+            case 1010:
+                batch_paths.push_back(optarg);
+                break;
+            case 1011:
+                pmk_cache_file = optarg;
+                break;
+            case 1012:
+                pmk_cache_size = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 1013:
+                progress_stream = optarg;
+                break;
+            case 1014:
+                progress_interval = std::atoi(optarg);
+                break;
             default:
                 printUsage(argv[0]);
                 return 1;
         }
     }
     
-    if (config.output_file.empty()) {
+    if (config.output_file.empty() && batch_paths.empty()) {
         std::cerr << "Error: Capture file is required (-f option)" << std::endl;
         printUsage(argv[0]);
         return 1;
@@ -135,9 +210,39 @@ int main(int argc, char* argv[]) {
         // Initialize logger
         Logger::getInstance().setVerbose(config.verbose);
         
-        std::cout << "Capture file: " << config.output_file << std::endl;
+        ProgressStream& stream = ProgressStream::getInstance();
+        if (!progress_stream.empty()) {
+            if (!stream.open(progress_stream, "airlevi-crack")) {
+                return 1;
+            }
+            stream.setInterval(std::chrono::milliseconds(progress_interval > 0 ? progress_interval : 1000));
+        }
+        
+        // Batch size, lane width and thread count come from a per-host profile
+        CrackTuning tuning = {static_cast<int>(std::thread::hardware_concurrency()), 64, 8, 0.0};
+        bool wpa_attack = (attack_type == "wpa" || attack_type == "wpa2") &&
+                          (brute_force || !config.wordlist_file.empty() || !batch_paths.empty());
+        if (wpa_attack || force_autotune) {
+            Autotuner autotuner(num_threads);
+            if (force_autotune || !autotuner.loadProfile(tuning)) {
+                tuning = autotuner.calibrate();
+                if (autotuner.saveProfile(tuning)) {
+                    Logger::getInstance().info("Saved tuning profile to " + Autotuner::profilePath());
+                }
+            }
+        }
+        if (num_threads > 0) {
+            tuning.threads = num_threads;
+        }
+        
+        if (batch_paths.empty()) {
+            std::cout << "Capture file: " << config.output_file << std::endl;
+        }
         std::cout << "Attack type: " << attack_type << std::endl;
-        std::cout << "Threads: " << num_threads << std::endl;
+        std::cout << "Threads: " << tuning.threads << std::endl;
+        if (wpa_attack) {
+            std::cout << "Batch size: " << tuning.batch_size << " (" << tuning.lanes << " lanes)" << std::endl;
+        }
         
         if (!config.target_bssid.empty()) {
             std::cout << "Target BSSID: " << config.target_bssid << std::endl;
@@ -147,22 +252,73 @@ int main(int argc, char* argv[]) {
             std::cout << "Target ESSID: " << config.target_essid << std::endl;
         }
         
+        PMKCache pmk_cache;
+        if (!pmk_cache_file.empty() && !pmk_cache.open(pmk_cache_file, pmk_cache_size)) {
+            return 1;
+        }
+        PMKCache* cache = pmk_cache.isOpen() ? &pmk_cache : nullptr;
+        
         std::cout << "\nStarting attack... Press Ctrl+C to stop\n" << std::endl;
         
         bool success = false;
         std::string found_password;
         
-        if (attack_type == "wep") {
+        if (!batch_paths.empty()) {
+            if (config.wordlist_file.empty()) {
+                std::cerr << "Error: Batch mode needs a wordlist (-w option)" << std::endl;
+                return 1;
+            }
+            
+            BatchJob job(config, tuning.threads);
+            for (const auto& path : batch_paths) {
+                job.addPath(path);
+            }
+            
+            // Plain words first, then the mask pass over whatever is left
+            job.addWordlistPass(config.wordlist_file);
+            if (!hybrid_mask.empty()) {
+                job.addHybridPass(config.wordlist_file, hybrid_mask, hybrid_prefix);
+            }
+            
+            job.run([&](DictionaryAttack& attack) {
+                attack.setBatchSize(tuning.batch_size);
+                attack.setLanes(tuning.lanes);
+                attack.setDeduplication(dedup_rate, dedup_memory_mb * 1024 * 1024);
+                attack.setPMKCache(cache);
+                return true;
+            });
+            job.printReport(std::cout);
+            stream.emit(ProgressEvent("result")
+                .add("mode", "batch")
+                .add("targets", job.getTargetCount())
+                .add("cracked", job.getCrackedCount()));
+            if (cache) {
+                std::cout << "PMK cache: " << cache->getHits() << " hits, " << cache->getMisses() << " misses" << std::endl;
+            }
+            return job.getCrackedCount() > 0 ? 0 : 1;
+        } else if (attack_type == "wep") {
             WEPCrack wep_cracker(config);
             success = wep_cracker.crack(found_password);
         } else if (attack_type == "wpa" || attack_type == "wpa2") {
             if (brute_force) {
-                BruteForce brute_forcer(config, num_threads);
+                BruteForce brute_forcer(config, tuning.threads);
                 brute_forcer.setCharset(charset);
                 brute_forcer.setLengthRange(min_length, max_length);
+                if (!markov_file.empty() && !brute_forcer.loadMarkovModel(markov_file)) {
+                    return 1;
+                }
+                brute_forcer.setBatchSize(tuning.batch_size);
+                brute_forcer.setLanes(tuning.lanes);
                 success = brute_forcer.crack(found_password);
             } else if (!config.wordlist_file.empty()) {
-                DictionaryAttack dict_attack(config, num_threads);
+                DictionaryAttack dict_attack(config, tuning.threads);
+                dict_attack.setBatchSize(tuning.batch_size);
+                dict_attack.setLanes(tuning.lanes);
+                dict_attack.setDeduplication(dedup_rate, dedup_memory_mb * 1024 * 1024);
+                dict_attack.setPMKCache(cache);
+                if (!hybrid_mask.empty() && !dict_attack.setHybridMask(hybrid_mask, hybrid_prefix)) {
+                    return 1;
+                }
                 success = dict_attack.crack(found_password);
             } else {
                 WPACrack wpa_cracker(config);
@@ -173,6 +329,17 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
+        if (cache) {
+            std::cout << "PMK cache: " << cache->getHits() << " hits, " << cache->getMisses() << " misses" << std::endl;
+        }
+        
+        ProgressEvent result("result");
+        result.add("mode", attack_type).add("found", success);
+        if (success) {
+            result.add("password", found_password);
+        }
+        stream.emit(result);
+        
         if (success) {
             std::cout << "\n[+] SUCCESS! Password found: " << found_password << std::endl;
         } else {
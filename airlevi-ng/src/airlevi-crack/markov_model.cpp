@@ -0,0 +1,66 @@
+#include "airlevi-crack/markov_model.h"
+#include "common/logger.h"
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+
+namespace airlevi {
+
+MarkovModel::MarkovModel(const std::string& charset) : charset_(charset), samples_(0) {
+    std::fill(index_, index_ + 256, -1);
+    for (size_t i = charset_.size(); i-- > 0;) {
+        index_[static_cast<uint8_t>(charset_[i])] = static_cast<int>(i);
+    }
+
+    // Untrained model: plain charset order everywhere
+    order_.resize(static_cast<size_t>(MAX_POSITIONS) * (charset_.size() + 1) * charset_.size());
+    for (size_t s = 0; s < order_.size(); s += charset_.size()) {
+        std::copy(charset_.begin(), charset_.end(), order_.begin() + s);
+    }
+}
+
+bool MarkovModel::train(const std::string& training_file) {
+    std::ifstream file(training_file);
+    if (!file.is_open()) {
+        Logger::getInstance().error("Cannot open Markov training file: " + training_file);
+        return false;
+    }
+
+    size_t cs = charset_.size();
+    std::vector<uint64_t> counts(order_.size(), 0);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        int prev = -1;
+        for (size_t pos = 0; pos < line.size() && pos < static_cast<size_t>(MAX_POSITIONS); ++pos) {
+            int idx = indexOf(line[pos]);
+            if (idx < 0) {
+                // Characters outside the charset break the chain
+                prev = -1;
+                continue;
+            }
+            counts[slot(pos, prev) + idx]++;
+            prev = idx;
+        }
+        samples_++;
+    }
+
+    // Stable sort keeps charset order among equally likely characters
+    std::vector<int> ranks(cs);
+    for (size_t s = 0; s < order_.size(); s += cs) {
+        std::iota(ranks.begin(), ranks.end(), 0);
+        std::stable_sort(ranks.begin(), ranks.end(),
+                         [&](int a, int b) { return counts[s + a] > counts[s + b]; });
+        for (size_t r = 0; r < cs; ++r) {
+            order_[s + r] = charset_[ranks[r]];
+        }
+    }
+
+    Logger::getInstance().info("Trained Markov model on " + std::to_string(samples_) + " passwords");
+    return true;
+}
+
+} // namespace airlevi
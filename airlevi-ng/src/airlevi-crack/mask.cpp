@@ -0,0 +1,76 @@
+#include "airlevi-crack/mask.h"
+#include "common/logger.h"
+
+namespace airlevi {
+
+namespace {
+
+const char kLower[] = "abcdefghijklmnopqrstuvwxyz";
+const char kUpper[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char kDigits[] = "0123456789";
+const char kSymbols[] = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+} // namespace
+
+bool Mask::compile(const std::string& mask) {
+    positions_.clear();
+    size_ = 1;
+
+    if (mask.empty()) {
+        Logger::getInstance().error("Mask is empty");
+        return false;
+    }
+
+    for (size_t i = 0; i < mask.size(); ++i) {
+        if (mask[i] != '?') {
+            positions_.push_back(std::string(1, mask[i]));
+            continue;
+        }
+
+        if (i + 1 >= mask.size()) {
+            Logger::getInstance().error("Mask ends with a bare '?': " + mask);
+            return false;
+        }
+
+        switch (mask[++i]) {
+            case 'l': positions_.push_back(kLower); break;
+            case 'u': positions_.push_back(kUpper); break;
+            case 'd': positions_.push_back(kDigits); break;
+            case 's': positions_.push_back(kSymbols); break;
+            case 'a': positions_.push_back(std::string(kLower) + kUpper + kDigits + kSymbols); break;
+            case 'h': positions_.push_back(std::string(kDigits) + "abcdef"); break;
+            case 'H': positions_.push_back(std::string(kDigits) + "ABCDEF"); break;
+            case '?': positions_.push_back("?"); break;
+            default:
+                Logger::getInstance().error("Unknown mask class '?" + std::string(1, mask[i]) + "' in " + mask);
+                return false;
+        }
+    }
+
+    for (const auto& charset : positions_) {
+        size_ *= charset.size();
+    }
+
+    return true;
+}
+
+void Mask::first(std::string& out, size_t offset, std::vector<uint32_t>& digits) const {
+    digits.assign(positions_.size(), 0);
+    for (size_t p = 0; p < positions_.size(); ++p) {
+        out[offset + p] = positions_[p][0];
+    }
+}
+
+bool Mask::next(std::string& out, size_t offset, std::vector<uint32_t>& digits) const {
+    for (size_t p = positions_.size(); p-- > 0;) {
+        if (++digits[p] < positions_[p].size()) {
+            out[offset + p] = positions_[p][digits[p]];
+            return true;
+        }
+        digits[p] = 0;
+        out[offset + p] = positions_[p][0];
+    }
+    return false;
+}
+
+} // namespace airlevi
@@ -0,0 +1,159 @@
+#include "airlevi-crack/pmk_batch.h"
+#include "common/sha1_lanes.h"
+#include <openssl/evp.h>
+#include <algorithm>
+#include <cstring>
+
+namespace airlevi {
+
+namespace {
+
+// Hash a 20-byte digest that follows one already-compressed 64-byte pad block
+template <int L>
+void hashDigestBlock(uint32_t out[5][L], const uint32_t start[5][L], const uint32_t digest[5][L]) {
+    uint32_t block[16][L];
+    for (int l = 0; l < L; ++l) {
+        for (int i = 0; i < 5; ++i) block[i][l] = digest[i][l];
+        block[5][l] = 0x80000000;
+        for (int i = 6; i < 15; ++i) block[i][l] = 0;
+        block[15][l] = (64 + 20) * 8;
+    }
+    for (int i = 0; i < 5; ++i)
+        for (int l = 0; l < L; ++l) out[i][l] = start[i][l];
+    sha1Compress<L>(out, block);
+}
+
+template <int L>
+void deriveGroup(const std::string* const* passwords, const std::string& essid, uint8_t (*const* pmks)[32]) {
+    uint32_t istate[5][L], ostate[5][L];
+    uint32_t ipad[16][L], opad[16][L];
+
+    // HMAC key schedule: compress K^ipad and K^opad once per candidate
+    for (int l = 0; l < L; ++l) {
+        uint8_t key[64] = {0};
+        const std::string& pw = *passwords[l];
+        memcpy(key, pw.data(), std::min<size_t>(pw.size(), 64));
+        for (int i = 0; i < 16; ++i) {
+            uint32_t word = loadBE32(key + i * 4);
+            ipad[i][l] = word ^ 0x36363636;
+            opad[i][l] = word ^ 0x5c5c5c5c;
+        }
+        for (int i = 0; i < 5; ++i) {
+            istate[i][l] = kSha1Init[i];
+            ostate[i][l] = kSha1Init[i];
+        }
+    }
+    sha1Compress<L>(istate, ipad);
+    sha1Compress<L>(ostate, opad);
+
+    for (uint32_t block_index = 1; block_index <= 2; ++block_index) {
+        // U1 = HMAC(P, ESSID || INT(i)), a single block since the ESSID is at most 32 bytes
+        uint8_t first[64] = {0};
+        memcpy(first, essid.data(), essid.size());
+        storeBE32(first + essid.size(), block_index);
+        first[essid.size() + 4] = 0x80;
+        uint64_t bits = (64 + essid.size() + 4) * 8;
+        storeBE32(first + 56, static_cast<uint32_t>(bits >> 32));
+        storeBE32(first + 60, static_cast<uint32_t>(bits));
+
+        uint32_t msg[16][L];
+        for (int i = 0; i < 16; ++i) {
+            uint32_t word = loadBE32(first + i * 4);
+            for (int l = 0; l < L; ++l) msg[i][l] = word;
+        }
+
+        uint32_t inner[5][L], u[5][L], t[5][L];
+        for (int i = 0; i < 5; ++i)
+            for (int l = 0; l < L; ++l) inner[i][l] = istate[i][l];
+        sha1Compress<L>(inner, msg);
+        hashDigestBlock<L>(u, ostate, inner);
+
+        for (int i = 0; i < 5; ++i)
+            for (int l = 0; l < L; ++l) t[i][l] = u[i][l];
+
+        for (int iter = 1; iter < 4096; ++iter) {
+            hashDigestBlock<L>(inner, istate, u);
+            hashDigestBlock<L>(u, ostate, inner);
+            for (int i = 0; i < 5; ++i)
+                for (int l = 0; l < L; ++l) t[i][l] ^= u[i][l];
+        }
+
+        for (int l = 0; l < L; ++l) {
+            uint8_t digest[20];
+            for (int i = 0; i < 5; ++i) storeBE32(digest + i * 4, t[i][l]);
+            if (block_index == 1) {
+                memcpy(*pmks[l], digest, 20);
+            } else {
+                memcpy(*pmks[l] + 20, digest, 12);
+            }
+        }
+    }
+}
+
+template <int L>
+void deriveLanes(const std::string* passwords, size_t count, const std::string& essid, uint8_t (*pmks)[32]) {
+    // The single-block U1 layout only holds ESSIDs up to 32 bytes (the 802.11 maximum)
+    if (essid.size() > 32) {
+        for (size_t i = 0; i < count; ++i) {
+            PKCS5_PBKDF2_HMAC(passwords[i].c_str(), passwords[i].length(),
+                              reinterpret_cast<const unsigned char*>(essid.c_str()), essid.length(),
+                              4096, EVP_sha1(), 32, pmks[i]);
+        }
+        return;
+    }
+
+    uint8_t scratch[L][32];
+    for (size_t base = 0; base < count; base += L) {
+        const std::string* lane_passwords[L];
+        uint8_t (*lane_pmks[L])[32];
+
+        // A partial last group repeats its final candidate into a scratch PMK
+        for (int l = 0; l < L; ++l) {
+            size_t index = base + l;
+            if (index < count) {
+                lane_passwords[l] = &passwords[index];
+                lane_pmks[l] = &pmks[index];
+            } else {
+                lane_passwords[l] = &passwords[count - 1];
+                lane_pmks[l] = &scratch[l];
+            }
+        }
+
+        deriveGroup<L>(lane_passwords, essid, lane_pmks);
+    }
+
+    // Passphrases longer than one HMAC block are not valid WPA keys, but keep them correct
+    for (size_t i = 0; i < count; ++i) {
+        if (passwords[i].size() > 64) {
+            PKCS5_PBKDF2_HMAC(passwords[i].c_str(), passwords[i].length(),
+                              reinterpret_cast<const unsigned char*>(essid.c_str()), essid.length(),
+                              4096, EVP_sha1(), 32, pmks[i]);
+        }
+    }
+}
+
+} // namespace
+
+PMKBatch::PMKBatch(int lanes) {
+    if (lanes >= 16) {
+        lanes_ = 16;
+        derive_ = &deriveLanes<16>;
+    } else if (lanes >= 8) {
+        lanes_ = 8;
+        derive_ = &deriveLanes<8>;
+    } else if (lanes >= 4) {
+        lanes_ = 4;
+        derive_ = &deriveLanes<4>;
+    } else {
+        lanes_ = 1;
+        derive_ = &deriveLanes<1>;
+    }
+}
+
+void PMKBatch::derive(const std::string* passwords, size_t count,
+                      const std::string& essid, uint8_t (*pmks)[32]) const {
+    if (count == 0) return;
+    derive_(passwords, count, essid, pmks);
+}
+
+} // namespace airlevi
@@ -0,0 +1,246 @@
+#include "airlevi-crack/pmk_cache.h"
+#include "common/logger.h"
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+namespace airlevi {
+
+namespace {
+
+// Past this the writer is falling behind; the cache is best effort, so drop
+const size_t kMaxPending = 1 << 20;
+
+bool exec(sqlite3* db, const char* sql) {
+    char* error_msg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        Logger::getInstance().error("PMK cache: " + std::string(error_msg ? error_msg : "unknown error"));
+        sqlite3_free(error_msg);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+PMKCache::PMKCache()
+    : read_db_(nullptr), write_db_(nullptr), select_stmt_(nullptr), max_entries_(0),
+      entry_count_(0), hits_(0), misses_(0), stopping_(false) {}
+
+PMKCache::~PMKCache() {
+    close();
+}
+
+bool PMKCache::open(const std::string& path, uint64_t max_entries) {
+    max_entries_ = max_entries;
+
+    if (sqlite3_open(path.c_str(), &write_db_) != SQLITE_OK) {
+        Logger::getInstance().error("Cannot open PMK cache: " + std::string(sqlite3_errmsg(write_db_)));
+        close();
+        return false;
+    }
+    sqlite3_busy_timeout(write_db_, 5000);
+
+    // WAL lets the workers read while the writer commits
+    if (!exec(write_db_, "PRAGMA journal_mode=WAL;") ||
+        !exec(write_db_, "PRAGMA synchronous=NORMAL;") ||
+        !exec(write_db_,
+              "CREATE TABLE IF NOT EXISTS pmk_cache ("
+              "essid BLOB NOT NULL,"
+              "password BLOB NOT NULL,"
+              "pmk BLOB NOT NULL,"
+              "hits INTEGER DEFAULT 0,"
+              "last_used INTEGER NOT NULL,"
+              "PRIMARY KEY(essid, password));") ||
+        !exec(write_db_, "CREATE INDEX IF NOT EXISTS idx_pmk_cache_last_used ON pmk_cache(last_used);")) {
+        close();
+        return false;
+    }
+
+    sqlite3_stmt* count_stmt = nullptr;
+    if (sqlite3_prepare_v2(write_db_, "SELECT COUNT(*) FROM pmk_cache;", -1, &count_stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(count_stmt) == SQLITE_ROW) {
+        entry_count_ = sqlite3_column_int64(count_stmt, 0);
+    }
+    sqlite3_finalize(count_stmt);
+
+    if (sqlite3_open_v2(path.c_str(), &read_db_, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(read_db_, "SELECT pmk FROM pmk_cache WHERE essid = ? AND password = ?;",
+                           -1, &select_stmt_, nullptr) != SQLITE_OK) {
+        Logger::getInstance().error("Cannot open PMK cache for reading: " + path);
+        close();
+        return false;
+    }
+    sqlite3_busy_timeout(read_db_, 5000);
+
+    stopping_ = false;
+    writer_ = std::thread(&PMKCache::writerThread, this);
+
+    Logger::getInstance().info("PMK cache " + path + ": " + std::to_string(entry_count_) + " entries (limit " +
+                             std::to_string(max_entries_) + ")");
+    return true;
+}
+
+void PMKCache::close() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            stopping_ = true;
+        }
+        pending_cv_.notify_all();
+        writer_.join();
+    }
+
+    if (select_stmt_) {
+        sqlite3_finalize(select_stmt_);
+        select_stmt_ = nullptr;
+    }
+    if (read_db_) {
+        sqlite3_close(read_db_);
+        read_db_ = nullptr;
+    }
+    if (write_db_) {
+        sqlite3_close(write_db_);
+        write_db_ = nullptr;
+    }
+}
+
+size_t PMKCache::lookup(const std::string& essid, const std::vector<std::string>& passwords,
+                        uint8_t (*pmks)[32], std::vector<bool>& hit) {
+    hit.assign(passwords.size(), false);
+    size_t found = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(read_mutex_);
+        for (size_t i = 0; i < passwords.size(); ++i) {
+            sqlite3_bind_blob(select_stmt_, 1, essid.data(), essid.size(), SQLITE_STATIC);
+            sqlite3_bind_blob(select_stmt_, 2, passwords[i].data(), passwords[i].size(), SQLITE_STATIC);
+
+            if (sqlite3_step(select_stmt_) == SQLITE_ROW && sqlite3_column_bytes(select_stmt_, 0) == 32) {
+                memcpy(pmks[i], sqlite3_column_blob(select_stmt_, 0), 32);
+                hit[i] = true;
+                found++;
+            }
+            sqlite3_reset(select_stmt_);
+        }
+    }
+
+    hits_ += found;
+    misses_ += passwords.size() - found;
+
+    if (found > 0) {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        for (size_t i = 0; i < passwords.size() && pending_.size() < kMaxPending; ++i) {
+            if (hit[i]) {
+                pending_.push_back(PendingEntry{essid, passwords[i], {0}, true});
+            }
+        }
+    }
+
+    return found;
+}
+
+void PMKCache::store(const std::string& essid, const std::string* passwords,
+                     const uint8_t (*pmks)[32], size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        for (size_t i = 0; i < count && pending_.size() < kMaxPending; ++i) {
+            PendingEntry entry{essid, passwords[i], {0}, false};
+            memcpy(entry.pmk, pmks[i], 32);
+            pending_.push_back(std::move(entry));
+        }
+    }
+    pending_cv_.notify_one();
+}
+
+void PMKCache::writerThread() {
+    std::vector<PendingEntry> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            // Wake at least once a second so entries reach disk steadily
+            pending_cv_.wait_for(lock, std::chrono::seconds(1),
+                                 [&] { return stopping_ || pending_.size() >= 4096; });
+
+            if (pending_.empty() && stopping_) {
+                break;
+            }
+
+            batch.assign(std::make_move_iterator(pending_.begin()), std::make_move_iterator(pending_.end()));
+            pending_.clear();
+        }
+
+        if (!batch.empty()) {
+            writeBatch(batch);
+            batch.clear();
+        }
+    }
+}
+
+void PMKCache::writeBatch(std::vector<PendingEntry>& batch) {
+    sqlite3_stmt* insert_stmt = nullptr;
+    sqlite3_stmt* touch_stmt = nullptr;
+
+    if (sqlite3_prepare_v2(write_db_,
+                           "INSERT OR IGNORE INTO pmk_cache (essid, password, pmk, last_used) VALUES (?, ?, ?, ?);",
+                           -1, &insert_stmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(write_db_,
+                           "UPDATE pmk_cache SET hits = hits + 1, last_used = ? WHERE essid = ? AND password = ?;",
+                           -1, &touch_stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(insert_stmt);
+        sqlite3_finalize(touch_stmt);
+        return;
+    }
+
+    sqlite3_int64 now = static_cast<sqlite3_int64>(std::time(nullptr));
+
+    exec(write_db_, "BEGIN;");
+    for (const auto& entry : batch) {
+        if (entry.touch_only) {
+            sqlite3_bind_int64(touch_stmt, 1, now);
+            sqlite3_bind_blob(touch_stmt, 2, entry.essid.data(), entry.essid.size(), SQLITE_STATIC);
+            sqlite3_bind_blob(touch_stmt, 3, entry.password.data(), entry.password.size(), SQLITE_STATIC);
+            sqlite3_step(touch_stmt);
+            sqlite3_reset(touch_stmt);
+        } else {
+            sqlite3_bind_blob(insert_stmt, 1, entry.essid.data(), entry.essid.size(), SQLITE_STATIC);
+            sqlite3_bind_blob(insert_stmt, 2, entry.password.data(), entry.password.size(), SQLITE_STATIC);
+            sqlite3_bind_blob(insert_stmt, 3, entry.pmk, 32, SQLITE_STATIC);
+            sqlite3_bind_int64(insert_stmt, 4, now);
+            if (sqlite3_step(insert_stmt) == SQLITE_DONE) {
+                entry_count_ += sqlite3_changes(write_db_);
+            }
+            sqlite3_reset(insert_stmt);
+        }
+    }
+    evict();
+    exec(write_db_, "COMMIT;");
+
+    sqlite3_finalize(insert_stmt);
+    sqlite3_finalize(touch_stmt);
+}
+
+void PMKCache::evict() {
+    if (max_entries_ == 0 || entry_count_ <= max_entries_) {
+        return;
+    }
+
+    // Trim an extra 5% so eviction does not run on every batch
+    uint64_t excess = entry_count_ - max_entries_ + max_entries_ / 20;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(write_db_,
+                           "DELETE FROM pmk_cache WHERE rowid IN "
+                           "(SELECT rowid FROM pmk_cache ORDER BY last_used LIMIT ?);",
+                           -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(excess));
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            uint64_t removed = sqlite3_changes(write_db_);
+            entry_count_ = entry_count_ > removed ? entry_count_ - removed : 0;
+        }
+    }
+    sqlite3_finalize(stmt);
+}
+
+} // namespace airlevi
@@ -1,10 +1,13 @@
 #include "airlevi-crack/wep_crack.h"
 #include "common/logger.h"
 #include "common/packet_parser.h"
+#include "common/capture_reader.h"
+#include "common/frame_index.h"
 #include <fstream>
 #include <algorithm>
 #include <map>
 #include <cmath>
+#include <thread>
 
 namespace airlevi {
 
@@ -211,40 +214,34 @@ bool WEPCrack::dictionaryAttack(std::string& found_key) {
 }
 
 bool WEPCrack::loadCaptureFile() {
-    std::ifstream file(config_.output_file, std::ios::binary);
-    if (!file.is_open()) {
+    CaptureReader reader;
+    if (!reader.open(config_.output_file)) {
         return false;
     }
     
-    // Skip pcap header (24 bytes)
-    file.seekg(24);
-    
-    PacketParser parser;
+    // Only WEP data frames are kept, and copied, for the attacks: the same
+    // predicate a sidecar index lists them under, per BSSID
+    std::vector<CaptureFrame> frames;
+    if (!loadIndexedFrames(config_.output_file, reader, postingMask(FramePosting::WEP_DATA), config_.target_bssid,
+                           frames)) {
+        frames = reader.scanParallel(
+            static_cast<int>(std::thread::hardware_concurrency()),
+            [](const CaptureFrame& frame) {
+                thread_local std::vector<uint8_t> unpadded;
+                const uint8_t* packet;
+                uint32_t length;
+                return CaptureReader::ieee80211Frame(frame, packet, length, unpadded) &&
+                       PacketParser::isWEPDataFrame(packet, static_cast<int>(length));
+            });
+    }
     
-    while (file.good()) {
-        // Read packet header
-        struct {
-            uint32_t ts_sec;
-            uint32_t ts_usec;
-            uint32_t caplen;
-            uint32_t len;
-        } pkt_hdr;
-        
-        file.read(reinterpret_cast<char*>(&pkt_hdr), sizeof(pkt_hdr));
-        if (file.gcount() != sizeof(pkt_hdr)) break;
-        
-        // Read packet data
-        std::vector<uint8_t> packet(pkt_hdr.caplen);
-        file.read(reinterpret_cast<char*>(packet.data()), pkt_hdr.caplen);
-        if (file.gcount() != pkt_hdr.caplen) break;
-        
-        // Check if it's a WEP encrypted data frame
-        if (packet.size() > 24 && parser.isDataFrame(packet.data())) {
-            // Check for WEP encryption (privacy bit set)
-            if ((packet[1] & 0x40) != 0) {
-                captured_packets_.push_back(packet);
-            }
-        }
+    captured_packets_.reserve(captured_packets_.size() + frames.size());
+    std::vector<uint8_t> unpadded;
+    for (const auto& frame : frames) {
+        const uint8_t* packet;
+        uint32_t length;
+        if (!CaptureReader::ieee80211Frame(frame, packet, length, unpadded)) continue;
+        captured_packets_.emplace_back(packet, packet + length);
     }
     
     return !captured_packets_.empty();
@@ -323,8 +320,8 @@ bool WEPCrack::testKey(const std::vector<uint8_t>& key) {
         const auto& packet = captured_packets_[i];
         if (packet.size() < 32) continue;
         
-        // Extract encrypted data (skip header + IV + key index)
-        std::vector<uint8_t> encrypted_data(packet.begin() + 28, packet.end() - 4); // Remove ICV
+        // IV, key index and encrypted body; wepDecrypt takes the IV from the front
+        std::vector<uint8_t> encrypted_data(packet.begin() + 24, packet.end() - 4); // Remove ICV
         
         auto decrypted = CryptoUtils::wepDecrypt(encrypted_data, key);
         
@@ -1,56 +1,103 @@
 #include "airlevi-crack/wpa_crack.h"
 #include "common/logger.h"
 #include "common/packet_parser.h"
+#include "common/capture_reader.h"
+#include "common/frame_dispatcher.h"
+#include "common/frame_index.h"
 #include <fstream>
 #include <algorithm>
 #include <map>
+#include <thread>
 
 namespace airlevi {
 
-WPACrack::WPACrack(const Config& config) : config_(config) {}
+WPACrack::WPACrack(const Config& config) : config_(config), target_loaded_(false) {}
 
 WPACrack::~WPACrack() {}
 
 bool WPACrack::crack(std::string& found_password) {
     Logger::getInstance().info("Starting WPA/WPA2 crack attack");
     
+    if (!prepareTarget() && pmkids_.empty()) {
+        return false;
+    }
+    
+    // Try PMKID attack first (faster)
+    if (!pmkids_.empty() && pmkidAttack(found_password)) {
+        return true;
+    }
+    
+    // Try handshake attack
+    if (verifier_ && handshakeAttack(found_password)) {
+        return true;
+    }
+    
+    return false;
+}
+
+bool WPACrack::prepareTarget() {
+    if (target_loaded_) {
+        return verifier_ != nullptr;
+    }
+    target_loaded_ = true;
+    
     if (!loadCaptureFile()) {
         Logger::getInstance().error("Failed to load capture file");
         return false;
     }
     
-    if (!extractHandshakes() && !extractPMKIDs()) {
+    bool have_handshakes = extractHandshakes();
+    bool have_pmkids = extractPMKIDs();
+    if (!have_handshakes && !have_pmkids) {
         Logger::getInstance().error("No WPA handshakes or PMKIDs found in capture file");
         return false;
     }
     
-    Logger::getInstance().info("Found " + std::to_string(handshakes_.size()) + " handshakes and " + 
+    Logger::getInstance().info("Found " + std::to_string(handshakes_.size()) + " handshake messages and " + 
                              std::to_string(pmkids_.size()) + " PMKIDs");
     
-    // Try PMKID attack first (faster)
-    if (!pmkids_.empty() && pmkidAttack(found_password)) {
-        return true;
+    auto best_handshake = findBestHandshake();
+    if (best_handshake.essid.empty()) {
+        Logger::getInstance().error("No valid handshake found");
+        return false;
     }
     
-    // Try handshake attack
-    if (!handshakes_.empty() && handshakeAttack(found_password)) {
-        return true;
+    verifier_ = std::make_unique<HandshakeVerifier>(best_handshake);
+    if (!verifier_->isSupported()) {
+        Logger::getInstance().error("Unsupported key descriptor version: " +
+                                  HandshakeVerifier::describe(best_handshake.key_version));
+        verifier_.reset();
+        return false;
     }
     
-    return false;
+    Logger::getInstance().info("Using handshake for ESSID: " + best_handshake.essid + " [" +
+                             HandshakeVerifier::describe(best_handshake.key_version) + "]");
+    return true;
+}
+
+bool WPACrack::loadTargets(std::vector<HandshakePacket>& handshakes, std::vector<PMKIDPacket>& pmkids) {
+    if (!loadCaptureFile()) {
+        Logger::getInstance().error("Failed to load capture file");
+        return false;
+    }
+    
+    if (extractHandshakes()) {
+        handshakes = pairHandshakes();
+    }
+    if (extractPMKIDs()) {
+        pmkids = pmkids_;
+    }
+    return !handshakes.empty() || !pmkids.empty();
 }
 
 bool WPACrack::handshakeAttack(std::string& found_password) {
     Logger::getInstance().info("Attempting handshake attack");
     
-    auto best_handshake = findBestHandshake();
-    if (best_handshake.essid.empty()) {
+    if (!verifier_) {
         Logger::getInstance().error("No valid handshake found");
         return false;
     }
     
-    Logger::getInstance().info("Using handshake for ESSID: " + best_handshake.essid);
-    
     if (!config_.wordlist_file.empty()) {
         std::ifstream wordlist(config_.wordlist_file);
         if (!wordlist.is_open()) {
@@ -68,7 +115,7 @@ bool WPACrack::handshakeAttack(std::string& found_password) {
                 Logger::getInstance().info("Tried " + std::to_string(attempts) + " passwords");
             }
             
-            if (testPassword(password, best_handshake)) {
+            if (verifier_->testPassword(password)) {
                 found_password = password;
                 Logger::getInstance().info("Password found: " + found_password);
                 return true;
@@ -139,55 +186,112 @@ bool WPACrack::validateHandshake(const HandshakePacket& handshake) {
 bool WPACrack::isCompleteHandshake(const std::vector<HandshakePacket>& packets) {
     if (packets.size() < 2) return false;
     
-    bool has_msg1 = false, has_msg2 = false, has_msg3 = false, has_msg4 = false;
+    bool has_msg1 = false, has_msg2 = false, has_msg3 = false;
     
     for (const auto& pkt : packets) {
         switch (pkt.message_number) {
             case 1: has_msg1 = true; break;
             case 2: has_msg2 = true; break;
             case 3: has_msg3 = true; break;
-            case 4: has_msg4 = true; break;
         }
     }
     
-    // Need at least messages 2 and 3 for cracking
-    return has_msg2 && has_msg3;
+    // Need the SNonce/MIC of message 2 and the ANonce of message 1 or 3
+    return has_msg2 && (has_msg1 || has_msg3);
 }
 
 bool WPACrack::loadCaptureFile() {
-    std::ifstream file(config_.output_file, std::ios::binary);
-    if (!file.is_open()) {
+    CaptureReader reader;
+    if (!reader.open(config_.output_file)) {
         return false;
     }
     
-    // Skip pcap header (24 bytes)
-    file.seekg(24);
+    // A sidecar or pcapng index from airlevi-dump lists every EAPOL frame and
+    // the beacons naming each BSS, so only those records are touched; the
+    // sidecar also narrows them down to the target BSSID
+    std::vector<CaptureFrame> frames;
+    std::vector<IndexedFrame> index;
+    uint8_t key_frames = postingMask(FramePosting::EAPOL) | postingMask(FramePosting::BEACON);
+    if (loadIndexedFrames(config_.output_file, reader, key_frames, config_.target_bssid, frames)) {
+        std::sort(frames.begin(), frames.end(), [](const CaptureFrame& a, const CaptureFrame& b) {
+            return a.timestamp_ns != b.timestamp_ns ? a.timestamp_ns < b.timestamp_ns : a.offset < b.offset;
+        });
+        Logger::getInstance().debug("Loaded " + std::to_string(frames.size()) + " frames through the sidecar index of " +
+                                    config_.output_file);
+    } else if (reader.readFrameIndex(index)) {
+        frames.reserve(index.size());
+        for (const IndexedFrame& entry : index) {
+            CaptureFrame frame;
+            if (reader.frameAt(entry.offset, frame)) {
+                frames.push_back(frame);
+            }
+        }
+        std::sort(frames.begin(), frames.end(), [](const CaptureFrame& a, const CaptureFrame& b) {
+            return a.timestamp_ns != b.timestamp_ns ? a.timestamp_ns < b.timestamp_ns : a.offset < b.offset;
+        });
+        Logger::getInstance().debug("Loaded " + std::to_string(frames.size()) + " indexed frames from " +
+                                    config_.output_file);
+    } else {
+        // Workers only pick out beacons and EAPOL frames; those few are then
+        // parsed here in timestamp order
+        FrameDispatcher dispatcher;
+        frames = reader.scanParallel(
+            static_cast<int>(std::thread::hardware_concurrency()),
+            [&dispatcher](const CaptureFrame& frame) {
+                thread_local std::vector<uint8_t> unpadded;
+                const uint8_t* packet;
+                uint32_t length;
+                if (!CaptureReader::ieee80211Frame(frame, packet, length, unpadded)) return false;
+                FrameClass frame_class = dispatcher.classify(packet, static_cast<int>(length));
+                return frame_class == FrameClass::BEACON || frame_class == FrameClass::EAPOL;
+            });
+    }
     
     PacketParser parser;
+    std::map<MacAddress, std::string> essids;
+    std::vector<uint8_t> unpadded;
     
-    while (file.good()) {
-        // Read packet header
-        struct {
-            uint32_t ts_sec;
-            uint32_t ts_usec;
-            uint32_t caplen;
-            uint32_t len;
-        } pkt_hdr;
-        
-        file.read(reinterpret_cast<char*>(&pkt_hdr), sizeof(pkt_hdr));
-        if (file.gcount() != sizeof(pkt_hdr)) break;
-        
-        // Read packet data
-        std::vector<uint8_t> packet(pkt_hdr.caplen);
-        file.read(reinterpret_cast<char*>(packet.data()), pkt_hdr.caplen);
-        if (file.gcount() != pkt_hdr.caplen) break;
+    for (const auto& frame : frames) {
+        const uint8_t* packet;
+        uint32_t length;
+        if (!CaptureReader::ieee80211Frame(frame, packet, length, unpadded)) continue;
         
-        // Check if it's an EAPOL frame
-        if (parser.isEAPOLFrame(packet.data())) {
-            HandshakePacket handshake;
-            if (parser.parseEAPOLFrame(packet.data(), pkt_hdr.caplen, handshake)) {
-                handshakes_.push_back(handshake);
+        // Beacons give us the ESSID used as the PBKDF2 salt
+        if (parser.isBeaconFrame(packet)) {
+            BeaconView beacon;
+            if (parser.parseBeaconFrame(packet, length, beacon) && !beacon.ssid.empty()) {
+                essids[beacon.bssid] = beacon.ssid.toString();
+            }
+        } else {
+            EapolKeyView eapol;
+            if (!parser.parseEAPOLFrame(packet, length, eapol)) continue;
+            
+            ByteView pmkid;
+            if (eapol.findPMKID(pmkid)) {
+                pmkids_.push_back(PMKIDPacket{eapol.ap_mac, eapol.client_mac, "", pmkid.toVector()});
             }
+            
+            HandshakePacket handshake;
+            eapol.materialize(handshake);
+            handshakes_.push_back(handshake);
+        }
+    }
+    
+    for (auto& hs : handshakes_) {
+        auto it = essids.find(hs.ap_mac);
+        if (it != essids.end() && it->second != "<hidden>") {
+            hs.essid = it->second;
+        } else if (!config_.target_essid.empty()) {
+            hs.essid = config_.target_essid;
+        }
+    }
+    
+    for (auto& pmkid : pmkids_) {
+        auto it = essids.find(pmkid.ap_mac);
+        if (it != essids.end() && it->second != "<hidden>") {
+            pmkid.essid = it->second;
+        } else if (!config_.target_essid.empty()) {
+            pmkid.essid = config_.target_essid;
         }
     }
     
@@ -213,10 +317,11 @@ bool WPACrack::extractHandshakes() {
         handshakes_.erase(it, handshakes_.end());
     }
     
-    // Remove invalid handshakes
+    // Remove messages that cannot be part of a handshake; full validation
+    // happens once messages are paired in findBestHandshake()
     auto it = std::remove_if(handshakes_.begin(), handshakes_.end(),
-        [this](const HandshakePacket& hs) {
-            return !validateHandshake(hs);
+        [](const HandshakePacket& hs) {
+            return hs.message_number < 1 || hs.message_number > 4;
         });
     
     handshakes_.erase(it, handshakes_.end());
@@ -225,86 +330,108 @@ bool WPACrack::extractHandshakes() {
 }
 
 bool WPACrack::extractPMKIDs() {
-    // PMKID extraction would be implemented here
-    // PMKIDs are found in the first message of RSN authentication
-    // This is a simplified placeholder
-    return false;
+    // The PMKID is salted with the ESSID, so one whose BSS never named itself is of no use
+    auto it = std::remove_if(pmkids_.begin(), pmkids_.end(),
+        [this](const PMKIDPacket& pmkid) {
+            if (pmkid.essid.empty()) {
+                return true;
+            }
+            if (!config_.target_bssid.empty() && pmkid.ap_mac.toString() != config_.target_bssid) {
+                return true;
+            }
+            if (!config_.target_essid.empty() && pmkid.essid != config_.target_essid) {
+                return true;
+            }
+            return false;
+        });
+    pmkids_.erase(it, pmkids_.end());
+    
+    // An AP repeats the same PMKID in every M1 to a station
+    std::sort(pmkids_.begin(), pmkids_.end(), [](const PMKIDPacket& a, const PMKIDPacket& b) {
+        return a.pmkid != b.pmkid ? a.pmkid < b.pmkid : a.essid < b.essid;
+    });
+    pmkids_.erase(std::unique(pmkids_.begin(), pmkids_.end(),
+                              [](const PMKIDPacket& a, const PMKIDPacket& b) {
+                                  return a.pmkid == b.pmkid && a.essid == b.essid;
+                              }),
+                  pmkids_.end());
+    
+    return !pmkids_.empty();
 }
 
 bool WPACrack::testPassword(const std::string& password, const HandshakePacket& handshake) {
+    HandshakeVerifier verifier(handshake);
+    return verifier.testPassword(password);
+}
+
+bool WPACrack::testPasswordPMKID(const std::string& password, const PMKIDPacket& pmkid) {
     if (password.length() < 8 || password.length() > 63) {
-        return false; // Invalid WPA password length
-    }
-    
-    try {
-        // Generate PMK from password and ESSID
-        auto pmk = CryptoUtils::generatePMK(password, handshake.essid);
-        
-        // Generate PTK
-        auto ptk = CryptoUtils::generatePTK(pmk, handshake.ap_mac, handshake.client_mac,
-                                           handshake.anonce, handshake.snonce);
-        
-        // Verify MIC
-        return CryptoUtils::verifyMIC(handshake, ptk);
-        
-    } catch (const std::exception& e) {
-        Logger::getInstance().debug("Error testing password '" + password + "': " + e.what());
         return false;
     }
+    
+    PMKIDVerifier verifier(pmkid.essid, pmkid.ap_mac, pmkid.client_mac, pmkid.pmkid.data());
+    auto pmk = CryptoUtils::generatePMK(password, pmkid.essid);
+    return pmk.size() == 32 && verifier.testPMK(pmk.data());
 }
 
-bool WPACrack::testPasswordPMKID(const std::string& password, const std::vector<uint8_t>& pmkid) {
-    // PMKID verification would be implemented here
-    // PMKID = HMAC-SHA1-128(PMK, "PMK Name" | MAC_AP | MAC_STA)
-    return false;
-}
-
-HandshakePacket WPACrack::findBestHandshake() {
-    if (handshakes_.empty()) {
-        return HandshakePacket();
+std::vector<HandshakePacket> WPACrack::pairHandshakes() {
+    // Group messages by AP and station, in capture order
+    std::map<std::pair<MacAddress, MacAddress>, std::vector<const HandshakePacket*>> grouped;
+    for (const auto& hs : handshakes_) {
+        grouped[std::make_pair(hs.ap_mac, hs.client_mac)].push_back(&hs);
     }
     
-    // Group handshakes by AP
-    std::map<MacAddress, std::vector<HandshakePacket>> grouped;
-    for (const auto& hs : handshakes_) {
-        grouped[hs.ap_mac].push_back(hs);
+    std::vector<HandshakePacket> paired;
+    for (const auto& group : grouped) {
+        const auto& packets = group.second;
+        
+        // Message 2 carries the SNonce and the MIC we verify against. Its
+        // ANonce comes from the M1 of the same replay counter or the M3 of
+        // the next one: after a retry, any other M1/M3 belongs to another
+        // exchange and no passphrase would match.
+        for (const HandshakePacket* m2 : packets) {
+            if (m2->message_number != 2) continue;
+            
+            const HandshakePacket* partner = nullptr;
+            for (const HandshakePacket* other : packets) {
+                if (other->message_number == 1 && other->replay_counter == m2->replay_counter) {
+                    partner = other;
+                    break;
+                }
+                if (!partner && other->message_number == 3 && other->replay_counter == m2->replay_counter + 1) {
+                    partner = other;
+                }
+            }
+            if (!partner) continue;
+            
+            HandshakePacket candidate = *m2;
+            candidate.anonce = partner->anonce;
+            if (validateHandshake(candidate)) {
+                paired.push_back(candidate);
+                break;
+            }
+        }
     }
     
-    // Find the most complete handshake
+    return paired;
+}
+
+HandshakePacket WPACrack::findBestHandshake() {
     HandshakePacket best;
     int best_score = 0;
     
-    for (const auto& pair : grouped) {
-        const auto& packets = pair.second;
+    for (const auto& candidate : pairHandshakes()) {
+        int score = 0;
         
-        if (isCompleteHandshake(packets)) {
-            // Find message 2 or 3 (both contain MIC and nonces)
-            for (const auto& pkt : packets) {
-                if (pkt.message_number == 2 || pkt.message_number == 3) {
-                    int score = 0;
-                    
-                    // Score based on completeness
-                    if (!pkt.anonce.empty()) score += 10;
-                    if (!pkt.snonce.empty()) score += 10;
-                    if (!pkt.mic.empty()) score += 20;
-                    if (!pkt.essid.empty()) score += 5;
-                    
-                    if (score > best_score) {
-                        best = pkt;
-                        best_score = score;
-                        
-                        // Fill in missing nonces from other messages
-                        for (const auto& other : packets) {
-                            if (best.anonce.empty() && !other.anonce.empty()) {
-                                best.anonce = other.anonce;
-                            }
-                            if (best.snonce.empty() && !other.snonce.empty()) {
-                                best.snonce = other.snonce;
-                            }
-                        }
-                    }
-                }
-            }
+        // Score based on completeness
+        if (!candidate.anonce.empty()) score += 10;
+        if (!candidate.snonce.empty()) score += 10;
+        if (!candidate.mic.empty()) score += 20;
+        if (!candidate.essid.empty()) score += 5;
+        
+        if (score > best_score) {
+            best = candidate;
+            best_score = score;
         }
     }
     
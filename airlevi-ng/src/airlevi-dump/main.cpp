@@ -3,10 +3,15 @@
 #include <getopt.h>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <ctime>
+#include <cstdlib>
+#include <iomanip>
 #include "airlevi-dump/packet_capture.h"
 #include "airlevi-dump/wifi_scanner.h"
 #include "common/logger.h"
 #include "common/config.h"
+#include "common/progress_stream.h"
 
 using namespace airlevi;
 
@@ -26,6 +31,9 @@ void printUsage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [OPTIONS]\n\n";
     std::cout << "Options:\n";
     std::cout << "  -i, --interface IFACE    Wireless interface to use\n";
+    std::cout << "  -r, --read FILE          Process a pcap/pcapng capture instead of an interface\n";
+    std::cout << "  --speed X                Replay at X times the recorded pace (default: 0,\n";
+    std::cout << "                           as fast as the pipeline takes frames)\n";
     std::cout << "  -c, --channel CHANNEL    Channel to monitor (1-196 for 2.4/5GHz)\n";
     std::cout << "  -w, --write FILE         Write packets to file\n";
     std::cout << "  -b, --bssid BSSID        Target specific BSSID\n";
@@ -35,13 +43,29 @@ void printUsage(const char* program_name) {
     std::cout << "  -h, --help               Show this help\n";
     std::cout << "  --hop                    Enable channel hopping\n";
     std::cout << "  --monitor                Enable monitor mode\n";
+    std::cout << "  --ring                   Capture through an AF_PACKET TPACKET_V3 ring\n";
+    std::cout << "                           (interface must already be in monitor mode)\n";
+    std::cout << "  --ring-size MB           Ring size per worker (default: 64)\n";
+    std::cout << "  --block-timeout MS       Hand over partly filled blocks after MS (default: 64)\n";
+    std::cout << "  --fanout N               Parse on N ring workers (default: 1)\n";
+    std::cout << "  --fanout-mode MODE       pair, hash or lb (default: pair)\n";
+    std::cout << "  --pcapng                 Write pcapng with capture metadata and a handshake index\n";
+    std::cout << "                           (implied by a .pcapng output file)\n";
+    std::cout << "  --rotate-size MB         Start a new output file every MB (capture-00001.cap, ...)\n";
+    std::cout << "  --rotate-time SECONDS    Start a new output file every SECONDS\n";
+    std::cout << "  --write-queue MB         Memory for records waiting on the disk (default: 32)\n";
+    std::cout << "  --direct-io              Write the output with O_DIRECT\n";
+    std::cout << "  --sidecar-index          Index every output file into FILE.alxi for the offline tools\n";
+    std::cout << "  --progress-stream DEST   NDJSON capture statistics to a file or fd:N\n";
+    std::cout << "  --progress-interval MS   Minimum time between statistics events (default: 1000)\n";
     std::cout << "\nExamples:\n";
     std::cout << "  " << program_name << " -i wlan0 --monitor\n";
     std::cout << "  " << program_name << " -i wlan0 -c 6 -w capture.cap\n";
     std::cout << "  " << program_name << " -i wlan0 -b 00:11:22:33:44:55\n";
+    std::cout << "  " << program_name << " -r old.pcapng -w handshakes.pcapng -b 00:11:22:33:44:55\n";
 }
 
-void displayStatistics(const Statistics& stats) {
+void displayStatistics(const Statistics& stats, const CaptureCounters& counters, const LatencyHistogram& latency) {
     auto now = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - stats.start_time);
     
@@ -50,12 +74,57 @@ void displayStatistics(const Statistics& stats) {
     std::cout << "Networks: " << stats.networks_found << " ";
     std::cout << "Clients: " << stats.clients_found << " ";
     std::cout << "Handshakes: " << stats.handshakes_captured << " ";
+    std::cout << "Dropped: " << counters.dropped + counters.interface_dropped << " ";
+    if (latency.getCount() > 0) {
+        std::cout << "p99: " << LatencyHistogram::formatNanoseconds(latency.getPercentile(99)) << " ";
+    }
     std::cout << std::flush;
 }
 
+// Recorded in the pcapng section header
+std::string sessionComment(const Config& config, bool channel_hop, const ReplayOptions& replay) {
+    char started[32];
+    time_t now = time(nullptr);
+    strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    
+    std::string comment = std::string("Session started ") + started + " on " + config.interface;
+    if (!replay.path.empty()) {
+        comment = std::string("Replay started ") + started + " of " + replay.path;
+    } else if (config.channel > 0) {
+        comment += ", channel " + std::to_string(config.channel);
+    } else if (channel_hop) {
+        comment += ", channel hopping";
+    }
+    if (!config.target_bssid.empty()) {
+        comment += ", target BSSID " + config.target_bssid;
+    }
+    if (!config.target_essid.empty()) {
+        comment += ", target ESSID " + config.target_essid;
+    }
+    return comment;
+}
+
+void emitStatistics(const Statistics& stats) {
+    ProgressEvent event("stats");
+    event.add("packets", stats.total_packets)
+         .add("networks", stats.networks_found)
+         .add("clients", stats.clients_found)
+         .add("handshakes", stats.handshakes_captured)
+         .add("records_queued", capture->getRecordsQueued())
+         .add("records_dropped", capture->getRecordsDropped());
+    addCaptureFields(event, capture->getCaptureCounters(), capture->getRingBacklog(),
+                     capture->getFrameLatency(), capture->getHandshakeLatency());
+    ProgressStream::getInstance().emit(event, true);
+}
+
 int main(int argc, char* argv[]) {
     Config config;
+    RingOptions ring;
+    ReplayOptions replay;
+    PcapWriterOptions writer;
     bool channel_hop = false;
+    std::string progress_stream;
+    int progress_interval = 1000;
     
     // Default values
     config.interface = "wlan0";
@@ -66,6 +135,7 @@ int main(int argc, char* argv[]) {
     
     static struct option long_options[] = {
         {"interface", required_argument, 0, 'i'},
+        {"read", required_argument, 0, 'r'},
         {"channel", required_argument, 0, 'c'},
         {"write", required_argument, 0, 'w'},
         {"bssid", required_argument, 0, 'b'},
@@ -75,15 +145,32 @@ int main(int argc, char* argv[]) {
         {"help", no_argument, 0, 'h'},
         {"hop", no_argument, 0, 1000},
         {"monitor", no_argument, 0, 1001},
+        {"ring", no_argument, 0, 1002},
+        {"ring-size", required_argument, 0, 1003},
+        {"block-timeout", required_argument, 0, 1004},
+        {"fanout", required_argument, 0, 1005},
+        {"fanout-mode", required_argument, 0, 1006},
+        {"progress-stream", required_argument, 0, 1007},
+        {"progress-interval", required_argument, 0, 1008},
+        {"rotate-size", required_argument, 0, 1009},
+        {"rotate-time", required_argument, 0, 1010},
+        {"write-queue", required_argument, 0, 1011},
+        {"direct-io", no_argument, 0, 1012},
+        {"pcapng", no_argument, 0, 1013},
+        {"sidecar-index", no_argument, 0, 1014},
+        {"speed", required_argument, 0, 1015},
         {0, 0, 0, 0}
     };
     
     int c;
-    while ((c = getopt_long(argc, argv, "i:c:w:b:e:t:vh", long_options, nullptr)) != -1) {
+    while ((c = getopt_long(argc, argv, "i:r:c:w:b:e:t:vh", long_options, nullptr)) != -1) {
         switch (c) {
             case 'i':
                 config.interface = optarg;
                 break;
+            case 'r':
+                replay.path = optarg;
+                break;
             case 'c':
                 config.channel = std::atoi(optarg);
                 break;
@@ -111,6 +198,51 @@ int main(int argc, char* argv[]) {
             case 1001:
                 config.monitor_mode = true;
                 break;
+            case 1002:
+                ring.enabled = true;
+                break;
+            case 1003:
+                ring.ring_size_mb = std::max(1, std::atoi(optarg));
+                break;
+            case 1004:
+                ring.block_timeout_ms = std::max(1, std::atoi(optarg));
+                break;
+            case 1005:
+                ring.workers = std::max(1, std::atoi(optarg));
+                break;
+            case 1006:
+                if (!RingCapture::parseFanoutMode(optarg, ring.fanout)) {
+                    std::cerr << "Unknown fanout mode: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 1007:
+                progress_stream = optarg;
+                break;
+            case 1008:
+                progress_interval = std::atoi(optarg);
+                break;
+            case 1009:
+                writer.rotate_size_mb = std::max(0, std::atoi(optarg));
+                break;
+            case 1010:
+                writer.rotate_seconds = std::max(0, std::atoi(optarg));
+                break;
+            case 1011:
+                writer.queue_mb = std::max(1, std::atoi(optarg));
+                break;
+            case 1012:
+                writer.direct_io = true;
+                break;
+            case 1013:
+                writer.format = CaptureFormat::PCAPNG;
+                break;
+            case 1014:
+                writer.sidecar_index = true;
+                break;
+            case 1015:
+                replay.speed = std::max(0.0, std::atof(optarg));
+                break;
             default:
                 printUsage(argv[0]);
                 return 1;
@@ -128,8 +260,27 @@ int main(int argc, char* argv[]) {
         // Initialize logger
         Logger::getInstance().setVerbose(config.verbose);
         
+        ProgressStream& stream = ProgressStream::getInstance();
+        if (!progress_stream.empty()) {
+            if (!stream.open(progress_stream, "airlevi-dump")) {
+                return 1;
+            }
+            stream.setInterval(std::chrono::milliseconds(progress_interval > 0 ? progress_interval : 1000));
+        }
+        
         // Create packet capture instance
         capture = std::make_unique<PacketCapture>(config);
+        capture->setCaptureRing(ring);
+        capture->setReplay(replay);
+        if (config.output_file.size() > 7 &&
+            config.output_file.compare(config.output_file.size() - 7, 7, ".pcapng") == 0) {
+            writer.format = CaptureFormat::PCAPNG;
+        }
+        if (writer.format == CaptureFormat::PCAPNG) {
+            writer.application = "AirLevi-NG airlevi-dump 1.0";
+            writer.comment = sessionComment(config, channel_hop, replay);
+        }
+        capture->setWriterOptions(writer);
         
         // Create WiFi scanner
         scanner = std::make_unique<WifiScanner>(config);
@@ -146,11 +297,15 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
-        std::cout << "Interface: " << config.interface << std::endl;
-        if (config.channel > 0) {
-            std::cout << "Channel: " << config.channel << std::endl;
-        } else if (channel_hop) {
-            std::cout << "Channel hopping enabled" << std::endl;
+        if (!replay.path.empty()) {
+            std::cout << "Replaying: " << replay.path << std::endl;
+        } else {
+            std::cout << "Interface: " << config.interface << std::endl;
+            if (config.channel > 0) {
+                std::cout << "Channel: " << config.channel << std::endl;
+            } else if (channel_hop) {
+                std::cout << "Channel hopping enabled" << std::endl;
+            }
         }
         
         if (!config.target_bssid.empty()) {
@@ -165,7 +320,7 @@ int main(int argc, char* argv[]) {
         
         // Channel hopping thread
         std::thread hop_thread;
-        if (channel_hop && config.channel == 0) {
+        if (channel_hop && config.channel == 0 && replay.path.empty()) {
             hop_thread = std::thread([&]() {
                 // Full 2.4GHz and 5GHz channel list for hopping
                 int channels[] = {
@@ -189,11 +344,15 @@ int main(int argc, char* argv[]) {
         
         // Statistics display thread
         std::thread stats_thread([&]() {
-            while (running) {
-                if (!config.verbose) {
-                    displayStatistics(scanner->getStatistics());
+            for (int tick = 0; running; ++tick) {
+                Statistics stats = scanner->getStatistics();
+                if (!config.verbose && tick % 10 == 0) {
+                    displayStatistics(stats, capture->getCaptureCounters(), capture->getFrameLatency());
                 }
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+                if (stream.isEnabled() && stream.progressDue()) {
+                    emitStatistics(stats);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
         });
         
@@ -210,6 +369,10 @@ int main(int argc, char* argv[]) {
                 }
             }
             
+            if (!replay.path.empty() && capture->isReplayFinished()) {
+                break;
+            }
+            
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
         
@@ -224,20 +387,47 @@ int main(int argc, char* argv[]) {
             stats_thread.join();
         }
         
+        // Kernel counters are gone once the capture handle is closed
+        CaptureCounters counters = capture->getCaptureCounters();
+        auto final_stats = scanner->getStatistics();
+        if (stream.isEnabled()) {
+            emitStatistics(final_stats);
+        }
+        
         capture->stop();
         scanner->stop();
         
         // Final statistics
-        auto final_stats = scanner->getStatistics();
         std::cout << "\n\nCapture Summary:" << std::endl;
         std::cout << "=================" << std::endl;
         std::cout << "Total packets captured: " << final_stats.total_packets << std::endl;
         std::cout << "Networks discovered: " << final_stats.networks_found << std::endl;
         std::cout << "Clients discovered: " << final_stats.clients_found << std::endl;
         std::cout << "Handshakes captured: " << final_stats.handshakes_captured << std::endl;
+        if (!replay.path.empty()) {
+            double seconds = capture->getReplaySeconds();
+            std::cout << "Frames replayed: " << counters.received << " in " << std::fixed << std::setprecision(2)
+                      << seconds << "s (" << std::setprecision(0)
+                      << (seconds > 0 ? counters.received / seconds : 0) << " frames/s)" << std::endl;
+            std::cout << "Frames processed/handshake frames: " << capture->getTotalPackets() << "/"
+                      << capture->getHandshakeCount() << std::endl;
+        } else {
+            std::cout << "Kernel received/dropped: " << counters.received << "/" << counters.dropped
+                      << " (interface dropped " << counters.interface_dropped << ")" << std::endl;
+        }
+        std::cout << "Frame latency: " << capture->getFrameLatency().summary() << std::endl;
+        std::cout << "Handshake latency: " << capture->getHandshakeLatency().summary() << std::endl;
         
         if (!config.output_file.empty()) {
-            std::cout << "Output saved to: " << config.output_file << std::endl;
+            int files = capture->getOutputFileCount();
+            if (writer.rotate_size_mb > 0 || writer.rotate_seconds > 0) {
+                std::cout << "Output saved to: " << PcapWriter::rotatedPath(config.output_file, 1) << " .. "
+                          << PcapWriter::rotatedPath(config.output_file, files) << std::endl;
+            } else {
+                std::cout << "Output saved to: " << config.output_file << std::endl;
+            }
+            std::cout << "Records written/dropped: " << capture->getRecordsQueued() << "/"
+                      << capture->getRecordsDropped() << std::endl;
         }
         
     } catch (const std::exception& e) {
@@ -1,14 +1,17 @@
 #include "airlevi-dump/packet_capture.h"
 #include "common/logger.h"
 #include <iostream>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
+#include <sys/time.h>
 
 namespace airlevi {
 
 PacketCapture::PacketCapture(const Config& config)
-    : config_(config), pcap_handle_(nullptr), running_(false), 
+    : config_(config), pcap_handle_(nullptr), link_type_(DLT_IEEE802_11_RADIO), running_(false), 
       total_packets_(0), handshake_count_(0) {
+    registerFrameHandlers();
 }
 
 PacketCapture::~PacketCapture() {
@@ -16,6 +19,13 @@ PacketCapture::~PacketCapture() {
 }
 
 bool PacketCapture::start() {
+    if (!replay_options_.path.empty()) {
+        return startReplay();
+    }
+    if (ring_options_.enabled) {
+        return startRing();
+    }
+    
     char errbuf[PCAP_ERRBUF_SIZE];
     
     // Open network interface
@@ -74,6 +84,8 @@ bool PacketCapture::start() {
     
     pcap_freecode(&filter);
     
+    link_type_ = pcap_datalink(pcap_handle_);
+    
     // Open output file if specified
     if (!config_.output_file.empty() && !openOutputFile()) {
         pcap_close(pcap_handle_);
@@ -88,6 +100,54 @@ bool PacketCapture::start() {
     return true;
 }
 
+bool PacketCapture::startRing() {
+    if (!ring_.open(config_.interface, ring_options_)) {
+        return false;
+    }
+    link_type_ = ring_.getLinkType();
+    
+    if (!config_.output_file.empty() && !openOutputFile()) {
+        ring_.close();
+        return false;
+    }
+    
+    ring_parsers_.assign(ring_.getWorkerCount(), PacketParser());
+    running_ = true;
+    ring_.start([this](int worker, const std::vector<RingPacket>& batch) {
+        processBatch(worker, batch);
+    });
+    
+    Logger::getInstance().info("Packet capture started on interface " + config_.interface + " (" +
+                               std::to_string(ring_.getWorkerCount()) + " ring workers)");
+    return true;
+}
+
+bool PacketCapture::startReplay() {
+    if (!replay_.open(replay_options_)) {
+        return false;
+    }
+    link_type_ = replay_.getLinkType();
+    
+    // Nothing is lost to a slow disk when the source can wait
+    writer_options_.wait_when_full = true;
+    if (!config_.output_file.empty() && !openOutputFile()) {
+        replay_.close();
+        return false;
+    }
+    
+    running_ = true;
+    replay_.start([this](int, const std::vector<RingPacket>& batch) {
+        replayBatch(batch);
+    });
+    
+    char pace[48] = "full speed";
+    if (replay_options_.speed > 0) {
+        snprintf(pace, sizeof(pace), "%gx recorded timing", replay_options_.speed);
+    }
+    Logger::getInstance().info("Replaying " + replay_options_.path + " (" + pace + ")");
+    return true;
+}
+
 void PacketCapture::stop() {
     if (running_) {
         running_ = false;
@@ -100,14 +160,15 @@ void PacketCapture::stop() {
             capture_thread_.join();
         }
         
+        ring_.close();
+        replay_.close();
+        
         if (pcap_handle_) {
             pcap_close(pcap_handle_);
             pcap_handle_ = nullptr;
         }
         
-        if (output_file_.is_open()) {
-            output_file_.close();
-        }
+        writer_.close();
         
         Logger::getInstance().info("Packet capture stopped");
     }
@@ -133,45 +194,162 @@ void PacketCapture::packetCallback(uint8_t* user_data, const struct pcap_pkthdr*
 }
 
 void PacketCapture::processPacket(const struct pcap_pkthdr* header, const uint8_t* packet) {
-    if (!shouldCapturePacket(packet, header->caplen)) {
-        return;
+    IndexedFrameKind index_kind;
+    if (processFrame(header, packet, 0, parser_, index_kind) && writer_.isOpen()) {
+        writer_.write(header, packet, 0, index_kind);
+    }
+}
+
+void PacketCapture::processBatch(int worker, const std::vector<RingPacket>& batch) {
+    PacketParser& parser = ring_parsers_[worker];
+    IndexedFrameKind index_kind;
+    for (const RingPacket& packet : batch) {
+        if (processFrame(&packet.header, packet.data, packet.interface_id, parser, index_kind) &&
+            writer_.isOpen()) {
+            writer_.write(&packet.header, packet.data, 0, index_kind);
+        }
     }
+}
+
+// Latency runs from the hand-over of the batch, the replay's stand-in for
+// the kernel's receive time; the output keeps the recorded timestamps
+void PacketCapture::replayBatch(const std::vector<RingPacket>& batch) {
+    struct timeval received;
+    gettimeofday(&received, nullptr);
     
-    total_packets_++;
+    IndexedFrameKind index_kind;
+    for (const RingPacket& packet : batch) {
+        struct pcap_pkthdr header = packet.header;
+        header.ts = received;
+        if (processFrame(&header, packet.data, packet.interface_id, parser_, index_kind) && writer_.isOpen()) {
+            writer_.write(&packet.header, packet.data, 0, index_kind);
+        }
+    }
+}
+
+// Runs on several ring workers at once: everything it touches is either
+// atomic, per worker (parser) or locked
+bool PacketCapture::processFrame(const struct pcap_pkthdr* header, const uint8_t* packet, uint32_t interface_id,
+                                 PacketParser& parser, IndexedFrameKind& index_kind) {
+    index_kind = IndexedFrameKind::NONE;
+    
+    // Monitor-mode frames arrive behind a radiotap header
+    const uint8_t* frame;
+    int length;
+    RadiotapInfo radiotap;
+    if (!parser.ieee80211Frame(packet, header->caplen, link_type_, frame, length, &radiotap, interface_id)) {
+        return false;
+    }
     
-    // Write to file if enabled
-    if (output_file_.is_open()) {
-        writePacketToFile(header, packet);
+    if (!shouldCapturePacket(frame, length)) {
+        return false;
     }
     
+    total_packets_++;
+    
     // Process packet based on type
-    onPacketReceived(packet, header->caplen);
+    onPacketReceived(frame, length);
+    
+    // Classified once; only the handler for its class parses it
+    FrameClass frame_class = dispatcher_.dispatch(frame, length, radiotap);
+    
+    if (frame_class == FrameClass::EAPOL || frame_class == FrameClass::SAE) {
+        handshake_latency_.record(nanosecondsSince(header->ts));
+    } else if (latencySampleDue()) {
+        frame_latency_.record(nanosecondsSince(header->ts));
+    }
+    
+    if (writer_.isIndexing()) {
+        index_kind = indexKind(frame_class, frame, length, parser);
+    }
+    return true;
+}
+
+IndexedFrameKind PacketCapture::indexKind(FrameClass frame_class, const uint8_t* frame, int length,
+                                          PacketParser& parser) {
+    if (frame_class == FrameClass::EAPOL) {
+        EapolKeyView key;
+        ByteView pmkid;
+        if (!parser.parseEAPOLFrame(frame, length, key)) return IndexedFrameKind::NONE;
+        return key.findPMKID(pmkid) ? IndexedFrameKind::PMKID : IndexedFrameKind::EAPOL;
+    }
     
-    // Parse different frame types
-    if (parser_.isBeaconFrame(packet)) {
-        WifiNetwork network;
-        if (parser_.parseBeaconFrame(packet, header->caplen, network)) {
-            onBeaconFrame(network);
+    if (frame_class == FrameClass::BEACON) {
+        // One beacon per BSS and file is enough to name it
+        BeaconView beacon;
+        if (!parser.parseBeaconFrame(frame, length, beacon) || beacon.ssid.empty()) return IndexedFrameKind::NONE;
+        
+        uint64_t bssid = 0;
+        for (uint8_t byte : beacon.bssid.bytes) bssid = (bssid << 8) | byte;
+        int file = writer_.getFileCount();
+        
+        std::lock_guard<std::mutex> lock(beacon_mutex_);
+        auto inserted = indexed_bss_.emplace(bssid, file);
+        if (!inserted.second && inserted.first->second == file) return IndexedFrameKind::NONE;
+        inserted.first->second = file;
+        return IndexedFrameKind::BEACON;
+    }
+    
+    return IndexedFrameKind::NONE;
+}
+
+CaptureCounters PacketCapture::getCaptureCounters() {
+    if (ring_.isOpen()) {
+        return ring_.getCounters();
+    }
+    if (!replay_options_.path.empty()) {
+        return replay_.getCounters();   // still there once the replay is closed
+    }
+    
+    CaptureCounters counters;
+    struct pcap_stat stats;
+    if (pcap_handle_ && pcap_stats(pcap_handle_, &stats) == 0) {
+        counters.received = stats.ps_recv;
+        counters.dropped = stats.ps_drop;
+        counters.interface_dropped = stats.ps_ifdrop;
+    }
+    return counters;
+}
+
+std::vector<size_t> PacketCapture::getRingBacklog() const {
+    return ring_.getBacklog();
+}
+
+void PacketCapture::registerFrameHandlers() {
+    dispatcher_.on(FrameClass::BEACON, [this](const uint8_t* frame, int length, const RadiotapInfo& radiotap) {
+        BeaconView beacon;
+        if (parser_.parseBeaconFrame(frame, length, beacon)) {
+            onBeaconFrame(beacon, radiotap);
         }
-    } else if (parser_.isDataFrame(packet)) {
+    });
+    
+    dispatcher_.on(FrameClass::DATA, [this](const uint8_t* frame, int length, const RadiotapInfo&) {
         MacAddress src, dst;
-        if (parser_.parseDataFrame(packet, header->caplen, src, dst)) {
+        if (parser_.parseDataFrame(frame, length, src, dst)) {
             onDataFrame(src, dst);
         }
-    } else if (parser_.isEAPOLFrame(packet)) {
-        HandshakePacket handshake;
-        if (parser_.parseEAPOLFrame(packet, header->caplen, handshake)) {
+    });
+    
+    dispatcher_.on(FrameClass::EAPOL, [this](const uint8_t* frame, int length, const RadiotapInfo&) {
+        EapolKeyView handshake;
+        if (parser_.parseEAPOLFrame(frame, length, handshake)) {
             handshake_count_++;
             onHandshakePacket(handshake);
         }
-    } else if (parser_.isSAEFrame(packet)) {
-        SAEHandshakePacket sae_packet;
-        if (parser_.parseSAEFrame(packet, header->caplen, sae_packet)) {
-            // Compter également les handshakes SAE
+    });
+    
+    dispatcher_.on(FrameClass::SAE, [this](const uint8_t* frame, int length, const RadiotapInfo&) {
+        // Compter également les handshakes SAE
+        SaeCommitView commit;
+        SaeConfirmView confirm;
+        if (parser_.parseSAEFrame(frame, length, commit)) {
             handshake_count_++;
-            onSAEHandshakePacket(sae_packet);
+            onSAECommit(commit);
+        } else if (parser_.parseSAEFrame(frame, length, confirm)) {
+            handshake_count_++;
+            onSAEConfirm(confirm);
         }
-    }
+    });
 }
 
 void PacketCapture::onPacketReceived(const uint8_t* packet, int length) {
@@ -180,10 +358,16 @@ void PacketCapture::onPacketReceived(const uint8_t* packet, int length) {
     }
 }
 
-void PacketCapture::onBeaconFrame(const WifiNetwork& network) {
+void PacketCapture::onBeaconFrame(const BeaconView& beacon, const RadiotapInfo& radiotap) {
     if (config_.verbose) {
+        // Only the log line needs the elements, decoded again only when they change
+        std::lock_guard<std::mutex> lock(beacon_mutex_);
+        bool changed;
+        const WifiNetwork& network = beacon_cache_.update(beacon, radiotap, changed);
+        int channel = network.channel > 0 ? network.channel : PacketParser::frequencyToChannel(radiotap.frequency);
+        
         std::string msg = "Beacon: " + network.essid + " (" + network.bssid.toString() + 
-                         ") Channel: " + std::to_string(network.channel);
+                         ") Channel: " + std::to_string(channel);
         Logger::getInstance().info(msg);
     }
 }
@@ -195,63 +379,41 @@ void PacketCapture::onDataFrame(const MacAddress& src, const MacAddress& dst) {
     }
 }
 
-void PacketCapture::onHandshakePacket(const HandshakePacket& handshake) {
+void PacketCapture::onHandshakePacket(const EapolKeyView& handshake) {
     std::string msg = "Handshake captured! AP: " + handshake.ap_mac.toString() + 
                      " Client: " + handshake.client_mac.toString() +
                      " Message: " + std::to_string(handshake.message_number);
     Logger::getInstance().info(msg);
 }
 
-void PacketCapture::onSAEHandshakePacket(const SAEHandshakePacket& sae_packet) {
-    std::string msg = "WPA3-SAE handshake captured! AP: " + sae_packet.ap_mac.toString() +
-                     " Client: " + sae_packet.client_mac.toString() +
-                     " Seq: " + std::to_string(sae_packet.message_number) +
-                     " Group: " + std::to_string(sae_packet.finite_field_group);
+void PacketCapture::onSAECommit(const SaeCommitView& commit) {
+    std::string msg = "WPA3-SAE handshake captured! AP: " + commit.ap_mac.toString() +
+                     " Client: " + commit.client_mac.toString() +
+                     " Seq: 1 Group: " + std::to_string(commit.group);
     Logger::getInstance().info(msg);
 }
 
-bool PacketCapture::openOutputFile() {
-    output_file_.open(config_.output_file, std::ios::binary);
-    if (!output_file_.is_open()) {
-        Logger::getInstance().error("Failed to open output file: " + config_.output_file);
-        return false;
-    }
-    
-    // Write pcap file header
-    struct {
-        uint32_t magic_number = 0xa1b2c3d4;
-        uint16_t version_major = 2;
-        uint16_t version_minor = 4;
-        int32_t thiszone = 0;
-        uint32_t sigfigs = 0;
-        uint32_t snaplen = 65535;
-        uint32_t network = 127; // IEEE 802.11 + radiotap header
-    } pcap_header;
-    
-    output_file_.write(reinterpret_cast<const char*>(&pcap_header), sizeof(pcap_header));
-    
-    Logger::getInstance().info("Output file opened: " + config_.output_file);
-    return true;
+void PacketCapture::onSAEConfirm(const SaeConfirmView& confirm) {
+    std::string msg = "WPA3-SAE handshake captured! AP: " + confirm.ap_mac.toString() +
+                     " Client: " + confirm.client_mac.toString() + " Seq: 2";
+    Logger::getInstance().info(msg);
 }
 
-void PacketCapture::writePacketToFile(const struct pcap_pkthdr* header, const uint8_t* packet) {
-    std::lock_guard<std::mutex> lock(file_mutex_);
-    
-    // Write packet header
-    struct PacketHeader {
-        uint32_t ts_sec;
-        uint32_t ts_usec;
-        uint32_t caplen;
-        uint32_t len;
-    } packet_header;
-
-    packet_header.ts_sec = static_cast<uint32_t>(header->ts.tv_sec);
-    packet_header.ts_usec = static_cast<uint32_t>(header->ts.tv_usec);
-    packet_header.caplen = header->caplen;
-    packet_header.len = header->len;
-
-    output_file_.write(reinterpret_cast<const char*>(&packet_header), sizeof(packet_header));
-    output_file_.write(reinterpret_cast<const char*>(packet), header->caplen);
+bool PacketCapture::openOutputFile() {
+    // Frames are written as received, so the file carries the interface's link type
+    CaptureInterface interface;
+    interface.name = config_.interface;
+    if (replay_.isOpen()) {
+        interface.name = replay_options_.path;
+        interface.description = "replayed capture";
+    } else if (config_.channel > 0) {
+        interface.description = "channel " + std::to_string(config_.channel);
+    }
+    interface.link_type = link_type_;
+    if (pcap_handle_) {
+        interface.snaplen = static_cast<uint32_t>(pcap_snapshot(pcap_handle_));
+    }
+    return writer_.open(config_.output_file, std::vector<CaptureInterface>{interface}, writer_options_);
 }
 
 bool PacketCapture::shouldCapturePacket(const uint8_t* packet, int length) {
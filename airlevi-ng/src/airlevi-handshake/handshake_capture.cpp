@@ -1,20 +1,16 @@
 #include "airlevi-handshake/handshake_capture.h"
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
 #include <unistd.h>
 #include <iomanip>
 #include <algorithm>
+#include <arpa/inet.h>
 
-// Radiotap header structure (simplified)
-struct radiotap_header {
-    uint8_t it_version;
-    uint8_t it_pad;
-    uint16_t it_len;
-    uint32_t it_present;
-};
+namespace airlevi {
 
 HandshakeCapture::HandshakeCapture()
-    : pcap_handle(nullptr), pcap_dumper(nullptr), running(false),
+    : pcap_handle(nullptr), running(false),
       channel_hopping_enabled(true), dwell_time_ms(250), deauth_attack_enabled(false),
       deauth_packets_per_burst(5), deauth_burst_interval_ms(2000), current_channel(1),
       packets_processed(0), deauth_sent(0) {
@@ -23,11 +19,18 @@ HandshakeCapture::HandshakeCapture()
     for (int i = 1; i <= 14; ++i) channels.push_back(i);
     std::vector<uint8_t> ghz5_channels = {36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 149, 153, 157, 161, 165};
     channels.insert(channels.end(), ghz5_channels.begin(), ghz5_channels.end());
+
+    dispatcher.on(FrameClass::BEACON, [this](const u_char* frame, int length, const RadiotapInfo&) {
+        parseBeaconFrame(frame, length);
+    });
+    dispatcher.on(FrameClass::EAPOL, [this](const u_char* frame, int length, const RadiotapInfo&) {
+        parseEAPOL(frame, length);
+    });
 }
 
 HandshakeCapture::~HandshakeCapture() {
     stopCapture();
-    if (pcap_dumper) pcap_dump_close(pcap_dumper);
+    pcap_writer.close();
     if (pcap_handle) pcap_close(pcap_handle);
 }
 
@@ -51,10 +54,22 @@ bool HandshakeCapture::initialize(const std::string& interface, const std::strin
         std::cerr << "[-] pcap_activate() failed: " << pcap_geterr(pcap_handle) << std::endl;
         return false;
     }
+    link_type = pcap_datalink(pcap_handle);
+
+    // A .pcapng file also gets the interface's metadata and an index of the handshakes
+    PcapWriterOptions options;
+    if (output_file.size() > 7 && output_file.compare(output_file.size() - 7, 7, ".pcapng") == 0) {
+        options.format = CaptureFormat::PCAPNG;
+        options.application = "AirLevi-NG airlevi-handshake 1.0";
+        options.comment = "Handshakes captured on " + interface;
+    }
+    CaptureInterface capture_interface;
+    capture_interface.name = interface;
+    capture_interface.link_type = link_type;
+    capture_interface.snaplen = static_cast<uint32_t>(pcap_snapshot(pcap_handle));
 
-    pcap_dumper = pcap_dump_open(pcap_handle, output_file.c_str());
-    if (!pcap_dumper) {
-        std::cerr << "[-] Failed to open output file " << output_file << ": " << pcap_geterr(pcap_handle) << std::endl;
+    if (!pcap_writer.open(output_file, std::vector<CaptureInterface>{capture_interface}, options)) {
+        std::cerr << "[-] Failed to open output file " << output_file << std::endl;
         return false;
     }
 
@@ -181,7 +196,7 @@ void HandshakeCapture::deauthLoop() {
             std::lock_guard<std::mutex> lock(data_mutex);
             for (const auto& pair : clients) {
                 if (pair.second.is_associated) {
-                    if (target_bssid.isNull() || pair.second.ap_bssid == target_bssid) {
+                    if (target_bssid == MacAddress() || pair.second.ap_bssid == target_bssid) {
                         clients_to_attack.push_back(pair.second);
                     }
                 }
@@ -202,29 +217,13 @@ void HandshakeCapture::processPacket(const struct pcap_pkthdr* header, const u_c
     if (!running) pcap_breakloop(pcap_handle);
     packets_processed++;
 
-    // Skip radiotap header
-    auto rt_header = reinterpret_cast<const radiotap_header*>(packet);
-    const u_char* dot11_frame = packet + rt_header->it_len;
-    int frame_len = header->caplen - rt_header->it_len;
-
-    if (frame_len < 24) return;
-
-    uint16_t frame_control = *reinterpret_cast<const uint16_t*>(dot11_frame);
-    uint8_t type = (frame_control & 0x0C) >> 2;
-    uint8_t subtype = (frame_control & 0xF0) >> 4;
-
-    if (type == 0 && subtype == 8) { // Management frame, Beacon
-        parseBeaconFrame(dot11_frame, frame_len);
-    } else if (type == 2) { // Data frame
-        // Check for EAPOL
-        if (frame_len > 32) {
-            const u_char* llc = dot11_frame + 24;
-            if (llc[0] == 0xAA && llc[1] == 0xAA && llc[2] == 0x03 &&
-                llc[6] == 0x88 && llc[7] == 0x8E) {
-                parseEAPOL(dot11_frame, frame_len);
-            }
-        }
-    }
+    const u_char* dot11_frame;
+    int frame_len;
+    RadiotapInfo radiotap;
+    if (!parser.ieee80211Frame(packet, header->caplen, link_type, dot11_frame, frame_len, &radiotap)) return;
+    if (frame_len < 24 || radiotap.bad_fcs) return;
+
+    dispatcher.dispatch(dot11_frame, frame_len, radiotap);
 }
 
 void HandshakeCapture::parseBeaconFrame(const u_char* packet, int length) {
@@ -324,7 +323,7 @@ void HandshakeCapture::sendDeauthPacket(const MacAddress& ap_bssid, const MacAdd
 }
 
 void HandshakeCapture::saveHandshake(const Handshake& handshake) {
-    if (!pcap_dumper) return;
+    if (!pcap_writer.isOpen()) return;
 
     struct pcap_pkthdr header;
     header.ts.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(handshake.timestamp.time_since_epoch()).count();
@@ -333,10 +332,11 @@ void HandshakeCapture::saveHandshake(const Handshake& handshake) {
     for (int i = 0; i < 4; ++i) {
         if (!handshake.eapol_frames[i].empty()) {
             header.caplen = header.len = handshake.eapol_frames[i].size();
-            pcap_dump(reinterpret_cast<u_char*>(pcap_dumper), &header, handshake.eapol_frames[i].data());
+            pcap_writer.write(&header, handshake.eapol_frames[i].data(), 0, IndexedFrameKind::EAPOL);
         }
     }
-    pcap_dump_flush(pcap_dumper);
+    // Written out by the writer thread right away, without waiting on the disk here
+    pcap_writer.flush();
 }
 
 bool HandshakeCapture::setWifiChannel(const std::string& interface, uint8_t channel) {
@@ -364,3 +364,5 @@ void HandshakeCapture::displayStatus() const {
     }
     std::cout << "╚══════════════════╩════════════════════════════╩═══════╩═════════════╝\n";
 }
+
+} // namespace airlevi
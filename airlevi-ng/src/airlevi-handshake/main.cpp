@@ -6,6 +6,9 @@
 #include <thread>
 #include <chrono>
 #include <cstdio>
+#include <cstdlib>
+
+using namespace airlevi;
 
 HandshakeCapture* g_capture = nullptr;
 
@@ -29,7 +32,7 @@ void printUsage(const std::string& app_name) {
     std::cout << "Usage: " << app_name << " -i <interface> -o <output.pcap> [options]\n\n";
     std::cout << "Required:\n";
     std::cout << "  -i <interface>      Wireless interface in monitor mode\n";
-    std::cout << "  -o <output.pcap>    File to save captured handshakes\n\n";
+    std::cout << "  -o <output.pcap>    File to save captured handshakes (.pcapng adds an index)\n\n";
     std::cout << "Optional:\n";
     std::cout << "  -b <bssid>          Target a specific BSSID\n";
     std::cout << "  -e <ssid>           Target a specific SSID\n";
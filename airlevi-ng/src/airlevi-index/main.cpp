@@ -0,0 +1,110 @@
+#include <iostream>
+#include <iomanip>
+#include <getopt.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "common/capture_reader.h"
+#include "common/frame_index.h"
+#include "common/logger.h"
+
+using namespace airlevi;
+
+void printUsage(const char* program_name) {
+    std::cout << "AirLevi-NG Capture Indexer v1.0\n";
+    std::cout << "Usage: " << program_name << " [OPTIONS] CAPTURE...\n\n";
+    std::cout << "Writes CAPTURE.alxi next to each capture: every frame's offset, timestamp,\n";
+    std::cout << "type and hashed BSSID/station, plus lists of the EAPOL, PMKID, beacon and\n";
+    std::cout << "WEP data frames. airlevi-crack then reads only the frames it needs.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -f, --force              Rebuild indexes that are still current\n";
+    std::cout << "  -v, --verbose            Verbose output\n";
+    std::cout << "  -h, --help               Show this help\n";
+    std::cout << "\nExamples:\n";
+    std::cout << "  " << program_name << " capture.cap\n";
+    std::cout << "  " << program_name << " -f captures/*.pcapng\n";
+}
+
+static bool indexCapture(const std::string& path, bool force) {
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    FrameIndex current;
+    if (!force && current.open(path, reader)) {
+        std::cout << "[*] " << path << ": index is current (" << current.size() << " frames)" << std::endl;
+        return true;
+    }
+    current.close();
+
+    auto start = std::chrono::steady_clock::now();
+    FrameIndexBuilder builder;
+    if (!builder.open(path)) {
+        return false;
+    }
+
+    CaptureFrame frame;
+    while (reader.next(frame)) {
+        builder.add(frame);
+    }
+    if (!builder.close()) {
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[+] " << path << ": " << builder.getFrameCount() << " frames, "
+              << builder.getPostingCount(FramePosting::EAPOL) << " EAPOL, "
+              << builder.getPostingCount(FramePosting::PMKID) << " PMKID, "
+              << builder.getPostingCount(FramePosting::BEACON) << " beacons, "
+              << builder.getPostingCount(FramePosting::WEP_DATA) << " WEP data in "
+              << std::fixed << std::setprecision(2) << seconds << "s" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool force = false;
+    bool verbose = false;
+
+    static struct option long_options[] = {
+        {"force", no_argument, 0, 'f'},
+        {"verbose", no_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "fvh", long_options, nullptr)) != -1) {
+        switch (c) {
+            case 'f':
+                force = true;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'h':
+                printUsage(argv[0]);
+                return 0;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind >= argc) {
+        std::cerr << "[-] No capture files given." << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Logger::getInstance().setVerbose(verbose);
+
+    int failed = 0;
+    for (int i = optind; i < argc; ++i) {
+        if (!indexCapture(argv[i], force)) {
+            std::cerr << "[-] Failed to index " << argv[i] << std::endl;
+            ++failed;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
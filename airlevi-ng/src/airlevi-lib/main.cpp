@@ -4,6 +4,7 @@
 #include <string>
 #include "airlevi-lib/password_database.h"
 #include "common/logger.h"
+#include "common/progress_stream.h"
 
 using namespace airlevi;
 
@@ -30,6 +31,8 @@ void printUsage(const char* program_name) {
     std::cout << "\nOptions:\n";
     std::cout << "  -v, --verbose          Verbose output\n";
     std::cout << "  -h, --help             Show this help\n";
+    std::cout << "  --progress-stream DEST NDJSON progress events to a file or fd:N\n";
+    std::cout << "  --progress-interval MS Minimum time between progress events (default: 1000)\n";
     std::cout << "\nExamples:\n";
     std::cout << "  " << program_name << " mydb.db --create\n";
     std::cout << "  " << program_name << " mydb.db --import-essid \"MyWiFi\"\n";
@@ -48,6 +51,8 @@ int main(int argc, char* argv[]) {
     std::string import_wordlist_essid;
     std::string import_wordlist_file;
     std::string compute_essid;
+    std::string progress_stream;
+    int progress_interval = 1000;
     
     static struct option long_options[] = {
         {"verbose", no_argument, 0, 'v'},
@@ -60,6 +65,8 @@ int main(int argc, char* argv[]) {
         {"list-essids", no_argument, 0, 1005},
         {"verify", no_argument, 0, 1006},
         {"vacuum", no_argument, 0, 1007},
+        {"progress-stream", required_argument, 0, 1008},
+        {"progress-interval", required_argument, 0, 1009},
         {0, 0, 0, 0}
     };
     
@@ -96,6 +103,12 @@ int main(int argc, char* argv[]) {
             case 1007:
                 vacuum_db = true;
                 break;
+            case 1008:
+                progress_stream = optarg;
+                break;
+            case 1009:
+                progress_interval = std::atoi(optarg);
+                break;
             default:
                 printUsage(argv[0]);
                 return 1;
@@ -127,6 +140,13 @@ int main(int argc, char* argv[]) {
     
     try {
         Logger::getInstance().setVerbose(verbose);
+        if (!progress_stream.empty()) {
+            if (!ProgressStream::getInstance().open(progress_stream, "airlevi-lib")) {
+                return 1;
+            }
+            ProgressStream::getInstance().setInterval(
+                std::chrono::milliseconds(progress_interval > 0 ? progress_interval : 1000));
+        }
         db = std::make_unique<PasswordDatabase>();
         
         if (create_db) {
@@ -1,10 +1,12 @@
 #include "airlevi-lib/password_database.h"
 #include "common/logger.h"
+#include "common/progress_stream.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <thread>
 #include <chrono>
+#include <cmath>
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 
@@ -23,7 +25,7 @@ bool PasswordDatabase::create(const std::string& db_path) {
     
     int rc = sqlite3_open(db_path.c_str(), &db_);
     if (rc != SQLITE_OK) {
-        Logger::getInstance().log("Cannot create database: " + std::string(sqlite3_errmsg(db_)), LogLevel::ERROR);
+        Logger::getInstance().error("Cannot create database: " + std::string(sqlite3_errmsg(db_)));
         return false;
     }
     
@@ -34,7 +36,7 @@ bool PasswordDatabase::create(const std::string& db_path) {
         return false;
     }
     
-    Logger::getInstance().log("Database created: " + db_path, LogLevel::INFO);
+    Logger::getInstance().info("Database created: " + db_path);
     return true;
 }
 
@@ -43,12 +45,12 @@ bool PasswordDatabase::open(const std::string& db_path) {
     
     int rc = sqlite3_open(db_path.c_str(), &db_);
     if (rc != SQLITE_OK) {
-        Logger::getInstance().log("Cannot open database: " + std::string(sqlite3_errmsg(db_)), LogLevel::ERROR);
+        Logger::getInstance().error("Cannot open database: " + std::string(sqlite3_errmsg(db_)));
         return false;
     }
     
     is_open_ = true;
-    Logger::getInstance().log("Database opened: " + db_path, LogLevel::INFO);
+    Logger::getInstance().info("Database opened: " + db_path);
     return true;
 }
 
@@ -120,7 +122,7 @@ bool PasswordDatabase::executeSQL(const std::string& sql) {
     
     if (rc != SQLITE_OK) {
         std::string error = error_msg ? error_msg : "Unknown error";
-        Logger::getInstance().log("SQL error: " + error, LogLevel::ERROR);
+        Logger::getInstance().error("SQL error: " + error);
         if (error_msg) sqlite3_free(error_msg);
         return false;
     }
@@ -142,11 +144,11 @@ bool PasswordDatabase::importESSID(const std::string& essid) {
     sqlite3_finalize(stmt);
     
     if (rc != SQLITE_DONE) {
-        Logger::getInstance().log("Failed to import ESSID: " + essid, LogLevel::ERROR);
+        Logger::getInstance().error("Failed to import ESSID: " + essid);
         return false;
     }
     
-    Logger::getInstance().log("Imported ESSID: " + essid, LogLevel::INFO);
+    Logger::getInstance().info("Imported ESSID: " + essid);
     return true;
 }
 
@@ -157,10 +159,14 @@ bool PasswordDatabase::importWordlist(const std::string& essid, const std::strin
     
     std::ifstream file(wordlist_path);
     if (!file.is_open()) {
-        Logger::getInstance().log("Cannot open wordlist: " + wordlist_path, LogLevel::ERROR);
+        Logger::getInstance().error("Cannot open wordlist: " + wordlist_path);
         return false;
     }
     
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    
     beginTransaction();
     
     std::string password;
@@ -174,12 +180,28 @@ bool PasswordDatabase::importWordlist(const std::string& essid, const std::strin
             if (count % 1000 == 0) {
                 std::cout << "\rImported " << count << " passwords..." << std::flush;
             }
+            
+            if (ProgressStream::getInstance().progressDue()) {
+                uint64_t position = static_cast<uint64_t>(file.tellg());
+                ProgressStream::getInstance().emit(ProgressEvent("progress")
+                    .add("stage", "import")
+                    .add("essid", essid)
+                    .add("imported", count)
+                    .add("position", position)
+                    .add("keyspace", file_size)
+                    .add("progress", file_size > 0 ? static_cast<double>(position) / file_size : 1.0), true);
+            }
         }
     }
     
     commitTransaction();
     file.close();
     
+    ProgressStream::getInstance().emit(ProgressEvent("result")
+        .add("stage", "import")
+        .add("essid", essid)
+        .add("imported", count));
+    
     std::cout << "\nImported " << count << " passwords for ESSID: " << essid << std::endl;
     return true;
 }
@@ -221,8 +243,11 @@ bool PasswordDatabase::computePMKs(const std::string& essid) {
     
     beginTransaction();
     
+    auto start = std::chrono::steady_clock::now();
     int count = 0;
+    size_t position = 0;
     for (const auto& password : passwords) {
+        position++;
         if (!pmkExists(essid, password)) {
             computePMK(essid, password);
             count++;
@@ -231,10 +256,30 @@ bool PasswordDatabase::computePMKs(const std::string& essid) {
                 std::cout << "\rComputed " << count << " PMKs..." << std::flush;
             }
         }
+        
+        if (ProgressStream::getInstance().progressDue()) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double rate = elapsed > 0 ? count / elapsed : 0.0;
+            size_t left = passwords.size() - position;
+            ProgressStream::getInstance().emit(ProgressEvent("progress")
+                .add("stage", "compute")
+                .add("essid", essid)
+                .add("computed", count)
+                .add("rate", rate)
+                .add("position", position)
+                .add("keyspace", passwords.size())
+                .add("progress", static_cast<double>(position) / passwords.size())
+                .add("eta", rate > 0 ? left / rate : NAN), true);
+        }
     }
     
     commitTransaction();
     
+    ProgressStream::getInstance().emit(ProgressEvent("result")
+        .add("stage", "compute")
+        .add("essid", essid)
+        .add("computed", count));
+    
     std::cout << "\nComputed " << count << " PMKs for ESSID: " << essid << std::endl;
     return true;
 }
@@ -268,7 +313,7 @@ bool PasswordDatabase::computePMK(const std::string& essid, const std::string& p
 bool PasswordDatabase::prepareStatement(const std::string& sql, sqlite3_stmt** stmt) {
     int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, stmt, nullptr);
     if (rc != SQLITE_OK) {
-        Logger::getInstance().log("Failed to prepare statement: " + getLastError(), LogLevel::ERROR);
+        Logger::getInstance().error("Failed to prepare statement: " + getLastError());
         return false;
     }
     return true;
@@ -400,32 +445,32 @@ bool PasswordDatabase::pmkExists(const std::string& essid, const std::string& pa
 
 bool PasswordDatabase::vacuum() {
     if (!is_open_) {
-        Logger::getInstance().log("Database is not open.", LogLevel::ERROR);
+        Logger::getInstance().error("Database is not open.");
         return false;
     }
-    Logger::getInstance().log("Running VACUUM on the database...", LogLevel::INFO);
+    Logger::getInstance().info("Running VACUUM on the database...");
     if (executeSQL("VACUUM;")) {
-        Logger::getInstance().log("Database vacuumed successfully.", LogLevel::INFO);
+        Logger::getInstance().info("Database vacuumed successfully.");
         return true;
     } else {
-        Logger::getInstance().log("Failed to vacuum database.", LogLevel::ERROR);
+        Logger::getInstance().error("Failed to vacuum database.");
         return false;
     }
 }
 
 bool PasswordDatabase::verify() {
     if (!is_open_) {
-        Logger::getInstance().log("Database is not open.", LogLevel::ERROR);
+        Logger::getInstance().error("Database is not open.");
         return false;
     }
     
-    Logger::getInstance().log("Verifying database integrity...", LogLevel::INFO);
+    Logger::getInstance().info("Verifying database integrity...");
     
     sqlite3_stmt* stmt;
     std::string sql = "PRAGMA integrity_check;";
     
     if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        Logger::getInstance().log("Failed to prepare integrity_check statement: " + getLastError(), LogLevel::ERROR);
+        Logger::getInstance().error("Failed to prepare integrity_check statement: " + getLastError());
         return false;
     }
     
@@ -435,20 +480,20 @@ bool PasswordDatabase::verify() {
     if (rc == SQLITE_ROW) {
         const char* result = (const char*)sqlite3_column_text(stmt, 0);
         if (result && std::string(result) == "ok") {
-            Logger::getInstance().log("Database integrity check passed.", LogLevel::INFO);
+            Logger::getInstance().info("Database integrity check passed.");
             ok = true;
         } else {
-            Logger::getInstance().log("Database integrity check failed: " + std::string(result ? result : ""), LogLevel::ERROR);
+            Logger::getInstance().error("Database integrity check failed: " + std::string(result ? result : ""));
             // Read all error messages
             while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
                  const char* error_msg = (const char*)sqlite3_column_text(stmt, 0);
                  if (error_msg) {
-                     Logger::getInstance().log("Details: " + std::string(error_msg), LogLevel::ERROR);
+                     Logger::getInstance().error("Details: " + std::string(error_msg));
                  }
             }
         }
     } else {
-        Logger::getInstance().log("Failed to execute integrity_check: " + getLastError(), LogLevel::ERROR);
+        Logger::getInstance().error("Failed to execute integrity_check: " + getLastError());
     }
     
     sqlite3_finalize(stmt);
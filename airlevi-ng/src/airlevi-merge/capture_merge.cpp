@@ -0,0 +1,205 @@
+#include "airlevi-merge/capture_merge.h"
+#include "common/logger.h"
+#include "common/pcap_writer.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace airlevi {
+
+namespace {
+
+uint64_t fnv1a64(const uint8_t* data, uint32_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint32_t i = 0; i < length; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+CaptureMerge::CaptureMerge(const MergeOptions& options) : options_(options) {
+}
+
+CaptureMerge::~CaptureMerge() {
+}
+
+bool CaptureMerge::addCapture(const std::string& path) {
+    Input input;
+    input.reader = std::make_unique<CaptureReader>();
+    if (!input.reader->open(path)) {
+        return false;
+    }
+    input.path = path;
+
+    // Output interfaces are fixed when the file is opened. A pcap has one
+    // link type; a pcapng may bring more, which costs a pass over it.
+    if (input.reader->getFormat() == CaptureFormat::PCAPNG) {
+        CaptureFrame frame;
+        while (input.reader->next(frame)) {
+            if (std::find(input.link_types.begin(), input.link_types.end(), frame.link_type) ==
+                input.link_types.end()) {
+                input.link_types.push_back(frame.link_type);
+            }
+        }
+        input.reader->rewind();
+    }
+    if (input.link_types.empty()) {
+        input.link_types.push_back(input.reader->getLinkType());
+    }
+
+    stats_.captures++;
+    inputs_.push_back(std::move(input));
+    return true;
+}
+
+bool CaptureMerge::write(const std::string& path) {
+    std::vector<CaptureInterface> interfaces;
+    for (Input& input : inputs_) {
+        for (uint32_t link_type : input.link_types) {
+            CaptureInterface interface;
+            interface.name = baseName(input.path);
+            interface.description = "merged from " + input.path;
+            interface.link_type = static_cast<int>(link_type);
+            input.interface_ids[link_type] = static_cast<uint32_t>(interfaces.size());
+            interfaces.push_back(interface);
+        }
+    }
+    if (interfaces.empty()) {
+        interfaces.push_back(CaptureInterface());
+    }
+
+    if (options_.format == CaptureFormat::PCAP) {
+        for (const CaptureInterface& interface : interfaces) {
+            if (interface.link_type != interfaces[0].link_type) {
+                Logger::getInstance().error("Inputs mix link types " + std::to_string(interfaces[0].link_type) +
+                                            " and " + std::to_string(interface.link_type) + ", which needs pcapng");
+                return false;
+            }
+        }
+    }
+
+    PcapWriterOptions writer_options;
+    writer_options.format = options_.format;
+    writer_options.application = "AirLevi-NG airlevi-merge 1.0";
+    writer_options.comment = "Merge of " + std::to_string(inputs_.size()) + " capture(s)";
+    writer_options.wait_when_full = true;
+
+    PcapWriter writer;
+    if (!writer.open(path, interfaces, writer_options)) {
+        return false;
+    }
+
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+        Head head;
+        head.input = i;
+        if (inputs_[i].reader->next(head.frame)) {
+            heads.push(head);
+        }
+    }
+
+    uint64_t last_timestamp = 0;
+    while (!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        const CaptureFrame& frame = head.frame;
+        stats_.frames_in++;
+
+        if (frame.timestamp_ns < last_timestamp) {
+            stats_.out_of_order++;
+        }
+        last_timestamp = std::max(last_timestamp, frame.timestamp_ns);
+
+        if (options_.dedup_window_us > 0 && duplicate(frame, head.input)) {
+            stats_.duplicates++;
+        } else {
+            struct pcap_pkthdr header = {};
+            header.ts.tv_sec = static_cast<time_t>(frame.timestamp_ns / 1000000000ULL);
+            header.ts.tv_usec = static_cast<suseconds_t>(frame.timestamp_ns % 1000000000ULL / 1000);
+            header.caplen = frame.caplen;
+            header.len = frame.len;
+            IndexedFrameKind kind = writer.isIndexing() ? indexKind(frame) : IndexedFrameKind::NONE;
+            writer.write(&header, frame.data, inputs_[head.input].interface_ids[frame.link_type], kind);
+            stats_.frames_out++;
+        }
+
+        if (inputs_[head.input].reader->next(head.frame)) {
+            heads.push(head);
+        }
+    }
+
+    writer.close();
+    return writer.getDropped() == 0;
+}
+
+bool CaptureMerge::duplicate(const CaptureFrame& frame, size_t input) {
+    const uint8_t* packet;
+    uint32_t length;
+    if (!CaptureReader::ieee80211Frame(frame, packet, length, unpadded_)) {
+        return false;
+    }
+
+    uint64_t window_ns = options_.dedup_window_us * 1000;
+    while (!recent_.empty() && recent_.front().timestamp_ns + window_ns < frame.timestamp_ns) {
+        const Seen* oldest = &recent_.front();
+        auto range = recent_by_hash_.equal_range(oldest->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == oldest) {
+                recent_by_hash_.erase(it);
+                break;
+            }
+        }
+        recent_.pop_front();
+    }
+
+    // A radio hears a transmission once; the same bytes twice from one
+    // input are distinct transmissions
+    uint64_t hash = fnv1a64(packet, length);
+    auto range = recent_by_hash_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->input != input) {
+            return true;
+        }
+    }
+
+    recent_.push_back(Seen{frame.timestamp_ns, hash, input});
+    recent_by_hash_.emplace(hash, &recent_.back());
+    return false;
+}
+
+IndexedFrameKind CaptureMerge::indexKind(const CaptureFrame& frame) {
+    const uint8_t* packet;
+    uint32_t frame_length;
+    if (!CaptureReader::ieee80211Frame(frame, packet, frame_length, unpadded_)) return IndexedFrameKind::NONE;
+    int length = static_cast<int>(frame_length);
+
+    FrameClass frame_class = dispatcher_.classify(packet, length);
+    if (frame_class == FrameClass::EAPOL) {
+        EapolKeyView key;
+        ByteView pmkid;
+        if (!parser_.parseEAPOLFrame(packet, length, key)) return IndexedFrameKind::NONE;
+        return key.findPMKID(pmkid) ? IndexedFrameKind::PMKID : IndexedFrameKind::EAPOL;
+    }
+
+    if (frame_class == FrameClass::BEACON) {
+        // One beacon per BSS is enough to name it
+        BeaconView beacon;
+        if (!parser_.parseBeaconFrame(packet, length, beacon) || beacon.ssid.empty()) return IndexedFrameKind::NONE;
+
+        uint64_t bssid = 0;
+        for (uint8_t byte : beacon.bssid.bytes) bssid = (bssid << 8) | byte;
+        return indexed_bss_.insert(bssid).second ? IndexedFrameKind::BEACON : IndexedFrameKind::NONE;
+    }
+
+    return IndexedFrameKind::NONE;
+}
+
+} // namespace airlevi
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <iomanip>
+#include <getopt.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include "airlevi-merge/capture_merge.h"
+#include "common/logger.h"
+
+using namespace airlevi;
+
+void printUsage(const char* program_name) {
+    std::cout << "AirLevi-NG Capture Merge v1.0\n";
+    std::cout << "Usage: " << program_name << " -o OUTPUT [OPTIONS] CAPTURE...\n\n";
+    std::cout << "Merges captures taken at the same time, e.g. one per radio, into one file\n";
+    std::cout << "in timestamp order.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -o, --output FILE        Merged capture: pcap for a .pcap/.cap file, pcapng\n";
+    std::cout << "                           with one interface per input otherwise\n";
+    std::cout << "  -d, --dedup[=USEC]       Drop frames another input already gave within USEC\n";
+    std::cout << "                           microseconds (default window: 1000)\n";
+    std::cout << "  -v, --verbose            Verbose output\n";
+    std::cout << "  -h, --help               Show this help\n";
+    std::cout << "\nExamples:\n";
+    std::cout << "  " << program_name << " -o all.pcapng wlan0.pcap wlan1.pcap wlan2.pcap\n";
+    std::cout << "  " << program_name << " -o all.pcap --dedup=500 radio-*.pcapng\n";
+}
+
+static bool hasExtension(const std::string& path, const std::string& extension) {
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    MergeOptions options;
+    std::string output;
+    bool verbose = false;
+
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"dedup", optional_argument, 0, 'd'},
+        {"verbose", no_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "o:d::vh", long_options, nullptr)) != -1) {
+        switch (c) {
+            case 'o':
+                output = optarg;
+                break;
+            case 'd':
+                options.dedup_window_us = optarg ? std::strtoull(optarg, nullptr, 10) : 1000;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'h':
+                printUsage(argv[0]);
+                return 0;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (output.empty() || optind >= argc) {
+        std::cerr << "[-] An output file and at least one capture are required." << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Logger::getInstance().setVerbose(verbose);
+
+    if (hasExtension(output, ".pcap") || hasExtension(output, ".cap")) {
+        options.format = CaptureFormat::PCAP;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CaptureMerge merge(options);
+    for (int i = optind; i < argc; ++i) {
+        if (!merge.addCapture(argv[i])) {
+            std::cerr << "[-] Skipping " << argv[i] << std::endl;
+        }
+    }
+
+    if (!merge.write(output)) {
+        std::cerr << "[-] Failed to write " << output << std::endl;
+        return 1;
+    }
+
+    const MergeStats& stats = merge.getStats();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[+] " << stats.captures << " capture(s), " << stats.frames_in << " frames -> " << output << ", "
+              << stats.frames_out << " frames in " << std::fixed << std::setprecision(2) << seconds << "s";
+    if (options.dedup_window_us > 0) {
+        std::cout << " (" << stats.duplicates << " duplicates dropped)";
+    }
+    std::cout << std::endl;
+    if (stats.out_of_order > 0) {
+        std::cout << "[!] " << stats.out_of_order << " frame(s) older than one before them: "
+                  << "an input is not in time order" << std::endl;
+    }
+    return stats.captures > 0 ? 0 : 1;
+}
@@ -1,16 +1,19 @@
 #include "airlevi-monitor/advanced_monitor.h"
 #include "common/network_interface.h"
+#include "common/crypto_utils.h"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <cstdlib>
+#include <sys/time.h>
 
 namespace airlevi {
 
 AdvancedMonitor::AdvancedMonitor() 
-    : pcap_handle_(nullptr), running_(false), channel_hopping_enabled_(true),
+    : pcap_handle_(nullptr), link_type_(DLT_IEEE802_11_RADIO), running_(false), channel_hopping_enabled_(true),
       current_channel_(1), channel_dwell_time_(250), signal_threshold_(-100) {
     
     // Initialize default channel list (2.4GHz)
@@ -18,6 +21,7 @@ AdvancedMonitor::AdvancedMonitor()
     
     memset(&stats_, 0, sizeof(stats_));
     loadOUIDatabase();
+    registerFrameHandlers();
 }
 
 AdvancedMonitor::~AdvancedMonitor() {
@@ -28,6 +32,25 @@ AdvancedMonitor::~AdvancedMonitor() {
 bool AdvancedMonitor::initialize(const std::string& interface) {
     interface_ = interface;
     
+    if (!replay_options_.path.empty()) {
+        if (!replay_.open(replay_options_)) return false;
+        
+        // A file has no channel to tune
+        link_type_ = replay_.getLinkType();
+        channel_hopping_enabled_ = false;
+        Logger::getInstance().info("Initialized advanced monitor on capture: " + replay_options_.path);
+        return true;
+    }
+    
+    if (ring_options_.enabled) {
+        if (!ring_.open(interface, ring_options_)) return false;
+        
+        link_type_ = ring_.getLinkType();
+        ring_parsers_.assign(ring_.getWorkerCount(), PacketParser());
+        Logger::getInstance().info("Initialized advanced monitor on: " + interface);
+        return true;
+    }
+    
     char errbuf[PCAP_ERRBUF_SIZE];
     pcap_handle_ = pcap_open_live(interface.c_str(), BUFSIZ, 1, 1000, errbuf);
     
@@ -48,19 +71,31 @@ bool AdvancedMonitor::initialize(const std::string& interface) {
         return false;
     }
     
+    link_type_ = pcap_datalink(pcap_handle_);
+    
     Logger::getInstance().info("Initialized advanced monitor on: " + interface);
     return true;
 }
 
 bool AdvancedMonitor::startMonitoring() {
-    if (running_ || !pcap_handle_) return false;
+    if (running_ || (!pcap_handle_ && !ring_.isOpen() && !replay_.isOpen())) return false;
     
     running_ = true;
     stats_.start_time = std::chrono::steady_clock::now();
     
-    monitoring_thread_ = std::thread(&AdvancedMonitor::monitoringThread, this);
+    if (ring_.isOpen()) {
+        ring_.start([this](int worker, const std::vector<RingPacket>& batch) {
+            ringHandler(worker, batch);
+        });
+    } else if (replay_.isOpen()) {
+        replay_.start([this](int, const std::vector<RingPacket>& batch) {
+            replayHandler(batch);
+        });
+    } else {
+        monitoring_thread_ = std::thread(&AdvancedMonitor::monitoringThread, this);
+    }
     
-    if (channel_hopping_enabled_) {
+    if (channel_hopping_enabled_ && !replay_.isOpen()) {
         channel_hopping_thread_ = std::thread(&AdvancedMonitor::channelHoppingThread, this);
     }
     
@@ -74,12 +109,42 @@ void AdvancedMonitor::stopMonitoring() {
     running_ = false;
     
     if (monitoring_thread_.joinable()) monitoring_thread_.join();
+    ring_.stop();
+    replay_.stop();
     if (channel_hopping_thread_.joinable()) channel_hopping_thread_.join();
     if (cleanup_thread_.joinable()) cleanup_thread_.join();
     
     Logger::getInstance().info("Stopped advanced monitoring");
 }
 
+void AdvancedMonitor::setChannelHopping(bool enabled, int dwell_time_ms) {
+    channel_hopping_enabled_ = enabled && replay_options_.path.empty();
+    channel_dwell_time_ = dwell_time_ms > 0 ? dwell_time_ms : 250;
+}
+
+void AdvancedMonitor::setFixedChannel(uint8_t channel) {
+    channel_hopping_enabled_ = false;
+    current_channel_ = channel;
+    if (!replay_options_.path.empty()) return;
+    
+    NetworkInterface ni(interface_);
+    if (!ni.setChannel(channel)) {
+        Logger::getInstance().warning("Failed to set channel " + std::to_string(channel) + " on " + interface_);
+    }
+}
+
+void AdvancedMonitor::setTargetBSSID(const MacAddress& bssid) {
+    target_bssid_ = bssid;
+}
+
+void AdvancedMonitor::setTargetSSID(const std::string& ssid) {
+    target_ssid_ = ssid;
+}
+
+void AdvancedMonitor::setSignalThreshold(int min_signal) {
+    signal_threshold_ = min_signal;
+}
+
 void AdvancedMonitor::monitoringThread() {
     struct pcap_pkthdr* header;
     const u_char* packet;
@@ -88,7 +153,7 @@ void AdvancedMonitor::monitoringThread() {
         int result = pcap_next_ex(pcap_handle_, &header, &packet);
         
         if (result == 1) {
-            packetHandler(header, packet);
+            packetHandler(header, packet, 0, parser_);
         } else if (result == -1) {
             Logger::getInstance().error("Error reading packet: " + std::string(pcap_geterr(pcap_handle_)));
             break;
@@ -96,6 +161,344 @@ void AdvancedMonitor::monitoringThread() {
     }
 }
 
+void AdvancedMonitor::ringHandler(int worker, const std::vector<RingPacket>& batch) {
+    for (const RingPacket& packet : batch) {
+        packetHandler(&packet.header, packet.data, packet.interface_id, ring_parsers_[worker]);
+    }
+}
+
+// Latency runs from the hand-over of the batch, the replay's stand-in for
+// the kernel's receive time
+void AdvancedMonitor::replayHandler(const std::vector<RingPacket>& batch) {
+    struct timeval received;
+    gettimeofday(&received, nullptr);
+    
+    for (const RingPacket& packet : batch) {
+        struct pcap_pkthdr header = packet.header;
+        header.ts = received;
+        packetHandler(&header, packet.data, packet.interface_id, parser_);
+    }
+}
+
+void AdvancedMonitor::packetHandler(const struct pcap_pkthdr* header, const u_char* packet, uint32_t interface_id,
+                                    PacketParser& parser) {
+    // Radiotap is decoded outside the lock, with the calling worker's parser
+    const uint8_t* frame;
+    int length;
+    RadiotapInfo radiotap;
+    if (!parser.ieee80211Frame(packet, header->caplen, link_type_, frame, length, &radiotap, interface_id)) return;
+    if (radiotap.bad_fcs || length < 2) return;
+    if (radiotap.has_signal && radiotap.signal_dbm < signal_threshold_) return;
+    
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    stats_.total_packets++;
+    
+    int channel = PacketParser::frequencyToChannel(radiotap.frequency);
+    ChannelStats& channel_stats = channel_stats_[channel > 0 ? channel : current_channel_.load()];
+    channel_stats.channel = channel > 0 ? channel : current_channel_.load();
+    channel_stats.total_packets++;
+    switch ((frame[0] >> 2) & 0x3) {
+        case 0: channel_stats.mgmt_packets++; break;
+        case 1: channel_stats.ctrl_packets++; break;
+        case 2: channel_stats.data_packets++; break;
+    }
+    
+    FrameClass frame_class = dispatcher_.dispatch(frame, length, radiotap);
+    if (frame_class == FrameClass::BEACON) {
+        channel_stats.beacon_packets++;
+    }
+    
+    if (frame_class == FrameClass::EAPOL || frame_class == FrameClass::SAE) {
+        handshake_latency_.record(nanosecondsSince(header->ts));
+    } else if (latencySampleDue()) {
+        frame_latency_.record(nanosecondsSince(header->ts));
+    }
+}
+
+CaptureCounters AdvancedMonitor::getCaptureCounters() {
+    if (ring_.isOpen()) {
+        return ring_.getCounters();
+    }
+    if (!replay_options_.path.empty()) {
+        return replay_.getCounters();   // still there once the replay is closed
+    }
+    
+    CaptureCounters counters;
+    struct pcap_stat stats;
+    if (pcap_handle_ && pcap_stats(pcap_handle_, &stats) == 0) {
+        counters.received = stats.ps_recv;
+        counters.dropped = stats.ps_drop;
+        counters.interface_dropped = stats.ps_ifdrop;
+    }
+    return counters;
+}
+
+std::vector<size_t> AdvancedMonitor::getRingBacklog() const {
+    return ring_.getBacklog();
+}
+
+void AdvancedMonitor::registerFrameHandlers() {
+    auto bind = [this](void (AdvancedMonitor::*analyze)(const u_char*, int, const RadiotapInfo&)) {
+        return [this, analyze](const uint8_t* frame, int length, const RadiotapInfo& radiotap) {
+            (this->*analyze)(frame, length, radiotap);
+        };
+    };
+    
+    dispatcher_.on(FrameClass::BEACON, bind(&AdvancedMonitor::analyzeBeacon));
+    dispatcher_.on(FrameClass::PROBE_REQUEST, bind(&AdvancedMonitor::analyzeProbeRequest));
+    dispatcher_.on(FrameClass::PROBE_RESPONSE, bind(&AdvancedMonitor::analyzeProbeResponse));
+    dispatcher_.on(FrameClass::AUTHENTICATION, bind(&AdvancedMonitor::analyzeAuthFrame));
+    dispatcher_.on(FrameClass::SAE, bind(&AdvancedMonitor::analyzeAuthFrame));
+    dispatcher_.on(FrameClass::ASSOC_REQUEST, bind(&AdvancedMonitor::analyzeAssocFrame));
+    dispatcher_.on(FrameClass::ASSOC_RESPONSE, bind(&AdvancedMonitor::analyzeAssocFrame));
+    dispatcher_.on(FrameClass::REASSOC_REQUEST, bind(&AdvancedMonitor::analyzeAssocFrame));
+    dispatcher_.on(FrameClass::REASSOC_RESPONSE, bind(&AdvancedMonitor::analyzeAssocFrame));
+    dispatcher_.on(FrameClass::DATA, bind(&AdvancedMonitor::analyzeDataFrame));
+    dispatcher_.on(FrameClass::DEAUTHENTICATION, bind(&AdvancedMonitor::analyzeDeauthFrame));
+    dispatcher_.on(FrameClass::DISASSOCIATION, bind(&AdvancedMonitor::analyzeDeauthFrame));
+    dispatcher_.on(FrameClass::EAPOL, bind(&AdvancedMonitor::analyzeEAPOLFrame));
+}
+
+// The analyze* handlers run from packetHandler() with data_mutex_ held
+
+void AdvancedMonitor::analyzeBeacon(const u_char* packet, int length, const RadiotapInfo& radiotap) {
+    stats_.beacon_frames++;
+    
+    BeaconView beacon;
+    if (!parser_.parseBeaconFrame(packet, length, beacon)) return;
+    
+    bool changed;
+    const WifiNetwork& network = beacon_cache_.update(beacon, radiotap, changed);
+    auto it = access_points_.find(network.bssid.toString());
+    
+    // Same elements as last time: nothing to decode again
+    if (!changed && it != access_points_.end()) {
+        AccessPointInfo& ap = it->second;
+        if (radiotap.has_signal) ap.signal_strength = radiotap.signal_dbm;
+        ap.last_seen = network.last_seen;
+        ap.beacon_count++;
+        return;
+    }
+    
+    updateAccessPoint(network, radiotap, true);
+    
+    it = access_points_.find(network.bssid.toString());
+    if (it != access_points_.end()) {
+        it->second.beacon_interval = beacon.beacon_interval;
+    }
+}
+
+void AdvancedMonitor::analyzeProbeRequest(const u_char* packet, int length, const RadiotapInfo& radiotap) {
+    stats_.probe_requests++;
+    
+    const IEEE80211Header* header = reinterpret_cast<const IEEE80211Header*>(packet);
+    ClientInfo& client = touchClient(header->addr2, radiotap);
+    
+    // Probe requests carry no fixed fields before their IEs
+    int header_length = sizeof(IEEE80211Header);
+    std::string ssid = parser_.extractSSID(packet + header_length, length - header_length);
+    if (!ssid.empty() && std::find(client.probed_ssids.begin(), client.probed_ssids.end(), ssid) == client.probed_ssids.end()) {
+        client.probed_ssids.push_back(ssid);
+    }
+}
+
+void AdvancedMonitor::analyzeProbeResponse(const u_char* packet, int length, const RadiotapInfo& radiotap) {
+    stats_.probe_responses++;
+    
+    // Same fixed fields and IEs as a beacon
+    WifiNetwork network;
+    if (parser_.parseBeaconFrame(packet, length, network)) {
+        updateAccessPoint(network, radiotap, false);
+    }
+}
+
+void AdvancedMonitor::analyzeAuthFrame(const u_char*, int, const RadiotapInfo&) {
+    stats_.auth_frames++;
+}
+
+void AdvancedMonitor::analyzeAssocFrame(const u_char* packet, int length, const RadiotapInfo& radiotap) {
+    stats_.assoc_frames++;
+    
+    const IEEE80211Header* header = reinterpret_cast<const IEEE80211Header*>(packet);
+    bool is_request = ((packet[0] >> 4) & 0x1) == 0;   // subtypes 0/2 request, 1/3 response
+    
+    MacAddress station = is_request ? header->addr2 : header->addr1;
+    MacAddress bssid = header->addr3;
+    
+    if (!is_request) {
+        // Capabilities(2), status code(2): only successful responses associate
+        int body = sizeof(IEEE80211Header);
+        if (length < body + 4 || (packet[body + 2] | (packet[body + 3] << 8)) != 0) return;
+    }
+    
+    ClientInfo& client = touchClient(station, radiotap);
+    client.is_associated = true;
+    client.associated_bssid = bssid;
+    
+    auto it = access_points_.find(bssid.toString());
+    if (it != access_points_.end()) {
+        auto& clients = it->second.clients;
+        if (std::find(clients.begin(), clients.end(), station) == clients.end()) {
+            clients.push_back(station);
+        }
+    }
+}
+
+void AdvancedMonitor::analyzeDataFrame(const u_char* packet, int length, const RadiotapInfo& radiotap) {
+    stats_.data_frames++;
+    
+    const IEEE80211Header* header = reinterpret_cast<const IEEE80211Header*>(packet);
+    bool to_ds = parser_.isToDS(packet);
+    bool from_ds = parser_.isFromDS(packet);
+    if (to_ds == from_ds) return;   // ad-hoc and WDS traffic has no single AP
+    
+    MacAddress bssid = to_ds ? header->addr1 : header->addr2;
+    MacAddress station = to_ds ? header->addr2 : header->addr1;
+    
+    auto it = access_points_.find(bssid.toString());
+    if (it != access_points_.end()) {
+        it->second.data_packets++;
+    }
+    
+    if (station.bytes[0] & 0x01) return;   // group addressed
+    
+    // Only the station's own transmissions say anything about its signal
+    RadiotapInfo station_radiotap = radiotap;
+    station_radiotap.has_signal = radiotap.has_signal && to_ds;
+    
+    ClientInfo& client = touchClient(station, station_radiotap);
+    client.packets_count++;
+    client.data_bytes += length;
+    client.is_associated = true;
+    client.associated_bssid = bssid;
+    
+    if (it != access_points_.end()) {
+        auto& clients = it->second.clients;
+        if (std::find(clients.begin(), clients.end(), station) == clients.end()) {
+            clients.push_back(station);
+        }
+    }
+}
+
+void AdvancedMonitor::analyzeDeauthFrame(const u_char* packet, int, const RadiotapInfo&) {
+    bool disassociation = (packet[0] & 0xfc) == 0xa0;
+    if (disassociation) {
+        stats_.disassoc_frames++;
+    } else {
+        stats_.deauth_frames++;
+    }
+    
+    // Whichever end is not the BSSID is the station leaving
+    const IEEE80211Header* header = reinterpret_cast<const IEEE80211Header*>(packet);
+    MacAddress station = header->addr2 == header->addr3 ? header->addr1 : header->addr2;
+    
+    auto it = clients_.find(station.toString());
+    if (it != clients_.end()) {
+        it->second.is_associated = false;
+    }
+}
+
+void AdvancedMonitor::analyzeEAPOLFrame(const u_char* packet, int length, const RadiotapInfo&) {
+    stats_.data_frames++;
+    
+    EapolKeyView eapol;
+    if (!parser_.parseEAPOLFrame(packet, length, eapol)) return;
+    if (eapol.message_number < 1 || eapol.message_number > 4) return;
+    
+    HandshakeInfo* handshake = nullptr;
+    for (auto& existing : handshakes_) {
+        if (existing.ap_bssid == eapol.ap_mac && existing.client_mac == eapol.client_mac && !existing.is_complete) {
+            handshake = &existing;
+            break;
+        }
+    }
+    if (!handshake) {
+        handshakes_.emplace_back();
+        handshake = &handshakes_.back();
+        handshake->ap_bssid = eapol.ap_mac;
+        handshake->client_mac = eapol.client_mac;
+        handshake->is_complete = false;
+        handshake->message_flags = 0;
+        handshake->anonce_message = 0;
+        handshake->anonce_replay_counter = 0;
+        handshake->replay_counter = 0;
+        
+        auto ap = access_points_.find(eapol.ap_mac.toString());
+        if (ap != access_points_.end()) {
+            handshake->ssid = ap->second.ssid;
+        }
+    }
+    
+    // The latest ANonce and M2 are kept: retries carry a higher replay counter
+    handshake->message_flags |= 1 << (eapol.message_number - 1);
+    handshake->captured_time = std::chrono::steady_clock::now();
+    if (eapol.message_number == 1 || eapol.message_number == 3) {
+        handshake->anonce = eapol.nonce.toVector();
+        handshake->anonce_message = eapol.message_number;
+        handshake->anonce_replay_counter = eapol.replay_counter;
+    } else if (eapol.message_number == 2) {
+        handshake->snonce = eapol.nonce.toVector();
+        handshake->mic = eapol.mic.toVector();
+        handshake->replay_counter = eapol.replay_counter;
+    }
+    
+    // Crackable once the M2 answers the ANonce held: an M1 with the same
+    // replay counter, or an M3 one above it
+    bool paired = handshake->anonce_message == 1 ? handshake->anonce_replay_counter == handshake->replay_counter
+                                                 : handshake->anonce_replay_counter == handshake->replay_counter + 1;
+    if ((handshake->message_flags & 0x2) && handshake->anonce_message != 0 && paired) {
+        handshake->is_complete = true;
+        stats_.handshakes_captured++;
+        Logger::getInstance().info("Handshake captured: " + eapol.ap_mac.toString() + " <-> " + eapol.client_mac.toString());
+    }
+}
+
+void AdvancedMonitor::updateAccessPoint(const WifiNetwork& network, const RadiotapInfo& radiotap, bool from_beacon) {
+    if (!target_ssid_.empty() && network.essid != target_ssid_) return;
+    if (!(target_bssid_ == MacAddress()) && !(network.bssid == target_bssid_)) return;
+    
+    auto now = std::chrono::steady_clock::now();
+    auto inserted = access_points_.emplace(network.bssid.toString(), AccessPointInfo());
+    AccessPointInfo& ap = inserted.first->second;
+    if (inserted.second) {
+        ap.bssid = network.bssid;
+        ap.first_seen = now;
+        ap.vendor = getVendorFromMAC(network.bssid);
+        stats_.unique_aps++;
+    }
+    
+    if (network.essid != "<hidden>" || ap.ssid.empty()) {
+        ap.ssid = network.essid == "<hidden>" ? "" : network.essid;
+    }
+    ap.channel = network.channel > 0 ? network.channel : PacketParser::frequencyToChannel(radiotap.frequency);
+    ap.encryption = network.encryption;
+    if (radiotap.has_signal) ap.signal_strength = radiotap.signal_dbm;
+    ap.last_seen = now;
+    if (from_beacon) ap.beacon_count++;
+}
+
+ClientInfo& AdvancedMonitor::touchClient(const MacAddress& mac, const RadiotapInfo& radiotap) {
+    auto inserted = clients_.emplace(mac.toString(), ClientInfo());
+    ClientInfo& client = inserted.first->second;
+    if (inserted.second) {
+        client.mac = mac;
+        client.vendor = getVendorFromMAC(mac);
+        stats_.unique_clients++;
+    }
+    
+    if (radiotap.has_signal) client.signal_strength = radiotap.signal_dbm;
+    client.last_seen = std::chrono::steady_clock::now();
+    return client;
+}
+
+std::string AdvancedMonitor::getVendorFromMAC(const MacAddress& mac) {
+    std::string oui = mac.toString().substr(0, 8);
+    std::transform(oui.begin(), oui.end(), oui.begin(), ::toupper);
+    
+    auto it = oui_database_.find(oui);
+    return it != oui_database_.end() ? it->second : "Unknown";
+}
+
 void AdvancedMonitor::channelHoppingThread() {
     size_t channel_index = 0;
     
@@ -114,6 +517,28 @@ void AdvancedMonitor::channelHoppingThread() {
     }
 }
 
+// Half-exchanges idle this long are dropped, so the next attempt between
+// the same pair starts from a clean entry
+void AdvancedMonitor::cleanupThread() {
+    const auto handshake_timeout = std::chrono::seconds(60);
+    auto next_sweep = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_sweep) continue;
+        next_sweep = now + std::chrono::seconds(5);
+        
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        handshakes_.erase(std::remove_if(handshakes_.begin(), handshakes_.end(),
+                                         [&](const HandshakeInfo& handshake) {
+                                             return !handshake.is_complete &&
+                                                    now - handshake.captured_time > handshake_timeout;
+                                         }),
+                          handshakes_.end());
+    }
+}
+
 void AdvancedMonitor::displayNetworksTable() {
     clearScreen();
     printHeader("WiFi Networks");
@@ -138,6 +563,220 @@ void AdvancedMonitor::displayNetworksTable() {
     }
 }
 
+void AdvancedMonitor::displayClientsTable() {
+    clearScreen();
+    printHeader("WiFi Clients");
+    
+    std::vector<std::string> headers = {"Station", "BSSID", "PWR", "Packets", "Vendor", "Seen", "Probes"};
+    std::vector<int> widths = {18, 18, 4, 8, 10, 8, 30};
+    
+    printTableHeader(headers, widths);
+    
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    for (const auto& [key, client] : clients_) {
+        std::string probes;
+        for (const auto& ssid : client.probed_ssids) {
+            probes += (probes.empty() ? "" : ",") + ssid;
+        }
+        std::vector<std::string> row = {
+            client.mac.toString(),
+            client.is_associated ? client.associated_bssid.toString() : "(not associated)",
+            std::to_string(client.signal_strength),
+            std::to_string(client.packets_count),
+            client.vendor,
+            formatDuration(client.last_seen),
+            probes
+        };
+        printTableRow(row, widths);
+    }
+}
+
+void AdvancedMonitor::displayChannelStats() {
+    clearScreen();
+    printHeader("Channel Statistics");
+    
+    std::vector<std::string> headers = {"CH", "Total", "Beacons", "Data", "Mgmt", "Ctrl"};
+    std::vector<int> widths = {3, 10, 10, 10, 10, 10};
+    
+    printTableHeader(headers, widths);
+    
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    for (const auto& [channel, stats] : channel_stats_) {
+        std::vector<std::string> row = {
+            std::to_string(channel),
+            std::to_string(stats.total_packets),
+            std::to_string(stats.beacon_packets),
+            std::to_string(stats.data_packets),
+            std::to_string(stats.mgmt_packets),
+            std::to_string(stats.ctrl_packets)
+        };
+        printTableRow(row, widths);
+    }
+}
+
+void AdvancedMonitor::displayHandshakes() {
+    clearScreen();
+    printHeader("Captured Handshakes");
+    
+    std::vector<std::string> headers = {"BSSID", "Station", "SSID", "Messages", "Status", "Seen"};
+    std::vector<int> widths = {18, 18, 20, 9, 10, 8};
+    
+    printTableHeader(headers, widths);
+    
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    for (const auto& handshake : handshakes_) {
+        std::string messages;
+        for (int m = 0; m < 4; ++m) {
+            if (handshake.message_flags & (1 << m)) messages += "M" + std::to_string(m + 1);
+        }
+        std::vector<std::string> row = {
+            handshake.ap_bssid.toString(),
+            handshake.client_mac.toString(),
+            handshake.ssid.empty() ? "<unknown>" : handshake.ssid,
+            messages,
+            handshake.is_complete ? "complete" : "partial",
+            formatDuration(handshake.captured_time)
+        };
+        printTableRow(row, widths);
+    }
+}
+
+void AdvancedMonitor::displayRealTimeStats() {
+    MonitorStats stats;
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        stats = stats_;
+    }
+    CaptureCounters counters = getCaptureCounters();
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - stats.start_time);
+    
+    std::cout << "\n=== Real-time Statistics (" << elapsed.count() << "s) ===\n";
+    std::cout << "Packets: " << stats.total_packets << "  Beacons: " << stats.beacon_frames
+              << "  Data: " << stats.data_frames << "  Handshakes: " << stats.handshakes_captured << "\n";
+    std::cout << "APs: " << stats.unique_aps << "  Clients: " << stats.unique_clients << "\n";
+    std::cout << "Kernel: " << counters.received << " received, " << counters.dropped << " dropped, "
+              << counters.interface_dropped << " dropped by interface\n";
+    
+    if (ring_.isOpen()) {
+        std::vector<size_t> backlog = getRingBacklog();
+        std::cout << "Ring backlog (blocks per worker):";
+        for (size_t blocks : backlog) {
+            std::cout << " " << blocks;
+        }
+        std::cout << "\n";
+    }
+    
+    std::cout << "Frame latency: " << frame_latency_.summary() << "\n";
+    std::cout << "Handshake latency: " << handshake_latency_.summary() << "\n";
+}
+
+bool AdvancedMonitor::exportToCSV(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        Logger::getInstance().error("Failed to open CSV file: " + filename);
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    file << "BSSID,SSID,Channel,Encryption,Signal,Beacons,Data,Clients,Vendor\n";
+    for (const auto& [key, ap] : access_points_) {
+        file << ap.bssid.toString() << ",\"" << ap.ssid << "\"," << static_cast<int>(ap.channel) << ","
+             << ap.encryption << "," << ap.signal_strength << "," << ap.beacon_count << "," << ap.data_packets << ","
+             << ap.clients.size() << "," << ap.vendor << "\n";
+    }
+    
+    file << "\nStation,BSSID,Signal,Packets,Bytes,Vendor,Probed SSIDs\n";
+    for (const auto& [key, client] : clients_) {
+        file << client.mac.toString() << "," << (client.is_associated ? client.associated_bssid.toString() : "")
+             << "," << client.signal_strength << "," << client.packets_count << "," << client.data_bytes << ","
+             << client.vendor << ",\"";
+        for (size_t i = 0; i < client.probed_ssids.size(); ++i) {
+            file << (i ? ";" : "") << client.probed_ssids[i];
+        }
+        file << "\"\n";
+    }
+    return file.good();
+}
+
+// One line per handshake: the pair, the nonces and MIC, and the replay
+// counters they were paired by
+bool AdvancedMonitor::exportHandshakes(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        Logger::getInstance().error("Failed to open handshake file: " + filename);
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    for (const auto& handshake : handshakes_) {
+        file << handshake.ap_bssid.toString() << " " << handshake.client_mac.toString() << " \""
+             << handshake.ssid << "\" " << (handshake.is_complete ? "complete" : "partial")
+             << " messages=" << static_cast<int>(handshake.message_flags)
+             << " anonce_message=" << static_cast<int>(handshake.anonce_message)
+             << " anonce_replay=" << handshake.anonce_replay_counter
+             << " replay=" << handshake.replay_counter
+             << " anonce=" << CryptoUtils::bytesToHex(handshake.anonce)
+             << " snonce=" << CryptoUtils::bytesToHex(handshake.snonce)
+             << " mic=" << CryptoUtils::bytesToHex(handshake.mic) << "\n";
+    }
+    return file.good();
+}
+
+bool AdvancedMonitor::saveSession(const std::string& filename) const {
+    MonitorStats stats;
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        stats = stats_;
+    }
+    
+    if (!exportToCSV(filename)) return false;
+    
+    std::ofstream file(filename, std::ios::app);
+    file << "\nTotal Packets,Beacons,Probe Requests,Probe Responses,Auth,Assoc,Data,Deauth,Disassoc,Handshakes\n";
+    file << stats.total_packets << "," << stats.beacon_frames << "," << stats.probe_requests << ","
+         << stats.probe_responses << "," << stats.auth_frames << "," << stats.assoc_frames << ","
+         << stats.data_frames << "," << stats.deauth_frames << "," << stats.disassoc_frames << ","
+         << stats.handshakes_captured << "\n";
+    return file.good();
+}
+
+void AdvancedMonitor::clearScreen() {
+#ifdef _WIN32
+    std::system("cls");
+#else
+    std::system("clear");
+#endif
+}
+
+void AdvancedMonitor::printHeader(const std::string& title) {
+    std::cout << "==================================================\n";
+    std::cout << "          AirLevi-NG - " << title << "\n";
+    std::cout << "==================================================\n\n";
+}
+
+void AdvancedMonitor::printTableHeader(const std::vector<std::string>& headers, const std::vector<int>& widths) {
+    printTableRow(headers, widths);
+    
+    int total = 0;
+    for (int width : widths) total += width + 1;
+    std::cout << std::string(total, '-') << "\n";
+}
+
+void AdvancedMonitor::printTableRow(const std::vector<std::string>& data, const std::vector<int>& widths) {
+    for (size_t i = 0; i < data.size() && i < widths.size(); ++i) {
+        std::string cell = data[i].size() > static_cast<size_t>(widths[i]) ? data[i].substr(0, widths[i]) : data[i];
+        std::cout << std::left << std::setw(widths[i]) << cell << " ";
+    }
+    std::cout << "\n";
+}
+
+std::string AdvancedMonitor::formatDuration(const std::chrono::steady_clock::time_point& start) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count();
+    if (seconds < 60) return std::to_string(seconds) + "s";
+    if (seconds < 3600) return std::to_string(seconds / 60) + "m";
+    return std::to_string(seconds / 3600) + "h";
+}
+
 void AdvancedMonitor::loadOUIDatabase() {
     // Basic OUI mappings - in real implementation, load from file
     oui_database_["00:50:F2"] = "Microsoft";
@@ -1,9 +1,14 @@
 #include "airlevi-monitor/advanced_monitor.h"
 #include "common/logger.h"
+#include "common/progress_stream.h"
 #include <iostream>
 #include <getopt.h>
 #include <signal.h>
 #include <cstdio>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 
 using namespace airlevi;
 
@@ -28,11 +33,24 @@ void signalHandler(int signal) {
     }
 }
 
+static void emitStatistics(AdvancedMonitor& monitor) {
+    auto stats = monitor.getStats();
+    ProgressEvent event("stats");
+    event.add("packets", stats.total_packets)
+         .add("aps", stats.unique_aps)
+         .add("clients", stats.unique_clients)
+         .add("handshakes", stats.handshakes_captured);
+    addCaptureFields(event, monitor.getCaptureCounters(), monitor.getRingBacklog(),
+                     monitor.getFrameLatency(), monitor.getHandshakeLatency());
+    ProgressStream::getInstance().emit(event, true);
+}
+
 void printUsage(const char* program) {
     std::cout << "AirLevi-NG Advanced Monitor v1.0\n\n";
     std::cout << "Usage: " << program << " [options]\n\n";
-    std::cout << "Required:\n";
-    std::cout << "  -i, --interface <iface>    Monitor mode interface\n\n";
+    std::cout << "Required (one of):\n";
+    std::cout << "  -i, --interface <iface>    Monitor mode interface\n";
+    std::cout << "  -r, --read <file>          Analyze a pcap/pcapng capture to its end, then exit\n\n";
     std::cout << "Options:\n";
     std::cout << "  -c, --channel <num>        Fixed channel (disables hopping)\n";
     std::cout << "  -H, --hop                  Enable channel hopping (default)\n";
@@ -43,6 +61,15 @@ void printUsage(const char* program) {
     std::cout << "  -w, --write <file>         Save session to file\n";
     std::cout << "  --csv <file>               Export to CSV\n";
     std::cout << "  --handshakes <file>        Save handshakes\n";
+    std::cout << "  --ring                     Capture through an AF_PACKET TPACKET_V3 ring\n";
+    std::cout << "  --ring-size <mb>           Ring size per worker (default: 64)\n";
+    std::cout << "  --block-timeout <ms>       Partly filled block timeout (default: 64)\n";
+    std::cout << "  --fanout <n>               Parse on n ring workers (default: 1)\n";
+    std::cout << "  --fanout-mode <mode>       pair, hash or lb (default: pair)\n";
+    std::cout << "  --progress-stream <dest>   NDJSON capture statistics to a file or fd:N\n";
+    std::cout << "  --progress-interval <ms>   Minimum time between statistics events (default: 1000)\n";
+    std::cout << "  --speed <x>                Replay at x times the recorded pace (default: 0,\n";
+    std::cout << "                             as fast as frames are analyzed)\n";
     std::cout << "  -v, --verbose              Enable verbose output\n";
     std::cout << "  -h, --help                 Show this help\n\n";
     std::cout << "Interactive Commands:\n";
@@ -61,9 +88,14 @@ int main(int argc, char* argv[]) {
     std::string interface, bssid, essid, output_file, csv_file, handshake_file;
     int channel = 0, dwell_time = 250, signal_threshold = -100;
     bool verbose = false, channel_hopping = true;
+    RingOptions ring;
+    ReplayOptions replay;
+    std::string progress_stream;
+    int progress_interval = 1000;
     
     static struct option long_options[] = {
         {"interface", required_argument, 0, 'i'},
+        {"read", required_argument, 0, 'r'},
         {"channel", required_argument, 0, 'c'},
         {"hop", no_argument, 0, 'H'},
         {"time", required_argument, 0, 't'},
@@ -73,17 +105,28 @@ int main(int argc, char* argv[]) {
         {"write", required_argument, 0, 'w'},
         {"csv", required_argument, 0, 1001},
         {"handshakes", required_argument, 0, 1002},
+        {"ring", no_argument, 0, 1003},
+        {"ring-size", required_argument, 0, 1004},
+        {"block-timeout", required_argument, 0, 1005},
+        {"fanout", required_argument, 0, 1006},
+        {"fanout-mode", required_argument, 0, 1007},
+        {"progress-stream", required_argument, 0, 1008},
+        {"progress-interval", required_argument, 0, 1009},
+        {"speed", required_argument, 0, 1010},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "i:c:Ht:b:e:s:w:vh", long_options, nullptr)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:r:c:Ht:b:e:s:w:vh", long_options, nullptr)) != -1) {
         switch (opt) {
             case 'i':
                 interface = optarg;
                 break;
+            case 'r':
+                replay.path = optarg;
+                break;
             case 'c':
                 channel = std::stoi(optarg);
                 channel_hopping = false;
@@ -112,6 +155,33 @@ int main(int argc, char* argv[]) {
             case 1002:
                 handshake_file = optarg;
                 break;
+            case 1003:
+                ring.enabled = true;
+                break;
+            case 1004:
+                ring.ring_size_mb = std::max(1, std::stoi(optarg));
+                break;
+            case 1005:
+                ring.block_timeout_ms = std::max(1, std::stoi(optarg));
+                break;
+            case 1006:
+                ring.workers = std::max(1, std::stoi(optarg));
+                break;
+            case 1007:
+                if (!RingCapture::parseFanoutMode(optarg, ring.fanout)) {
+                    std::cerr << "Unknown fanout mode: " << optarg << "\n";
+                    return 1;
+                }
+                break;
+            case 1008:
+                progress_stream = optarg;
+                break;
+            case 1009:
+                progress_interval = std::stoi(optarg);
+                break;
+            case 1010:
+                replay.speed = std::max(0.0, std::stod(optarg));
+                break;
             case 'v':
                 verbose = true;
                 break;
@@ -124,28 +194,41 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    if (interface.empty()) {
-        std::cerr << "Error: Interface is required\n";
+    if (interface.empty() && replay.path.empty()) {
+        std::cerr << "Error: Interface or capture file is required\n";
         printUsage(argv[0]);
         return 1;
     }
     
     Logger::getInstance().setVerbose(verbose);
     
+    ProgressStream& stream = ProgressStream::getInstance();
+    if (!progress_stream.empty()) {
+        if (!stream.open(progress_stream, "airlevi-monitor")) {
+            return 1;
+        }
+        stream.setInterval(std::chrono::milliseconds(progress_interval > 0 ? progress_interval : 1000));
+    }
+    
     try {
         AdvancedMonitor monitor;
         monitor_instance = &monitor;
+        monitor.setCaptureRing(ring);
+        monitor.setReplay(replay);
         
         if (!monitor.initialize(interface)) {
-            std::cerr << "Failed to initialize interface: " << interface << std::endl;
+            std::cerr << "Failed to initialize " << (replay.path.empty() ? "interface: " + interface
+                                                                          : "capture: " + replay.path) << std::endl;
             return 1;
         }
         
-        // Configure monitoring
-        if (channel > 0) {
-            monitor.setFixedChannel(channel);
-        } else {
-            monitor.setChannelHopping(true, dwell_time);
+        // Configure monitoring; a file has no channel to tune
+        if (replay.path.empty()) {
+            if (channel > 0) {
+                monitor.setFixedChannel(channel);
+            } else {
+                monitor.setChannelHopping(true, dwell_time);
+            }
         }
         
         if (!bssid.empty()) {
@@ -161,10 +244,13 @@ int main(int argc, char* argv[]) {
         monitor.setSignalThreshold(signal_threshold);
         
         std::cout << "\n=== AirLevi-NG Advanced Monitor ===\n";
-        std::cout << "Interface: " << interface << "\n";
-        if (channel > 0) {
+        if (!replay.path.empty()) {
+            std::cout << "Capture: " << replay.path << "\n";
+        } else if (channel > 0) {
+            std::cout << "Interface: " << interface << "\n";
             std::cout << "Fixed Channel: " << channel << "\n";
         } else {
+            std::cout << "Interface: " << interface << "\n";
             std::cout << "Channel Hopping: Enabled (" << dwell_time << "ms dwell)\n";
         }
         if (!bssid.empty()) std::cout << "Target BSSID: " << bssid << "\n";
@@ -177,11 +263,30 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
-        // Interactive mode
-        std::cout << "Monitoring started. Press 'h' for help, 'q' to quit.\n";
+        std::thread stats_thread;
+        if (stream.isEnabled()) {
+            stats_thread = std::thread([&]() {
+                while (running) {
+                    if (stream.progressDue()) {
+                        emitStatistics(monitor);
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            });
+        }
+        
+        // A replay runs to the end of the file and reports like a finished session
+        if (!replay.path.empty()) {
+            std::cout << "Replay started. Press Ctrl+C to stop early.\n";
+            while (running && !monitor.isReplayFinished()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        } else {
+            std::cout << "Monitoring started. Press 'h' for help, 'q' to quit.\n";
+        }
         
         char cmd;
-        while (running && std::cin >> cmd) {
+        while (running && replay.path.empty() && std::cin >> cmd) {
             switch (cmd) {
                 case 'n':
                     monitor.displayNetworksTable();
@@ -207,7 +312,14 @@ int main(int argc, char* argv[]) {
             }
         }
         
+        running = false;
+        if (stats_thread.joinable()) {
+            stats_thread.join();
+        }
         monitor.stopMonitoring();
+        if (stream.isEnabled()) {
+            emitStatistics(monitor);
+        }
         
         // Export data if requested
         if (!csv_file.empty()) {
@@ -232,6 +344,18 @@ int main(int argc, char* argv[]) {
         std::cout << "Unique APs: " << stats.unique_aps << "\n";
         std::cout << "Unique Clients: " << stats.unique_clients << "\n";
         std::cout << "Handshakes: " << stats.handshakes_captured << "\n";
+        CaptureCounters counters = monitor.getCaptureCounters();
+        if (!replay.path.empty()) {
+            double seconds = monitor.getReplaySeconds();
+            std::cout << "Frames Replayed: " << counters.received << " in " << std::fixed << std::setprecision(2)
+                      << seconds << "s (" << std::setprecision(0)
+                      << (seconds > 0 ? counters.received / seconds : 0) << " frames/s)\n";
+        } else {
+            std::cout << "Kernel Received/Dropped: " << counters.received << "/" << counters.dropped
+                      << " (interface dropped " << counters.interface_dropped << ")\n";
+        }
+        std::cout << "Frame Latency: " << monitor.getFrameLatency().summary() << "\n";
+        std::cout << "Handshake Latency: " << monitor.getHandshakeLatency().summary() << "\n";
         std::cout << "========================\n";
         
     } catch (const std::exception& e) {
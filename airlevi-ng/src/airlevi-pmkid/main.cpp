@@ -1,5 +1,8 @@
 #include "airlevi-pmkid/pmkid_attack.h"
+#include "common/progress_stream.h"
 #include <iostream>
+#include <sstream>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <thread>
@@ -8,6 +11,8 @@
 #include <unistd.h>
 #include <cstdio>
 
+using namespace airlevi;
+
 PMKIDAttack* g_attack = nullptr;
 
 static bool parseMacString(const std::string& mac_str, MacAddress& out) {
@@ -40,6 +45,7 @@ void printUsage(const std::string& program_name) {
     std::cout << "  -o <file>          Output file for results\n";
     std::cout << "  -f <format>        Export format (csv, hashcat)\n";
     std::cout << "  -t <timeout>       Attack timeout in seconds\n";
+    std::cout << "  -P <dest>          NDJSON progress and results to a file or fd:N\n";
     std::cout << "  -h                 Show this help\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << program_name << " -i wlan0mon\n";
@@ -194,10 +200,11 @@ int main(int argc, char* argv[]) {
     bool channel_hopping = true;
     int dwell_time = 250;
     int timeout = 0;
+    std::string progress_stream;
     
     // Parse command line arguments
     int opt;
-    while ((opt = getopt(argc, argv, "i:b:e:c:Cd:w:o:f:t:h")) != -1) {
+    while ((opt = getopt(argc, argv, "i:b:e:c:Cd:w:o:f:t:P:h")) != -1) {
         switch (opt) {
             case 'i':
                 interface = optarg;
@@ -230,6 +237,9 @@ int main(int argc, char* argv[]) {
             case 't':
                 timeout = std::atoi(optarg);
                 break;
+            case 'P':
+                progress_stream = optarg;
+                break;
             case 'h':
             default:
                 printUsage(argv[0]);
@@ -249,6 +259,11 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (!progress_stream.empty() && !ProgressStream::getInstance().open(progress_stream, "airlevi-pmkid")) {
+        std::cerr << "[-] Failed to open progress stream " << progress_stream << std::endl;
+        return 1;
+    }
+    
     // Setup signal handlers
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
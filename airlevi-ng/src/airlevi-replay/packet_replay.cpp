@@ -27,7 +27,7 @@ static bool isZeroMac(const MacAddress& mac) {
 }
 
 PacketReplay::PacketReplay() 
-    : pcap_handle_(nullptr), inject_handle_(nullptr), mode_(ReplayMode::SINGLE),
+    : inject_handle_(nullptr), mode_(ReplayMode::SINGLE),
       packet_delay_(1000), packet_count_(1), burst_size_(10), speed_multiplier_(1.0),
       modify_mac_(false), running_(false) {
     memset(&stats_, 0, sizeof(stats_));
@@ -35,7 +35,6 @@ PacketReplay::PacketReplay()
 
 PacketReplay::~PacketReplay() {
     stopReplay();
-    if (pcap_handle_) pcap_close(pcap_handle_);
     if (inject_handle_) pcap_close(inject_handle_);
 }
 
@@ -57,22 +56,16 @@ bool PacketReplay::initialize(const std::string& interface) {
 bool PacketReplay::loadCaptureFile(const std::string& filename) {
     capture_file_ = filename;
     
-    char errbuf[PCAP_ERRBUF_SIZE];
-    pcap_handle_ = pcap_open_offline(filename.c_str(), errbuf);
-    
-    if (!pcap_handle_) {
-        Logger::getInstance().error("Failed to open capture file: " + std::string(errbuf));
+    // Frames stay in the mapping; only their views are kept, and those of
+    // a previous capture go with its mapping
+    packets_.clear();
+    if (!capture_.open(filename)) {
         return false;
     }
     
-    // Load all packets into memory
-    packets_.clear();
-    struct pcap_pkthdr* header;
-    const u_char* packet;
-    
-    while (pcap_next_ex(pcap_handle_, &header, &packet) >= 0) {
-        std::vector<u_char> packet_data(packet, packet + header->caplen);
-        packets_.emplace_back(packet_data, header->caplen);
+    CaptureFrame frame;
+    while (capture_.next(frame)) {
+        packets_.push_back(frame);
     }
     
     Logger::getInstance().info("Loaded " + std::to_string(packets_.size()) + " packets from " + filename);
@@ -152,19 +145,10 @@ void PacketReplay::replayThread() {
     while (running_) {
         switch (mode_) {
             case ReplayMode::SINGLE:
-                for (const auto& [packet_data, length] : packets_) {
+                for (const auto& frame : packets_) {
                     if (!running_) break;
                     
-                    std::vector<u_char> modified_packet = packet_data;
-                    if (modify_mac_) {
-                        modifyPacket(modified_packet.data(), length);
-                    }
-                    
-                    if (injectPacket(modified_packet.data(), length)) {
-                        std::lock_guard<std::mutex> lock(stats_mutex_);
-                        stats_.packets_sent++;
-                        stats_.bytes_sent += length;
-                    }
+                    replayFrame(frame);
                     
                     usleep(packet_delay_ / speed_multiplier_);
                 }
@@ -172,19 +156,10 @@ void PacketReplay::replayThread() {
                 break;
                 
             case ReplayMode::CONTINUOUS:
-                for (const auto& [packet_data, length] : packets_) {
+                for (const auto& frame : packets_) {
                     if (!running_) break;
                     
-                    std::vector<u_char> modified_packet = packet_data;
-                    if (modify_mac_) {
-                        modifyPacket(modified_packet.data(), length);
-                    }
-                    
-                    if (injectPacket(modified_packet.data(), length)) {
-                        std::lock_guard<std::mutex> lock(stats_mutex_);
-                        stats_.packets_sent++;
-                        stats_.bytes_sent += length;
-                    }
+                    replayFrame(frame);
                     
                     usleep(packet_delay_ / speed_multiplier_);
                 }
@@ -192,19 +167,10 @@ void PacketReplay::replayThread() {
                 
             case ReplayMode::BURST:
                 for (int burst = 0; burst < burst_size_ && running_; burst++) {
-                    for (const auto& [packet_data, length] : packets_) {
+                    for (const auto& frame : packets_) {
                         if (!running_) break;
                         
-                        std::vector<u_char> modified_packet = packet_data;
-                        if (modify_mac_) {
-                            modifyPacket(modified_packet.data(), length);
-                        }
-                        
-                        if (injectPacket(modified_packet.data(), length)) {
-                            std::lock_guard<std::mutex> lock(stats_mutex_);
-                            stats_.packets_sent++;
-                            stats_.bytes_sent += length;
-                        }
+                        replayFrame(frame);
                     }
                     usleep(packet_delay_ / speed_multiplier_);
                 }
@@ -217,18 +183,10 @@ void PacketReplay::replayThread() {
                     break;
                 }
                 
-                for (const auto& [packet_data, length] : packets_) {
+                for (const auto& frame : packets_) {
                     if (!running_ || packets_sent >= packet_count_) break;
                     
-                    std::vector<u_char> modified_packet = packet_data;
-                    if (modify_mac_) {
-                        modifyPacket(modified_packet.data(), length);
-                    }
-                    
-                    if (injectPacket(modified_packet.data(), length)) {
-                        std::lock_guard<std::mutex> lock(stats_mutex_);
-                        stats_.packets_sent++;
-                        stats_.bytes_sent += length;
+                    if (replayFrame(frame)) {
                         packets_sent++;
                     }
                     
@@ -239,6 +197,25 @@ void PacketReplay::replayThread() {
     }
 }
 
+bool PacketReplay::replayFrame(const CaptureFrame& frame) {
+    bool sent;
+    if (modify_mac_) {
+        // The mapping is read-only, rewrite a copy
+        std::vector<u_char> modified_packet(frame.data, frame.data + frame.caplen);
+        modifyPacket(modified_packet.data(), frame.caplen);
+        sent = injectPacket(modified_packet.data(), frame.caplen);
+    } else {
+        sent = injectPacket(frame.data, frame.caplen);
+    }
+    
+    if (sent) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.packets_sent++;
+        stats_.bytes_sent += frame.caplen;
+    }
+    return sent;
+}
+
 bool PacketReplay::injectPacket(const u_char* packet, int length) {
     if (pcap_inject(inject_handle_, packet, length) == -1) {
         std::lock_guard<std::mutex> lock(stats_mutex_);
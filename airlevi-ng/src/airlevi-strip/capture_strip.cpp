@@ -0,0 +1,358 @@
+#include "airlevi-strip/capture_strip.h"
+#include "common/crypto_utils.h"
+#include "common/frame_index.h"
+#include "common/logger.h"
+#include "common/pcap_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace airlevi {
+
+namespace {
+
+// BSSID of a data frame from its DS bits; false between two access points
+bool dataBssid(const uint8_t* frame, MacAddress& bssid) {
+    switch (frame[1] & 0x03) {
+        case 0: bssid = MacAddress(frame + 16); return true;
+        case 1: bssid = MacAddress(frame + 4); return true;
+        case 2: bssid = MacAddress(frame + 10); return true;
+        default: return false;
+    }
+}
+
+std::string macHex(const MacAddress& mac) {
+    return CryptoUtils::bytesToHex(std::vector<uint8_t>(mac.bytes, mac.bytes + 6));
+}
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+CaptureStrip::CaptureStrip(const StripOptions& options)
+    : options_(options), filtered_(false), paired_(false) {
+    if (!options_.bssid.empty()) {
+        unsigned int b[6];
+        if (std::sscanf(options_.bssid.c_str(), "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) == 6) {
+            for (int i = 0; i < 6; ++i) target_.bytes[i] = static_cast<uint8_t>(b[i] & 0xFF);
+            filtered_ = true;
+        } else {
+            Logger::getInstance().warning("Ignoring invalid BSSID filter: " + options_.bssid);
+        }
+    }
+}
+
+CaptureStrip::~CaptureStrip() = default;
+
+bool CaptureStrip::wanted(const MacAddress& bssid) const {
+    return !filtered_ || bssid == target_;
+}
+
+bool CaptureStrip::addCapture(const std::string& path) {
+    auto reader = std::make_unique<CaptureReader>();
+    if (!reader->open(path)) {
+        return false;
+    }
+
+    uint8_t mask = postingMask(FramePosting::EAPOL) | postingMask(FramePosting::BEACON);
+    if (options_.keep_wep) mask |= postingMask(FramePosting::WEP_DATA);
+
+    std::vector<CaptureFrame> frames;
+    if (loadIndexedFrames(path, *reader, mask, options_.bssid, frames)) {
+        std::sort(frames.begin(), frames.end(), [](const CaptureFrame& a, const CaptureFrame& b) {
+            return a.timestamp_ns != b.timestamp_ns ? a.timestamp_ns < b.timestamp_ns : a.offset < b.offset;
+        });
+        Logger::getInstance().debug("Read " + std::to_string(frames.size()) + " frames through the sidecar index of " +
+                                    path);
+    } else {
+        // Workers only pick candidates by frame class; the few they return
+        // are parsed and paired here, in timestamp order
+        int threads = options_.threads > 0 ? options_.threads : static_cast<int>(std::thread::hardware_concurrency());
+        bool keep_wep = options_.keep_wep;
+        const FrameDispatcher& dispatcher = dispatcher_;
+        frames = reader->scanParallel(threads, [&dispatcher, keep_wep](const CaptureFrame& frame) {
+            thread_local std::vector<uint8_t> unpadded;
+            const uint8_t* packet;
+            uint32_t length;
+            if (!CaptureReader::ieee80211Frame(frame, packet, length, unpadded)) return false;
+            FrameClass frame_class = dispatcher.classify(packet, static_cast<int>(length));
+            return frame_class == FrameClass::BEACON || frame_class == FrameClass::PROBE_RESPONSE ||
+                   frame_class == FrameClass::EAPOL ||
+                   (keep_wep && frame_class == FrameClass::DATA && (packet[1] & 0x40));
+        }, options_.range_bytes);
+    }
+
+    size_t capture = captures_.size();
+    for (const CaptureFrame& frame : frames) {
+        selectFrame(Frame{frame, capture});
+    }
+
+    stats_.captures++;
+    stats_.bytes_in += reader->getSize();
+    stats_.candidates += frames.size();
+    captures_.push_back(std::move(reader));
+    paths_.push_back(path);
+    paired_ = false;
+    return true;
+}
+
+void CaptureStrip::selectFrame(const Frame& frame) {
+    const uint8_t* packet;
+    uint32_t frame_length;
+    if (!CaptureReader::ieee80211Frame(frame.frame, packet, frame_length, unpadded_)) return;
+    int length = static_cast<int>(frame_length);
+
+    FrameClass frame_class = dispatcher_.classify(packet, length);
+
+    if (frame_class == FrameClass::BEACON || frame_class == FrameClass::PROBE_RESPONSE) {
+        BeaconView beacon;
+        if (!parser_.parseBeaconFrame(packet, length, beacon) || beacon.ssid.empty() || !wanted(beacon.bssid)) return;
+        if (beacons_.emplace(beacon.bssid, frame).second) {
+            essids_[beacon.bssid] = beacon.ssid.toString();
+        }
+    } else if (frame_class == FrameClass::EAPOL) {
+        EapolKeyView key;
+        if (!parser_.parseEAPOLFrame(packet, length, key) || key.message_number == 0 || !wanted(key.ap_mac)) return;
+
+        ByteView pmkid;
+        if (key.message_number == 1 && key.findPMKID(pmkid) &&
+            std::any_of(pmkid.data, pmkid.data + pmkid.size, [](uint8_t byte) { return byte != 0; })) {
+            pmkids_.push_back(Pmkid{frame, key.ap_mac, key.client_mac, pmkid.toVector()});
+        }
+        messages_[std::make_pair(key.ap_mac, key.client_mac)].push_back(
+            KeyMessage{frame, key.message_number, key.replay_counter});
+    } else if (options_.keep_wep && frame_class == FrameClass::DATA && (packet[1] & 0x40)) {
+        // One frame per IV is enough for the statistical attacks
+        MacAddress bssid;
+        if (!PacketParser::isWEPDataFrame(packet, length) || !dataBssid(packet, bssid) || !wanted(bssid)) {
+            return;
+        }
+        const uint8_t* iv = packet + PacketParser::ieee80211HeaderLength(packet);
+        uint32_t iv_value = (iv[0] << 16) | (iv[1] << 8) | iv[2];
+        if (wep_ivs_[bssid].insert(iv_value).second) {
+            wep_frames_.push_back(frame);
+        }
+    }
+}
+
+void CaptureStrip::pairHandshakes() {
+    if (paired_) return;
+    handshakes_.clear();
+
+    for (const auto& group : messages_) {
+        const std::vector<KeyMessage>& messages = group.second;
+        std::set<std::vector<uint8_t>> mics;
+
+        for (const KeyMessage& m2 : messages) {
+            if (m2.message_number != 2) continue;
+
+            // Best partner: an M1 of the same replay counter, then the M3
+            // answering it, then the ANonce message closest in time, which
+            // hashcat is told was not replay-checked
+            const KeyMessage* partner = nullptr;
+            uint8_t message_pair = 0;
+            uint64_t best_distance = UINT64_MAX;
+            for (const KeyMessage& other : messages) {
+                if (other.message_number == 1 && other.replay_counter == m2.replay_counter) {
+                    partner = &other;
+                    message_pair = 0x00;
+                    break;
+                }
+                if (other.message_number == 3 && other.replay_counter == m2.replay_counter + 1) {
+                    partner = &other;
+                    message_pair = 0x02;
+                    best_distance = 0;
+                } else if ((other.message_number == 1 || other.message_number == 3) && best_distance > 0) {
+                    uint64_t a = other.source.frame.timestamp_ns;
+                    uint64_t b = m2.source.frame.timestamp_ns;
+                    uint64_t distance = a > b ? a - b : b - a;
+                    if (distance < best_distance) {
+                        partner = &other;
+                        message_pair = (other.message_number == 1 ? 0x00 : 0x02) | 0x80;
+                        best_distance = distance;
+                    }
+                }
+            }
+            if (!partner) continue;
+
+            // Retransmissions of the same M2 pair up identically
+            const uint8_t* packet;
+            uint32_t length;
+            EapolKeyView key;
+            if (!CaptureReader::ieee80211Frame(m2.source.frame, packet, length, unpadded_) ||
+                !parser_.parseEAPOLFrame(packet, static_cast<int>(length), key) || key.mic.empty() ||
+                !mics.insert(key.mic.toVector()).second) {
+                continue;
+            }
+            handshakes_.push_back(Handshake{group.first.first, &m2, partner, message_pair});
+        }
+    }
+    paired_ = true;
+}
+
+std::vector<std::pair<const CaptureStrip::Frame*, IndexedFrameKind>> CaptureStrip::selection() {
+    pairHandshakes();
+
+    std::vector<std::pair<const Frame*, IndexedFrameKind>> frames;
+    std::set<MacAddress> named;
+    stats_.eapol = stats_.pmkids = stats_.wep = stats_.beacons = 0;
+    stats_.handshakes = handshakes_.size();
+
+    stats_.unnamed = 0;
+    for (const Handshake& handshake : handshakes_) {
+        frames.emplace_back(&handshake.eapol->source, IndexedFrameKind::EAPOL);
+        frames.emplace_back(&handshake.anonce->source, IndexedFrameKind::EAPOL);
+        named.insert(handshake.ap_mac);
+        if (!essids_.count(handshake.ap_mac)) stats_.unnamed++;
+    }
+    for (const Pmkid& pmkid : pmkids_) {
+        frames.emplace_back(&pmkid.source, IndexedFrameKind::PMKID);
+        named.insert(pmkid.ap_mac);
+        if (!essids_.count(pmkid.ap_mac)) stats_.unnamed++;
+    }
+    for (const Frame& frame : wep_frames_) {
+        frames.emplace_back(&frame, IndexedFrameKind::NONE);
+    }
+    for (const auto& ivs : wep_ivs_) {
+        named.insert(ivs.first);
+    }
+    for (const MacAddress& bssid : named) {
+        auto beacon = beacons_.find(bssid);
+        if (beacon != beacons_.end()) {
+            frames.emplace_back(&beacon->second, IndexedFrameKind::BEACON);
+        }
+    }
+
+    // Time order; a frame picked twice (a PMKID M1 that also pairs) is
+    // written once, as its most specific kind
+    std::sort(frames.begin(), frames.end(), [](const std::pair<const Frame*, IndexedFrameKind>& a,
+                                               const std::pair<const Frame*, IndexedFrameKind>& b) {
+        const Frame& x = *a.first;
+        const Frame& y = *b.first;
+        if (x.frame.timestamp_ns != y.frame.timestamp_ns) return x.frame.timestamp_ns < y.frame.timestamp_ns;
+        if (x.capture != y.capture) return x.capture < y.capture;
+        if (x.frame.offset != y.frame.offset) return x.frame.offset < y.frame.offset;
+        return a.second > b.second;
+    });
+    frames.erase(std::unique(frames.begin(), frames.end(), [](const std::pair<const Frame*, IndexedFrameKind>& a,
+                                                              const std::pair<const Frame*, IndexedFrameKind>& b) {
+        return a.first->capture == b.first->capture && a.first->frame.offset == b.first->frame.offset;
+    }), frames.end());
+
+    for (const auto& frame : frames) {
+        switch (frame.second) {
+            case IndexedFrameKind::EAPOL: stats_.eapol++; break;
+            case IndexedFrameKind::PMKID: stats_.pmkids++; break;
+            case IndexedFrameKind::BEACON: stats_.beacons++; break;
+            default: stats_.wep++; break;
+        }
+    }
+    return frames;
+}
+
+bool CaptureStrip::writePcapng(const std::string& path) {
+    std::vector<std::pair<const Frame*, IndexedFrameKind>> frames = selection();
+
+    // One interface per input capture and link type, named after the capture
+    std::vector<CaptureInterface> interfaces;
+    std::map<std::pair<size_t, uint32_t>, uint32_t> interface_ids;
+    for (const auto& frame : frames) {
+        auto key = std::make_pair(frame.first->capture, frame.first->frame.link_type);
+        if (interface_ids.count(key)) continue;
+
+        CaptureInterface interface;
+        interface.name = baseName(paths_[key.first]);
+        interface.description = "stripped from " + paths_[key.first];
+        interface.link_type = static_cast<int>(key.second);
+        interface_ids[key] = static_cast<uint32_t>(interfaces.size());
+        interfaces.push_back(interface);
+    }
+    if (interfaces.empty()) {
+        // Still a valid, empty capture
+        interfaces.push_back(CaptureInterface());
+    }
+
+    PcapWriterOptions options;
+    options.format = CaptureFormat::PCAPNG;
+    options.application = "AirLevi-NG airlevi-strip 1.0";
+    options.comment = "Crack-relevant frames of " + std::to_string(captures_.size()) + " capture(s)";
+    options.wait_when_full = true;
+
+    PcapWriter writer;
+    if (!writer.open(path, interfaces, options)) {
+        return false;
+    }
+    for (const auto& frame : frames) {
+        const CaptureFrame& source = frame.first->frame;
+        struct pcap_pkthdr header = {};
+        header.ts.tv_sec = static_cast<time_t>(source.timestamp_ns / 1000000000ULL);
+        header.ts.tv_usec = static_cast<suseconds_t>(source.timestamp_ns % 1000000000ULL / 1000);
+        header.caplen = source.caplen;
+        header.len = source.len;
+        writer.write(&header, source.data,
+                     interface_ids[std::make_pair(frame.first->capture, source.link_type)], frame.second);
+    }
+    writer.close();
+    return writer.getDropped() == 0;
+}
+
+bool CaptureStrip::writeHashes(const std::string& path) {
+    selection();
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        Logger::getInstance().error("Cannot create hash file: " + path);
+        return false;
+    }
+
+    std::set<std::string> written;
+
+    for (const Pmkid& pmkid : pmkids_) {
+        auto essid = essids_.find(pmkid.ap_mac);
+        if (essid == essids_.end()) continue;
+        std::string line = "WPA*01*" + CryptoUtils::bytesToHex(pmkid.pmkid) + "*" + macHex(pmkid.ap_mac) + "*" +
+                           macHex(pmkid.client_mac) + "*" +
+                           CryptoUtils::bytesToHex(std::vector<uint8_t>(essid->second.begin(), essid->second.end())) +
+                           "***";
+        if (written.insert(line).second) out << line << "\n";
+    }
+
+    // Both views are held at once, so each frame gets its own unpadded copy
+    std::vector<uint8_t> anonce_unpadded;
+    for (const Handshake& handshake : handshakes_) {
+        const uint8_t* packet;
+        uint32_t length;
+        EapolKeyView m2;
+        EapolKeyView anonce;
+        if (!CaptureReader::ieee80211Frame(handshake.eapol->source.frame, packet, length, unpadded_) ||
+            !parser_.parseEAPOLFrame(packet, static_cast<int>(length), m2) ||
+            !CaptureReader::ieee80211Frame(handshake.anonce->source.frame, packet, length, anonce_unpadded) ||
+            !parser_.parseEAPOLFrame(packet, static_cast<int>(length), anonce)) {
+            continue;
+        }
+
+        auto essid = essids_.find(m2.ap_mac);
+        if (essid == essids_.end() || m2.eapol.size < EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH) continue;
+
+        // hashcat takes the EAPOL frame with its MIC zeroed
+        std::vector<uint8_t> eapol = m2.eapol.toVector();
+        std::fill(eapol.begin() + EAPOL_MIC_OFFSET, eapol.begin() + EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH, 0);
+
+        char message_pair[3];
+        snprintf(message_pair, sizeof(message_pair), "%02x", handshake.message_pair);
+        std::string line = "WPA*02*" + CryptoUtils::bytesToHex(m2.mic.toVector()) + "*" + macHex(m2.ap_mac) + "*" +
+                           macHex(m2.client_mac) + "*" +
+                           CryptoUtils::bytesToHex(std::vector<uint8_t>(essid->second.begin(), essid->second.end())) +
+                           "*" + CryptoUtils::bytesToHex(anonce.nonce.toVector()) + "*" +
+                           CryptoUtils::bytesToHex(eapol) + "*" + message_pair;
+        if (written.insert(line).second) out << line << "\n";
+    }
+
+    return out.good();
+}
+
+} // namespace airlevi
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <iomanip>
+#include <getopt.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include "airlevi-strip/capture_strip.h"
+#include "common/logger.h"
+
+using namespace airlevi;
+
+void printUsage(const char* program_name) {
+    std::cout << "AirLevi-NG Capture Strip v1.0\n";
+    std::cout << "Usage: " << program_name << " -o OUTPUT [OPTIONS] CAPTURE...\n\n";
+    std::cout << "Keeps only what a crack needs: the beacon or probe response naming each BSS,\n";
+    std::cout << "EAPOL messages that pair into a handshake and M1s carrying a PMKID.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -o, --output FILE        Minimal pcapng, or hashcat 22000 lines for a\n";
+    std::cout << "                           .22000/.hc22000 file\n";
+    std::cout << "  -b, --bssid BSSID        Only this BSS\n";
+    std::cout << "  -j, --threads NUM        Scan workers per capture (default: CPU cores)\n";
+    std::cout << "  --range-size BYTES       Smallest part of a capture given to a worker\n";
+    std::cout << "                           (default: 16 MiB)\n";
+    std::cout << "  --wep                    Also keep one WEP data frame per IV (pcapng only)\n";
+    std::cout << "  -v, --verbose            Verbose output\n";
+    std::cout << "  -h, --help               Show this help\n";
+    std::cout << "\nExamples:\n";
+    std::cout << "  " << program_name << " -o field.pcapng day1.cap day2.cap\n";
+    std::cout << "  " << program_name << " -o field.22000 -b 00:11:22:33:44:55 capture.pcapng\n";
+}
+
+static bool hasExtension(const std::string& path, const std::string& extension) {
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    StripOptions options;
+    std::string output;
+    bool verbose = false;
+
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"bssid", required_argument, 0, 'b'},
+        {"threads", required_argument, 0, 'j'},
+        {"verbose", no_argument, 0, 'v'},
+        {"help", no_argument, 0, 'h'},
+        {"wep", no_argument, 0, 1000},
+        {"range-size", required_argument, 0, 1001},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "o:b:j:vh", long_options, nullptr)) != -1) {
+        switch (c) {
+            case 'o':
+                output = optarg;
+                break;
+            case 'b':
+                options.bssid = optarg;
+                break;
+            case 'j':
+                options.threads = std::atoi(optarg);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'h':
+                printUsage(argv[0]);
+                return 0;
+            case 1000:
+                options.keep_wep = true;
+                break;
+            case 1001:
+                options.range_bytes = std::strtoull(optarg, nullptr, 10);
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (output.empty() || optind >= argc) {
+        std::cerr << "[-] An output file and at least one capture are required." << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Logger::getInstance().setVerbose(verbose);
+
+    bool hashes = hasExtension(output, ".22000") || hasExtension(output, ".hc22000");
+    if (hashes && options.keep_wep) {
+        std::cerr << "[!] 22000 has no room for WEP frames, ignoring --wep" << std::endl;
+        options.keep_wep = false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CaptureStrip strip(options);
+    for (int i = optind; i < argc; ++i) {
+        if (!strip.addCapture(argv[i])) {
+            std::cerr << "[-] Skipping " << argv[i] << std::endl;
+        }
+    }
+
+    bool ok = hashes ? strip.writeHashes(output) : strip.writePcapng(output);
+    if (!ok) {
+        std::cerr << "[-] Failed to write " << output << std::endl;
+        return 1;
+    }
+
+    const StripStats& stats = strip.getStats();
+    struct stat st;
+    uint64_t bytes_out = stat(output.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[+] " << stats.captures << " capture(s), " << stats.bytes_in << " bytes -> " << output << ", "
+              << bytes_out << " bytes in " << std::fixed << std::setprecision(2) << seconds << "s\n";
+    std::cout << "    " << stats.handshakes << " handshake(s) from " << stats.eapol << " EAPOL frames, "
+              << stats.pmkids << " PMKID(s), " << stats.beacons << " beacon(s)";
+    if (options.keep_wep) {
+        std::cout << ", " << stats.wep << " WEP IVs";
+    }
+    std::cout << std::endl;
+    if (stats.unnamed > 0) {
+        std::cout << "[!] " << stats.unnamed << " handshake(s)/PMKID(s) without a beacon naming their BSS"
+                  << (hashes ? " were left out" : "") << std::endl;
+    }
+    return stats.captures > 0 ? 0 : 1;
+}
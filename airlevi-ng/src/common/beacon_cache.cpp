@@ -0,0 +1,176 @@
+#include "common/beacon_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace airlevi {
+
+namespace {
+
+const uint8_t IE_TIM = 5;
+const uint8_t IE_BSS_LOAD = 11;
+
+const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+const uint64_t HASH_MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+
+uint64_t mixWord(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * HASH_MULTIPLIER;
+    return hash ^ (hash >> 32);
+}
+
+// Four independent lanes over 32-byte blocks so the multiplies overlap
+// instead of forming one long dependency chain; a single changed word
+// always changes the result
+uint64_t mix(uint64_t hash, const uint8_t* data, size_t length) {
+    if (length >= 32) {
+        uint64_t lanes[4] = {hash, hash ^ 1, hash ^ 2, hash ^ 3};
+        while (length >= 32) {
+            for (int i = 0; i < 4; ++i) {
+                uint64_t word;
+                memcpy(&word, data + 8 * i, 8);
+                lanes[i] = mixWord(lanes[i], word);
+            }
+            data += 32;
+            length -= 32;
+        }
+        hash = mixWord(mixWord(mixWord(lanes[0], lanes[1]), lanes[2]), lanes[3]);
+    }
+
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        hash = mixWord(hash, word);
+        data += 8;
+        length -= 8;
+    }
+
+    uint64_t tail = length;
+    for (size_t i = 0; i < length; ++i) {
+        tail |= static_cast<uint64_t>(data[i]) << (8 * (i + 1));
+    }
+    return mixWord(hash, tail);
+}
+
+uint64_t macKey(const MacAddress& mac) {
+    uint64_t key = 0;
+    for (int i = 0; i < 6; ++i) {
+        key = (key << 8) | mac.bytes[i];
+    }
+    return key;
+}
+
+uint64_t seedHash(const BeaconView& beacon) {
+    return (HASH_SEED ^ beacon.capabilities ^ (static_cast<uint64_t>(beacon.beacon_interval) << 16)) *
+           HASH_MULTIPLIER;
+}
+
+} // namespace
+
+uint64_t BeaconCache::stableHash(const BeaconView& beacon) {
+    Layout layout;
+    return stableHash(beacon, layout);
+}
+
+uint64_t BeaconCache::stableHash(const BeaconView& beacon, Layout& layout) {
+    uint64_t hash = seedHash(beacon);
+    layout.count = 0;
+
+    // Hash the runs of elements between the first TIM and BSS Load
+    const uint8_t* current = beacon.ies.data;
+    const uint8_t* end = beacon.ies.data + beacon.ies.size;
+    const uint8_t* run = current;
+
+    while (current + 2 <= end && current + 2 + current[1] <= end) {
+        const uint8_t* next = current + 2 + current[1];
+        bool volatile_element = current[0] == IE_TIM || current[0] == IE_BSS_LOAD;
+        bool first = layout.count == 0 || (layout.count == 1 && layout.id[0] != current[0]);
+        if (volatile_element && first) {
+            hash = mix(hash, run, current - run);
+            layout.id[layout.count] = current[0];
+            layout.gap[layout.count] = static_cast<uint16_t>(current - run);
+            layout.count++;
+            run = next;
+        }
+        current = next;
+    }
+
+    // Truncated trailing bytes included: they are as stable as the rest
+    return mix(hash, run, end - run);
+}
+
+bool BeaconCache::stableHash(const BeaconView& beacon, const Layout& layout, uint64_t& hash) {
+    hash = seedHash(beacon);
+
+    const uint8_t* run = beacon.ies.data;
+    const uint8_t* end = beacon.ies.data + beacon.ies.size;
+
+    for (uint8_t i = 0; i < layout.count; ++i) {
+        const uint8_t* element = run + layout.gap[i];
+        if (element + 2 > end || element[0] != layout.id[i] || element + 2 + element[1] > end) return false;
+
+        hash = mix(hash, run, layout.gap[i]);
+        run = element + 2 + element[1];
+    }
+
+    hash = mix(hash, run, end - run);
+    return true;
+}
+
+const WifiNetwork& BeaconCache::update(const BeaconView& beacon, const RadiotapInfo& radiotap, bool& changed) {
+    uint64_t key = macKey(beacon.bssid);
+    auto it = entries_.find(key);
+
+    // Hashed around the volatile elements where the last beacon had them.
+    // Equal hashes mean equal bytes up to each of them, so the element
+    // chain lines up exactly as it did and needs no walk.
+    uint64_t hash;
+    bool hit = it != entries_.end() && stableHash(beacon, it->second.layout, hash) && hash == it->second.hash;
+
+    if (!hit) {
+        Layout layout;
+        hash = stableHash(beacon, layout);
+
+        // find() first: emplace() would build a node for every beacon
+        if (it == entries_.end()) {
+            if (entries_.size() >= max_entries_) evictOldest();
+            it = entries_.emplace(key, Entry()).first;
+        } else {
+            hit = hash == it->second.hash;   // the volatile elements moved
+        }
+        it->second.layout = layout;
+    }
+
+    Entry& entry = it->second;
+    changed = !hit;
+
+    if (changed) {
+        misses_++;
+        entry.hash = hash;
+        beacon.materialize(entry.network);
+    } else {
+        hits_++;
+        entry.network.last_seen = std::chrono::steady_clock::now();
+    }
+
+    if (radiotap.has_signal) entry.network.signal_strength = radiotap.signal_dbm;
+    entry.network.packets_captured++;
+    return entry.network;
+}
+
+void BeaconCache::evictOldest() {
+    std::vector<std::pair<std::chrono::steady_clock::time_point, uint64_t>> ages;
+    ages.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+        ages.emplace_back(entry.second.network.last_seen, entry.first);
+    }
+
+    size_t count = std::max<size_t>(1, ages.size() / 4);
+    std::nth_element(ages.begin(), ages.begin() + (count - 1), ages.end());
+    for (size_t i = 0; i < count; ++i) {
+        entries_.erase(ages[i].second);
+    }
+    evictions_ += count;
+}
+
+} // namespace airlevi
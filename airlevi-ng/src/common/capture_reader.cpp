@@ -0,0 +1,577 @@
+#include "common/capture_reader.h"
+#include "common/logger.h"
+#include "common/packet_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace airlevi {
+
+namespace {
+
+const uint32_t PCAP_MAGIC_USEC = 0xa1b2c3d4;
+const uint32_t PCAP_MAGIC_NSEC = 0xa1b23c4d;
+const uint32_t PCAPNG_SECTION_HEADER = 0x0a0d0d0a;
+const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+
+const uint32_t PCAPNG_INTERFACE_DESCRIPTION = 1;
+const uint32_t PCAPNG_OBSOLETE_PACKET = 2;
+const uint32_t PCAPNG_SIMPLE_PACKET = 3;
+const uint32_t PCAPNG_NAME_RESOLUTION = 4;
+const uint32_t PCAPNG_INTERFACE_STATISTICS = 5;
+const uint32_t PCAPNG_ENHANCED_PACKET = 6;
+const uint32_t PCAPNG_DECRYPTION_SECRETS = 10;
+const uint32_t PCAPNG_CUSTOM = 0x00000bad;
+const uint32_t PCAPNG_CUSTOM_NO_COPY = 0x40000bad;
+
+const uint16_t PCAPNG_OPT_END = 0;
+const uint16_t PCAPNG_OPT_IF_TSRESOL = 9;
+
+// Records that fail these bounds are treated as noise while resynchronizing
+const uint32_t MAX_RECORD_LENGTH = 16U << 20;
+const uint32_t MAX_CLOCK_SKEW = 86400;                 // before the first record
+const uint32_t MAX_CAPTURE_SPAN = 10U * 366 * 86400;   // after the first record
+const int RESYNC_CHAIN = 8;
+
+uint32_t loadLE32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t read16(const uint8_t* p, bool swapped) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap16(value) : value;
+}
+
+uint32_t read32(const uint8_t* p, bool swapped) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap32(value) : value;
+}
+
+bool knownPcapngBlock(uint32_t type) {
+    switch (type) {
+        case PCAPNG_SECTION_HEADER:
+        case PCAPNG_INTERFACE_DESCRIPTION:
+        case PCAPNG_OBSOLETE_PACKET:
+        case PCAPNG_SIMPLE_PACKET:
+        case PCAPNG_NAME_RESOLUTION:
+        case PCAPNG_INTERFACE_STATISTICS:
+        case PCAPNG_ENHANCED_PACKET:
+        case PCAPNG_DECRYPTION_SECRETS:
+        case PCAPNG_CUSTOM:
+        case PCAPNG_CUSTOM_NO_COPY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+CaptureReader::CaptureReader()
+    : fd_(-1), map_(nullptr), size_(0), first_record_(0), format_(CaptureFormat::PCAP),
+      nanosecond_(false), snaplen_(0), first_second_(0), link_type_(0),
+      cursor_{0, false, {}}, start_{0, false, {}}, head_{0, false, {}} {}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+bool CaptureReader::open(const std::string& path) {
+    close();
+    path_ = path;
+
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        Logger::getInstance().error("Cannot open capture file: " + path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size < 12) {
+        Logger::getInstance().error("Not a capture file: " + path);
+        close();
+        return false;
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (map == MAP_FAILED) {
+        Logger::getInstance().error("Cannot map capture file: " + path);
+        close();
+        return false;
+    }
+    map_ = static_cast<const uint8_t*>(map);
+    madvise(map, size_, MADV_SEQUENTIAL);
+
+    uint32_t magic = loadLE32(map_);
+    if (magic == PCAPNG_SECTION_HEADER) {
+        format_ = CaptureFormat::PCAPNG;
+        first_record_ = 0;
+        start_ = Cursor{0, false, {}};
+        if (!readSectionHeader(start_)) {
+            Logger::getInstance().error("Malformed pcapng section header: " + path);
+            close();
+            return false;
+        }
+
+        // Interfaces described ahead of the first packet, without consuming it
+        head_ = start_;
+        head_.pos = start_.pos + read32(map_ + 4, start_.swapped);
+        while (head_.pos + 12 <= size_) {
+            const uint8_t* block = map_ + head_.pos;
+            uint32_t type = read32(block, head_.swapped);
+            uint32_t total_length = read32(block + 4, head_.swapped);
+            if (type == PCAPNG_SECTION_HEADER || type == PCAPNG_ENHANCED_PACKET ||
+                type == PCAPNG_OBSOLETE_PACKET || type == PCAPNG_SIMPLE_PACKET) break;
+            if (total_length < 12 || total_length % 4 != 0 || head_.pos + total_length > size_) break;
+            if (type == PCAPNG_INTERFACE_DESCRIPTION && !readInterface(head_, block + 8, total_length - 12)) break;
+            head_.pos += total_length;
+        }
+        link_type_ = head_.interfaces.empty() ? 0 : head_.interfaces[0].link_type;
+        rewind();
+        return true;
+    }
+
+    format_ = CaptureFormat::PCAP;
+    if (size_ < 24) {
+        Logger::getInstance().error("Truncated pcap header: " + path);
+        close();
+        return false;
+    }
+
+    bool swapped;
+    if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC) {
+        swapped = false;
+    } else if (__builtin_bswap32(magic) == PCAP_MAGIC_USEC || __builtin_bswap32(magic) == PCAP_MAGIC_NSEC) {
+        swapped = true;
+    } else {
+        Logger::getInstance().error("Unknown capture format: " + path);
+        close();
+        return false;
+    }
+    nanosecond_ = (read32(map_, swapped) == PCAP_MAGIC_NSEC);
+    snaplen_ = read32(map_ + 16, swapped);
+    link_type_ = read32(map_ + 20, swapped) & 0x0fffffff;   // upper bits carry FCS flags
+    first_record_ = 24;
+    first_second_ = size_ >= 28 ? read32(map_ + 24, swapped) : 0;
+
+    start_ = Cursor{first_record_, swapped, {}};
+    head_ = start_;
+    rewind();
+    return true;
+}
+
+void CaptureReader::close() {
+    if (map_) {
+        munmap(const_cast<uint8_t*>(map_), size_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    cursor_ = Cursor{0, false, {}};
+    start_ = cursor_;
+    head_ = cursor_;
+}
+
+void CaptureReader::rewind() {
+    cursor_ = start_;
+}
+
+bool CaptureReader::next(CaptureFrame& frame) {
+    if (!map_) return false;
+    return nextFrame(cursor_, size_, frame);
+}
+
+bool CaptureReader::readFrameIndex(std::vector<IndexedFrame>& frames) const {
+    frames.clear();
+    if (!map_ || format_ != CaptureFormat::PCAPNG || size_ < 40) return false;
+
+    // The block's length is repeated in its last four bytes
+    bool swapped = head_.swapped;
+    uint32_t total_length = read32(map_ + size_ - 4, swapped);
+    if (total_length < 40 || total_length % 4 != 0 || total_length > size_) return false;
+
+    const uint8_t* block = map_ + size_ - total_length;
+    if (read32(block, swapped) != PCAPNG_CUSTOM_NO_COPY || read32(block + 4, swapped) != total_length) return false;
+    if (read32(block + 8, swapped) != PCAPNG_INDEX_PEN || read32(block + 12, swapped) != PCAPNG_INDEX_MAGIC ||
+        read32(block + 16, swapped) != PCAPNG_INDEX_VERSION) return false;
+
+    uint32_t count = read32(block + 20, swapped);
+    if (static_cast<uint64_t>(count) * 16 + 28 != total_length) return false;
+
+    uint64_t index_start = size_ - total_length;
+    frames.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* entry = block + 24 + i * 16;
+        uint64_t offset = (static_cast<uint64_t>(read32(entry + 4, swapped)) << 32) | read32(entry, swapped);
+        uint32_t kind = read32(entry + 8, swapped);
+        if (offset >= index_start) {
+            frames.clear();
+            return false;
+        }
+        if (kind == 0 || kind > static_cast<uint32_t>(IndexedFrameKind::BEACON)) continue;   // newer writer
+        frames.push_back(IndexedFrame{offset, static_cast<IndexedFrameKind>(kind)});
+    }
+    return true;
+}
+
+bool CaptureReader::frameAt(uint64_t offset, CaptureFrame& frame) const {
+    if (!map_ || offset < head_.pos) return false;
+
+    // pcapng interfaces are those described ahead of the first packet
+    Cursor cursor = head_;
+    cursor.pos = offset;
+    return nextFrame(cursor, offset + 1, frame) && frame.offset == offset;
+}
+
+std::vector<CaptureFrame> CaptureReader::scanParallel(int threads,
+                                                      const std::function<bool(const CaptureFrame&)>& keep,
+                                                      uint64_t min_range_bytes) const {
+    std::vector<CaptureFrame> frames;
+    if (!map_) return frames;
+
+    uint64_t span = size_ - first_record_;
+    size_t parts = static_cast<size_t>(std::max(threads, 1));
+    uint64_t range_bytes = std::max<uint64_t>(min_range_bytes, 1);
+    parts = static_cast<size_t>(std::min<uint64_t>(parts, std::max<uint64_t>(1, span / range_bytes)));
+
+    std::vector<uint64_t> bounds(parts + 1);
+    for (size_t i = 0; i < parts; ++i) {
+        bounds[i] = first_record_ + span * i / parts;
+    }
+    bounds[parts] = size_;
+
+    std::vector<Cursor> starts(parts);
+    std::vector<Cursor> ends(parts);
+    std::vector<std::vector<CaptureFrame>> results(parts);
+
+    auto scan = [&](size_t part) {
+        Cursor cursor = start_;
+        if (part > 0) {
+            // Later ranges assume the first section's byte order and
+            // interfaces; the merge below catches them when that is wrong
+            cursor = head_;
+            resync(cursor, bounds[part], bounds[part + 1]);
+        }
+        starts[part] = cursor;
+        scanRange(cursor, bounds[part + 1], keep, results[part]);
+        ends[part] = cursor;
+    };
+
+    if (parts == 1) {
+        scan(0);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(parts);
+        for (size_t i = 0; i < parts; ++i) {
+            workers.emplace_back(scan, i);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Each range must pick up exactly where the previous one stopped. The
+    // first range starts at a known boundary, so by induction every range
+    // that agrees with its predecessor decoded the same records a sequential
+    // pass would have; any that does not is rescanned from the true state.
+    size_t rescanned = 0;
+    for (size_t i = 1; i < parts; ++i) {
+        if (starts[i] == ends[i - 1]) continue;
+
+        Cursor cursor = ends[i - 1];
+        results[i].clear();
+        scanRange(cursor, bounds[i + 1], keep, results[i]);
+        ends[i] = cursor;
+        ++rescanned;
+    }
+    if (rescanned > 0) {
+        Logger::getInstance().debug("Rescanned " + std::to_string(rescanned) + " of " + std::to_string(parts) +
+                                    " ranges in " + path_);
+    }
+
+    size_t total = 0;
+    for (const auto& result : results) total += result.size();
+    frames.reserve(total);
+    for (auto& result : results) {
+        frames.insert(frames.end(), result.begin(), result.end());
+    }
+
+    std::sort(frames.begin(), frames.end(), [](const CaptureFrame& a, const CaptureFrame& b) {
+        return a.timestamp_ns != b.timestamp_ns ? a.timestamp_ns < b.timestamp_ns : a.offset < b.offset;
+    });
+    return frames;
+}
+
+void CaptureReader::scanRange(Cursor& cursor, uint64_t end, const std::function<bool(const CaptureFrame&)>& keep,
+                              std::vector<CaptureFrame>& frames) const {
+    CaptureFrame frame;
+    while (nextFrame(cursor, end, frame)) {
+        if (keep(frame)) {
+            frames.push_back(frame);
+        }
+    }
+}
+
+bool CaptureReader::resync(Cursor& cursor, uint64_t from, uint64_t end) const {
+    bool pcapng = format_ == CaptureFormat::PCAPNG;
+    uint64_t pos = pcapng ? (from + 3) & ~3ULL : from;   // pcapng blocks are 32-bit aligned
+    uint64_t step = pcapng ? 4 : 1;
+
+    for (; pos < end; pos += step) {
+        if (pcapng ? plausiblePcapngChain(pos, cursor.swapped) : plausiblePcapChain(pos, cursor.swapped)) {
+            cursor.pos = pos;
+            return true;
+        }
+    }
+
+    // No record starts in this range
+    cursor.pos = end;
+    return false;
+}
+
+bool CaptureReader::plausiblePcapChain(uint64_t pos, bool swapped) const {
+    uint32_t max_caplen = (snaplen_ > 0 && snaplen_ <= MAX_RECORD_LENGTH) ? snaplen_ : MAX_RECORD_LENGTH;
+    uint32_t max_fraction = nanosecond_ ? 1000000000U : 1000000U;
+
+    for (int i = 0; i < RESYNC_CHAIN; ++i) {
+        if (pos == size_) return i > 0;
+        if (pos + 16 > size_) return false;
+
+        const uint8_t* record = map_ + pos;
+        uint32_t ts_sec = read32(record, swapped);
+        uint32_t ts_frac = read32(record + 4, swapped);
+        uint32_t caplen = read32(record + 8, swapped);
+        uint32_t len = read32(record + 12, swapped);
+
+        if (ts_frac >= max_fraction) return false;
+        if (static_cast<uint64_t>(ts_sec) + MAX_CLOCK_SKEW < first_second_) return false;
+        if (ts_sec > static_cast<uint64_t>(first_second_) + MAX_CAPTURE_SPAN) return false;
+        if (caplen > max_caplen || caplen > len || len > MAX_RECORD_LENGTH) return false;
+        if (pos + 16 + caplen > size_) return false;
+
+        pos += 16 + caplen;
+    }
+    return true;
+}
+
+bool CaptureReader::plausiblePcapngChain(uint64_t pos, bool swapped) const {
+    for (int i = 0; i < RESYNC_CHAIN; ++i) {
+        if (pos == size_) return i > 0;
+        if (pos + 12 > size_) return false;
+
+        const uint8_t* block = map_ + pos;
+        uint32_t type = read32(block, swapped);
+        uint32_t total_length = read32(block + 4, swapped);
+
+        if (!knownPcapngBlock(type)) return false;
+        if (total_length < 12 || total_length % 4 != 0 || total_length > MAX_RECORD_LENGTH) return false;
+        if (pos + total_length > size_) return false;
+        if (read32(block + total_length - 4, swapped) != total_length) return false;
+
+        pos += total_length;
+    }
+    return true;
+}
+
+bool CaptureReader::nextFrame(Cursor& cursor, uint64_t limit, CaptureFrame& frame) const {
+    return format_ == CaptureFormat::PCAPNG ? nextPcapng(cursor, limit, frame) : nextPcap(cursor, limit, frame);
+}
+
+bool CaptureReader::nextPcap(Cursor& cursor, uint64_t limit, CaptureFrame& frame) const {
+    if (cursor.pos >= limit || cursor.pos + 16 > size_) return false;
+
+    const uint8_t* record = map_ + cursor.pos;
+    uint32_t ts_sec = read32(record, cursor.swapped);
+    uint32_t ts_frac = read32(record + 4, cursor.swapped);
+    uint32_t caplen = read32(record + 8, cursor.swapped);
+    uint32_t len = read32(record + 12, cursor.swapped);
+
+    if (cursor.pos + 16 + caplen > size_) {
+        Logger::getInstance().warning("Truncated record at offset " + std::to_string(cursor.pos) + " in " + path_);
+        return false;
+    }
+
+    frame.timestamp_ns = static_cast<uint64_t>(ts_sec) * 1000000000ULL + (nanosecond_ ? ts_frac : ts_frac * 1000ULL);
+    frame.link_type = link_type_;
+    frame.data = record + 16;
+    frame.caplen = caplen;
+    frame.len = len;
+    frame.offset = cursor.pos;
+    frame.interface_id = 0;
+
+    cursor.pos += 16 + caplen;
+    return true;
+}
+
+bool CaptureReader::nextPcapng(Cursor& cursor, uint64_t limit, CaptureFrame& frame) const {
+    while (cursor.pos < limit && cursor.pos + 12 <= size_) {
+        const uint8_t* block = map_ + cursor.pos;
+        uint32_t type = read32(block, cursor.swapped);
+
+        if (type == PCAPNG_SECTION_HEADER) {
+            // A new section may switch byte order and always resets interfaces
+            if (!readSectionHeader(cursor)) return false;
+        }
+
+        uint32_t total_length = read32(block + 4, cursor.swapped);
+        if (total_length < 12 || total_length % 4 != 0 || cursor.pos + total_length > size_) {
+            Logger::getInstance().warning("Malformed pcapng block at offset " + std::to_string(cursor.pos) + " in " + path_);
+            return false;
+        }
+
+        const uint8_t* body = block + 8;
+        uint32_t body_length = total_length - 12;
+        uint64_t block_offset = cursor.pos;
+        cursor.pos += total_length;
+
+        switch (type) {
+            case PCAPNG_INTERFACE_DESCRIPTION:
+                if (!readInterface(cursor, body, body_length)) return false;
+                break;
+
+            case PCAPNG_ENHANCED_PACKET:
+            case PCAPNG_OBSOLETE_PACKET: {
+                if (body_length < 20) break;
+
+                uint32_t iface_id = type == PCAPNG_ENHANCED_PACKET ? read32(body, cursor.swapped)
+                                                                   : read16(body, cursor.swapped);
+                if (iface_id >= cursor.interfaces.size()) break;
+
+                uint64_t units = (static_cast<uint64_t>(read32(body + 4, cursor.swapped)) << 32) |
+                                 read32(body + 8, cursor.swapped);
+                uint32_t caplen = read32(body + 12, cursor.swapped);
+                if (caplen > body_length - 20) break;
+
+                const Interface& iface = cursor.interfaces[iface_id];
+                frame.timestamp_ns = toNanoseconds(iface, units);
+                frame.link_type = iface.link_type;
+                frame.data = body + 20;
+                frame.caplen = caplen;
+                frame.len = read32(body + 16, cursor.swapped);
+                frame.offset = block_offset;
+                frame.interface_id = iface_id;
+                return true;
+            }
+
+            case PCAPNG_SIMPLE_PACKET: {
+                if (body_length < 4 || cursor.interfaces.empty()) break;
+
+                uint32_t len = read32(body, cursor.swapped);
+                frame.timestamp_ns = 0;     // simple packets carry no timestamp
+                frame.link_type = cursor.interfaces[0].link_type;
+                frame.data = body + 4;
+                frame.caplen = std::min(len, body_length - 4);
+                frame.len = len;
+                frame.offset = block_offset;
+                frame.interface_id = 0;
+                return true;
+            }
+
+            default:
+                // Name resolution, statistics and custom blocks are skipped
+                break;
+        }
+    }
+    return false;
+}
+
+bool CaptureReader::readSectionHeader(Cursor& cursor) const {
+    if (cursor.pos + 28 > size_) return false;
+
+    uint32_t magic = loadLE32(map_ + cursor.pos + 8);
+    if (magic == PCAPNG_BYTE_ORDER_MAGIC) {
+        cursor.swapped = false;
+    } else if (__builtin_bswap32(magic) == PCAPNG_BYTE_ORDER_MAGIC) {
+        cursor.swapped = true;
+    } else {
+        return false;
+    }
+
+    cursor.interfaces.clear();
+    return true;
+}
+
+bool CaptureReader::readInterface(Cursor& cursor, const uint8_t* body, uint32_t body_length) const {
+    if (body_length < 8) return false;
+
+    Interface iface;
+    iface.link_type = read16(body, cursor.swapped);
+    iface.binary_resolution = false;
+    iface.exponent = 6;
+
+    // Options: code, length, value padded to 32 bits
+    uint32_t pos = 8;
+    while (pos + 4 <= body_length) {
+        uint16_t code = read16(body + pos, cursor.swapped);
+        uint16_t length = read16(body + pos + 2, cursor.swapped);
+        if (code == PCAPNG_OPT_END || pos + 4 + length > body_length) break;
+
+        if (code == PCAPNG_OPT_IF_TSRESOL && length >= 1) {
+            uint8_t value = body[pos + 4];
+            iface.binary_resolution = (value & 0x80) != 0;
+            iface.exponent = value & 0x7f;
+        }
+        pos += 4 + ((length + 3) & ~3u);
+    }
+
+    cursor.interfaces.push_back(iface);
+    return true;
+}
+
+uint64_t CaptureReader::toNanoseconds(const Interface& iface, uint64_t units) const {
+    if (iface.binary_resolution) {
+        if (iface.exponent >= 64) return 0;
+        unsigned __int128 scaled = static_cast<unsigned __int128>(units) * 1000000000ULL;
+        return static_cast<uint64_t>(scaled >> iface.exponent);
+    }
+
+    static const uint64_t powers[] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+        10000000ULL, 100000000ULL, 1000000000ULL
+    };
+    if (iface.exponent <= 9) {
+        return units * powers[9 - iface.exponent];
+    }
+    uint64_t divisor = 1;
+    for (int i = 9; i < iface.exponent && i < 28; ++i) divisor *= 10;
+    return units / divisor;
+}
+
+bool CaptureReader::ieee80211Frame(const CaptureFrame& frame, const uint8_t*& data, uint32_t& length,
+                                   std::vector<uint8_t>& scratch) {
+    if (frame.link_type == LINKTYPE_IEEE802_11) {
+        data = frame.data;
+        length = frame.caplen;
+        return true;
+    }
+
+    if (frame.link_type == LINKTYPE_IEEE802_11_RADIOTAP) {
+        RadiotapInfo info;
+        if (!PacketParser::decodeRadiotap(frame.data, static_cast<int>(frame.caplen), info)) return false;
+
+        uint32_t trailer = info.has_fcs ? 4 : 0;
+        if (info.header_length + trailer > frame.caplen) return false;
+        data = frame.data + info.header_length;
+        length = frame.caplen - info.header_length - trailer;
+        if (info.data_pad) {
+            int padded_length = static_cast<int>(length);
+            PacketParser::removeDataPad(data, padded_length, scratch);
+            length = static_cast<uint32_t>(padded_length);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace airlevi
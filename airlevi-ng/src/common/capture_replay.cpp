@@ -0,0 +1,146 @@
+#include "common/capture_replay.h"
+#include "common/logger.h"
+#include <vector>
+
+namespace airlevi {
+
+CaptureReplay::CaptureReplay()
+    : stopping_(false), playing_(false), finished_(false), frames_(0), skipped_(0), elapsed_ns_(-1) {
+}
+
+CaptureReplay::~CaptureReplay() {
+    close();
+}
+
+bool CaptureReplay::open(const ReplayOptions& options) {
+    close();
+    options_ = options;
+    if (options_.batch_frames == 0) options_.batch_frames = 1;
+    if (options_.speed < 0) options_.speed = 0;
+
+    if (!reader_.open(options_.path)) {
+        return false;
+    }
+    frames_ = 0;
+    skipped_ = 0;
+    playing_ = false;
+    finished_ = false;
+    elapsed_ns_ = -1;
+    return true;
+}
+
+void CaptureReplay::close() {
+    stop();
+    reader_.close();
+}
+
+bool CaptureReplay::start(BatchHandler handler) {
+    if (!reader_.isOpen() || thread_.joinable()) {
+        return false;
+    }
+    stopping_ = false;
+    started_ = std::chrono::steady_clock::now();
+    playing_ = true;
+    thread_ = std::thread(&CaptureReplay::replayLoop, this, std::move(handler));
+    return true;
+}
+
+void CaptureReplay::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stopping_ = true;
+    }
+    stop_wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+CaptureCounters CaptureReplay::getCounters() const {
+    CaptureCounters counters;
+    counters.received = frames_;
+    return counters;
+}
+
+double CaptureReplay::getElapsedSeconds() const {
+    int64_t elapsed = elapsed_ns_;
+    if (elapsed < 0) {
+        if (!playing_) return 0;
+        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_)
+                      .count();
+    }
+    return elapsed / 1e9;
+}
+
+bool CaptureReplay::waitUntil(std::chrono::steady_clock::time_point due) {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    stop_wake_.wait_until(lock, due, [this]() { return stopping_.load(); });
+    return !stopping_;
+}
+
+void CaptureReplay::replayLoop(BatchHandler handler) {
+    uint32_t link_type = reader_.getLinkType();
+    std::vector<RingPacket> batch;
+    batch.reserve(options_.batch_frames);
+
+    auto deliver = [&]() {
+        if (batch.empty()) return;
+        handler(0, batch);
+        frames_ += batch.size();
+        batch.clear();
+    };
+
+    // Paced: a frame recorded t after the first is due t / speed after start()
+    bool paced = options_.speed > 0;
+    bool first = true;
+    uint64_t origin_ns = 0;
+
+    CaptureFrame frame;
+    while (!stopping_ && reader_.next(frame)) {
+        if (frame.link_type != link_type) {
+            skipped_++;
+            continue;
+        }
+
+        if (paced) {
+            if (first) {
+                origin_ns = frame.timestamp_ns;
+                first = false;
+            }
+            uint64_t offset_ns = frame.timestamp_ns > origin_ns ? frame.timestamp_ns - origin_ns : 0;
+            auto due = started_ + std::chrono::nanoseconds(static_cast<int64_t>(offset_ns / options_.speed));
+            if (due > std::chrono::steady_clock::now()) {
+                // Frames already due go out before waiting for this one
+                deliver();
+                if (!waitUntil(due)) break;
+            }
+        }
+
+        RingPacket packet;
+        packet.header.ts.tv_sec = static_cast<time_t>(frame.timestamp_ns / 1000000000ULL);
+        packet.header.ts.tv_usec = static_cast<suseconds_t>(frame.timestamp_ns % 1000000000ULL / 1000);
+        packet.header.caplen = frame.caplen;
+        packet.header.len = frame.len;
+        packet.data = frame.data;
+        packet.interface_id = frame.interface_id;
+        batch.push_back(packet);
+        if (batch.size() >= options_.batch_frames) {
+            deliver();
+        }
+    }
+    deliver();
+
+    elapsed_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_)
+                      .count();
+    if (!stopping_) {
+        Logger::getInstance().info("Replay of " + options_.path + " finished: " + std::to_string(frames_.load()) +
+                                   " frames");
+        if (skipped_ > 0) {
+            Logger::getInstance().warning(std::to_string(skipped_.load()) +
+                                          " frames of other link types were skipped");
+        }
+    }
+    finished_ = true;
+}
+
+} // namespace airlevi
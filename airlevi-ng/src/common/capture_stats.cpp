@@ -0,0 +1,135 @@
+#include "common/capture_stats.h"
+#include "common/progress_stream.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+namespace airlevi {
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::indexFor(uint64_t value) {
+    if (value < LINEAR) return static_cast<size_t>(value);
+
+    // Keep the top SUB_BUCKET_BITS bits: value >> shift lies in [HALF, LINEAR)
+    int magnitude = 63 - __builtin_clzll(value);
+    int shift = magnitude - (SUB_BUCKET_BITS - 1);
+    return LINEAR + (shift - 1) * HALF + static_cast<size_t>((value >> shift) - HALF);
+}
+
+uint64_t LatencyHistogram::highestValueAt(size_t index) {
+    if (index < LINEAR) return index;
+
+    size_t offset = index - LINEAR;
+    int shift = static_cast<int>(offset / HALF) + 1;
+    uint64_t top = offset % HALF + HALF;
+    if (shift + SUB_BUCKET_BITS >= 64 && top == LINEAR - 1) return UINT64_MAX;
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    counts_[indexFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (nanoseconds > max && !max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const {
+    uint64_t total = getCount();
+    if (total == 0) return 0;
+
+    // Smallest bucket whose cumulative count reaches the rank
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t value = highestValueAt(i);
+            return value < getMax() ? value : getMax();
+        }
+    }
+    return getMax();
+}
+
+std::string LatencyHistogram::formatNanoseconds(uint64_t nanoseconds) {
+    char buffer[32];
+    if (nanoseconds < 1000) {
+        snprintf(buffer, sizeof(buffer), "%lluns", static_cast<unsigned long long>(nanoseconds));
+    } else if (nanoseconds < 1000000) {
+        snprintf(buffer, sizeof(buffer), "%.1fus", nanoseconds / 1e3);
+    } else if (nanoseconds < 1000000000) {
+        snprintf(buffer, sizeof(buffer), "%.1fms", nanoseconds / 1e6);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.2fs", nanoseconds / 1e9);
+    }
+    return buffer;
+}
+
+std::string LatencyHistogram::summary() const {
+    if (getCount() == 0) return "-";
+
+    return "p50 " + formatNanoseconds(getPercentile(50)) + " p99 " + formatNanoseconds(getPercentile(99)) +
+           " p99.9 " + formatNanoseconds(getPercentile(99.9)) + " max " + formatNanoseconds(getMax());
+}
+
+uint64_t nanosecondsSince(const struct timeval& timestamp) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    int64_t elapsed = (static_cast<int64_t>(now.tv_sec) - timestamp.tv_sec) * 1000000000LL +
+                      now.tv_nsec - static_cast<int64_t>(timestamp.tv_usec) * 1000;
+    return elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0;   // clock stepped back
+}
+
+bool latencySampleDue() {
+    thread_local uint32_t frames = 0;
+    return ++frames % LATENCY_SAMPLE_EVERY == 0;
+}
+
+uint64_t readInterfaceDrops(const std::string& interface) {
+    std::ifstream file("/sys/class/net/" + interface + "/statistics/rx_dropped");
+    uint64_t drops = 0;
+    file >> drops;
+    return drops;
+}
+
+void addCaptureFields(ProgressEvent& event, const CaptureCounters& counters, const std::vector<size_t>& backlog,
+                      const LatencyHistogram& frame_latency, const LatencyHistogram& handshake_latency) {
+    size_t backlog_total = 0;
+    size_t backlog_max = 0;
+    for (size_t blocks : backlog) {
+        backlog_total += blocks;
+        backlog_max = std::max(backlog_max, blocks);
+    }
+
+    event.add("kernel_received", counters.received)
+         .add("kernel_dropped", counters.dropped)
+         .add("interface_dropped", counters.interface_dropped)
+         .add("ring_backlog", backlog_total)
+         .add("ring_backlog_max", backlog_max)
+         .add("latency_samples", frame_latency.getCount())
+         .add("latency_p50_ns", frame_latency.getPercentile(50))
+         .add("latency_p99_ns", frame_latency.getPercentile(99))
+         .add("latency_p999_ns", frame_latency.getPercentile(99.9))
+         .add("latency_max_ns", frame_latency.getMax())
+         .add("handshake_frames", handshake_latency.getCount())
+         .add("handshake_latency_p99_ns", handshake_latency.getPercentile(99))
+         .add("handshake_latency_max_ns", handshake_latency.getMax());
+}
+
+} // namespace airlevi
@@ -4,6 +4,8 @@
 #include <openssl/hmac.h>
 #include <openssl/sha.h>
 #include <openssl/md5.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
@@ -76,9 +78,29 @@ std::vector<uint8_t> CryptoUtils::generatePTK(const std::vector<uint8_t>& pmk,
                                              const MacAddress& client_mac,
                                              const std::vector<uint8_t>& anonce,
                                              const std::vector<uint8_t>& snonce) {
+    auto prf_data = buildPTKData(ap_mac, client_mac, anonce, snonce);
     
-    // Create data for PRF
+    // Generate 64-byte PTK using PRF
+    return prf(pmk, "Pairwise key expansion", prf_data, 64);
+}
+
+std::vector<uint8_t> CryptoUtils::generatePTKSha256(const std::vector<uint8_t>& pmk,
+                                                   const MacAddress& ap_mac,
+                                                   const MacAddress& client_mac,
+                                                   const std::vector<uint8_t>& anonce,
+                                                   const std::vector<uint8_t>& snonce) {
+    auto kdf_data = buildPTKData(ap_mac, client_mac, anonce, snonce);
+    
+    // 384-bit PTK (KCK || KEK || TK) for CCMP with SHA256 AKMs
+    return kdfSha256(pmk, "Pairwise key expansion", kdf_data, 48);
+}
+
+std::vector<uint8_t> CryptoUtils::buildPTKData(const MacAddress& ap_mac,
+                                              const MacAddress& client_mac,
+                                              const std::vector<uint8_t>& anonce,
+                                              const std::vector<uint8_t>& snonce) {
     std::vector<uint8_t> prf_data;
+    prf_data.reserve(12 + anonce.size() + snonce.size());
     
     // Min(AP MAC, Client MAC) || Max(AP MAC, Client MAC)
     if (ap_mac < client_mac) {
@@ -98,40 +120,90 @@ std::vector<uint8_t> CryptoUtils::generatePTK(const std::vector<uint8_t>& pmk,
         prf_data.insert(prf_data.end(), anonce.begin(), anonce.end());
     }
     
-    // Generate 64-byte PTK using PRF
-    return prf(pmk, "Pairwise key expansion", prf_data, 64);
+    return prf_data;
 }
 
 bool CryptoUtils::verifyMIC(const HandshakePacket& handshake, const std::vector<uint8_t>& ptk) {
-    if (ptk.size() < 16) return false;
+    if (ptk.size() < 16 || handshake.mic.size() != EAPOL_MIC_LENGTH) return false;
     
     // Extract KCK (first 16 bytes of PTK)
     std::vector<uint8_t> kck(ptk.begin(), ptk.begin() + 16);
     
     // Calculate MIC
-    auto calculated_mic = calculateMIC(kck, handshake.eapol_data);
+    auto calculated_mic = calculateMIC(kck, handshake.eapol_data, handshake.key_version);
     
     // Compare with stored MIC
-    return std::equal(calculated_mic.begin(), calculated_mic.end(), handshake.mic.begin());
+    return CRYPTO_memcmp(calculated_mic.data(), handshake.mic.data(), EAPOL_MIC_LENGTH) == 0;
 }
 
 std::vector<uint8_t> CryptoUtils::calculateMIC(const std::vector<uint8_t>& kck,
-                                              const std::vector<uint8_t>& eapol_data) {
+                                              const std::vector<uint8_t>& eapol_data,
+                                              KeyDescriptorVersion version) {
     // Create EAPOL data with zeroed MIC field
     std::vector<uint8_t> data = eapol_data;
     
-    // Zero out MIC field (bytes 77-92 in EAPOL key frame)
-    if (data.size() >= 93) {
-        std::fill(data.begin() + 77, data.begin() + 93, 0);
+    if (data.size() >= EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH) {
+        std::fill(data.begin() + EAPOL_MIC_OFFSET, data.begin() + EAPOL_MIC_OFFSET + EAPOL_MIC_LENGTH, 0);
     }
     
-    // Calculate HMAC-MD5
-    unsigned char mic[16];
+    unsigned char mic[EVP_MAX_MD_SIZE];
     unsigned int mic_len;
     
-    HMAC(EVP_md5(), kck.data(), kck.size(), data.data(), data.size(), mic, &mic_len);
+    switch (version) {
+        case KeyDescriptorVersion::HMAC_SHA1_AES:
+            // HMAC-SHA1 truncated to 128 bits
+            HMAC(EVP_sha1(), kck.data(), kck.size(), data.data(), data.size(), mic, &mic_len);
+            break;
+        case KeyDescriptorVersion::AES_128_CMAC:
+            return aesCmac(kck, data);
+        default:
+            HMAC(EVP_md5(), kck.data(), kck.size(), data.data(), data.size(), mic, &mic_len);
+            break;
+    }
     
-    return std::vector<uint8_t>(mic, mic + 16);
+    return std::vector<uint8_t>(mic, mic + EAPOL_MIC_LENGTH);
+}
+
+std::vector<uint8_t> CryptoUtils::aesCmac(const std::vector<uint8_t>& key,
+                                         const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> mac(16);
+    if (key.size() != 16 || !aesCmac(key.data(), data.data(), data.size(), mac.data())) {
+        mac.clear();
+    }
+    return mac;
+}
+
+bool CryptoUtils::aesCmac(const uint8_t* key, const uint8_t* data, size_t length, uint8_t* mac) {
+    // Fetching the MAC and its cipher is the expensive part, so each thread
+    // does it once; EVP_MAC_init() then only rekeys
+    struct CmacContext {
+        EVP_MAC* mac;
+        EVP_MAC_CTX* ctx;
+        CmacContext() : mac(EVP_MAC_fetch(nullptr, "CMAC", nullptr)), ctx(nullptr) {
+            if (!mac) return;
+            ctx = EVP_MAC_CTX_new(mac);
+            char cipher[] = "AES-128-CBC";
+            OSSL_PARAM params[] = {
+                OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_CIPHER, cipher, 0),
+                OSSL_PARAM_construct_end()
+            };
+            if (ctx && EVP_MAC_CTX_set_params(ctx, params) != 1) {
+                EVP_MAC_CTX_free(ctx);
+                ctx = nullptr;
+            }
+        }
+        ~CmacContext() {
+            EVP_MAC_CTX_free(ctx);
+            EVP_MAC_free(mac);
+        }
+    };
+    static thread_local CmacContext cmac;
+
+    size_t mac_len = 0;
+    return cmac.ctx &&
+           EVP_MAC_init(cmac.ctx, key, 16, nullptr) == 1 &&
+           EVP_MAC_update(cmac.ctx, data, length) == 1 &&
+           EVP_MAC_final(cmac.ctx, mac, &mac_len, 16) == 1;
 }
 
 std::vector<uint8_t> CryptoUtils::md5Hash(const std::vector<uint8_t>& data) {
@@ -226,6 +298,38 @@ std::vector<uint8_t> CryptoUtils::prf(const std::vector<uint8_t>& key,
     return result;
 }
 
+std::vector<uint8_t> CryptoUtils::kdfSha256(const std::vector<uint8_t>& key,
+                                           const std::string& label,
+                                           const std::vector<uint8_t>& data,
+                                           size_t output_length) {
+    std::vector<uint8_t> result;
+    result.reserve(output_length + SHA256_DIGEST_LENGTH);
+    
+    // Input for HMAC: counter(LE16) + label + data + length in bits(LE16)
+    uint16_t length_bits = static_cast<uint16_t>(output_length * 8);
+    std::vector<uint8_t> kdf_input(2);
+    kdf_input.insert(kdf_input.end(), label.begin(), label.end());
+    kdf_input.insert(kdf_input.end(), data.begin(), data.end());
+    kdf_input.push_back(length_bits & 0xff);
+    kdf_input.push_back(length_bits >> 8);
+    
+    uint16_t counter = 1;
+    while (result.size() < output_length) {
+        kdf_input[0] = counter & 0xff;
+        kdf_input[1] = counter >> 8;
+        counter++;
+        
+        unsigned char hash[SHA256_DIGEST_LENGTH];
+        unsigned int hash_len;
+        HMAC(EVP_sha256(), key.data(), key.size(), kdf_input.data(), kdf_input.size(), hash, &hash_len);
+        
+        result.insert(result.end(), hash, hash + hash_len);
+    }
+    
+    result.resize(output_length);
+    return result;
+}
+
 std::vector<uint8_t> CryptoUtils::hmacSha1(const std::vector<uint8_t>& key,
                                           const std::vector<uint8_t>& data) {
     unsigned char result[SHA_DIGEST_LENGTH];
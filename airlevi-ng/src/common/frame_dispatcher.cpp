@@ -0,0 +1,88 @@
+#include "common/frame_dispatcher.h"
+#include "common/packet_parser.h"
+
+namespace airlevi {
+
+namespace {
+
+const uint8_t TYPE_MANAGEMENT = 0;
+const uint8_t TYPE_CONTROL = 1;
+const uint8_t TYPE_DATA = 2;
+
+const uint16_t AUTH_ALGORITHM_SAE = 3;
+
+uint8_t tableIndex(uint8_t type, uint8_t subtype) {
+    return static_cast<uint8_t>((subtype << 2) | type);
+}
+
+} // namespace
+
+FrameDispatcher::FrameDispatcher() {
+    for (auto& entry : table_) {
+        entry = FrameClass::OTHER;
+    }
+
+    table_[tableIndex(TYPE_MANAGEMENT, 0)] = FrameClass::ASSOC_REQUEST;
+    table_[tableIndex(TYPE_MANAGEMENT, 1)] = FrameClass::ASSOC_RESPONSE;
+    table_[tableIndex(TYPE_MANAGEMENT, 2)] = FrameClass::REASSOC_REQUEST;
+    table_[tableIndex(TYPE_MANAGEMENT, 3)] = FrameClass::REASSOC_RESPONSE;
+    table_[tableIndex(TYPE_MANAGEMENT, 4)] = FrameClass::PROBE_REQUEST;
+    table_[tableIndex(TYPE_MANAGEMENT, 5)] = FrameClass::PROBE_RESPONSE;
+    table_[tableIndex(TYPE_MANAGEMENT, 8)] = FrameClass::BEACON;
+    table_[tableIndex(TYPE_MANAGEMENT, 10)] = FrameClass::DISASSOCIATION;
+    table_[tableIndex(TYPE_MANAGEMENT, 11)] = FrameClass::AUTHENTICATION;
+    table_[tableIndex(TYPE_MANAGEMENT, 12)] = FrameClass::DEAUTHENTICATION;
+    table_[tableIndex(TYPE_MANAGEMENT, 13)] = FrameClass::ACTION;
+    table_[tableIndex(TYPE_MANAGEMENT, 14)] = FrameClass::ACTION;   // no ack
+
+    for (uint8_t subtype = 0; subtype < 16; ++subtype) {
+        table_[tableIndex(TYPE_CONTROL, subtype)] = FrameClass::CONTROL;
+
+        // Subtype bit 2 marks frames without a payload (Null, QoS Null, CF-Ack...)
+        table_[tableIndex(TYPE_DATA, subtype)] = (subtype & 0x4) ? FrameClass::NULL_DATA : FrameClass::DATA;
+    }
+}
+
+void FrameDispatcher::on(FrameClass frame_class, Handler handler) {
+    handlers_[static_cast<size_t>(frame_class)] = std::move(handler);
+}
+
+FrameClass FrameDispatcher::classify(const uint8_t* frame, int length) const {
+    if (!frame || length < 2) return FrameClass::OTHER;
+
+    FrameClass frame_class = table_[frame[0] >> 2];
+    if (length < static_cast<int>(sizeof(IEEE80211Header)) && frame_class != FrameClass::CONTROL) {
+        return FrameClass::OTHER;
+    }
+
+    // Only two classes look past the header, and only at fixed offsets
+    if (frame_class == FrameClass::DATA) {
+        int header_length = PacketParser::ieee80211HeaderLength(frame);
+        bool is_protected = (frame[1] & 0x40) != 0;
+        if (!is_protected && length >= header_length + 8) {
+            const uint8_t* llc = frame + header_length;
+            if (llc[0] == 0xaa && llc[1] == 0xaa && llc[2] == 0x03 && llc[6] == 0x88 && llc[7] == 0x8e) {
+                return FrameClass::EAPOL;
+            }
+        }
+    } else if (frame_class == FrameClass::AUTHENTICATION) {
+        int body = static_cast<int>(sizeof(IEEE80211Header));
+        if (length >= body + 2 && (frame[body] | (frame[body + 1] << 8)) == AUTH_ALGORITHM_SAE) {
+            return FrameClass::SAE;
+        }
+    }
+
+    return frame_class;
+}
+
+FrameClass FrameDispatcher::dispatch(const uint8_t* frame, int length, const RadiotapInfo& radiotap) const {
+    FrameClass frame_class = classify(frame, length);
+
+    const Handler& handler = handlers_[static_cast<size_t>(frame_class)];
+    if (handler) {
+        handler(frame, length, radiotap);
+    }
+    return frame_class;
+}
+
+} // namespace airlevi
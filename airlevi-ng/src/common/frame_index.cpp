@@ -0,0 +1,332 @@
+#include "common/frame_index.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace airlevi {
+
+namespace {
+
+const char* const SIDECAR_SUFFIX = ".alxi";
+
+uint32_t stationHash(const uint8_t* address) {
+    // Broadcast and multicast receivers are not stations
+    return (address[0] & 0x01) ? 0 : FrameIndex::hashAddress(address);
+}
+
+// BSSID and station of a management or data frame, from the DS bits
+void frameAddresses(const uint8_t* frame, int length, uint32_t& bssid, uint32_t& station) {
+    bssid = 0;
+    station = 0;
+    if (length < static_cast<int>(sizeof(IEEE80211Header))) return;
+
+    const uint8_t* addr1 = frame + 4;
+    const uint8_t* addr2 = frame + 10;
+    const uint8_t* addr3 = frame + 16;
+    int type = (frame[0] >> 2) & 0x03;
+
+    if (type == 0) {
+        bssid = FrameIndex::hashAddress(addr3);
+        station = stationHash(memcmp(addr2, addr3, 6) != 0 ? addr2 : addr1);
+    } else if (type == 2) {
+        switch (frame[1] & 0x03) {
+            case 0:   // ad hoc
+                bssid = FrameIndex::hashAddress(addr3);
+                station = stationHash(addr2);
+                break;
+            case 1:   // ToDS
+                bssid = FrameIndex::hashAddress(addr1);
+                station = stationHash(addr2);
+                break;
+            case 2:   // FromDS
+                bssid = FrameIndex::hashAddress(addr2);
+                station = stationHash(addr1);
+                break;
+            default:  // WDS: between two access points
+                bssid = FrameIndex::hashAddress(addr2);
+                break;
+        }
+    }
+}
+
+} // namespace
+
+FrameIndexBuilder::FrameIndexBuilder() : file_(nullptr), frame_count_(0) {}
+
+FrameIndexBuilder::~FrameIndexBuilder() {
+    discard();
+}
+
+bool FrameIndexBuilder::open(const std::string& capture_path) {
+    discard();
+    path_ = FrameIndex::sidecarPath(capture_path);
+    temp_path_ = path_ + ".tmp";
+
+    file_ = fopen(temp_path_.c_str(), "wb");
+    if (!file_) {
+        Logger::getInstance().error("Cannot create frame index: " + temp_path_);
+        return false;
+    }
+    setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+    // Filled in by close()
+    FrameIndexHeader header = {};
+    fwrite(&header, sizeof(header), 1, file_);
+
+    frame_count_ = 0;
+    for (auto& posting : postings_) posting.clear();
+    named_bss_.clear();
+    return true;
+}
+
+void FrameIndexBuilder::add(const CaptureFrame& frame) {
+    if (!file_) return;
+
+    FrameIndexEntry entry = {};
+    entry.offset = frame.offset;
+    entry.timestamp_ns = frame.timestamp_ns;
+    entry.caplen = frame.caplen;
+
+    const uint8_t* packet;
+    uint32_t length;
+    if (CaptureReader::ieee80211Frame(frame, packet, length, unpadded_) && length >= 2) {
+        entry.frame_control = static_cast<uint16_t>(packet[0] | (packet[1] << 8));
+        frameAddresses(packet, static_cast<int>(length), entry.bssid_hash, entry.station_hash);
+        entry.postings = classify(packet, static_cast<int>(length));
+    }
+
+    for (size_t list = 0; list < static_cast<size_t>(FramePosting::COUNT); ++list) {
+        if (entry.postings & (1u << list)) postings_[list].push_back(frame_count_);
+    }
+    fwrite(&entry, sizeof(entry), 1, file_);
+    ++frame_count_;
+}
+
+uint8_t FrameIndexBuilder::classify(const uint8_t* frame, int length) {
+    FrameClass frame_class = dispatcher_.classify(frame, length);
+
+    if (frame_class == FrameClass::EAPOL) {
+        EapolKeyView key;
+        ByteView pmkid;
+        if (!parser_.parseEAPOLFrame(frame, length, key)) return 0;
+        return postingMask(FramePosting::EAPOL) | (key.findPMKID(pmkid) ? postingMask(FramePosting::PMKID) : 0);
+    }
+
+    if (frame_class == FrameClass::BEACON || frame_class == FrameClass::PROBE_RESPONSE) {
+        // Listed again only when the BSS changes its name
+        BeaconView beacon;
+        if (!parser_.parseBeaconFrame(frame, length, beacon) || beacon.ssid.empty()) return 0;
+
+        uint64_t bssid = 0;
+        for (uint8_t byte : beacon.bssid.bytes) bssid = (bssid << 8) | byte;
+        uint64_t ssid = 14695981039346656037ULL;
+        for (size_t i = 0; i < beacon.ssid.size; ++i) {
+            ssid = (ssid ^ beacon.ssid.data[i]) * 1099511628211ULL;
+        }
+
+        auto inserted = named_bss_.emplace(bssid, ssid);
+        if (!inserted.second && inserted.first->second == ssid) return 0;
+        inserted.first->second = ssid;
+        return postingMask(FramePosting::BEACON);
+    }
+
+    if (frame_class == FrameClass::DATA && PacketParser::isWEPDataFrame(frame, length)) {
+        return postingMask(FramePosting::WEP_DATA);
+    }
+    return 0;
+}
+
+bool FrameIndexBuilder::close() {
+    if (!file_) return false;
+
+    std::string capture_path = path_.substr(0, path_.size() - strlen(SIDECAR_SUFFIX));
+    struct stat st;
+    bool ok = stat(capture_path.c_str(), &st) == 0;
+
+    FrameIndexHeader header = {};
+    header.magic = SIDECAR_INDEX_MAGIC;
+    header.version = SIDECAR_INDEX_VERSION;
+    header.capture_size = ok ? static_cast<uint64_t>(st.st_size) : 0;
+    header.frame_count = frame_count_;
+    for (size_t list = 0; list < static_cast<size_t>(FramePosting::COUNT); ++list) {
+        header.posting_counts[list] = postings_[list].size();
+        if (!postings_[list].empty()) {
+            fwrite(postings_[list].data(), sizeof(uint64_t), postings_[list].size(), file_);
+        }
+    }
+
+    ok = ok && fseek(file_, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file_) == 1;
+    ok = fclose(file_) == 0 && ok;
+    file_ = nullptr;
+
+    if (!ok || rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        Logger::getInstance().error("Failed to write frame index: " + path_);
+        unlink(temp_path_.c_str());
+        return false;
+    }
+    return true;
+}
+
+void FrameIndexBuilder::discard() {
+    if (!file_) return;
+    fclose(file_);
+    file_ = nullptr;
+    unlink(temp_path_.c_str());
+}
+
+FrameIndex::FrameIndex() : map_(nullptr), size_(0), header_(nullptr), entries_(nullptr), postings_{} {}
+
+FrameIndex::~FrameIndex() {
+    close();
+}
+
+bool FrameIndex::open(const std::string& capture_path, const CaptureReader& reader) {
+    close();
+
+    std::string path = sidecarPath(capture_path);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(FrameIndexHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    map_ = static_cast<const uint8_t*>(map);
+    size_ = static_cast<uint64_t>(st.st_size);
+    header_ = reinterpret_cast<const FrameIndexHeader*>(map_);
+
+    // The counts must account for the file exactly
+    uint64_t expected = sizeof(FrameIndexHeader);
+    bool valid = header_->magic == SIDECAR_INDEX_MAGIC && header_->version == SIDECAR_INDEX_VERSION &&
+                 header_->frame_count <= size_ / sizeof(FrameIndexEntry);
+    if (valid) {
+        expected += header_->frame_count * sizeof(FrameIndexEntry);
+        for (uint64_t count : header_->posting_counts) {
+            valid = valid && count <= header_->frame_count;
+            expected += count * sizeof(uint64_t);
+        }
+    }
+    if (!valid || expected != size_) {
+        Logger::getInstance().warning("Ignoring malformed frame index: " + path);
+        close();
+        return false;
+    }
+
+    entries_ = reinterpret_cast<const FrameIndexEntry*>(map_ + sizeof(FrameIndexHeader));
+    const uint64_t* posting = reinterpret_cast<const uint64_t*>(entries_ + header_->frame_count);
+    for (size_t list = 0; list < static_cast<size_t>(FramePosting::COUNT); ++list) {
+        postings_[list] = posting;
+        posting += header_->posting_counts[list];
+    }
+
+    // A capture that was replaced or has grown since makes the index stale;
+    // the first and last frames must be where it says
+    bool current = reader.getSize() == header_->capture_size;
+    for (uint64_t number : {uint64_t(0), header_->frame_count - 1}) {
+        CaptureFrame frame;
+        if (!current || header_->frame_count == 0) break;
+        current = reader.frameAt(entries_[number].offset, frame) &&
+                  frame.timestamp_ns == entries_[number].timestamp_ns;
+    }
+    if (!current) {
+        Logger::getInstance().warning("Frame index " + path + " does not match " + capture_path + ", ignoring it");
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FrameIndex::close() {
+    if (map_) {
+        munmap(const_cast<uint8_t*>(map_), static_cast<size_t>(size_));
+    }
+    map_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    entries_ = nullptr;
+    for (auto& posting : postings_) posting = nullptr;
+}
+
+const uint64_t* FrameIndex::posting(FramePosting list, uint64_t& count) const {
+    count = header_ ? header_->posting_counts[static_cast<size_t>(list)] : 0;
+    return postings_[static_cast<size_t>(list)];
+}
+
+std::vector<uint64_t> FrameIndex::find(uint8_t mask, const MacAddress* bssid) const {
+    std::vector<uint64_t> numbers;
+    uint32_t hash = bssid ? hashAddress(bssid->bytes) : 0;
+
+    for (size_t list = 0; list < static_cast<size_t>(FramePosting::COUNT); ++list) {
+        if (!(mask & (1u << list))) continue;
+
+        uint64_t count;
+        const uint64_t* posting = this->posting(static_cast<FramePosting>(list), count);
+        for (uint64_t i = 0; i < count; ++i) {
+            if (posting[i] < header_->frame_count && (!bssid || entries_[posting[i]].bssid_hash == hash)) {
+                numbers.push_back(posting[i]);
+            }
+        }
+    }
+
+    // A frame can be on several lists
+    std::sort(numbers.begin(), numbers.end());
+    numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(numbers.size());
+    for (uint64_t number : numbers) {
+        offsets.push_back(entries_[number].offset);
+    }
+    return offsets;
+}
+
+std::string FrameIndex::sidecarPath(const std::string& capture_path) {
+    return capture_path + SIDECAR_SUFFIX;
+}
+
+uint32_t FrameIndex::hashAddress(const uint8_t* address) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 6; ++i) {
+        hash = (hash ^ address[i]) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+bool loadIndexedFrames(const std::string& capture_path, const CaptureReader& reader, uint8_t mask,
+                       const std::string& bssid, std::vector<CaptureFrame>& frames) {
+    FrameIndex index;
+    if (!index.open(capture_path, reader)) return false;
+
+    MacAddress target;
+    bool filtered = !bssid.empty();
+    if (filtered) {
+        unsigned int b[6];
+        if (std::sscanf(bssid.c_str(), "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+            return false;
+        }
+        for (int i = 0; i < 6; ++i) target.bytes[i] = static_cast<uint8_t>(b[i] & 0xFF);
+    }
+
+    std::vector<uint64_t> offsets = index.find(mask, filtered ? &target : nullptr);
+    frames.clear();
+    frames.reserve(offsets.size());
+    for (uint64_t offset : offsets) {
+        CaptureFrame frame;
+        if (reader.frameAt(offset, frame)) {
+            frames.push_back(frame);
+        }
+    }
+    return true;
+}
+
+} // namespace airlevi
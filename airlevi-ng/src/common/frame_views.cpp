@@ -0,0 +1,104 @@
+#include "common/frame_views.h"
+#include "common/packet_parser.h"
+
+namespace airlevi {
+
+void EapolKeyView::materialize(HandshakePacket& handshake) const {
+    handshake.ap_mac = ap_mac;
+    handshake.client_mac = client_mac;
+    handshake.message_number = message_number;
+    handshake.key_version = key_version;
+    handshake.replay_counter = replay_counter;
+    
+    if (message_number == 1 || message_number == 3) {
+        handshake.anonce = nonce.toVector();
+    } else if (message_number == 2 || message_number == 4) {
+        handshake.snonce = nonce.toVector();
+    }
+    if (!mic.empty()) {
+        handshake.mic = mic.toVector();
+    }
+    handshake.eapol_data = eapol.toVector();
+}
+
+bool EapolKeyView::findPMKID(ByteView& pmkid) const {
+    if (message_number != 1) return false;
+    
+    // KDEs: 0xdd, length, OUI, data type, data
+    size_t pos = 0;
+    while (pos + 2 <= key_data.size) {
+        const uint8_t* element = key_data.data + pos;
+        size_t length = element[1];
+        if (pos + 2 + length > key_data.size) break;
+        
+        if (element[0] == 0xdd && length >= 20 &&
+            element[2] == 0x00 && element[3] == 0x0f && element[4] == 0xac && element[5] == 0x04) {
+            pmkid.data = element + 6;
+            pmkid.size = 16;
+            return true;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+void BeaconView::materialize(WifiNetwork& network) const {
+    PacketParser parser;
+    const uint8_t* ie_start = ies.data;
+    int ie_length = static_cast<int>(ies.size);
+    
+    network.bssid = bssid;
+    if (!has_ssid) {
+        network.essid = "";
+    } else if (ssid.empty()) {
+        network.essid = "<hidden>";
+    } else {
+        network.essid = ssid.toString();
+    }
+    
+    EncryptionType enc_type;
+    parser.extractBeaconElements(ie_start, ie_length, network.channel, enc_type);
+    switch (enc_type) {
+        case EncryptionType::OPEN:
+            network.encryption = "Open";
+            break;
+        case EncryptionType::WEP:
+            network.encryption = "WEP";
+            break;
+        case EncryptionType::WPA:
+            network.encryption = "WPA";
+            break;
+        case EncryptionType::WPA2:
+            network.encryption = "WPA2";
+            break;
+        case EncryptionType::WPA3:
+            network.encryption = "WPA3";
+            break;
+        default:
+            network.encryption = "Unknown";
+            break;
+    }
+    network.last_seen = std::chrono::steady_clock::now();
+}
+
+void SaeCommitView::materialize(SAEHandshakePacket& sae_packet) const {
+    sae_packet.ap_mac = ap_mac;
+    sae_packet.client_mac = client_mac;
+    sae_packet.message_number = 1;
+    sae_packet.finite_field_group = group;
+    sae_packet.scalar = scalar.toVector();
+    sae_packet.element = element.toVector();
+    
+    // Group ID onwards, as the frame carries it
+    sae_packet.raw_data.assign(body.data - 2, body.data + body.size);
+}
+
+void SaeConfirmView::materialize(SAEHandshakePacket& sae_packet) const {
+    sae_packet.ap_mac = ap_mac;
+    sae_packet.client_mac = client_mac;
+    sae_packet.message_number = 2;
+    sae_packet.confirm = confirm.toVector();
+    sae_packet.raw_data = body.toVector();
+}
+
+} // namespace airlevi
@@ -0,0 +1,132 @@
+#include "common/numa_topology.h"
+#include "common/logger.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace airlevi {
+
+NumaTopology::NumaTopology() {
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                continue;
+            }
+
+            std::ifstream cpulist("/sys/devices/system/node/" + name + "/cpulist");
+            std::string list;
+            if (!std::getline(cpulist, list)) continue;
+
+            NumaNode node;
+            node.id = std::stoi(name.substr(4));
+            node.cpus = parseCpuList(list);
+
+            // Memory-only nodes have no CPUs to run workers on
+            if (!node.cpus.empty()) {
+                nodes_.push_back(node);
+            }
+        }
+        closedir(dir);
+    }
+
+    std::sort(nodes_.begin(), nodes_.end(),
+              [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+
+    if (nodes_.empty()) {
+        NumaNode node;
+        node.id = 0;
+        int count = std::max(1u, std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < count; ++cpu) {
+            node.cpus.push_back(cpu);
+        }
+        nodes_.push_back(node);
+    }
+}
+
+std::vector<int> NumaTopology::parseCpuList(const std::string& list) {
+    // Format: "0-3,8-11,16"
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+        try {
+            size_t dash = range.find('-');
+            if (dash == std::string::npos) {
+                cpus.push_back(std::stoi(range));
+            } else {
+                int first = std::stoi(range.substr(0, dash));
+                int last = std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+        } catch (const std::exception&) {
+            // Skip malformed entries
+        }
+    }
+
+    return cpus;
+}
+
+std::vector<int> NumaTopology::distributeThreads(int num_threads) const {
+    std::vector<int> counts(nodes_.size(), 0);
+
+    size_t total_cpus = 0;
+    for (const auto& node : nodes_) {
+        total_cpus += node.cpus.size();
+    }
+
+    // Largest-remainder share so the counts always add up to num_threads
+    int assigned = 0;
+    std::vector<std::pair<double, size_t>> remainders;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        double share = static_cast<double>(num_threads) * nodes_[i].cpus.size() / total_cpus;
+        counts[i] = static_cast<int>(share);
+        assigned += counts[i];
+        remainders.emplace_back(share - counts[i], i);
+    }
+
+    std::sort(remainders.begin(), remainders.end(),
+              [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) {
+                  return a.first > b.first;
+              });
+    for (size_t i = 0; assigned < num_threads; i = (i + 1) % remainders.size()) {
+        counts[remainders[i].second]++;
+        assigned++;
+    }
+
+    return counts;
+}
+
+bool NumaTopology::bindCurrentThread(size_t node_index) const {
+    if (node_index >= nodes_.size()) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : nodes_[node_index].cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        Logger::getInstance().debug("Failed to bind thread to NUMA node " +
+                                  std::to_string(nodes_[node_index].id));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace airlevi
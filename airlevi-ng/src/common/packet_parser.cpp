@@ -1,51 +1,108 @@
 #include "common/packet_parser.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <arpa/inet.h> // For ntohs
+#include <endian.h>    // 802.11 fields are little-endian
 
 namespace airlevi {
 
+namespace {
+
+// Alignment and size of the radiotap namespace fields, indexed by present bit
+struct RadiotapField {
+    uint8_t align;
+    uint8_t size;
+};
+
+const RadiotapField RADIOTAP_FIELDS[] = {
+    {8, 8},    // 0  TSFT
+    {1, 1},    // 1  Flags
+    {1, 1},    // 2  Rate
+    {2, 4},    // 3  Channel
+    {2, 2},    // 4  FHSS
+    {1, 1},    // 5  dBm antenna signal
+    {1, 1},    // 6  dBm antenna noise
+    {2, 2},    // 7  Lock quality
+    {2, 2},    // 8  TX attenuation
+    {2, 2},    // 9  dB TX attenuation
+    {1, 1},    // 10 dBm TX power
+    {1, 1},    // 11 Antenna
+    {1, 1},    // 12 dB antenna signal
+    {1, 1},    // 13 dB antenna noise
+    {2, 2},    // 14 RX flags
+    {2, 2},    // 15 TX flags
+    {1, 1},    // 16 RTS retries
+    {1, 1},    // 17 Data retries
+    {4, 8},    // 18 XChannel
+    {1, 3},    // 19 MCS
+    {4, 8},    // 20 A-MPDU status
+    {2, 12},   // 21 VHT
+    {8, 12},   // 22 Timestamp
+    {2, 12},   // 23 HE
+    {2, 12},   // 24 HE-MU
+    {2, 6},    // 25 HE-MU-other-user
+    {1, 1},    // 26 0-length-PSDU
+    {2, 4},    // 27 L-SIG
+};
+const int RADIOTAP_KNOWN_FIELDS = sizeof(RADIOTAP_FIELDS) / sizeof(RADIOTAP_FIELDS[0]);
+
+const int RADIOTAP_FLAGS = 1;
+const int RADIOTAP_RATE = 2;
+const int RADIOTAP_CHANNEL = 3;
+const int RADIOTAP_DBM_ANTSIGNAL = 5;
+const int RADIOTAP_XCHANNEL = 18;
+
+const uint32_t RADIOTAP_NAMESPACE_BIT = 1u << 29;
+const uint32_t RADIOTAP_VENDOR_NAMESPACE_BIT = 1u << 30;
+const uint32_t RADIOTAP_EXT_BIT = 1u << 31;
+
+const uint8_t RADIOTAP_F_FCS = 0x10;
+const uint8_t RADIOTAP_F_DATAPAD = 0x20;
+const uint8_t RADIOTAP_F_BADFCS = 0x40;
+
+// Radiotap is little-endian whatever the host or capture byte order
+uint16_t radiotap16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+uint32_t radiotap32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
 PacketParser::PacketParser() {}
 
 PacketParser::~PacketParser() {}
 
 bool PacketParser::parseBeaconFrame(const uint8_t* packet, int length, WifiNetwork& network) {
-    if (length < sizeof(BeaconFrame)) return false;
+    BeaconView beacon;
+    if (!parseBeaconFrame(packet, length, beacon)) return false;
     
-    const BeaconFrame* beacon = reinterpret_cast<const BeaconFrame*>(packet);
+    beacon.materialize(network);
+    return true;
+}
+
+bool PacketParser::parseBeaconFrame(const uint8_t* packet, int length, BeaconView& beacon) {
+    if (!packet || length < static_cast<int>(sizeof(BeaconFrame))) return false;
     
-    // Extract BSSID (AP MAC address)
-    network.bssid = MacAddress(beacon->header.addr3.bytes);
+    const BeaconFrame* frame = reinterpret_cast<const BeaconFrame*>(packet);
+    beacon.bssid = MacAddress(frame->header.addr3.bytes);
+    beacon.beacon_interval = le16toh(frame->beacon_interval);
+    beacon.capabilities = le16toh(frame->capabilities);
     
-    // Parse information elements
-    const uint8_t* ie_start = packet + sizeof(BeaconFrame);
-    int ie_length = length - sizeof(BeaconFrame);
+    beacon.ies.data = packet + sizeof(BeaconFrame);
+    beacon.ies.size = length - sizeof(BeaconFrame);
     
-    network.essid = extractSSID(ie_start, ie_length);
-    network.channel = extractChannel(ie_start, ie_length);
-    EncryptionType enc_type = extractEncryption(ie_start, ie_length);
-    switch (enc_type) {
-        case EncryptionType::OPEN:
-            network.encryption = "Open";
-            break;
-        case EncryptionType::WEP:
-            network.encryption = "WEP";
-            break;
-        case EncryptionType::WPA:
-            network.encryption = "WPA";
-            break;
-        case EncryptionType::WPA2:
-            network.encryption = "WPA2";
-            break;
-        case EncryptionType::WPA3:
-            network.encryption = "WPA3";
-            break;
-        default:
-            network.encryption = "Unknown";
-            break;
+    const uint8_t* ssid_ie = findInformationElement(beacon.ies.data, static_cast<int>(beacon.ies.size), 0);
+    beacon.has_ssid = ssid_ie != nullptr;
+    beacon.ssid = ByteView();
+    if (ssid_ie) {
+        beacon.ssid.data = ssid_ie + 2;
+        beacon.ssid.size = ssid_ie[1];
     }
-    network.last_seen = std::chrono::steady_clock::now();
     
     return true;
 }
@@ -74,61 +131,94 @@ bool PacketParser::parseDataFrame(const uint8_t* packet, int length, MacAddress&
 }
 
 bool PacketParser::parseEAPOLFrame(const uint8_t* packet, int length, HandshakePacket& handshake) {
-    if (length < sizeof(IEEE80211Header) + 8) return false; // Minimum EAPOL size
+    EapolKeyView eapol;
+    if (!parseEAPOLFrame(packet, length, eapol)) return false;
+    
+    eapol.materialize(handshake);
+    return true;
+}
+
+bool PacketParser::parseEAPOLFrame(const uint8_t* packet, int length, EapolKeyView& eapol) {
+    if (!packet || length < static_cast<int>(sizeof(IEEE80211Header)) + 8) return false; // Minimum EAPOL size
     
     const IEEE80211Header* header = reinterpret_cast<const IEEE80211Header*>(packet);
-    const uint8_t* eapol_start = packet + sizeof(IEEE80211Header);
+    int header_length = ieee80211HeaderLength(packet);
+    if (length < header_length + 8) return false;
+    const uint8_t* eapol_start = packet + header_length;
     
     // Check for LLC/SNAP header and EAPOL
     if (eapol_start[6] != 0x88 || eapol_start[7] != 0x8e) return false; // EAPOL ethertype
     
     const uint8_t* eapol_packet = eapol_start + 8; // Skip LLC/SNAP
+    int eapol_available = length - header_length - 8;
+    
+    // EAPOL header(4) + descriptor type(1) + key info(2) ... key data length ends at offset 99
+    if (eapol_available < 99) return false;
     
     // EAPOL header: version(1) + type(1) + length(2)
     if (eapol_packet[1] != 0x03) return false; // Key type
     
-    // Extract MAC addresses
-    handshake.ap_mac = MacAddress(header->addr1.bytes);
-    handshake.client_mac = MacAddress(header->addr2.bytes);
+    // The body must itself cover the key descriptor: eapol, MIC and key
+    // data are bounded by it, not by the capture length
+    int eapol_length = (eapol_packet[2] << 8) | eapol_packet[3];
+    if (eapol_length + 4 < 99 || eapol_length + 4 > eapol_available) return false;
+    
+    // Extract MAC addresses: the AP is the transmitter on FromDS frames (M1/M3)
+    // and the receiver on ToDS frames (M2/M4)
+    if (isFromDS(packet)) {
+        eapol.ap_mac = MacAddress(header->addr2.bytes);
+        eapol.client_mac = MacAddress(header->addr1.bytes);
+    } else {
+        eapol.ap_mac = MacAddress(header->addr1.bytes);
+        eapol.client_mac = MacAddress(header->addr2.bytes);
+    }
     
-    // Parse key information
+    // Key information follows the descriptor type and is big-endian
     const uint8_t* key_info = eapol_packet + 4;
-    uint16_t key_info_flags = (key_info[1] << 8) | key_info[0];
+    uint16_t key_info_flags = (key_info[1] << 8) | key_info[2];
+    
+    eapol.key_info = key_info_flags;
+    
+    // Replay counter: 8 bytes, big-endian, after the key length
+    eapol.replay_counter = 0;
+    for (int i = 5; i < 13; ++i) {
+        eapol.replay_counter = (eapol.replay_counter << 8) | key_info[i];
+    }
+    eapol.key_version = static_cast<KeyDescriptorVersion>(key_info_flags & 0x0007);
     
     // Determine message number based on key info flags
     bool install = (key_info_flags & 0x0040) != 0;
     bool ack = (key_info_flags & 0x0080) != 0;
     bool mic = (key_info_flags & 0x0100) != 0;
+    bool secure = (key_info_flags & 0x0200) != 0;
     
+    eapol.message_number = 0;
     if (ack && !install && !mic) {
-        handshake.message_number = 1;
-    } else if (!ack && !install && mic) {
-        handshake.message_number = 2;
+        eapol.message_number = 1;
+    } else if (!ack && !install && mic && !secure) {
+        eapol.message_number = 2;
     } else if (ack && install && mic) {
-        handshake.message_number = 3;
+        eapol.message_number = 3;
     } else if (!ack && !install && mic) {
-        handshake.message_number = 4;
+        eapol.message_number = 4;
     }
     
-    // Extract nonces and MIC
-    if (handshake.message_number == 1 || handshake.message_number == 3) {
-        // ANonce is at offset 13 in key data
-        handshake.anonce.assign(key_info + 13, key_info + 13 + 32);
-    }
+    eapol.eapol.data = eapol_packet;
+    eapol.eapol.size = eapol_length + 4;
     
-    if (handshake.message_number == 2 || handshake.message_number == 4) {
-        // SNonce is at offset 13 in key data
-        handshake.snonce.assign(key_info + 13, key_info + 13 + 32);
-    }
+    // ANonce or SNonce: 32 bytes at offset 13 of the key descriptor
+    eapol.nonce.data = key_info + 13;
+    eapol.nonce.size = eapol.message_number != 0 ? 32 : 0;
     
-    // Extract MIC (16 bytes at offset 77)
-    if (mic) {
-        handshake.mic.assign(key_info + 77, key_info + 77 + 16);
-    }
+    // MIC: 16 bytes at offset 77
+    eapol.mic.data = key_info + 77;
+    eapol.mic.size = mic ? 16 : 0;
     
-    // Store complete EAPOL data
-    int eapol_length = (eapol_packet[2] << 8) | eapol_packet[3];
-    handshake.eapol_data.assign(eapol_packet, eapol_packet + eapol_length + 4);
+    // Key data: length at offset 93, data from offset 95, within the EAPOL body
+    int key_data_length = (key_info[93] << 8) | key_info[94];
+    int key_data_available = eapol_length + 4 - 99;
+    eapol.key_data.data = key_info + 95;
+    eapol.key_data.size = key_data_length <= key_data_available ? key_data_length : 0;
     
     return true;
 }
@@ -187,6 +277,35 @@ EncryptionType PacketParser::extractEncryption(const uint8_t* ie_data, int ie_le
     return EncryptionType::OPEN; // Simplified for now
 }
 
+void PacketParser::extractBeaconElements(const uint8_t* ie_data, int ie_length, int& channel, EncryptionType& encryption) {
+    const uint8_t* rsn_ie = nullptr;
+    const uint8_t* wpa_ie = nullptr;
+    channel = 0;
+    
+    const uint8_t* current = ie_data;
+    const uint8_t* end = ie_data + ie_length;
+    while (current + 2 <= end && current + 2 + current[1] <= end) {
+        uint8_t id = current[0];
+        uint8_t len = current[1];
+        
+        if (id == 3 && len == 1 && channel == 0) {
+            channel = current[2];                        // DS Parameter Set
+        } else if (id == 48 && !rsn_ie) {
+            rsn_ie = current;
+        } else if (id == 221 && !wpa_ie && len >= 4 &&
+                   current[2] == 0x00 && current[3] == 0x50 && current[4] == 0xf2 && current[5] == 0x01) {
+            wpa_ie = current;                            // Microsoft WPA OUI
+        }
+        
+        current += 2 + len;
+    }
+    
+    // RSN takes precedence over WPA, as in extractEncryption()
+    if (rsn_ie && parseRSNInformation(rsn_ie + 2, rsn_ie[1], encryption)) return;
+    if (wpa_ie && parseWPAInformation(wpa_ie + 6, wpa_ie[1] - 4, encryption)) return;
+    encryption = EncryptionType::OPEN;
+}
+
 bool PacketParser::isBeaconFrame(const uint8_t* packet) {
     if (!packet) return false;
     return (packet[0] & 0xfc) == 0x80; // Type: Management, Subtype: Beacon
@@ -203,10 +322,28 @@ bool PacketParser::isEAPOLFrame(const uint8_t* packet) {
     if (!isDataFrame(packet)) return false;
     
     // Check for EAPOL ethertype in LLC/SNAP header
-    const uint8_t* llc_start = packet + sizeof(IEEE80211Header);
+    const uint8_t* llc_start = packet + ieee80211HeaderLength(packet);
     return (llc_start[6] == 0x88 && llc_start[7] == 0x8e);
 }
 
+int PacketParser::ieee80211HeaderLength(const uint8_t* packet) {
+    int length = sizeof(IEEE80211Header);
+    if ((packet[0] & 0x0c) == 0x08) {
+        if ((packet[1] & 0x03) == 0x03) length += 6;    // ToDS and FromDS: addr4
+        if (packet[0] & 0x80) {
+            length += 2;                                 // QoS control
+            if (packet[1] & 0x80) length += 4;           // +HTC
+        }
+    }
+    return length;
+}
+
+bool PacketParser::isWEPDataFrame(const uint8_t* packet, int length) {
+    if (!packet || length < 2 || (packet[0] & 0x0c) != 0x08 || !(packet[1] & 0x40)) return false;
+    int header_length = ieee80211HeaderLength(packet);
+    return length >= header_length + 4 && !(packet[header_length + 3] & 0x20);
+}
+
 bool PacketParser::isDeauthFrame(const uint8_t* packet) {
     if (!packet) return false;
     return (packet[0] & 0xfc) == 0xc0; // Type: Management, Subtype: Deauthentication
@@ -219,7 +356,7 @@ bool PacketParser::isSAEFrame(const uint8_t* packet) {
 
     // Check auth algorithm inside the frame body
     const uint16_t* auth_algo = reinterpret_cast<const uint16_t*>(packet + sizeof(IEEE80211Header));
-    if (ntohs(*auth_algo) != 3) return false; // 3 = SAE
+    if (le16toh(*auth_algo) != 3) return false; // 3 = SAE
 
     return true;
 }
@@ -317,6 +454,76 @@ bool PacketParser::validateFrameChecksum(const uint8_t* packet, int length) {
 }
 
 bool PacketParser::parseSAEFrame(const uint8_t* packet, int length, SAEHandshakePacket& sae_packet) {
+    SaeCommitView commit;
+    if (parseSAEFrame(packet, length, commit)) {
+        commit.materialize(sae_packet);
+        return true;
+    }
+    
+    SaeConfirmView confirm;
+    if (parseSAEFrame(packet, length, confirm)) {
+        confirm.materialize(sae_packet);
+        return true;
+    }
+    
+    return false; // Other sequence numbers are not part of the handshake
+}
+
+bool PacketParser::parseSAEFrame(const uint8_t* packet, int length, SaeCommitView& commit) {
+    const uint8_t* body;
+    int body_length;
+    if (!parseSAEHeader(packet, length, 1, commit.ap_mac, commit.client_mac, commit.status, body, body_length)) {
+        return false;
+    }
+    if (body_length < 2) return false; // Must have at least group ID
+    
+    commit.group = body[0] | (body[1] << 8);
+    commit.body.data = body + 2;
+    commit.body.size = body_length - 2;
+    commit.token = ByteView();
+    commit.scalar = ByteView();
+    commit.element = ByteView();
+    
+    size_t scalar_length, element_length;
+    if (!saeGroupSizes(commit.group, scalar_length, element_length)) return true;
+    if (commit.body.size < scalar_length + element_length) return true;
+    
+    // Bytes beyond scalar and element are either trailing elements (password
+    // identifier, rejected groups: extension IDs) or a leading anti-clogging token
+    size_t extra = commit.body.size - scalar_length - element_length;
+    if (extra > 0) {
+        const uint8_t* tail = commit.body.data + scalar_length + element_length;
+        if (tail[0] != 255 || !elementsSpanExactly(tail, extra)) {
+            commit.token.data = commit.body.data;
+            commit.token.size = extra;
+        }
+    }
+    
+    commit.scalar.data = commit.body.data + commit.token.size;
+    commit.scalar.size = scalar_length;
+    commit.element.data = commit.scalar.data + scalar_length;
+    commit.element.size = element_length;
+    return true;
+}
+
+bool PacketParser::parseSAEFrame(const uint8_t* packet, int length, SaeConfirmView& confirm) {
+    const uint8_t* body;
+    int body_length;
+    if (!parseSAEHeader(packet, length, 2, confirm.ap_mac, confirm.client_mac, confirm.status, body, body_length)) {
+        return false;
+    }
+    
+    confirm.body.data = body;
+    confirm.body.size = body_length;
+    confirm.send_confirm = body_length >= 2 ? (body[0] | (body[1] << 8)) : 0;
+    confirm.confirm.data = body + 2;
+    confirm.confirm.size = body_length > 2 ? body_length - 2 : 0;
+    return true;
+}
+
+bool PacketParser::parseSAEHeader(const uint8_t* packet, int length, uint16_t sequence,
+                                  MacAddress& ap_mac, MacAddress& client_mac, uint16_t& status,
+                                  const uint8_t*& body, int& body_length) {
     struct AuthenticationFrame {
         IEEE80211Header header;
         uint16_t auth_algorithm;
@@ -324,34 +531,257 @@ bool PacketParser::parseSAEFrame(const uint8_t* packet, int length, SAEHandshake
         uint16_t status_code;
     } __attribute__((packed));
 
-    if (length < sizeof(AuthenticationFrame)) return false;
+    if (!packet || length < static_cast<int>(sizeof(AuthenticationFrame))) return false;
 
     const AuthenticationFrame* auth_frame = reinterpret_cast<const AuthenticationFrame*>(packet);
 
-    if (ntohs(auth_frame->auth_algorithm) != 3) return false; // SAE
-
-    sae_packet.ap_mac = MacAddress(auth_frame->header.addr1.bytes);
-    sae_packet.client_mac = MacAddress(auth_frame->header.addr2.bytes);
-    
-    uint16_t seq_num = ntohs(auth_frame->auth_seq);
-    const uint8_t* sae_data = packet + sizeof(AuthenticationFrame);
-    int sae_data_len = length - sizeof(AuthenticationFrame);
-
-    if (seq_num == 1) { // Commit Message
-        sae_packet.message_number = 1;
-        if (sae_data_len < 2) return false; // Must have at least group ID
-        sae_packet.finite_field_group = sae_data[0] | (sae_data[1] << 8);
-        // Simplified parsing: copy the rest of the data
-        sae_packet.raw_data.assign(sae_data, sae_data + sae_data_len);
-    } else if (seq_num == 2) { // Confirm Message
-        sae_packet.message_number = 2;
-        // Simplified parsing: copy the confirm data
-        sae_packet.raw_data.assign(sae_data, sae_data + sae_data_len);
+    if (le16toh(auth_frame->auth_algorithm) != 3) return false; // SAE
+    if (le16toh(auth_frame->auth_seq) != sequence) return false;
+
+    ap_mac = MacAddress(auth_frame->header.addr1.bytes);
+    client_mac = MacAddress(auth_frame->header.addr2.bytes);
+    status = le16toh(auth_frame->status_code);
+    
+    body = packet + sizeof(AuthenticationFrame);
+    body_length = length - static_cast<int>(sizeof(AuthenticationFrame));
+    return true;
+}
+
+bool PacketParser::saeGroupSizes(uint16_t group, size_t& scalar_length, size_t& element_length) {
+    // Scalars are the length of the group order; ECC elements are x || y,
+    // FFC elements one field element
+    struct GroupSizes {
+        uint16_t group;
+        uint16_t scalar;
+        uint16_t element;
+    };
+    static const GroupSizes sizes[] = {
+        {19, 32, 64}, {20, 48, 96}, {21, 66, 132},      // NIST P-256/384/521
+        {25, 24, 48}, {26, 28, 56},                     // NIST P-192/224
+        {28, 32, 64}, {29, 48, 96}, {30, 64, 128},      // Brainpool
+        {15, 384, 384}, {16, 512, 512}, {17, 768, 768}, {18, 1024, 1024},
+        {22, 20, 128}, {23, 28, 256}, {24, 32, 256},
+    };
+    
+    for (const auto& entry : sizes) {
+        if (entry.group == group) {
+            scalar_length = entry.scalar;
+            element_length = entry.element;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PacketParser::elementsSpanExactly(const uint8_t* data, size_t length) {
+    size_t pos = 0;
+    while (pos + 2 <= length) {
+        pos += 2 + data[pos + 1];
+    }
+    return pos == length;
+}
+
+bool PacketParser::parseRadiotap(const uint8_t* packet, int length, RadiotapInfo& info, size_t slot) {
+    if (!packet || length < 8 || packet[0] != 0) return false;
+
+    slot = std::min(slot, MAX_RADIOTAP_SLOTS - 1);
+    if (slot >= radiotap_cache_.size()) {
+        RadiotapLayout empty = {};
+        radiotap_cache_.resize(slot + 1, empty);
+    }
+    RadiotapLayout& cached = radiotap_cache_[slot];
+
+    // Fast path: same it_len and present bitmaps as the previous frame, so
+    // every field sits at the same offset
+    if (cached.key_length > 0 && cached.header_length <= length &&
+        memcmp(packet + 2, cached.key, cached.key_length) == 0) {
+        readRadiotap(packet, cached, info);
+        return true;
+    }
+
+    RadiotapLayout layout;
+    bool cacheable;
+    if (!walkRadiotap(packet, length, layout, cacheable)) return false;
+
+    readRadiotap(packet, layout, info);
+    if (cacheable) {
+        cached = layout;
+    }
+    return true;
+}
+
+bool PacketParser::decodeRadiotap(const uint8_t* packet, int length, RadiotapInfo& info) {
+    RadiotapLayout layout;
+    bool cacheable;
+    if (!packet || !walkRadiotap(packet, length, layout, cacheable)) return false;
+
+    readRadiotap(packet, layout, info);
+    return true;
+}
+
+bool PacketParser::walkRadiotap(const uint8_t* packet, int length, RadiotapLayout& layout, bool& cacheable) {
+    if (length < 8 || packet[0] != 0) return false;
+
+    uint16_t header_length = radiotap16(packet + 2);
+    if (header_length < 8 || header_length > length) return false;
+
+    // Present words chain through their EXT bit
+    int words_end = 4;
+    for (;;) {
+        if (words_end + 4 > header_length) return false;
+        uint32_t present = radiotap32(packet + words_end);
+        words_end += 4;
+        if (!(present & RADIOTAP_EXT_BIT)) break;
+    }
+
+    layout.header_length = header_length;
+    layout.flags = layout.rate = layout.channel = layout.xchannel = layout.signal = 0;
+    cacheable = static_cast<size_t>(words_end - 2) <= MAX_RADIOTAP_KEY;
+
+    // Field offsets are aligned relative to the start of the header
+    int offset = words_end;
+    int bit_base = 0;             // bit 32 of the second word continues bit 31 of the first
+    bool radiotap_namespace = true;
+    bool walkable = true;         // false once a field of unknown size has been met
+
+    for (int word = 4; word < words_end && walkable; word += 4) {
+        uint32_t present = radiotap32(packet + word);
+
+        if (radiotap_namespace) {
+            for (int bit = 0; bit < 29; ++bit) {
+                if (!(present & (1u << bit))) continue;
+
+                int field = bit_base + bit;
+                if (field >= RADIOTAP_KNOWN_FIELDS) {
+                    walkable = false;
+                    break;
+                }
+
+                const RadiotapField& spec = RADIOTAP_FIELDS[field];
+                offset = (offset + spec.align - 1) & ~(spec.align - 1);
+                if (offset + spec.size > header_length) {
+                    walkable = false;
+                    break;
+                }
+
+                // Later namespaces repeat fields per antenna; the first is the combined value
+                uint16_t* slot = nullptr;
+                switch (field) {
+                    case RADIOTAP_FLAGS: slot = &layout.flags; break;
+                    case RADIOTAP_RATE: slot = &layout.rate; break;
+                    case RADIOTAP_CHANNEL: slot = &layout.channel; break;
+                    case RADIOTAP_DBM_ANTSIGNAL: slot = &layout.signal; break;
+                    case RADIOTAP_XCHANNEL: slot = &layout.xchannel; break;
+                }
+                if (slot && *slot == 0) *slot = static_cast<uint16_t>(offset);
+
+                offset += spec.size;
+            }
+            if (!walkable) break;
+        }
+
+        // Namespace switches take effect from the next word
+        if (present & RADIOTAP_VENDOR_NAMESPACE_BIT) {
+            // OUI(3), sub-namespace(1), skip length(2), then the vendor data
+            offset = (offset + 1) & ~1;
+            if (offset + 6 > header_length) break;
+            offset += 6 + radiotap16(packet + offset + 4);
+            radiotap_namespace = false;
+            bit_base = 0;
+            cacheable = false;    // skip lengths live in the data, not the bitmaps
+        } else if (present & RADIOTAP_NAMESPACE_BIT) {
+            radiotap_namespace = true;
+            bit_base = 0;
+        } else {
+            bit_base += 32;
+        }
+    }
+
+    if (cacheable) {
+        layout.key_length = static_cast<uint8_t>(words_end - 2);
+        memcpy(layout.key, packet + 2, layout.key_length);
+    } else {
+        layout.key_length = 0;
+    }
+    return true;
+}
+
+void PacketParser::readRadiotap(const uint8_t* packet, const RadiotapLayout& layout, RadiotapInfo& info) {
+    info.header_length = layout.header_length;
+    info.flags = layout.flags ? packet[layout.flags] : 0;
+    info.rate_kbps = layout.rate ? packet[layout.rate] * 500u : 0;
+
+    info.has_signal = layout.signal != 0;
+    info.signal_dbm = info.has_signal ? static_cast<int8_t>(packet[layout.signal]) : 0;
+
+    if (layout.channel) {
+        info.frequency = radiotap16(packet + layout.channel);
+        info.channel_flags = radiotap16(packet + layout.channel + 2);
+    } else if (layout.xchannel) {
+        // flags(4), frequency(2), channel(1), max power(1)
+        info.frequency = radiotap16(packet + layout.xchannel + 4);
+        info.channel_flags = static_cast<uint16_t>(radiotap32(packet + layout.xchannel));
     } else {
-        return false; // Other sequence numbers are not part of the handshake
+        info.frequency = 0;
+        info.channel_flags = 0;
     }
 
+    info.has_fcs = (info.flags & RADIOTAP_F_FCS) != 0;
+    info.bad_fcs = (info.flags & RADIOTAP_F_BADFCS) != 0;
+    info.data_pad = (info.flags & RADIOTAP_F_DATAPAD) != 0;
+}
+
+bool PacketParser::ieee80211Frame(const uint8_t* packet, int length, int link_type,
+                                  const uint8_t*& frame, int& frame_length, RadiotapInfo* info, size_t slot) {
+    if (!packet) return false;
+
+    if (link_type == DLT_IEEE802_11) {
+        frame = packet;
+        frame_length = length;
+        if (info) *info = RadiotapInfo();
+        return true;
+    }
+
+    if (link_type != DLT_IEEE802_11_RADIO) return false;
+
+    RadiotapInfo radiotap;
+    if (!parseRadiotap(packet, length, radiotap, slot)) return false;
+
+    frame = packet + radiotap.header_length;
+    frame_length = length - radiotap.header_length;
+    if (radiotap.has_fcs) {
+        frame_length -= 4;
+    }
+    if (frame_length < 0) return false;
+
+    if (radiotap.data_pad) {
+        removeDataPad(frame, frame_length, unpadded_);
+    }
+
+    if (info) *info = radiotap;
     return true;
 }
 
+void PacketParser::removeDataPad(const uint8_t*& frame, int& frame_length, std::vector<uint8_t>& unpadded) {
+    // The driver aligned the body to 32 bits: parsers expect it right
+    // behind the MAC header
+    if (frame_length < 2) return;
+    int header_length = ieee80211HeaderLength(frame);
+    int pad = (4 - header_length % 4) % 4;
+    if (pad == 0 || header_length + pad > frame_length) return;
+
+    unpadded.assign(frame, frame + header_length);
+    unpadded.insert(unpadded.end(), frame + header_length + pad, frame + frame_length);
+    frame = unpadded.data();
+    frame_length = static_cast<int>(unpadded.size());
+}
+
+int PacketParser::frequencyToChannel(int frequency) {
+    if (frequency == 2484) return 14;
+    if (frequency >= 2412 && frequency < 2484) return (frequency - 2407) / 5;
+    if (frequency >= 5955 && frequency <= 7115) return (frequency - 5950) / 5;   // 6 GHz
+    if (frequency >= 5000 && frequency < 5955) return (frequency - 5000) / 5;
+    return 0;
+}
+
 } // namespace airlevi
@@ -0,0 +1,654 @@
+#include "common/pcap_writer.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+namespace airlevi {
+
+namespace {
+
+const size_t DIRECT_ALIGNMENT = 4096;   // covers 512-byte and 4K logical sectors
+const int SPINS_BEFORE_YIELD = 64;
+const int WAIT_FOR_ROOM_US = 200;
+
+struct PcapFileHeader {
+    uint32_t magic_number;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t network;
+};
+
+const uint32_t PCAPNG_SECTION_HEADER = 0x0a0d0d0a;
+const uint32_t PCAPNG_INTERFACE_DESCRIPTION = 1;
+const uint32_t PCAPNG_ENHANCED_PACKET = 6;
+const uint32_t PCAPNG_CUSTOM_NO_COPY = 0x40000bad;
+const size_t PCAPNG_PACKET_OVERHEAD = 32;     // block header, EPB fields and trailing length
+
+const uint16_t OPT_END = 0;
+const uint16_t OPT_COMMENT = 1;
+const uint16_t SHB_OS = 3;
+const uint16_t SHB_USERAPPL = 4;
+const uint16_t IF_NAME = 2;
+const uint16_t IF_DESCRIPTION = 3;
+const uint16_t IF_TSRESOL = 9;
+
+// Blocks are built in host byte order, which the section header declares
+void append16(std::vector<uint8_t>& out, uint16_t value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+void append32(std::vector<uint8_t>& out, uint32_t value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+void appendOption(std::vector<uint8_t>& out, uint16_t code, const void* value, size_t length) {
+    length = std::min<size_t>(length, 0xfffc);
+    append16(out, code);
+    append16(out, static_cast<uint16_t>(length));
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    out.insert(out.end(), bytes, bytes + length);
+    out.resize(out.size() + ((4 - length % 4) % 4), 0);
+}
+
+void appendOption(std::vector<uint8_t>& out, uint16_t code, const std::string& value) {
+    if (!value.empty()) {
+        appendOption(out, code, value.data(), value.size());
+    }
+}
+
+size_t beginBlock(std::vector<uint8_t>& out, uint32_t type) {
+    size_t start = out.size();
+    append32(out, type);
+    append32(out, 0);   // total length, patched by endBlock()
+    return start;
+}
+
+void endBlock(std::vector<uint8_t>& out, size_t start) {
+    append16(out, OPT_END);
+    append16(out, 0);
+    uint32_t total_length = static_cast<uint32_t>(out.size() - start + 4);
+    memcpy(&out[start + 4], &total_length, sizeof(total_length));
+    append32(out, total_length);
+}
+
+std::string errnoString(const std::string& what) {
+    return what + ": " + strerror(errno);
+}
+
+} // namespace
+
+PcapWriter::PcapWriter()
+    : open_(false), mask_(0), batch_bytes_(0), reserve_(0), commit_(0), tail_(0),
+      queued_(0), dropped_(0), file_count_(0), stopping_(false), flush_requested_(false), fd_(-1), direct_(false),
+      failed_(false), file_bytes_(0), header_bytes_(0), staging_(nullptr), staging_size_(0), staging_used_(0), direct_offset_(0) {}
+
+PcapWriter::~PcapWriter() {
+    close();
+}
+
+bool PcapWriter::open(const std::string& path, int link_type, const PcapWriterOptions& options) {
+    CaptureInterface interface;
+    interface.link_type = link_type;
+    return open(path, std::vector<CaptureInterface>{interface}, options);
+}
+
+bool PcapWriter::open(const std::string& path, const std::vector<CaptureInterface>& interfaces,
+                      const PcapWriterOptions& options) {
+    close();
+    if (interfaces.empty()) return false;
+    path_ = path;
+    interfaces_ = interfaces;
+    options_ = options;
+    direct_ = options.direct_io;
+    failed_ = false;
+
+    size_t capacity = 1 << 20;
+    while (capacity < std::max<size_t>(options.queue_mb, 1) << 20) {
+        capacity <<= 1;
+    }
+    ring_.assign(capacity, 0);
+    mask_ = capacity - 1;
+    batch_bytes_ = std::min(std::max<size_t>(options.batch_kb, 1) << 10, capacity / 2);
+    reserve_ = 0;
+    commit_ = 0;
+    tail_ = 0;
+    queued_ = 0;
+    dropped_ = 0;
+    file_count_ = 0;
+    pending_index_.clear();
+
+    if (direct_) {
+        staging_size_ = std::max((batch_bytes_ + DIRECT_ALIGNMENT - 1) & ~(DIRECT_ALIGNMENT - 1), 16 * DIRECT_ALIGNMENT);
+        void* buffer = nullptr;
+        if (posix_memalign(&buffer, DIRECT_ALIGNMENT, staging_size_) != 0) {
+            Logger::getInstance().error("Failed to allocate the O_DIRECT staging buffer");
+            return false;
+        }
+        staging_ = static_cast<uint8_t*>(buffer);
+    }
+
+    // The first file is opened here so that the caller sees the failure
+    if (!openFile()) {
+        free(staging_);
+        staging_ = nullptr;
+        ring_.clear();
+        return false;
+    }
+
+    stopping_ = false;
+    flush_requested_ = false;
+    open_ = true;
+    thread_ = std::thread(&PcapWriter::writerLoop, this);
+    return true;
+}
+
+void PcapWriter::close() {
+    if (!open_) return;
+    open_ = false;
+
+    stopping_ = true;
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    closeFile();
+    free(staging_);
+    staging_ = nullptr;
+    ring_.clear();
+    ring_.shrink_to_fit();
+
+    if (dropped_ > 0) {
+        Logger::getInstance().warning("Capture writer dropped " + std::to_string(dropped_.load()) +
+                                      " records while the disk fell behind");
+    }
+}
+
+bool PcapWriter::write(const struct pcap_pkthdr* header, const uint8_t* data, uint32_t interface_id,
+                       IndexedFrameKind kind) {
+    if (!open_) return false;
+
+    bool pcapng = options_.format == CaptureFormat::PCAPNG;
+    uint32_t padded = (header->caplen + 3) & ~3u;
+    uint64_t length = pcapng ? PCAPNG_PACKET_OVERHEAD + padded : sizeof(RecordHeader) + header->caplen;
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t start = reserve_.load(std::memory_order_relaxed);
+    for (;;) {
+        // Free space only grows, so a record that does not fit now is dropped
+        // rather than waited for, unless the caller can afford to wait
+        if (start + length - tail > ring_.size()) {
+            tail = tail_.load(std::memory_order_acquire);
+            if (start + length - tail > ring_.size()) {
+                if (!options_.wait_when_full || length > ring_.size()) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                flush();
+                std::this_thread::sleep_for(std::chrono::microseconds(WAIT_FOR_ROOM_US));
+                start = reserve_.load(std::memory_order_relaxed);
+                continue;
+            }
+        }
+        if (reserve_.compare_exchange_weak(start, start + length, std::memory_order_relaxed)) break;
+    }
+
+    if (pcapng) {
+        // Enhanced Packet Block with microsecond timestamps (if_tsresol 6)
+        uint64_t timestamp = static_cast<uint64_t>(header->ts.tv_sec) * 1000000 + header->ts.tv_usec;
+        uint32_t total_length = static_cast<uint32_t>(length);
+        uint32_t block[7] = {
+            PCAPNG_ENHANCED_PACKET, total_length,
+            interface_id < interfaces_.size() ? interface_id : 0,
+            static_cast<uint32_t>(timestamp >> 32), static_cast<uint32_t>(timestamp),
+            header->caplen, header->len
+        };
+        static const uint8_t zeros[4] = {0, 0, 0, 0};
+        copyIn(start, block, sizeof(block));
+        copyIn(start + sizeof(block), data, header->caplen);
+        copyIn(start + sizeof(block) + header->caplen, zeros, padded - header->caplen);
+        copyIn(start + sizeof(block) + padded, &total_length, sizeof(total_length));
+
+        if (kind != IndexedFrameKind::NONE) {
+            // Before the commit, so the writer sees it with the record
+            std::lock_guard<std::mutex> lock(index_mutex_);
+            pending_index_.emplace_back(start, kind);
+        }
+    } else {
+        RecordHeader record;
+        record.ts_sec = static_cast<uint32_t>(header->ts.tv_sec);
+        record.ts_usec = static_cast<uint32_t>(header->ts.tv_usec);
+        record.caplen = header->caplen;
+        record.len = header->len;
+        copyIn(start, &record, sizeof(record));
+        copyIn(start + sizeof(record), data, header->caplen);
+    }
+
+    // Publish in reservation order; the wait is the earlier producers' memcpy
+    for (int spins = 0; commit_.load(std::memory_order_acquire) != start; ++spins) {
+        if (spins >= SPINS_BEFORE_YIELD) std::this_thread::yield();
+    }
+    commit_.store(start + length, std::memory_order_release);
+    queued_.fetch_add(1, std::memory_order_relaxed);
+
+    // Wake the writer when this record crosses the batch threshold. There is
+    // no lock, so a wakeup can be missed; the flush interval bounds the delay.
+    if (start - tail < batch_bytes_ && start + length - tail >= batch_bytes_) {
+        wake_.notify_one();
+    }
+    return true;
+}
+
+void PcapWriter::flush() {
+    if (!open_) return;
+    flush_requested_ = true;
+    wake_.notify_one();
+}
+
+std::string PcapWriter::rotatedPath(const std::string& path, int index) {
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "-%05d", index);
+
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1) {
+        return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+void PcapWriter::writerLoop() {
+    std::chrono::milliseconds interval(std::max(options_.flush_interval_ms, 1));
+
+    while (!stopping_) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait_for(lock, interval, [this] {
+                return stopping_ || flush_requested_ ||
+                       commit_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed) >= batch_bytes_;
+            });
+        }
+        flush_requested_ = false;
+        drain();
+    }
+
+    // Producers have stopped before close(); take whatever they left
+    drain();
+}
+
+void PcapWriter::drain() {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t commit = commit_.load(std::memory_order_acquire);
+
+    while (tail < commit) {
+        if (failed_) {
+            // Keep consuming so that producers never stall on a dead disk
+            collectIndex(tail, commit, 0);
+            file_index_.clear();
+            tail = commit;
+            break;
+        }
+
+        if (fd_ >= 0 && rotationDue()) {
+            closeFile();
+        }
+        if (fd_ < 0 && !openFile()) {
+            failed_ = true;
+            continue;
+        }
+
+        uint64_t end = commit;
+        bool file_full = false;
+        uint64_t limit = options_.rotate_size_mb << 20;
+        if (limit > 0 && file_bytes_ + (end - tail) > limit) {
+            end = cutForRotation(tail, commit);
+            file_full = true;
+        }
+
+        // At most two pieces: the span may wrap around the end of the ring
+        struct iovec iov[2];
+        int count = 0;
+        uint64_t offset = tail & mask_;
+        size_t first = static_cast<size_t>(std::min<uint64_t>(end - tail, ring_.size() - offset));
+        iov[count].iov_base = &ring_[offset];
+        iov[count++].iov_len = first;
+        if (first < end - tail) {
+            iov[count].iov_base = &ring_[0];
+            iov[count++].iov_len = static_cast<size_t>(end - tail - first);
+        }
+
+        collectIndex(tail, end, file_bytes_);
+        if (sidecar_.isOpen()) {
+            indexRecords(tail, end, file_bytes_);
+        }
+        if (!writeOut(iov, count)) {
+            failed_ = true;
+            closeFile();
+        }
+        file_bytes_ += end - tail;
+        tail = end;
+        tail_.store(tail, std::memory_order_release);
+
+        if (file_full) {
+            closeFile();
+        }
+    }
+
+    tail_.store(tail, std::memory_order_release);
+
+    // Direct I/O holds back the partial last block; write it padded so that
+    // a flush reaches the disk, and rewrite it once it fills up
+    if (direct_ && fd_ >= 0 && !writeStaging(true)) {
+        failed_ = true;
+        closeFile();
+    }
+}
+
+bool PcapWriter::openFile() {
+    int index = ++file_count_;
+    bool rotating = options_.rotate_size_mb > 0 || options_.rotate_seconds > 0;
+    std::string path = rotating ? rotatedPath(path_, index) : path_;
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    fd_ = ::open(path.c_str(), flags | (direct_ ? O_DIRECT : 0), 0644);
+    if (fd_ < 0 && direct_ && errno == EINVAL) {
+        // tmpfs and some network filesystems refuse O_DIRECT
+        Logger::getInstance().warning("O_DIRECT is not supported for " + path + ", writing through the page cache");
+        direct_ = false;
+        fd_ = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd_ < 0) {
+        Logger::getInstance().error(errnoString("Failed to open output file " + path));
+        return false;
+    }
+
+    file_path_ = path;
+    file_bytes_ = 0;
+    file_opened_ = std::chrono::steady_clock::now();
+    file_index_.clear();
+    staging_used_ = 0;
+    direct_offset_ = 0;
+
+    std::vector<uint8_t> header = fileHeader();
+    struct iovec iov = {header.data(), header.size()};
+    if (!writeOut(&iov, 1)) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    file_bytes_ = header_bytes_ = header.size();
+
+    // Without its sidecar the capture is still fine, only slower to search
+    if (options_.sidecar_index) {
+        sidecar_.open(path);
+    }
+
+    Logger::getInstance().info("Output file opened: " + path);
+    return true;
+}
+
+void PcapWriter::closeFile() {
+    if (fd_ < 0) return;
+
+    if (options_.format == CaptureFormat::PCAPNG && !failed_ && !writeIndex()) {
+        failed_ = true;
+    }
+
+    if (direct_) {
+        // The last block went out padded; cut the file back to its real length
+        writeStaging(true);
+        if (ftruncate(fd_, static_cast<off_t>(direct_offset_ + staging_used_)) != 0) {
+            Logger::getInstance().error(errnoString("Failed to truncate output file"));
+        }
+    }
+    ::close(fd_);
+    fd_ = -1;
+
+    if (sidecar_.isOpen()) {
+        if (failed_) {
+            sidecar_.discard();
+        } else {
+            sidecar_.close();
+        }
+    }
+}
+
+bool PcapWriter::rotationDue() const {
+    if (options_.rotate_seconds <= 0 || file_bytes_ <= header_bytes_) return false;
+    return std::chrono::steady_clock::now() - file_opened_ >= std::chrono::seconds(options_.rotate_seconds);
+}
+
+uint64_t PcapWriter::recordLength(uint64_t position) const {
+    if (options_.format == CaptureFormat::PCAPNG) {
+        uint32_t total_length;
+        copyOut(position + 4, &total_length, sizeof(total_length));
+        return total_length;
+    }
+    RecordHeader record;
+    copyOut(position, &record, sizeof(record));
+    return sizeof(record) + record.caplen;
+}
+
+uint64_t PcapWriter::cutForRotation(uint64_t begin, uint64_t end) const {
+    // Walk the record headers for the longest prefix that still fits; a file
+    // always takes at least one record
+    uint64_t limit = options_.rotate_size_mb << 20;
+    uint64_t position = begin;
+    while (position < end) {
+        uint64_t next = position + recordLength(position);
+        if (position != begin && file_bytes_ + (next - begin) > limit) break;
+        position = next;
+    }
+    return position;
+}
+
+std::vector<uint8_t> PcapWriter::fileHeader() const {
+    std::vector<uint8_t> out;
+    const CaptureInterface& first = interfaces_.front();
+
+    if (options_.format == CaptureFormat::PCAP) {
+        PcapFileHeader header = {0xa1b2c3d4, 2, 4, 0, 0, first.snaplen, static_cast<uint32_t>(first.link_type)};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+        out.assign(bytes, bytes + sizeof(header));
+        return out;
+    }
+
+    size_t section = beginBlock(out, PCAPNG_SECTION_HEADER);
+    append32(out, 0x1a2b3c4d);     // byte-order magic
+    append16(out, 1);
+    append16(out, 0);
+    append32(out, 0xffffffff);     // section length unknown
+    append32(out, 0xffffffff);
+    appendOption(out, OPT_COMMENT, options_.comment);
+    struct utsname system;
+    if (uname(&system) == 0) {
+        appendOption(out, SHB_OS, std::string(system.sysname) + " " + system.release);
+    }
+    appendOption(out, SHB_USERAPPL, options_.application);
+    endBlock(out, section);
+
+    for (const CaptureInterface& interface : interfaces_) {
+        size_t block = beginBlock(out, PCAPNG_INTERFACE_DESCRIPTION);
+        append16(out, static_cast<uint16_t>(interface.link_type));
+        append16(out, 0);
+        append32(out, interface.snaplen);
+        appendOption(out, IF_NAME, interface.name);
+        appendOption(out, IF_DESCRIPTION, interface.description);
+        uint8_t resolution = 6;
+        appendOption(out, IF_TSRESOL, &resolution, 1);
+        endBlock(out, block);
+    }
+    return out;
+}
+
+void PcapWriter::collectIndex(uint64_t begin, uint64_t end, uint64_t file_offset) {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    if (pending_index_.empty()) return;
+
+    size_t kept = 0;
+    for (const auto& entry : pending_index_) {
+        if (entry.first < end) {
+            file_index_.push_back(IndexedFrame{file_offset + (entry.first - begin), entry.second});
+        } else {
+            pending_index_[kept++] = entry;
+        }
+    }
+    pending_index_.resize(kept);
+}
+
+bool PcapWriter::writeIndex() {
+    std::sort(file_index_.begin(), file_index_.end(), [](const IndexedFrame& a, const IndexedFrame& b) {
+        return a.offset < b.offset;
+    });
+
+    // Layout read back by CaptureReader::readFrameIndex()
+    std::vector<uint8_t> out;
+    append32(out, PCAPNG_CUSTOM_NO_COPY);
+    append32(out, static_cast<uint32_t>(28 + 16 * file_index_.size()));
+    append32(out, PCAPNG_INDEX_PEN);
+    append32(out, PCAPNG_INDEX_MAGIC);
+    append32(out, PCAPNG_INDEX_VERSION);
+    append32(out, static_cast<uint32_t>(file_index_.size()));
+    for (const IndexedFrame& frame : file_index_) {
+        append32(out, static_cast<uint32_t>(frame.offset));
+        append32(out, static_cast<uint32_t>(frame.offset >> 32));
+        append32(out, static_cast<uint32_t>(frame.kind));
+        append32(out, 0);
+    }
+    append32(out, static_cast<uint32_t>(out.size() + 4));
+
+    struct iovec iov = {out.data(), out.size()};
+    file_index_.clear();
+    return writeOut(&iov, 1);
+}
+
+void PcapWriter::indexRecords(uint64_t begin, uint64_t end, uint64_t file_offset) {
+    // Decodes the records back from the ring as they go to the file, so the
+    // capture threads never see the sidecar
+    bool pcapng = options_.format == CaptureFormat::PCAPNG;
+    size_t header_length = pcapng ? PCAPNG_PACKET_OVERHEAD - 4 : sizeof(RecordHeader);
+
+    for (uint64_t position = begin; position < end; position += recordLength(position)) {
+        uint32_t fields[7];
+        copyOut(position, fields, header_length);
+
+        CaptureFrame frame;
+        if (pcapng) {
+            uint32_t interface_id = fields[2] < interfaces_.size() ? fields[2] : 0;
+            frame.link_type = static_cast<uint32_t>(interfaces_[interface_id].link_type);
+            frame.interface_id = interface_id;
+            frame.timestamp_ns = ((static_cast<uint64_t>(fields[3]) << 32) | fields[4]) * 1000;
+            frame.caplen = fields[5];
+            frame.len = fields[6];
+        } else {
+            frame.link_type = static_cast<uint32_t>(interfaces_.front().link_type);
+            frame.interface_id = 0;
+            frame.timestamp_ns = static_cast<uint64_t>(fields[0]) * 1000000000ULL + fields[1] * 1000ULL;
+            frame.caplen = fields[2];
+            frame.len = fields[3];
+        }
+        frame.offset = file_offset + (position - begin);
+
+        size_t data = static_cast<size_t>((position + header_length) & mask_);
+        if (data + frame.caplen <= ring_.size()) {
+            frame.data = &ring_[data];
+        } else {
+            record_copy_.resize(frame.caplen);
+            copyOut(position + header_length, record_copy_.data(), frame.caplen);
+            frame.data = record_copy_.data();
+        }
+        sidecar_.add(frame);
+    }
+}
+
+void PcapWriter::copyIn(uint64_t position, const void* data, size_t length) {
+    size_t offset = static_cast<size_t>(position & mask_);
+    size_t first = std::min(length, ring_.size() - offset);
+    memcpy(&ring_[offset], data, first);
+    memcpy(&ring_[0], static_cast<const uint8_t*>(data) + first, length - first);
+}
+
+void PcapWriter::copyOut(uint64_t position, void* data, size_t length) const {
+    size_t offset = static_cast<size_t>(position & mask_);
+    size_t first = std::min(length, ring_.size() - offset);
+    memcpy(data, &ring_[offset], first);
+    memcpy(static_cast<uint8_t*>(data) + first, &ring_[0], length - first);
+}
+
+bool PcapWriter::writeOut(struct iovec* iov, int count) {
+    if (direct_) {
+        for (int i = 0; i < count; ++i) {
+            const uint8_t* data = static_cast<const uint8_t*>(iov[i].iov_base);
+            size_t length = iov[i].iov_len;
+            while (length > 0) {
+                size_t chunk = std::min(length, staging_size_ - staging_used_);
+                memcpy(staging_ + staging_used_, data, chunk);
+                staging_used_ += chunk;
+                data += chunk;
+                length -= chunk;
+                if (staging_used_ == staging_size_ && !writeStaging(false)) return false;
+            }
+        }
+        return true;
+    }
+
+    while (count > 0) {
+        ssize_t written = ::writev(fd_, iov, std::min(count, IOV_MAX));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            Logger::getInstance().error(errnoString("Failed to write capture"));
+            return false;
+        }
+
+        // Short write: skip what went out and retry the rest
+        size_t remaining = static_cast<size_t>(written);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+bool PcapWriter::writeStaging(bool pad) {
+    size_t whole = staging_used_ & ~(DIRECT_ALIGNMENT - 1);
+    size_t length = whole;
+    if (pad && staging_used_ > whole) {
+        memset(staging_ + staging_used_, 0, whole + DIRECT_ALIGNMENT - staging_used_);
+        length = whole + DIRECT_ALIGNMENT;
+    }
+
+    size_t done = 0;
+    while (done < length) {
+        ssize_t written = pwrite(fd_, staging_ + done, length - done, static_cast<off_t>(direct_offset_ + done));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            Logger::getInstance().error(errnoString("Failed to write capture"));
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+
+    // Whole blocks are final; a padded partial block stays to be rewritten
+    memmove(staging_, staging_ + whole, staging_used_ - whole);
+    staging_used_ -= whole;
+    direct_offset_ += whole;
+    return true;
+}
+
+} // namespace airlevi
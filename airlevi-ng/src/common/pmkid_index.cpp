@@ -0,0 +1,120 @@
+#include "common/pmkid_index.h"
+#include "common/sha1_lanes.h"
+#include <algorithm>
+#include <cstring>
+
+namespace airlevi {
+
+size_t PMKIDIndex::add(const std::string& essid, const MacAddress& ap_mac,
+                       const MacAddress& client_mac, const uint8_t* pmkid) {
+    Bucket& bucket = buckets_[essid];
+
+    std::string key(reinterpret_cast<const char*>(ap_mac.bytes), 6);
+    key.append(reinterpret_cast<const char*>(client_mac.bytes), 6);
+    key.append(reinterpret_cast<const char*>(pmkid), 16);
+
+    auto it = bucket.lookup.find(key);
+    if (it != bucket.lookup.end()) {
+        return it->second;
+    }
+
+    size_t slot = bucket.ids.size();
+    if (slot % LANES == 0) {
+        bucket.blocks.resize(bucket.blocks.size() + 16 * LANES, 0);
+        bucket.expected.resize(bucket.expected.size() + 4 * LANES, 0);
+    }
+
+    // "PMK Name" || AA || SPA, padded as the inner message after the ipad block
+    uint8_t message[64] = {0};
+    memcpy(message, "PMK Name", 8);
+    memcpy(message + 8, ap_mac.bytes, 6);
+    memcpy(message + 14, client_mac.bytes, 6);
+    message[20] = 0x80;
+    storeBE32(message + 60, (64 + 20) * 8);
+
+    size_t group = slot / LANES;
+    size_t lane = slot % LANES;
+    for (int w = 0; w < 16; ++w) {
+        bucket.blocks[(group * 16 + w) * LANES + lane] = loadBE32(message + w * 4);
+    }
+    for (int w = 0; w < 4; ++w) {
+        bucket.expected[(group * 4 + w) * LANES + lane] = loadBE32(pmkid + w * 4);
+    }
+
+    size_t id = count_++;
+    bucket.ids.push_back(id);
+    bucket.lookup.emplace(key, id);
+    return id;
+}
+
+std::vector<std::string> PMKIDIndex::getESSIDs() const {
+    std::vector<std::string> essids;
+    for (const auto& pair : buckets_) {
+        essids.push_back(pair.first);
+    }
+    return essids;
+}
+
+void PMKIDIndex::match(const std::string& essid, const uint8_t* pmk, std::vector<size_t>& matches) const {
+    auto it = buckets_.find(essid);
+    if (it == buckets_.end()) {
+        return;
+    }
+    const Bucket& bucket = it->second;
+
+    // HMAC key schedule, once per PMK
+    uint8_t key[64] = {0};
+    memcpy(key, pmk, 32);
+    uint32_t ipad[16][1], opad[16][1];
+    uint32_t istate[5][1], ostate[5][1];
+    for (int w = 0; w < 16; ++w) {
+        uint32_t word = loadBE32(key + w * 4);
+        ipad[w][0] = word ^ 0x36363636;
+        opad[w][0] = word ^ 0x5c5c5c5c;
+    }
+    for (int i = 0; i < 5; ++i) {
+        istate[i][0] = kSha1Init[i];
+        ostate[i][0] = kSha1Init[i];
+    }
+    sha1Compress<1>(istate, ipad);
+    sha1Compress<1>(ostate, opad);
+
+    size_t groups = (bucket.ids.size() + LANES - 1) / LANES;
+    for (size_t g = 0; g < groups; ++g) {
+        const uint32_t (*block)[LANES] = reinterpret_cast<const uint32_t (*)[LANES]>(&bucket.blocks[g * 16 * LANES]);
+        const uint32_t (*expected)[LANES] = reinterpret_cast<const uint32_t (*)[LANES]>(&bucket.expected[g * 4 * LANES]);
+
+        uint32_t inner[5][LANES];
+        for (int i = 0; i < 5; ++i)
+            for (int l = 0; l < LANES; ++l) inner[i][l] = istate[i][0];
+        sha1Compress<LANES>(inner, block);
+
+        uint32_t outer_block[16][LANES];
+        uint32_t outer[5][LANES];
+        for (int l = 0; l < LANES; ++l) {
+            for (int i = 0; i < 5; ++i) outer_block[i][l] = inner[i][l];
+            outer_block[5][l] = 0x80000000;
+            for (int i = 6; i < 15; ++i) outer_block[i][l] = 0;
+            outer_block[15][l] = (64 + 20) * 8;
+        }
+        for (int i = 0; i < 5; ++i)
+            for (int l = 0; l < LANES; ++l) outer[i][l] = ostate[i][0];
+        sha1Compress<LANES>(outer, outer_block);
+
+        uint32_t diff[LANES];
+        for (int l = 0; l < LANES; ++l) {
+            diff[l] = (outer[0][l] ^ expected[0][l]) | (outer[1][l] ^ expected[1][l]) |
+                      (outer[2][l] ^ expected[2][l]) | (outer[3][l] ^ expected[3][l]);
+        }
+
+        // Only lanes that hold an entry count; the tail of the last group is padding
+        size_t valid = std::min<size_t>(LANES, bucket.ids.size() - g * LANES);
+        for (size_t l = 0; l < valid; ++l) {
+            if (diff[l] == 0) {
+                matches.push_back(bucket.ids[g * LANES + l]);
+            }
+        }
+    }
+}
+
+} // namespace airlevi
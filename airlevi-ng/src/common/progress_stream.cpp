@@ -0,0 +1,187 @@
+#include "common/progress_stream.h"
+#include "common/logger.h"
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace airlevi {
+
+ProgressEvent::ProgressEvent(const std::string& type) : type_(type) {}
+
+ProgressEvent& ProgressEvent::add(const std::string& key, const std::string& value) {
+    return raw(key, "\"" + escape(value) + "\"");
+}
+
+ProgressEvent& ProgressEvent::add(const std::string& key, double value) {
+    if (!std::isfinite(value)) {
+        return raw(key, "null");
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3f", value);
+    return raw(key, buffer);
+}
+
+ProgressEvent& ProgressEvent::raw(const std::string& key, const std::string& json) {
+    fields_ += ",\"" + escape(key) + "\":" + json;
+    return *this;
+}
+
+std::string ProgressEvent::escape(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                } else {
+                    escaped += static_cast<char>(c);
+                }
+        }
+    }
+    return escaped;
+}
+
+ProgressStream& ProgressStream::getInstance() {
+    static ProgressStream instance;
+    return instance;
+}
+
+ProgressStream::ProgressStream()
+    : enabled_(false), interval_ns_(1000000000LL), next_due_ns_(0), dropped_(0),
+      fd_(-1), owns_fd_(false), stopping_(false) {}
+
+ProgressStream::~ProgressStream() {
+    close();
+}
+
+bool ProgressStream::open(const std::string& target, const std::string& tool) {
+    close();
+
+    if (target.compare(0, 3, "fd:") == 0) {
+        char* end = nullptr;
+        long fd = strtol(target.c_str() + 3, &end, 10);
+        if (end == target.c_str() + 3 || *end != '\0' || fd < 0 || fcntl(fd, F_GETFD) == -1) {
+            Logger::getInstance().error("Invalid progress stream descriptor: " + target);
+            return false;
+        }
+        fd_ = static_cast<int>(fd);
+        owns_fd_ = false;
+    } else {
+        fd_ = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            Logger::getInstance().error("Cannot open progress stream: " + target);
+            return false;
+        }
+        owns_fd_ = true;
+    }
+
+    // A scheduler closing its end must not kill the run with SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+
+    tool_ = tool;
+    stopping_ = false;
+    dropped_ = 0;
+    next_due_ns_ = 0;
+    writer_ = std::thread(&ProgressStream::writerThread, this);
+    enabled_ = true;
+    return true;
+}
+
+void ProgressStream::close() {
+    if (!enabled_) return;
+    enabled_ = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    if (owns_fd_) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+}
+
+bool ProgressStream::progressDue() {
+    if (!enabled_) return false;
+
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    long long due = next_due_ns_.load(std::memory_order_relaxed);
+    if (now < due) return false;
+
+    // Exactly one caller wins each interval
+    return next_due_ns_.compare_exchange_strong(due, now + interval_ns_.load(std::memory_order_relaxed));
+}
+
+void ProgressStream::emit(const ProgressEvent& event, bool droppable) {
+    if (!enabled_) return;
+
+    double ts = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    char stamp[32];
+    snprintf(stamp, sizeof(stamp), "%.3f", ts);
+
+    std::string line = "{\"event\":\"" + ProgressEvent::escape(event.getType()) + "\",\"tool\":\"" +
+                       ProgressEvent::escape(tool_) + "\",\"ts\":" + stamp + event.getFields() + "}\n";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (droppable && queue_.size() >= MAX_QUEUED) {
+        dropped_++;
+        return;
+    }
+    queue_.push_back(std::move(line));
+    cv_.notify_one();
+}
+
+void ProgressStream::writerThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty() && stopping_) break;
+
+        std::string data;
+        while (!queue_.empty()) {
+            data += queue_.front();
+            queue_.pop_front();
+        }
+
+        lock.unlock();
+        writeAll(data);
+        lock.lock();
+    }
+}
+
+void ProgressStream::writeAll(const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd_, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                usleep(1000);
+                continue;
+            }
+            // Consumer went away; keep the tool running without its stream
+            return;
+        }
+        written += n;
+    }
+}
+
+} // namespace airlevi
@@ -0,0 +1,329 @@
+#include "common/ring_capture.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+namespace airlevi {
+
+namespace {
+
+const int POLL_INTERVAL_MS = 100;   // how often an idle worker checks for stop()
+const uint32_t FRAME_SIZE = 2048;   // only used to size the request; V3 packs frames
+
+std::atomic<uint16_t> next_fanout_group(0);
+
+int linkTypeFor(unsigned short hardware_type) {
+    switch (hardware_type) {
+        case ARPHRD_IEEE80211: return DLT_IEEE802_11;
+        case ARPHRD_IEEE80211_RADIOTAP: return DLT_IEEE802_11_RADIO;
+        case ARPHRD_IEEE80211_PRISM: return DLT_PRISM_HEADER;
+        case ARPHRD_ETHER:
+        case ARPHRD_LOOPBACK: return DLT_EN10MB;
+        default: return -1;
+    }
+}
+
+std::string errnoString(const std::string& what) {
+    return what + ": " + strerror(errno);
+}
+
+} // namespace
+
+RingCapture::RingCapture()
+    : link_type_(-1), block_size_(0), fanout_group_(0), running_(false), interface_drops_at_open_(0) {}
+
+RingCapture::~RingCapture() {
+    close();
+}
+
+bool RingCapture::open(const std::string& interface, const RingOptions& options) {
+    close();
+    interface_ = interface;
+
+    int ifindex = if_nametoindex(interface.c_str());
+    if (ifindex == 0) {
+        Logger::getInstance().error(errnoString("Unknown interface " + interface));
+        return false;
+    }
+
+    // Whole pages, and at least two frames per block
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    block_size_ = (std::max<size_t>(options.block_size_kb * 1024, 2 * FRAME_SIZE) + page - 1) / page * page;
+
+    // Fanout group ids are per network namespace
+    fanout_group_ = static_cast<uint16_t>(getpid() ^ (next_fanout_group++ << 12));
+
+    workers_.resize(std::max(options.workers, 1));
+    for (Worker& worker : workers_) {
+        if (!openSocket(worker, ifindex, options) || (workers_.size() > 1 && !joinFanout(worker, options))) {
+            close();
+            return false;
+        }
+    }
+
+    counters_ = CaptureCounters();
+    interface_drops_at_open_ = readInterfaceDrops(interface);
+
+    Logger::getInstance().info("Capture ring on " + interface + ": " + std::to_string(workers_.size()) + " x " +
+                               std::to_string(workers_[0].block_count * block_size_ >> 20) + " MiB");
+    return true;
+}
+
+bool RingCapture::openSocket(Worker& worker, int ifindex, const RingOptions& options) {
+    worker.fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (worker.fd < 0) {
+        Logger::getInstance().error(errnoString("Failed to open packet socket"));
+        return false;
+    }
+
+    if (link_type_ < 0) {
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, interface_.c_str(), IFNAMSIZ - 1);
+        if (ioctl(worker.fd, SIOCGIFHWADDR, &ifr) < 0) {
+            Logger::getInstance().error(errnoString("Failed to read the link type of " + interface_));
+            return false;
+        }
+        link_type_ = linkTypeFor(ifr.ifr_hwaddr.sa_family);
+        if (link_type_ < 0) {
+            Logger::getInstance().error("Unsupported link type " + std::to_string(ifr.ifr_hwaddr.sa_family) +
+                                        " on " + interface_);
+            return false;
+        }
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(worker.fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        Logger::getInstance().error(errnoString("TPACKET_V3 not supported"));
+        return false;
+    }
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = static_cast<unsigned int>(block_size_);
+    req.tp_block_nr = static_cast<unsigned int>(std::max<size_t>(options.ring_size_mb * 1024 * 1024 / block_size_, 2));
+    req.tp_frame_size = FRAME_SIZE;
+    req.tp_frame_nr = req.tp_block_size / req.tp_frame_size * req.tp_block_nr;
+    req.tp_retire_blk_tov = static_cast<unsigned int>(options.block_timeout_ms);
+    if (setsockopt(worker.fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        Logger::getInstance().error(errnoString("Failed to set up the capture ring"));
+        return false;
+    }
+    worker.block_count = req.tp_block_nr;
+
+    void* ring = mmap(nullptr, worker.block_count * block_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, worker.fd, 0);
+    if (ring == MAP_FAILED) {
+        Logger::getInstance().error(errnoString("Failed to map the capture ring"));
+        return false;
+    }
+    worker.ring = static_cast<uint8_t*>(ring);
+
+    struct sockaddr_ll address;
+    memset(&address, 0, sizeof(address));
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(ETH_P_ALL);
+    address.sll_ifindex = ifindex;
+    if (bind(worker.fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        Logger::getInstance().error(errnoString("Failed to bind to " + interface_));
+        return false;
+    }
+
+    struct packet_mreq membership;
+    memset(&membership, 0, sizeof(membership));
+    membership.mr_ifindex = ifindex;
+    membership.mr_type = PACKET_MR_PROMISC;
+    setsockopt(worker.fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership));
+
+    return true;
+}
+
+bool RingCapture::joinFanout(Worker& worker, const RingOptions& options) {
+    bool first = &worker == &workers_.front();
+
+    int mode = PACKET_FANOUT_CBPF;
+    if (options.fanout == FanoutMode::HASH) mode = PACKET_FANOUT_HASH;
+    if (options.fanout == FanoutMode::LOAD_BALANCE) mode = PACKET_FANOUT_LB;
+
+    int argument = fanout_group_ | (mode << 16);
+    if (setsockopt(worker.fd, SOL_PACKET, PACKET_FANOUT, &argument, sizeof(argument)) < 0) {
+        Logger::getInstance().error(errnoString("Failed to join fanout group"));
+        return false;
+    }
+
+    if (mode != PACKET_FANOUT_CBPF || !first) return true;
+
+    // The kernel flow hash cannot see into 802.11 frames, so the worker is
+    // picked from addr1[5] ^ addr2[5]: the same for both directions between
+    // two stations, keeping a handshake's frames on one worker. The kernel
+    // takes the result modulo the number of sockets.
+    uint32_t addr1 = 9, addr2 = 15;
+    if (link_type_ == DLT_EN10MB) {
+        addr1 = 5;
+        addr2 = 11;
+    }
+
+    // Loads are relative to the link-layer header (SKF_LL_OFF): received
+    // frames reach the fanout with the network header already pulled
+    const uint32_t LL = static_cast<uint32_t>(SKF_LL_OFF);
+
+    std::vector<struct sock_filter> program;
+    if (link_type_ == DLT_IEEE802_11_RADIO) {
+        // X = it_len, little-endian at offset 2
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, LL + 2));
+        program.push_back(BPF_STMT(BPF_MISC | BPF_TAX, 0));
+        program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, LL + 3));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8));
+        program.push_back(BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0));
+        program.push_back(BPF_STMT(BPF_MISC | BPF_TAX, 0));
+    } else {
+        program.push_back(BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 0));
+    }
+    program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, LL + addr1));
+    program.push_back(BPF_STMT(BPF_ST, 0));
+    program.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_IND, LL + addr2));
+    program.push_back(BPF_STMT(BPF_LDX | BPF_W | BPF_MEM, 0));
+    program.push_back(BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0));
+    program.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+    struct sock_fprog fprog;
+    fprog.len = static_cast<unsigned short>(program.size());
+    fprog.filter = program.data();
+    if (setsockopt(worker.fd, SOL_PACKET, PACKET_FANOUT_DATA, &fprog, sizeof(fprog)) < 0) {
+        Logger::getInstance().error(errnoString("Failed to install the fanout program"));
+        return false;
+    }
+    return true;
+}
+
+void RingCapture::close() {
+    stop();
+    for (Worker& worker : workers_) {
+        if (worker.ring) munmap(worker.ring, worker.block_count * block_size_);
+        if (worker.fd >= 0) ::close(worker.fd);
+    }
+    workers_.clear();
+    link_type_ = -1;
+}
+
+bool RingCapture::start(BatchHandler handler) {
+    if (workers_.empty() || running_) return false;
+
+    handler_ = std::move(handler);
+    running_ = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i].thread = std::thread(&RingCapture::workerLoop, this, static_cast<int>(i));
+    }
+    return true;
+}
+
+void RingCapture::stop() {
+    running_ = false;
+    for (Worker& worker : workers_) {
+        if (worker.thread.joinable()) worker.thread.join();
+    }
+}
+
+CaptureCounters RingCapture::getCounters() {
+    std::lock_guard<std::mutex> lock(counters_mutex_);
+
+    for (const Worker& worker : workers_) {
+        // tp_packets already includes tp_drops
+        struct tpacket_stats_v3 stats;
+        socklen_t length = sizeof(stats);
+        if (getsockopt(worker.fd, SOL_PACKET, PACKET_STATISTICS, &stats, &length) == 0) {
+            counters_.received += stats.tp_packets;
+            counters_.dropped += stats.tp_drops;
+        }
+    }
+
+    uint64_t interface_drops = readInterfaceDrops(interface_);
+    counters_.interface_dropped = interface_drops > interface_drops_at_open_ ? interface_drops - interface_drops_at_open_ : 0;
+    return counters_;
+}
+
+std::vector<size_t> RingCapture::getBacklog() const {
+    std::vector<size_t> backlog;
+    for (const Worker& worker : workers_) {
+        size_t ready = 0;
+        for (size_t block = 0; block < worker.block_count; ++block) {
+            auto* desc = reinterpret_cast<struct tpacket_block_desc*>(worker.ring + block * block_size_);
+            if (__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_RELAXED) & TP_STATUS_USER) {
+                ready++;
+            }
+        }
+        backlog.push_back(ready);
+    }
+    return backlog;
+}
+
+bool RingCapture::parseFanoutMode(const std::string& name, FanoutMode& mode) {
+    if (name == "pair") {
+        mode = FanoutMode::STATION_PAIR;
+    } else if (name == "hash") {
+        mode = FanoutMode::HASH;
+    } else if (name == "lb") {
+        mode = FanoutMode::LOAD_BALANCE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void RingCapture::workerLoop(int index) {
+    Worker& worker = workers_[index];
+    std::vector<RingPacket> batch;
+    size_t block = 0;
+
+    struct pollfd pfd;
+    pfd.fd = worker.fd;
+    pfd.events = POLLIN | POLLERR;
+
+    while (running_) {
+        auto* desc = reinterpret_cast<struct tpacket_block_desc*>(worker.ring + block * block_size_);
+        if (!(__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+            pfd.revents = 0;
+            poll(&pfd, 1, POLL_INTERVAL_MS);
+            continue;
+        }
+
+        batch.clear();
+        const uint8_t* next = reinterpret_cast<const uint8_t*>(desc) + desc->hdr.bh1.offset_to_first_pkt;
+        for (uint32_t i = 0; i < desc->hdr.bh1.num_pkts; ++i) {
+            auto* hdr = reinterpret_cast<const struct tpacket3_hdr*>(next);
+
+            RingPacket packet;
+            packet.header.ts.tv_sec = hdr->tp_sec;
+            packet.header.ts.tv_usec = hdr->tp_nsec / 1000;
+            packet.header.caplen = hdr->tp_snaplen;
+            packet.header.len = hdr->tp_len;
+            packet.data = next + hdr->tp_mac;
+            packet.interface_id = 0;
+            batch.push_back(packet);
+
+            next += hdr->tp_next_offset;
+        }
+
+        if (!batch.empty()) {
+            handler_(index, batch);
+        }
+
+        // Back to the kernel only once the batch is done with
+        __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        block = (block + 1) % worker.block_count;
+    }
+}
+
+} // namespace airlevi
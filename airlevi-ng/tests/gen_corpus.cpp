@@ -0,0 +1,591 @@
+// Known-answer corpus for the crack engines: synthesizes captures whose
+// passphrases are known, plus a wordlist that contains them.
+//
+//   airlevi-gen-corpus DIR [DECOYS]
+//
+// Writes DIR/wordlist.txt, one capture per case and DIR/expected.txt
+// ("case file essid password" per line), and starts DIR/throughput.csv for
+// tests/run_case.sh. Output is deterministic.
+
+#include "common/pcap_writer.h"
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/provider.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+const Bytes AP_MAC = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+const Bytes STA_MAC = {0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb};
+
+std::mt19937 rng(0x41495256);
+
+Bytes randomBytes(size_t count) {
+    Bytes out(count);
+    for (auto& b : out) b = static_cast<uint8_t>(rng() & 0xff);
+    return out;
+}
+
+void append(Bytes& out, const Bytes& data) {
+    // Grown first, then copied into the bytes it now owns
+    size_t offset = out.size();
+    if (data.empty()) return;
+    out.resize(offset + data.size());
+    memcpy(out.data() + offset, data.data(), data.size());
+}
+
+void appendBE16(Bytes& out, uint16_t value) {
+    out.push_back(value >> 8);
+    out.push_back(value & 0xff);
+}
+
+void appendLE16(Bytes& out, uint16_t value) {
+    out.push_back(value & 0xff);
+    out.push_back(value >> 8);
+}
+
+void appendLE32(Bytes& out, uint32_t value) {
+    appendLE16(out, value & 0xffff);
+    appendLE16(out, value >> 16);
+}
+
+uint32_t crc32(const Bytes& data) {
+    uint32_t crc = 0xffffffff;
+    for (uint8_t b : data) {
+        crc ^= b;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+std::string toHex(const Bytes& data) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (uint8_t b : data) {
+        hex += digits[b >> 4];
+        hex += digits[b & 0x0f];
+    }
+    return hex;
+}
+
+Bytes pbkdf2(const std::string& password, const std::string& essid) {
+    Bytes pmk(32);
+    PKCS5_PBKDF2_HMAC(password.c_str(), password.size(),
+                      reinterpret_cast<const unsigned char*>(essid.data()), essid.size(),
+                      4096, EVP_sha1(), 32, pmk.data());
+    return pmk;
+}
+
+Bytes hmac(const EVP_MD* md, const Bytes& key, const Bytes& data) {
+    Bytes out(EVP_MAX_MD_SIZE);
+    unsigned int len = 0;
+    HMAC(md, key.data(), key.size(), data.data(), data.size(), out.data(), &len);
+    out.resize(len);
+    return out;
+}
+
+// IEEE 802.11 PRF-512 (key descriptor versions 1 and 2)
+Bytes prf(const Bytes& key, const std::string& label, const Bytes& data, size_t length) {
+    Bytes out;
+    for (uint8_t i = 0; out.size() < length; ++i) {
+        Bytes input(label.begin(), label.end());
+        input.push_back(0);
+        append(input, data);
+        input.push_back(i);
+        append(out, hmac(EVP_sha1(), key, input));
+    }
+    out.resize(length);
+    return out;
+}
+
+// IEEE 802.11 KDF-SHA256 (key descriptor version 3)
+Bytes kdf(const Bytes& key, const std::string& label, const Bytes& data, size_t bits) {
+    Bytes out;
+    for (uint16_t i = 1; out.size() * 8 < bits; ++i) {
+        Bytes input;
+        appendLE16(input, i);
+        input.insert(input.end(), label.begin(), label.end());
+        append(input, data);
+        appendLE16(input, static_cast<uint16_t>(bits));
+        append(out, hmac(EVP_sha256(), key, input));
+    }
+    out.resize(bits / 8);
+    return out;
+}
+
+Bytes cmac(const Bytes& key, const Bytes& data) {
+    Bytes out(16);
+    size_t len = 0;
+    char cipher[] = "AES-128-CBC";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_CIPHER, cipher, 0),
+        OSSL_PARAM_construct_end()
+    };
+    EVP_MAC* mac = EVP_MAC_fetch(nullptr, "CMAC", nullptr);
+    EVP_MAC_CTX* ctx = mac ? EVP_MAC_CTX_new(mac) : nullptr;
+    if (!ctx || EVP_MAC_init(ctx, key.data(), key.size(), params) != 1 ||
+        EVP_MAC_update(ctx, data.data(), data.size()) != 1 ||
+        EVP_MAC_final(ctx, out.data(), &len, out.size()) != 1) {
+        out.clear();
+    }
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(mac);
+    return out;
+}
+
+Bytes md5(const std::string& data) {
+    Bytes out(EVP_MAX_MD_SIZE);
+    unsigned int len = 0;
+    EVP_Digest(data.data(), data.size(), out.data(), &len, EVP_md5(), nullptr);
+    out.resize(len);
+    return out;
+}
+
+// RC4 lives in OpenSSL's legacy provider, loaded by main()
+Bytes rc4(const Bytes& key, const Bytes& data) {
+    Bytes out(data.size());
+    int len = 0;
+    EVP_CIPHER* cipher = EVP_CIPHER_fetch(nullptr, "RC4", nullptr);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!cipher || !ctx ||
+        EVP_EncryptInit_ex2(ctx, cipher, nullptr, nullptr, nullptr) != 1 ||
+        EVP_CIPHER_CTX_set_key_length(ctx, static_cast<int>(key.size())) != 1 ||
+        EVP_EncryptInit_ex2(ctx, nullptr, key.data(), nullptr, nullptr) != 1 ||
+        EVP_EncryptUpdate(ctx, out.data(), &len, data.data(), static_cast<int>(data.size())) != 1) {
+        out.clear();
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+    return out;
+}
+
+Bytes beacon(const std::string& essid) {
+    Bytes frame = {0x80, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    append(frame, AP_MAC);
+    append(frame, AP_MAC);
+    frame.push_back(0);
+    frame.push_back(0);
+
+    append(frame, Bytes(8, 0));     // timestamp
+    appendLE16(frame, 100);         // beacon interval
+    appendLE16(frame, 0x0411);      // capabilities: ESS, privacy
+    frame.push_back(0);
+    frame.push_back(static_cast<uint8_t>(essid.size()));
+    frame.insert(frame.end(), essid.begin(), essid.end());
+    append(frame, {3, 1, 6});       // DS parameter set: channel 6
+    return frame;
+}
+
+Bytes eapolKey(uint16_t key_info, const Bytes& nonce, const Bytes& mic, const Bytes& key_data,
+               uint8_t replay_counter = 1) {
+    Bytes body = {2};               // descriptor type: RSN
+    appendBE16(body, key_info);
+    appendBE16(body, 16);           // key length
+    append(body, {0, 0, 0, 0, 0, 0, 0, replay_counter});
+    append(body, nonce);
+    append(body, Bytes(16, 0));     // key IV
+    append(body, Bytes(8, 0));      // key RSC
+    append(body, Bytes(8, 0));      // reserved
+    append(body, mic);
+    appendBE16(body, static_cast<uint16_t>(key_data.size()));
+    append(body, key_data);
+
+    Bytes eapol = {1, 3};           // 802.1X-2001, EAPOL-Key
+    appendBE16(eapol, static_cast<uint16_t>(body.size()));
+    append(eapol, body);
+    return eapol;
+}
+
+Bytes dataFrame(bool from_ds, uint8_t flags, const Bytes& payload) {
+    Bytes frame = {0x08, static_cast<uint8_t>((from_ds ? 0x02 : 0x01) | flags), 0x00, 0x00};
+    append(frame, from_ds ? STA_MAC : AP_MAC);
+    append(frame, from_ds ? AP_MAC : STA_MAC);
+    append(frame, AP_MAC);
+    frame.push_back(0);
+    frame.push_back(0);
+    append(frame, payload);
+    return frame;
+}
+
+Bytes eapolFrame(bool from_ds, const Bytes& eapol) {
+    Bytes payload = {0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x88, 0x8e};
+    append(payload, eapol);
+    return dataFrame(from_ds, 0, payload);
+}
+
+// The same data frame as a QoS data frame, TID 0
+Bytes qosFrame(const Bytes& frame) {
+    Bytes qos(frame.begin(), frame.begin() + 24);
+    qos[0] = 0x88;
+    append(qos, {0x00, 0x00});      // QoS control
+    qos.insert(qos.end(), frame.begin() + 24, frame.end());
+    return qos;
+}
+
+// The frame as a monitor interface with several antennas delivers it: a
+// radiotap header whose present bitmap extends over three words (combined
+// fields, then a namespace per antenna) and a trailing FCS. With data_pad,
+// QoS data frames get their body aligned to 32 bits behind the 26-byte
+// header, as some drivers deliver them.
+Bytes radiotapFrame(const Bytes& frame, bool data_pad = false) {
+    Bytes out = {0, 0};
+    appendLE16(out, 36);                                      // it_len
+    appendLE32(out, 0xa000002f);    // TSFT, flags, rate, channel, signal; namespace, ext
+    appendLE32(out, 0xa0000820);    // antenna 0: signal, antenna; namespace, ext
+    appendLE32(out, 0x00000820);    // antenna 1: signal, antenna
+    append(out, Bytes(8, 0));       // TSFT
+    out.push_back(data_pad ? 0x30 : 0x10);   // flags: FCS at end, data pad
+    out.push_back(12);              // 6 Mb/s
+    appendLE16(out, 2437);          // channel 6
+    appendLE16(out, 0x00c0);        // 2 GHz, OFDM
+    out.push_back(static_cast<uint8_t>(-42));
+    out.push_back(static_cast<uint8_t>(-44));
+    out.push_back(0);
+    out.push_back(static_cast<uint8_t>(-40));
+    out.push_back(1);
+    out.push_back(0);               // it_len pad
+
+    if (data_pad && (frame[0] & 0x8c) == 0x88) {
+        out.insert(out.end(), frame.begin(), frame.begin() + 26);
+        append(out, {0x00, 0x00});
+        out.insert(out.end(), frame.begin() + 26, frame.end());
+    } else {
+        append(out, frame);
+    }
+    appendLE32(out, crc32(frame));
+    return out;
+}
+
+// Classic pcap, LINKTYPE_IEEE802_11 unless told otherwise; one frame a
+// second unless given the seconds past the corpus epoch of each
+bool writePcap(const std::string& path, const std::vector<Bytes>& frames, const std::vector<uint32_t>& seconds = {},
+               uint32_t link_type = 105) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    const uint32_t header[6] = {0xa1b2c3d4, 0x00040002, 0, 0, 65535, link_type};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const Bytes& frame = frames[i];
+        uint32_t ts = 1700000000 + (seconds.empty() ? static_cast<uint32_t>(i) : seconds[i]);
+        const uint32_t record[4] = {ts, 0, static_cast<uint32_t>(frame.size()), static_cast<uint32_t>(frame.size())};
+        out.write(reinterpret_cast<const char*>(record), sizeof(record));
+        out.write(reinterpret_cast<const char*>(frame.data()), frame.size());
+    }
+    return out.good();
+}
+
+// Through the capture writer, the way airlevi-dump writes; pcapng lists the
+// frames given a kind in its trailing index
+bool writeIndexed(const std::string& path, const std::vector<Bytes>& frames,
+                  const std::vector<airlevi::IndexedFrameKind>& kinds, airlevi::PcapWriterOptions options) {
+    airlevi::CaptureInterface interface;
+    interface.name = "corpus0";
+    interface.link_type = 105;
+    options.application = "airlevi-gen-corpus";
+
+    airlevi::PcapWriter writer;
+    if (!writer.open(path, {interface}, options)) return false;
+
+    bool ok = true;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        struct pcap_pkthdr header = {};
+        header.ts.tv_sec = 1700000000 + static_cast<time_t>(i);
+        header.caplen = header.len = static_cast<uint32_t>(frames[i].size());
+        ok = writer.write(&header, frames[i].data(), 0, kinds[i]) && ok;
+    }
+    writer.close();
+    return ok && writer.getDropped() == 0;
+}
+
+// Message 2 answering the given ANonce, with its MIC
+Bytes signedM2(int version, const Bytes& pmk, const Bytes& anonce, const Bytes& snonce, uint8_t replay_counter) {
+    Bytes data;
+    append(data, std::min(AP_MAC, STA_MAC));
+    append(data, std::max(AP_MAC, STA_MAC));
+    append(data, std::min(anonce, snonce));
+    append(data, std::max(anonce, snonce));
+
+    Bytes ptk = version == 3 ? kdf(pmk, "Pairwise key expansion", data, 384)
+                             : prf(pmk, "Pairwise key expansion", data, 64);
+    Bytes kck(ptk.begin(), ptk.begin() + 16);
+
+    Bytes m2 = eapolKey(0x0108 | version, snonce, Bytes(16, 0), {}, replay_counter);
+
+    Bytes mic;
+    if (version == 1) {
+        mic = hmac(EVP_md5(), kck, m2);
+    } else if (version == 2) {
+        mic = hmac(EVP_sha1(), kck, m2);
+        mic.resize(16);
+    } else {
+        mic = cmac(kck, m2);
+    }
+    return eapolKey(0x0108 | version, snonce, mic, {}, replay_counter);
+}
+
+// Beacon plus messages 1 and 2 of a 4-way handshake
+std::vector<Bytes> handshake(int version, const std::string& essid, const std::string& password) {
+    Bytes pmk = pbkdf2(password, essid);
+    Bytes anonce = randomBytes(32);
+    Bytes snonce = randomBytes(32);
+
+    Bytes m1 = eapolKey(0x0088 | version, anonce, Bytes(16, 0), {});
+    Bytes m2 = signedM2(version, pmk, anonce, snonce, 1);
+
+    return {beacon(essid), eapolFrame(true, m1), eapolFrame(false, m2)};
+}
+
+// A retried handshake: the station missed the first M1, answered a second
+// one the capture lost, and the AP went on to M3. Only the M3, one replay
+// counter above the M2, carries the ANonce the MIC was computed with.
+std::vector<Bytes> retriedHandshake(const std::string& essid, const std::string& password) {
+    Bytes pmk = pbkdf2(password, essid);
+    Bytes stale_anonce = randomBytes(32);
+    Bytes anonce = randomBytes(32);
+    Bytes snonce = randomBytes(32);
+
+    Bytes m1 = eapolKey(0x008a, stale_anonce, Bytes(16, 0), {}, 1);
+    Bytes m2 = signedM2(2, pmk, anonce, snonce, 2);
+    Bytes m3 = eapolKey(0x03ca, anonce, randomBytes(16), {}, 3);
+
+    return {beacon(essid), eapolFrame(true, m1), eapolFrame(false, m2), eapolFrame(true, m3)};
+}
+
+// A handshake airlevi-strip scans in RANGE_PARTS ranges, the middle
+// boundary falling on the payload of a data frame that holds a chain of
+// plausible record headers. The last fake record swallows the M1, so a
+// worker that trusted its resync would lose the pair.
+const uint64_t RANGE_BYTES = 1024;
+const uint64_t RANGE_PARTS = 4;
+
+std::vector<Bytes> rangesCapture(const std::string& essid, const std::string& password) {
+    std::vector<Bytes> key_frames = handshake(2, essid, password);
+    const Bytes& m1 = key_frames[1];
+
+    // Eight headers like writePcap() writes, the first seven with 8 bytes each
+    Bytes chain;
+    for (int i = 0; i < 8; ++i) {
+        uint32_t caplen = i < 7 ? 8 : static_cast<uint32_t>(16 + m1.size());
+        const uint32_t record[4] = {1700000000, 0, caplen, caplen};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(record);
+        append(chain, Bytes(bytes, bytes + sizeof(record)));
+        if (i < 7) append(chain, Bytes(8, 0));
+    }
+
+    std::vector<Bytes> fillers;
+    auto recordBytes = [](const Bytes& frame) { return 16 + static_cast<uint64_t>(frame.size()); };
+    for (;;) {
+        // The chain starts at `before + pad`; the middle boundary is at
+        // 24 + span / 2, with span = `rest + pad`
+        uint64_t before = 24 + recordBytes(key_frames[0]) + 16 + 24;
+        uint64_t rest = recordBytes(key_frames[0]) + 16 + 24 + chain.size() + recordBytes(m1) +
+                        recordBytes(key_frames[2]);
+        for (const auto& filler : fillers) rest += recordBytes(filler);
+
+        if (rest + 48 >= 2 * before && rest + 48 - 2 * before + rest >= RANGE_PARTS * RANGE_BYTES) {
+            Bytes payload(rest + 48 - 2 * before, 0);
+            append(payload, chain);
+            std::vector<Bytes> frames = {key_frames[0], dataFrame(false, 0, payload), m1, key_frames[2]};
+            frames.insert(frames.end(), fillers.begin(), fillers.end());
+            return frames;
+        }
+        fillers.push_back(dataFrame(true, 0, randomBytes(256)));
+    }
+}
+
+// Beacon plus an M1 carrying the PMKID KDE; also returns the 22000 line
+std::vector<Bytes> pmkidCapture(const std::string& essid, const std::string& password, std::string& hash_line) {
+    Bytes pmk = pbkdf2(password, essid);
+
+    Bytes message = {'P', 'M', 'K', ' ', 'N', 'a', 'm', 'e'};
+    append(message, AP_MAC);
+    append(message, STA_MAC);
+    Bytes pmkid = hmac(EVP_sha1(), pmk, message);
+    pmkid.resize(16);
+
+    Bytes kde = {0xdd, 0x14, 0x00, 0x0f, 0xac, 0x04};
+    append(kde, pmkid);
+    Bytes m1 = eapolKey(0x008a, randomBytes(32), Bytes(16, 0), kde);
+
+    hash_line = "WPA*01*" + toHex(pmkid) + "*" + toHex(AP_MAC) + "*" + toHex(STA_MAC) + "*" +
+                toHex(Bytes(essid.begin(), essid.end())) + "***";
+    return {beacon(essid), eapolFrame(true, m1)};
+}
+
+// WEP data frames keyed the way airlevi-crack derives keys from passphrases
+std::vector<Bytes> wepCapture(const std::string& essid, const std::string& passphrase, int frames) {
+    Bytes digest = md5(passphrase);
+    Bytes key(digest.begin(), digest.begin() + 5);
+
+    std::vector<Bytes> capture = {beacon(essid)};
+    for (int i = 0; i < frames; ++i) {
+        Bytes plain = {0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00};
+        append(plain, randomBytes(40 + i));
+        uint32_t icv = crc32(plain);
+        for (int b = 0; b < 4; ++b) plain.push_back((icv >> (8 * b)) & 0xff);
+
+        Bytes iv = randomBytes(3);
+        Bytes seed = iv;
+        append(seed, key);
+
+        Bytes cipher = rc4(seed, plain);
+        if (cipher.empty()) return {};
+
+        Bytes payload = iv;
+        payload.push_back(0);       // key index 0
+        append(payload, cipher);
+        capture.push_back(dataFrame(false, 0x40, payload));
+    }
+    return capture;
+}
+
+struct Case {
+    std::string name;
+    std::string file;
+    std::string essid;
+    std::string password;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " DIR [DECOYS]" << std::endl;
+        return 1;
+    }
+
+    std::string dir = argv[1];
+    int decoys = argc > 2 ? std::atoi(argv[2]) : 2000;
+    mkdir(dir.c_str(), 0755);
+
+    // Loading one provider stops the default from loading implicitly
+    if (!OSSL_PROVIDER_load(nullptr, "default") || !OSSL_PROVIDER_load(nullptr, "legacy")) {
+        std::cerr << "OpenSSL legacy provider unavailable: the WEP case needs RC4" << std::endl;
+        return 1;
+    }
+
+    const std::vector<Case> cases = {
+        {"wpa-v1", "wpa-v1.pcap", "corpus-tkip", "tkip-passphrase-01"},
+        {"wpa-v2", "wpa-v2.pcap", "corpus-ccmp", "ccmp-passphrase-02"},
+        {"wpa-v3", "wpa-v3.pcap", "corpus-cmac", "cmac-passphrase-03"},
+        {"pmkid", "pmkid.pcap", "corpus-pmkid", "pmkid-passphrase-04"},
+        {"wep", "wep.pcap", "corpus-wep", "wep-passphrase-05"},
+        {"brute", "brute.pcap", "corpus-brute", "01101001"},
+        {"indexed", "indexed.pcapng", "corpus-indexed", "indexed-passphrase-06"},
+        {"sidecar", "sidecar.pcap", "corpus-sidecar", "sidecar-passphrase-07"},
+        {"merge", "radio-a.pcap", "corpus-merge", "merge-passphrase-08"},
+        {"retry", "retry.pcap", "corpus-retry", "retry-passphrase-09"},
+        {"ranges", "ranges.pcap", "corpus-ranges", "ranges-passphrase-10"},
+        {"radiotap", "radiotap.pcap", "corpus-radiotap", "radiotap-passphrase-11"},
+        {"padded", "padded.pcap", "corpus-padded", "padded-passphrase-12"},
+    };
+
+    bool ok = true;
+    std::ofstream expected(dir + "/expected.txt");
+    for (const auto& c : cases) {
+        std::vector<Bytes> frames;
+        std::vector<airlevi::IndexedFrameKind> kinds;
+        std::vector<uint32_t> seconds;
+        if (c.name == "wpa-v1") {
+            frames = handshake(1, c.essid, c.password);
+        } else if (c.name == "wpa-v2" || c.name == "brute") {
+            frames = handshake(2, c.essid, c.password);
+        } else if (c.name == "wpa-v3") {
+            frames = handshake(3, c.essid, c.password);
+        } else if (c.name == "retry") {
+            frames = retriedHandshake(c.essid, c.password);
+        } else if (c.name == "ranges") {
+            frames = rangesCapture(c.essid, c.password);
+        } else if (c.name == "radiotap") {
+            for (const Bytes& frame : handshake(2, c.essid, c.password)) {
+                frames.push_back(radiotapFrame(frame));
+            }
+        } else if (c.name == "padded") {
+            // QoS EAPOL frames with a radiotap data pad after their header
+            std::vector<Bytes> key_frames = handshake(2, c.essid, c.password);
+            frames.push_back(radiotapFrame(key_frames[0]));
+            for (size_t i = 1; i < key_frames.size(); ++i) {
+                frames.push_back(radiotapFrame(qosFrame(key_frames[i]), true));
+            }
+        } else if (c.name == "indexed" || c.name == "sidecar") {
+            // Unindexed traffic around the handshake, which the index lets
+            // airlevi-crack skip
+            std::vector<Bytes> key_frames = handshake(2, c.essid, c.password);
+            for (int i = 0; i < 3; ++i) {
+                for (int n = 0; n < 16; ++n) {
+                    frames.push_back(dataFrame(n % 2 == 0, 0, randomBytes(64 + n)));
+                    kinds.push_back(airlevi::IndexedFrameKind::NONE);
+                }
+                frames.push_back(key_frames[i]);
+                kinds.push_back(i == 0 ? airlevi::IndexedFrameKind::BEACON : airlevi::IndexedFrameKind::EAPOL);
+            }
+        } else if (c.name == "merge") {
+            // Two radios that both heard the beacon but one message each:
+            // only their merge holds a crackable pair
+            std::vector<Bytes> key_frames = handshake(2, c.essid, c.password);
+            frames = {key_frames[0], key_frames[1]};
+            seconds = {0, 1};
+            ok = writePcap(dir + "/radio-b.pcap", {key_frames[0], key_frames[2]}, {0, 2}) && ok;
+        } else if (c.name == "pmkid") {
+            std::string line;
+            frames = pmkidCapture(c.essid, c.password, line);
+            std::ofstream(dir + "/pmkid.22000") << line << "\n";
+        } else {
+            frames = wepCapture(c.essid, c.password, 32);
+            ok = !frames.empty() && ok;
+        }
+
+        airlevi::PcapWriterOptions options;
+        if (c.name == "indexed") {
+            options.format = airlevi::CaptureFormat::PCAPNG;
+        } else {
+            options.sidecar_index = true;
+        }
+        uint32_t link_type = c.name == "radiotap" || c.name == "padded" ? 127 : 105;
+        ok = (kinds.empty() ? writePcap(dir + "/" + c.file, frames, seconds, link_type)
+                            : writeIndexed(dir + "/" + c.file, frames, kinds, options)) && ok;
+        expected << c.name << " " << c.file << " " << c.essid << " " << c.password << "\n";
+    }
+
+    // Decoys first so every run scans the whole list before its answer
+    std::ofstream wordlist(dir + "/wordlist.txt");
+    for (int i = 0; i < decoys; ++i) {
+        wordlist << "decoy-" << std::to_string(rng() % 1000000000) << "-" << i << "\n";
+    }
+    for (const auto& c : cases) {
+        if (c.name != "brute") wordlist << c.password << "\n";
+    }
+
+    // A list without any answer, for the no-false-positive cases
+    std::ofstream misses(dir + "/misses.txt");
+    for (int i = 0; i < 64; ++i) {
+        misses << "miss-" << std::to_string(rng() % 1000000000) << "-" << i << "\n";
+    }
+
+    std::ofstream throughput(dir + "/throughput.csv");
+    throughput << "case,seconds,tested,rate\n";
+
+    if (!ok || !expected.good() || !wordlist.good() || !misses.good() || !throughput.good()) {
+        std::cerr << "Failed to write corpus to " << dir << std::endl;
+        return 1;
+    }
+
+    std::cout << "Corpus written to " << dir << " (" << cases.size() << " cases, "
+              << decoys << " decoys)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Run one known-answer case and record its throughput.
+#
+#   run_case.sh NAME EXPECT RESULTS_CSV -- COMMAND [ARGS...]
+#
+# Passes when COMMAND's output contains EXPECT. The elapsed time and the
+# candidate count the engine reports are appended to RESULTS_CSV.
+
+name=$1
+expect=$2
+results=$3
+shift 3
+[ "$1" = "--" ] && shift
+
+output=$(mktemp)
+trap 'rm -f "$output"' EXIT
+
+start=$(date +%s.%N)
+"$@" >"$output" 2>&1
+status=$?
+end=$(date +%s.%N)
+
+cat "$output"
+
+tested=$(sed -n -E 's/.*(Tested|Tried) ([0-9]+) passwords.*/\2/p' "$output" | tail -n 1)
+[ -n "$tested" ] || tested=0
+awk -v name="$name" -v start="$start" -v end="$end" -v tested="$tested" 'BEGIN {
+    elapsed = end - start
+    printf "%s,%.3f,%d,%.1f\n", name, elapsed, tested, (elapsed > 0 ? tested / elapsed : 0)
+}' >>"$results"
+
+if ! grep -qF -- "$expect" "$output"; then
+    echo "FAIL: '$name' exited $status without '$expect'" >&2
+    exit 1
+fi
+exit 0